@@ -0,0 +1,74 @@
+#ifndef _ANIMATION_H
+#define _ANIMATION_H
+
+#include <Arduino.h>
+
+// Multi-frame playback from .anim files, a device-native container made by
+// tools/anim_tool.py (from a GIF, or the synthetic benchmark corpus):
+//
+//   header  "ANIM", version, max_drop, width, height, frames, loops, 0
+//   frame   delay_ms (u16), flags (u8), 0, length (u32), rect message
+//
+// All fields little-endian. Each frame is a /ws rectangle message
+// (rect_update.h) in panel coordinates, covering only what changed, so
+// playback decodes sub-rectangles straight into the blit strips. The first
+// frame is a key frame covering the whole canvas; it is redrawn on every
+// loop. A frame's rectangle also covers what the max_drop frames before it
+// changed, so up to max_drop frames in a row may be skipped without leaving
+// stale pixels.
+//
+// Frames are paced against a schedule from the first frame: a frame whose
+// successor is already due is dropped, while allowed (never a key frame or
+// the last one); a frame more than ANIM_RESYNC_MS late restarts the
+// schedule at that frame rather than racing to catch up. Playback stops between frames when a newer display
+// request supersedes it.
+
+#define ANIM_EXTENSION ".anim"
+#define ANIM_MAGIC "ANIM"
+#define ANIM_VERSION 1
+#define ANIM_HEADER_SIZE 16
+#define ANIM_FRAME_HEADER_SIZE 8
+#define ANIM_FRAME_KEY 0x01 // Covers the whole canvas
+
+#ifndef ANIM_READ_CHUNK
+#define ANIM_READ_CHUNK 1024
+#endif
+
+#define ANIM_MIN_DELAY_MS 10   // As browsers do for GIFs with 0 delays
+#define ANIM_RESYNC_MS 500
+#define ANIM_POLL_MS 20        // Superseded check while waiting for a frame
+
+typedef struct
+{
+	uint32_t frames;         // Drawn
+	uint32_t dropped;
+	uint32_t resyncs;
+	uint32_t loops;          // Completed
+	uint32_t elapsed_ms;
+	uint32_t fps_x10;        // Frames drawn per second
+	uint32_t target_fps_x10; // What the delays ask for
+	uint32_t decode_us_avg;  // Per drawn frame: reading and decoding
+	uint32_t decode_us_max;
+	uint32_t push_us_avg;    // Per drawn frame: SPI (window setup, waits)
+	uint32_t push_us_max;
+	uint32_t late_us_max;    // Worst start behind schedule of a drawn frame
+} anim_stats_t;
+
+bool animationIsFile(const char* filename);
+
+// Play /images/filename on the panel at speedPercent of its frame rate, for
+// loops passes (0: as many as the file says, where 0 means until
+// superseded). Holds the display lock throughout, so other drawing and
+// thumbnail decodes wait until playback ends. True if the first frame was
+// drawn; out (optional) gets the playback statistics
+bool animationPlay(const char* filename, uint16_t speedPercent = 100, uint16_t loops = 0,
+                   anim_stats_t* out = nullptr);
+
+// Playback also ends after ms (0: no limit) - the playlist sets the item's
+// dwell around showing it
+void animationSetMaxDuration(uint32_t ms);
+
+// The last playback's statistics, for /metrics
+void animationWriteMetrics(Print& out);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <Arduino.h>
+
+// Decoder and blit benchmark over a fixed corpus: the images in
+// /images/BENCH_DIR, generated by tools/bench_corpus.py into
+// bench/corpus/images/bench. The corpus is not part of data/: the native
+// build reads it with --fs bench/corpus, and a device only gets it in a
+// filesystem image built with BENCH_CORPUS=1 (tools/gzip_data.py). Every
+// image is decoded straight to the panel `runs` times, then each PNG row
+// conversion kernel is timed on synthetic rows.
+// Results are one JSON object per line so two runs can be diffed; the same
+// code runs on the device (serial "bench" command) and in the native build.
+
+#define BENCH_DIR "bench"
+
+#ifndef BENCH_DEFAULT_RUNS
+#define BENCH_DEFAULT_RUNS 5
+#endif
+
+#define BENCH_MAX_RUNS 100
+#define BENCH_KERNEL_ROWS 320 // One full frame of rows per kernel
+
+void benchRun(Print& out, uint16_t runs = BENCH_DEFAULT_RUNS);
+
+// /images listing cost against directory size: BENCH_LIST_DIR is filled to
+// 1/5, 1/2 and all of `files` and listed with the old String-building code
+// and from an image catalog of the directory (by name, size and mtime).
+// Each step also times the incremental catalog scan and name lookups
+// against LittleFS.exists(). Heap peaks are sampled between chunks; the
+// directory and its catalog are removed again afterwards.
+#define BENCH_LIST_DIR "/listbench"
+#define BENCH_LIST_CATALOG "/listbench.cat"
+#define BENCH_LIST_LOOKUPS 200
+#define BENCH_LIST_DEFAULT_FILES 500
+#define BENCH_LIST_CHUNK 1436 // Typical chunk the web server asks for
+
+void benchListing(Print& out, uint16_t files = BENCH_LIST_DEFAULT_FILES);
+
+// /upload storage path without the network: `bytes` arrive in
+// BENCH_LIST_CHUNK pieces and are written as the handler used to (straight
+// into the destination, one write per chunk) and through an upload session
+// (block-coalesced temporary file, then rename). Reports KB/s, the number
+// of file writes and the longest time one chunk held the caller (the
+// async_tcp task on the device) for each, BENCH_UPLOAD_RUNS times.
+#define BENCH_UPLOAD_NAME "uploadbench.bin"
+#define BENCH_UPLOAD_DEFAULT_BYTES (100 * 1024)
+#define BENCH_UPLOAD_RUNS 3
+
+void benchUpload(Print& out, uint32_t bytes = BENCH_UPLOAD_DEFAULT_BYTES);
+
+// Animation playback over the .anim files in /images/BENCH_DIR (from
+// tools/anim_tool.py corpus): each is played once at its own frame rate
+// and once at speedPercent, fast enough that frames have to be dropped.
+// Reports drawn and dropped frames, achieved against requested fps and
+// per-frame decode and SPI push time.
+#ifndef BENCH_ANIM_FAST_PERCENT
+#define BENCH_ANIM_FAST_PERCENT 400
+#endif
+
+void benchAnimation(Print& out, uint16_t speedPercent = BENCH_ANIM_FAST_PERCENT);
+
+#endif
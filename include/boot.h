@@ -0,0 +1,66 @@
+#ifndef _BOOT_H
+#define _BOOT_H
+
+#include <Arduino.h>
+
+// Fast boot. The image shown at power-off (with its progressive flag and
+// whether the slideshow was running) is kept in NVS and drawn again as the
+// first thing after the panel is up, from its panel-native cache when it has
+// one. Meanwhile a task of its own mounts LittleFS and brings up the Wi-Fi
+// AP and web server; setup() only waits for the mount before drawing.
+//
+// Each phase is stamped in milliseconds since the application started (the
+// ROM and second-stage bootloader before it are not counted), logged as a
+// "[BOOT]" line as it happens, printed again as one timeline once the
+// services are up (early USB CDC output is often lost) and kept for /metrics.
+
+#define BOOT_NVS_NAMESPACE "boot"
+#define BOOT_TASK_STACK 8192
+#define BOOT_MAX_PHASES 16
+
+#ifndef BOOT_SERIAL_WAIT_MS
+#define BOOT_SERIAL_WAIT_MS 0 // Delay for the USB host to attach before the first log line
+#endif
+
+#ifndef BOOT_STORAGE_TIMEOUT_MS
+#define BOOT_STORAGE_TIMEOUT_MS 5000 // Longest wait for the mount; a first-boot format takes seconds
+#endif
+
+typedef struct
+{
+	char image[64];   // Last image displayed through /display, "" if none
+	bool progressive;
+	bool playlist;    // Slideshow was running
+} boot_settings_t;
+
+typedef struct
+{
+	const char* name;
+	uint32_t ms;
+} boot_phase_t;
+
+// Phase complete: log it and keep its time (phase must be a string literal)
+void bootMark(const char* phase);
+
+void bootLoadSettings(boot_settings_t* out);
+
+// NVS is only written when the value changes, so showing the same image
+// again (or a playlist stop while stopped) costs no flash wear
+void bootRememberImage(const char* filename, bool progressive);
+void bootRememberPlaylist(bool running);
+
+// Start the boot task: storage_init(), then ethernet_init() and
+// playlistInit() (ethernet.h, playlist.h)
+void bootStartServices();
+
+// Wait for the mount; true if LittleFS is usable
+bool bootWaitStorage(uint32_t timeoutMs);
+
+// Wait for the web server and playlist; true once they are up
+bool bootWaitServices(uint32_t timeoutMs);
+
+// Phase times so far, one per line, and as metrics
+void bootPrintTimeline(Print& out);
+void bootWriteMetrics(Print& out);
+
+#endif
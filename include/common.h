@@ -27,6 +27,12 @@
 #define TASK_PRIO_ETH (5)
 #define TASK_PRIO_CAN (2)
 #define TASK_PRIO_WS (3)
+#define TASK_PRIO_RENDER (2) // Below async_tcp, above the slideshow
+#define TASK_PRIO_PLAYLIST (1)
+#define TASK_PRIO_THUMB (1)
+#define TASK_PRIO_STORAGE (2) // Upload flash writes, below async_tcp
+#define TASK_PRIO_BOOT (1)    // Mount and network bring-up, time-sliced with setup()
+#define TASK_PRIO_EVENTS (2)  // Server-sent events, below async_tcp
 
 #define CAN_BUFFER_SIZE 64
 #define ETHERNET_BUFFER_SIZE 5
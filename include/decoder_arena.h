@@ -0,0 +1,16 @@
+#ifndef _DECODER_ARENA_H
+#define _DECODER_ARENA_H
+
+#include <Arduino.h>
+
+// One heap block holding all decoder state (PNG object or TJpgDec workspace,
+// plus the open file). It exists only while a display operation runs, so the
+// RAM is available to the web server the rest of the time.
+
+void* decoderArenaAcquire(size_t size);
+void decoderArenaRelease();
+
+// Logs free heap and the largest free block, tagged with a stage name
+void decoderHeapReport(const char* stage);
+
+#endif
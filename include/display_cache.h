@@ -0,0 +1,75 @@
+#ifndef _DISPLAY_CACHE_H
+#define _DISPLAY_CACHE_H
+
+#include <Arduino.h>
+#include "LittleFS.h"
+
+// Panel-native RGB565 sidecar cache
+// Each image under /images gets a full-frame copy in /cache, stored in the
+// byte order the ILI9341 expects, so redisplaying it is a plain file->SPI copy.
+#define DISPLAY_CACHE_DIR "/cache"
+#define DISPLAY_CACHE_EXT ".565"
+#define DISPLAY_CACHE_MAGIC 0x35363552 // "R565"
+#define DISPLAY_CACHE_WIDTH 240
+#define DISPLAY_CACHE_HEIGHT 320
+
+#ifndef DISPLAY_CACHE_BAND_ROWS
+#define DISPLAY_CACHE_BAND_ROWS 16 // Rows buffered while capturing (>= max JPEG MCU height)
+#endif
+
+// Sidecars are a full frame each (about 150 KB): at most this many are kept,
+// the least recently drawn going first, and none is captured when it would
+// leave less than DISPLAY_CACHE_MIN_FREE bytes of the filesystem free
+#ifndef DISPLAY_CACHE_MAX_ENTRIES
+#define DISPLAY_CACHE_MAX_ENTRIES 4
+#endif
+
+#ifndef DISPLAY_CACHE_MIN_FREE
+#define DISPLAY_CACHE_MIN_FREE (256 * 1024)
+#endif
+
+#ifndef DISPLAY_CACHE_READ_ROWS
+#define DISPLAY_CACHE_READ_ROWS 16 // Rows read from flash per SPI strip (<= TFT_BLIT_STRIP_ROWS, divides 320)
+#endif
+
+// Tile index stored next to each sidecar: one 32-bit hash per 16x16 tile.
+// Switching between cached images only sends the tiles whose hash differs
+// from what is currently on the panel.
+#define DISPLAY_TILE_SIZE 16
+#define DISPLAY_TILE_COLS (DISPLAY_CACHE_WIDTH / DISPLAY_TILE_SIZE)
+#define DISPLAY_TILE_ROWS (DISPLAY_CACHE_HEIGHT / DISPLAY_TILE_SIZE)
+#define DISPLAY_TILE_COUNT (DISPLAY_TILE_COLS * DISPLAY_TILE_ROWS)
+#define DISPLAY_TILES_EXT ".tiles"
+#define DISPLAY_TILES_MAGIC 0x454C4954 // "TILE"
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t width;
+	uint16_t height;
+	uint32_t source_size;  // Size of the original file when the sidecar was made
+	uint32_t source_mtime; // Last-write time of the original file
+} display_cache_header_t;
+
+// Create the directory and load the recency list (oldest sidecars by write
+// time evicted down to the budget, orphans removed)
+void displayCacheInit();
+String displayCachePath(const char* filename);
+bool displayCacheValid(const char* filename);
+bool displayCacheDraw(const char* filename);
+void displayCacheInvalidate(const char* filename);
+
+// Something other than a cached frame was drawn; the next draw is a full one
+void displayCacheScreenChanged();
+
+// Capture decoder output (panel byte order) into a new sidecar while it is
+// drawn; evicts older sidecars to make room, false (no capture) when the
+// filesystem stays too full
+bool displayCacheBeginCapture(const char* filename);
+void displayCacheCapture(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t* pixels);
+bool displayCacheEndCapture(bool success);
+
+// Sidecar count and evictions, for /metrics
+void displayCacheWriteMetrics(Print& out);
+
+#endif
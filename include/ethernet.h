@@ -11,10 +11,28 @@
 
 static bool wifi_connected = false;
 
+#define EVENTS_QUEUE_LENGTH 16
+#define EVENTS_TASK_STACK 3072
+
 extern AsyncWebServer server;
+extern AsyncEventSource events;
+
+// Queue a server-sent event for /events; safe from any task. The render,
+// storage and OTA tasks all report here, and a single "events" task makes
+// every events.send() call, so the event source is only ever driven from
+// one context besides async_tcp. Dropped when the queue is full or before
+// ethernet_init()
+void eventsSend(const char* data, const char* event, uint32_t id = 0);
 
 void WiFiEvent(WiFiEvent_t event);
+
+// Mount LittleFS (formatting it if the mount fails), create /images and
+// the display cache directory and load the image catalog; false if the
+// filesystem is unusable
+bool storage_init();
+
+// Thumbnails, upload sessions, Wi-Fi AP and web server; needs storage_init()
 void ethernet_init();
-void displayImage(const char* filename);
+void displayImage(const char* filename, bool progressive = false);
 
 #endif
\ No newline at end of file
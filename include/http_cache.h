@@ -0,0 +1,39 @@
+#ifndef _HTTP_CACHE_H
+#define _HTTP_CACHE_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// Conditional GET support for the web server. Every file reply carries a
+// strong ETag and a Cache-Control policy; a request whose If-None-Match
+// names the current ETag gets an empty 304 instead of the body.
+//   Web assets (/index.html, /update/...; nothing else on LittleFS is
+//     served this way): ETag = CRC-32 of the stored file (the .gz copy when
+//     the build compressed it), computed once per boot; "no-cache", so the
+//     browser revalidates and a warm load costs one 304 per asset.
+//   Images and thumbnails: ETag from the catalog CRC. URLs carrying the
+//     current ?v=<crc> are immutable and cached for a year.
+// Assets are gzipped at build time (tools/gzip_data.py); the web server
+// sends name.gz with Content-Encoding: gzip when only that copy exists.
+
+#define HTTP_CACHE_ASSETS 8 // Web assets whose ETag is remembered
+#define HTTP_CACHE_IMMUTABLE "public, max-age=31536000, immutable"
+#define HTTP_CACHE_REVALIDATE "no-cache"
+#define HTTP_CACHE_NONE "no-store"
+
+// Reply with the web asset at path (or its .gz), or 304 when unchanged;
+// false for any other path
+bool httpServeAsset(AsyncWebServerRequest* request, const String& path);
+
+// Reply with a file whose ETag the caller knows (quoted, e.g. from the
+// catalog); size is only counted for the metrics
+void httpSendFile(AsyncWebServerRequest* request, const String& path, const char* contentType,
+                  const String& etag, const char* cacheControl, uint32_t size);
+
+// True when If-None-Match lists etag (or "*")
+bool httpNotModified(AsyncWebServerRequest* request, const String& etag);
+
+// Request counts and body bytes sent, for /metrics
+void httpCacheWriteMetrics(Print& out);
+
+#endif
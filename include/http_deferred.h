@@ -0,0 +1,24 @@
+#ifndef _HTTP_DEFERRED_H
+#define _HTTP_DEFERRED_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <functional>
+
+// Replies whose result comes from another task (the storage task, the
+// stream decoder). The handler returns at once with a response that sends
+// nothing yet; the server's poll of the connection (every 500 ms, from
+// AsyncTCP, on async_tcp) asks the result function again until it is ready,
+// then the status line, headers and body go out in one write. Nothing
+// blocks async_tcp, and nothing but async_tcp touches the request.
+//
+// The result function runs on async_tcp; it returns false while the result
+// is pending, or fills code and body (and should give up by itself after a
+// timeout). It is not called again after the client disconnects.
+
+typedef std::function<bool(int* code, String* body)> http_deferred_result_t;
+
+// Reply to request with contentType once result has one
+void httpSendDeferred(AsyncWebServerRequest* request, const char* contentType, http_deferred_result_t result);
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef _IMAGE_CATALOG_H
+#define _IMAGE_CATALOG_H
+
+#include <Arduino.h>
+
+// Persistent index of the files in an image directory. One fixed-size record
+// per file (name, size, mtime, CRC-32, format and dimensions) is kept in RAM
+// sorted by name, so lookups are a binary search and listings never touch
+// the filesystem. The records are mirrored to a catalog file that is replaced
+// atomically (written beside it, then renamed) on every change.
+// At startup the file is loaded and reconciled with one walk of the
+// directory: files whose size and mtime still match keep their record, the
+// rest are probed again. A missing or corrupt catalog is rebuilt that way.
+
+#define IMAGE_CATALOG_PATH "/images.cat"
+#define IMAGE_CATALOG_MAGIC 0x54414349 // "ICAT"
+#define IMAGE_CATALOG_VERSION 1
+#define IMAGE_CATALOG_NAME_MAX 64 // Including the terminator
+
+#ifndef IMAGE_CATALOG_MAX
+#define IMAGE_CATALOG_MAX 1024 // Records held; the directory may hold more
+#endif
+
+#ifndef IMAGE_CATALOG_PROBE_CHUNK
+#define IMAGE_CATALOG_PROBE_CHUNK 1024 // Read size while checksumming a file
+#endif
+
+typedef enum
+{
+	IMAGE_FORMAT_UNKNOWN = 0,
+	IMAGE_FORMAT_JPEG,
+	IMAGE_FORMAT_PNG,
+	IMAGE_FORMAT_ANIM,
+} image_format_t;
+
+typedef struct
+{
+	char name[IMAGE_CATALOG_NAME_MAX];
+	uint32_t size;
+	uint32_t mtime;
+	uint32_t crc; // CRC-32 (zlib polynomial) of the whole file
+	uint16_t width;
+	uint16_t height;
+	uint8_t format; // image_format_t
+	uint8_t reserved[3];
+} image_catalog_entry_t;
+
+// On-flash layout: this header, then count records in name order
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t record_size;
+	uint32_t count;
+	uint32_t crc; // CRC-32 of the records
+} image_catalog_header_t;
+
+typedef struct image_catalog image_catalog_t;
+
+// Catalog of IMAGE_LIST_DIR, created by imageCatalogInit()
+extern image_catalog_t* imageCatalog;
+
+void imageCatalogInit();
+
+// Load path and reconcile it with dir; never fails short of running out of memory
+image_catalog_t* imageCatalogOpen(const char* dir, const char* path);
+void imageCatalogClose(image_catalog_t* catalog);
+
+// Walk the directory and bring the records up to date; returns files probed
+uint32_t imageCatalogScan(image_catalog_t* catalog);
+
+bool imageCatalogLookup(image_catalog_t* catalog, const char* name, image_catalog_entry_t* out);
+bool imageCatalogContains(image_catalog_t* catalog, const char* name);
+
+// Record by position in name order; false past the end
+bool imageCatalogAt(image_catalog_t* catalog, uint32_t index, image_catalog_entry_t* out);
+uint32_t imageCatalogCount(image_catalog_t* catalog);
+
+// Bumped on every change, so readers can tell their view is stale
+uint32_t imageCatalogGeneration(image_catalog_t* catalog);
+
+// Insert or replace a record, or drop one, and persist the catalog
+bool imageCatalogUpdate(image_catalog_t* catalog, const image_catalog_entry_t* entry);
+bool imageCatalogRemove(image_catalog_t* catalog, const char* name);
+
+// Fill a record for a file of the catalog's directory. With crcKnown the
+// file is only opened for its header; otherwise it is read in full.
+bool imageCatalogProbe(image_catalog_t* catalog, const char* name, image_catalog_entry_t* out,
+                       bool crcKnown = false, uint32_t crc = 0);
+
+// Heap held by the records
+size_t imageCatalogMemory(image_catalog_t* catalog);
+
+// Incremental CRC-32, zlib convention: start with 0
+uint32_t imageCatalogCrc32(uint32_t crc, const uint8_t* data, size_t len);
+
+const char* imageFormatName(uint8_t format);
+
+#endif
@@ -5,20 +5,96 @@
 #include "LittleFS.h"
 #include <TJpg_Decoder.h>
 #include <PNGdec.h>
+#include "animation.h"
 
 extern Adafruit_ILI9341 tft;
 
+// PNG rows collected per SPI strip; bounded by the blit buffer size
+#ifndef PNG_STRIP_ROWS
+#define PNG_STRIP_ROWS 16
+#endif
+
+// Colour that transparent PNG pixels are blended against (RGB565)
+#ifndef PNG_BACKGROUND_COLOR
+#define PNG_BACKGROUND_COLOR ILI9341_BLACK
+#endif
+
+// Resampling filter for images that are not already panel-sized
+#ifndef IMAGE_SCALE_BILINEAR
+#define IMAGE_SCALE_BILINEAR 1
+#endif
+
+// Where a fitted image lands on the panel
+typedef struct
+{
+	int16_t x;
+	int16_t y;
+	uint16_t width;
+	uint16_t height;
+} image_placement_t;
+
 // Image display functions
-void displayImageFromFile(const char* filename);
-void displayImageWithScaling(const char* filename, bool centerImage = true);
+void displayImageFromFile(const char* filename, bool progressive = false);
+bool displayImageWithScaling(const char* filename, bool centerImage = true, bool progressive = false);
 void clearDisplay();
 
+// Creates the display lock; called once before any task can draw
+// (renderTaskInit(), ahead of the web server)
+void displayInit();
+
+// Held for a whole display operation; callers that draw several steps (e.g.
+// a transition plus the image) take it around all of them
+void displayLock();
+void displayUnlock();
+
+// displayLock() that gives up after timeoutMs; true when taken
+bool displayTryLock(uint32_t timeoutMs);
+
+// Called from the drawing task as the image fills in (percent of the frame,
+// in 10% steps); progressive JPEGs report the preview pass first
+typedef void (*display_progress_t)(uint8_t percent);
+void displaySetProgressCallback(display_progress_t callback);
+
+// Bytes of filename already in RAM; the next display of that file decodes
+// from them instead of LittleFS. Pass nullptr to drop it again.
+void displaySetPreloaded(const char* filename, const uint8_t* data, size_t size);
+
+// Decode straight to the panel, skipping the sidecar cache, the progressive
+// preview and the error screens (used by the benchmark)
+bool displayDecodeUncached(const char* filename, bool centerImage = true);
+
+// Play an .anim file as a display request of its own, at speedPercent and
+// for loops passes (see animationPlay; used by the benchmark)
+bool displayAnimation(const char* filename, uint16_t speedPercent = 100, uint16_t loops = 0,
+                      anim_stats_t* out = nullptr);
+
+// Pull-style input for displayDecodeJpegStream(): copy up to len bytes into
+// buf, waiting until some are available; 0 ends the data
+typedef size_t (*display_reader_t)(void* context, uint8_t* buf, size_t len);
+
+// Decode a JPEG to the panel while it arrives, from reader instead of a
+// file. Baseline JPEGs only; no sidecar cache or progressive preview
+bool displayDecodeJpegStream(display_reader_t reader, void* context, bool centerImage = true);
+
+// Decode fitted and centred into a width x height buffer of panel-order
+// RGB565 instead of the panel; JPEGs use the tjpgd 1/2..1/8 reduction
+bool displayRenderThumbnail(const char* filename, uint16_t* pixels, uint16_t width, uint16_t height);
+
+// Bytes the decoder pulled from its source for the last image
+uint32_t displayLastBytesRead();
+
+// Request sequencing - a new request makes any decode in progress stop early
+uint32_t displayRequestNew();
+bool displayRequestSuperseded();
+void computeImagePlacement(uint16_t srcW, uint16_t srcH, bool centerImage, image_placement_t* out);
+
 // PNG functions
-bool drawPNG(const char* filename, int16_t x, int16_t y);
+bool drawPNG(const char* filename, bool centerImage);
 int pngDraw(PNGDRAW *pDraw);
 
 // JPEG functions  
-bool drawJPEG(const char* filename, int16_t x, int16_t y);
+bool drawJPEG(const char* filename, bool centerImage);
+bool drawJPEGPreview(const char* filename, bool centerImage);
 bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap);
 
 // File reading functions
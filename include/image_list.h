@@ -0,0 +1,52 @@
+#ifndef _IMAGE_LIST_H
+#define _IMAGE_LIST_H
+
+#include <Arduino.h>
+
+// JSON listing of an image catalog, produced a piece at a time so it can
+// back a chunked HTTP response:
+//   {"images":[{"name":..,"size":..,"mtime":..,"format":..,"width":..,"height":..,"crc":..},...],
+//    "offset":..,"returned":..,"total":..,"stale":..}
+// Records come from the catalog's RAM index, never from the filesystem.
+// Name order (and no sort) is the catalog's own order and needs no state;
+// size and mtime orders take one small key per image, released with the
+// listing. If the catalog changes while a listing streams (an upload or a
+// delete), the entries end there and "stale" is true: fetch it again.
+
+#define IMAGE_LIST_DIR "/images"
+
+#define IMAGE_LIST_PIECE_MAX 320 // One escaped entry (63-byte name) fits
+
+typedef enum
+{
+	IMAGE_SORT_NONE = 0, // Catalog order, the same as by name
+	IMAGE_SORT_NAME,
+	IMAGE_SORT_SIZE,
+	IMAGE_SORT_MTIME,
+} image_sort_t;
+
+typedef struct
+{
+	uint32_t offset;
+	uint32_t limit; // 0 = everything after offset
+	image_sort_t sort;
+	bool descending;
+} image_list_query_t;
+
+typedef struct image_list image_list_t;
+typedef struct image_catalog image_catalog_t;
+
+// "name", "size", "mtime" or "" -> sort key; false for anything else
+bool imageListParseSort(const char* text, image_sort_t* sort);
+
+image_list_t* imageListOpen(image_catalog_t* catalog, const image_list_query_t* query, String* error);
+
+// Next bytes of the document; 0 once it is complete
+size_t imageListFill(image_list_t* list, uint8_t* buffer, size_t maxLen);
+
+// Heap held by the listing (state and sort keys)
+size_t imageListMemory(const image_list_t* list);
+
+void imageListClose(image_list_t* list);
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef _IMAGE_SCALER_H
+#define _IMAGE_SCALER_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Streaming fixed-point resampler for big-endian RGB565 rows.
+// Source rows are pushed top to bottom; each destination row is produced as
+// soon as the source rows it depends on have arrived, into memory handed out
+// by a target callback (normally a slot in the current SPI strip). Only the
+// previous source row is kept, so no frame buffer is needed. Like
+// pixel_convert.h this header builds on a Linux host.
+
+#ifndef IMAGE_SCALER_MAX_DST
+#define IMAGE_SCALER_MAX_DST 240 // Widest destination row (panel width)
+#endif
+
+typedef uint16_t* (*scaler_target_t)(void* user, uint16_t dstY);
+
+typedef struct
+{
+	uint16_t src_w;
+	uint16_t src_h;
+	uint16_t dst_w;
+	uint16_t dst_h;
+	uint32_t step_y;   // 16.16 source rows per destination row
+	bool bilinear;
+	uint16_t next_src; // Index of the next source row to be pushed
+	uint16_t next_dst; // Next destination row to produce
+	uint16_t* prev;    // Copy of the previous source row (bilinear only)
+	scaler_target_t target;
+	void* user;
+	uint16_t x0[IMAGE_SCALER_MAX_DST]; // Left source column per destination column
+	uint8_t fx[IMAGE_SCALER_MAX_DST];  // 5-bit weight of the right neighbour
+} image_scaler_t;
+
+namespace image_scaler {
+
+// RGB565 spread over 32 bits (G in the upper half) so one multiply scales
+// all three channels with a 5-bit weight
+static inline uint32_t spread(uint16_t be) {
+    uint16_t c = (uint16_t)((be << 8) | (be >> 8));
+    return (c | ((uint32_t)c << 16)) & 0x07E0F81Fu;
+}
+
+static inline uint16_t unspread(uint32_t v) {
+    uint16_t c = (uint16_t)(v | (v >> 16));
+    return (uint16_t)((c << 8) | (c >> 8));
+}
+
+static inline uint32_t lerp(uint32_t a, uint32_t b, uint32_t w) {
+    return ((a * (32 - w) + b * w) >> 5) & 0x07E0F81Fu;
+}
+
+// 16.16 source coordinate of destination index d. Bilinear samples at pixel
+// centres; nearest picks the source pixel containing the centre.
+static inline uint32_t sourcePos(uint32_t d, uint32_t step, bool bilinear) {
+    int32_t pos = (int32_t)(d * step + step / 2);
+    if (bilinear) {
+        pos -= 0x8000;
+    }
+    return pos < 0 ? 0 : (uint32_t)pos;
+}
+
+static inline void nearestRow(const image_scaler_t* sc, const uint16_t* row, uint16_t* dst) {
+    for (uint16_t x = 0; x < sc->dst_w; x++) {
+        dst[x] = row[sc->x0[x]];
+    }
+}
+
+static inline void bilinearRow(const image_scaler_t* sc, const uint16_t* top, const uint16_t* bottom, uint32_t fy, uint16_t* dst) {
+    uint16_t last = sc->src_w - 1;
+    for (uint16_t x = 0; x < sc->dst_w; x++) {
+        uint16_t x0 = sc->x0[x];
+        uint16_t x1 = x0 < last ? x0 + 1 : last;
+        uint32_t w = sc->fx[x];
+        uint32_t t = lerp(spread(top[x0]), spread(top[x1]), w);
+        uint32_t b = lerp(spread(bottom[x0]), spread(bottom[x1]), w);
+        dst[x] = unspread(lerp(t, b, fy));
+    }
+}
+
+} // namespace image_scaler
+
+// tjpgd reduction (1, 2, 4 or 8) for a srcW x srcH JPEG fitted to fitW x
+// fitH: the coarsest whose output still covers the fit, so the resampler
+// only ever shrinks what the decoder hands it
+static inline uint8_t scalerJpegScale(uint16_t srcW, uint16_t srcH, uint16_t fitW, uint16_t fitH) {
+    uint8_t scale = 1;
+    while (scale < 8 && srcW / (scale * 2) >= fitW && srcH / (scale * 2) >= fitH) {
+        scale *= 2;
+    }
+    return scale;
+}
+
+// prevRow must hold srcW pixels when bilinear is set (unused otherwise)
+static inline bool scalerInit(image_scaler_t* sc, uint16_t srcW, uint16_t srcH, uint16_t dstW, uint16_t dstH,
+                              bool bilinear, uint16_t* prevRow, scaler_target_t target, void* user) {
+    if (!srcW || !srcH || !dstW || !dstH || dstW > IMAGE_SCALER_MAX_DST || (bilinear && !prevRow)) {
+        return false;
+    }
+    sc->src_w = srcW;
+    sc->src_h = srcH;
+    sc->dst_w = dstW;
+    sc->dst_h = dstH;
+    sc->step_y = ((uint32_t)srcH << 16) / dstH;
+    sc->bilinear = bilinear;
+    sc->next_src = 0;
+    sc->next_dst = 0;
+    sc->prev = prevRow;
+    sc->target = target;
+    sc->user = user;
+
+    uint32_t stepX = ((uint32_t)srcW << 16) / dstW;
+    for (uint16_t x = 0; x < dstW; x++) {
+        uint32_t pos = image_scaler::sourcePos(x, stepX, bilinear);
+        uint16_t x0 = (uint16_t)(pos >> 16);
+        sc->x0[x] = x0 < srcW ? x0 : srcW - 1;
+        sc->fx[x] = bilinear ? (uint8_t)((pos >> 11) & 0x1F) : 0;
+    }
+    return true;
+}
+
+// Feed the next source row; emits every destination row it completes
+static inline void scalerPushRow(image_scaler_t* sc, const uint16_t* row) {
+    uint16_t sy = sc->next_src;
+    if (sy >= sc->src_h) {
+        return;
+    }
+    uint16_t last = sc->src_h - 1;
+
+    while (sc->next_dst < sc->dst_h) {
+        uint32_t pos = image_scaler::sourcePos(sc->next_dst, sc->step_y, sc->bilinear);
+        uint16_t y0 = (uint16_t)(pos >> 16);
+        if (y0 > last) {
+            y0 = last;
+        }
+        if (!sc->bilinear) {
+            if (y0 > sy) {
+                break;
+            }
+            image_scaler::nearestRow(sc, row, sc->target(sc->user, sc->next_dst));
+        } else {
+            uint16_t y1 = y0 < last ? y0 + 1 : last;
+            if (y1 > sy) {
+                break;
+            }
+            const uint16_t* top = (y0 == sy) ? row : sc->prev;
+            uint32_t fy = (y0 == y1) ? 0 : (pos >> 11) & 0x1F;
+            image_scaler::bilinearRow(sc, top, row, fy, sc->target(sc->user, sc->next_dst));
+        }
+        sc->next_dst++;
+    }
+
+    if (sc->bilinear) {
+        memcpy(sc->prev, row, (size_t)sc->src_w * 2);
+    }
+    sc->next_src++;
+}
+
+#endif
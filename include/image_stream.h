@@ -0,0 +1,63 @@
+#ifndef _IMAGE_STREAM_H
+#define _IMAGE_STREAM_H
+
+#include <Arduino.h>
+
+class AsyncClient;
+
+// POST /stream: a JPEG request body drawn while it arrives. Body chunks go
+// from the async_tcp callback into a ring buffer; a short-lived "stream"
+// task pulls from it through tjpgd (displayDecodeJpegStream), so MCU rows
+// reach the panel as soon as their bytes are in. With ?save=NAME the same
+// chunks also feed an upload session, persisting the file in the same pass.
+// When the ring runs low the client's receive window is held back
+// (AsyncClient::ackLater) until the decoder has caught up; async_tcp never
+// waits on the ring. One stream at a time; the display lock is held from the
+// first byte to the last pixel.
+
+#ifndef IMAGE_STREAM_RING_SIZE
+#define IMAGE_STREAM_RING_SIZE (12 * 1024)
+#endif
+
+// Reception pauses below this much free ring space: one TCP window (5744
+// bytes with the default lwIP settings) must still fit
+#define IMAGE_STREAM_PAUSE_FREE 6144
+
+#define IMAGE_STREAM_TASK_STACK 6144
+#define IMAGE_STREAM_IDLE_MS 5000     // No data for this long ends the decode
+#define IMAGE_STREAM_TIMEOUT_MS 10000 // Decode tail after the last byte
+
+typedef struct
+{
+	bool shown;
+	bool saved;
+	uint32_t bytes;
+	uint32_t crc;         // Of the body, for the catalog when saved
+	uint32_t transfer_ms; // First to last body byte
+	uint32_t decode_ms;   // Decoder start to last pixel
+	uint32_t tail_ms;     // Last body byte to last pixel
+	uint32_t total_ms;    // First body byte to last pixel
+	uint32_t pauses;
+} image_stream_result_t;
+
+// Start a stream for the request on client; saveName (or nullptr) is the
+// /images file to write as well, expected its size when known. Returns the
+// stream id, or 0 when another stream is running or memory is short
+uint32_t imageStreamBegin(AsyncClient* client, const char* saveName, size_t expected);
+void imageStreamWrite(uint32_t id, const uint8_t* data, size_t len);
+
+// No more body: complete when all of it arrived (the file is committed),
+// otherwise the connection dropped (the file is discarded)
+void imageStreamEnd(uint32_t id, bool complete);
+
+// Result once the decoder (and the file) finished; false while pending.
+// Never blocks, so it can be polled from async_tcp
+bool imageStreamResult(uint32_t id, image_stream_result_t* out);
+
+// The request is gone; the stream is freed once the decoder is done too
+void imageStreamRelease(uint32_t id);
+
+// Stream counts and last timings, for /metrics
+void imageStreamWriteMetrics(Print& out);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef _OTA_IMAGE_H
+#define _OTA_IMAGE_H
+
+#include <Arduino.h>
+
+// Firmware and filesystem images on their way into Update. The data may be
+// the plain .bin or a gzip of it (tools/ota_pack.py), told apart by the gzip
+// magic; gzip is inflated as it arrives with the ROM inflater, whose window
+// of OTA_INFLATE_WINDOW bytes doubles as the output buffer, so memory stays
+// bounded whatever the image size. The gzip CRC-32 and length are checked
+// at the end.
+//
+// When the manifest's SHA-256 (and size) of the image are given, the bytes
+// written to flash are hashed on the way and compared before Update.end()
+// marks the partition bootable; a mismatch aborts the update, so a bad image
+// is never booted. Progress is reported every OTA_PROGRESS_STEP bytes
+// written.
+
+#define OTA_INFLATE_WINDOW 32768 // Deflate's largest distance (TINFL_LZ_DICT_SIZE)
+#define OTA_SHA256_SIZE 32
+
+#ifndef OTA_PROGRESS_STEP
+#define OTA_PROGRESS_STEP (64 * 1024)
+#endif
+
+typedef enum
+{
+	OTA_OK = 0,
+	OTA_NO_MEMORY,
+	OTA_BEGIN_FAILED,  // Update.begin(): no partition, or the image does not fit
+	OTA_BAD_DATA,      // Corrupt or truncated gzip (stream, CRC-32 or length)
+	OTA_WRITE_FAILED,
+	OTA_SIZE_MISMATCH, // Image length differs from the manifest
+	OTA_HASH_MISMATCH, // SHA-256 differs from the manifest
+	OTA_END_FAILED     // Update.end() rejected the image
+} ota_status_t;
+
+typedef struct ota_image ota_image_t;
+
+typedef struct
+{
+	ota_status_t status;
+	bool compressed;
+	bool verified;     // Matched the manifest's SHA-256
+	bool finished;     // Last report for this image
+	uint32_t received; // Bytes of upload, compressed or not
+	uint32_t written;  // Image bytes written to flash
+	uint32_t expected; // Image size from the manifest, 0 when unknown
+	uint8_t percent;   // Of expected, when known
+	uint32_t elapsed_ms;
+	uint32_t in_kbps;  // Upload bytes per second, in KB
+	uint32_t out_kbps; // Flash bytes per second, in KB
+} ota_progress_t;
+
+typedef void (*ota_progress_callback_t)(const ota_progress_t* progress);
+
+// Called on the task that writes the image (the storage task)
+void otaSetProgressCallback(ota_progress_callback_t callback);
+
+// 64 hex digits into out; false if malformed
+bool otaParseSha256(const char* hex, uint8_t* out);
+
+// Start an update of command (U_FLASH or U_SPIFFS). sha256 (optional) and
+// size (0: unknown) come from the manifest. Returns nullptr only when out
+// of memory; otherwise check otaImageStatus()
+ota_image_t* otaImageBegin(int command, const uint8_t* sha256, uint32_t size);
+
+ota_status_t otaImageWrite(ota_image_t* ota, const uint8_t* data, size_t len);
+
+// All data arrived: check gzip trailer, size and hash, then Update.end()
+ota_status_t otaImageFinish(ota_image_t* ota);
+
+// Aborts the update unless it finished
+void otaImageFree(ota_image_t* ota);
+
+ota_status_t otaImageStatus(const ota_image_t* ota);
+void otaImageProgress(const ota_image_t* ota, ota_progress_t* out);
+const char* otaStatusText(ota_status_t status);
+
+// The final report of the last update (all zero before the first)
+void otaLastProgress(ota_progress_t* out);
+
+// Update counts and the last update's sizes and throughput, for /metrics
+void otaWriteMetrics(Print& out);
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef _PIXEL_CONVERT_H
+#define _PIXEL_CONVERT_H
+
+#include <stdint.h>
+#include <string.h>
+
+// PNG scanline -> big-endian RGB565 conversion kernels.
+// One kernel is instantiated per PNG pixel type and bit depth and picked once
+// per image, so the per-row path has no format branches. Kernels emit two
+// pixels per 32-bit store. This header has no Arduino dependencies so it can
+// be built and benchmarked on a Linux host.
+
+// PNG colour types (IHDR), same values as PNGdec's PNG_PIXEL_*
+#define PIXEL_TYPE_GRAYSCALE 0
+#define PIXEL_TYPE_TRUECOLOR 2
+#define PIXEL_TYPE_INDEXED 3
+#define PIXEL_TYPE_GRAY_ALPHA 4
+#define PIXEL_TYPE_TRUECOLOR_ALPHA 6
+
+typedef struct
+{
+	const uint16_t* lut; // Palette/gray lookup table, big-endian RGB565 (256 entries)
+	uint8_t bg_r;        // Background for alpha blending, 8-bit per channel
+	uint8_t bg_g;
+	uint8_t bg_b;
+} pixel_context_t;
+
+typedef void (*pixel_row_kernel_t)(const uint8_t* src, uint16_t* dst, int width, const pixel_context_t* ctx);
+
+namespace pixel_convert {
+
+// Host-order RGB565 from 8-bit channels
+static inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// Two host-order pixels -> one word holding both in panel byte order
+static inline uint32_t packPair(uint16_t first, uint16_t second) {
+    uint32_t w = (uint32_t)first | ((uint32_t)second << 16);
+    return ((w & 0x00FF00FFu) << 8) | ((w >> 8) & 0x00FF00FFu);
+}
+
+static inline void storePair(uint16_t* dst, uint32_t pair) {
+    memcpy(dst, &pair, 4);
+}
+
+// (c * a + bg * (255 - a)) / 255 without a divide
+static inline uint8_t blend(uint8_t c, uint8_t a, uint8_t bg) {
+    uint32_t t = (uint32_t)c * a + (uint32_t)bg * (255 - a) + 128;
+    return (uint8_t)((t + (t >> 8)) >> 8);
+}
+
+// Direct-colour rows: Channels samples of BytesPerSample bytes each; for
+// 16-bit samples only the most significant (first) byte is used.
+template <int Channels, int BytesPerSample, bool Alpha>
+struct DirectRow
+{
+    static const int kStride = Channels * BytesPerSample;
+
+    static inline uint16_t pixel(const uint8_t* p, const pixel_context_t* ctx) {
+        uint8_t r, g, b;
+        if (Channels >= 3) {
+            r = p[0];
+            g = p[BytesPerSample];
+            b = p[2 * BytesPerSample];
+        } else {
+            r = g = b = p[0];
+        }
+        if (Alpha) {
+            uint8_t a = p[(Channels - 1) * BytesPerSample];
+            if (a != 255) {
+                r = blend(r, a, ctx->bg_r);
+                g = blend(g, a, ctx->bg_g);
+                b = blend(b, a, ctx->bg_b);
+            }
+        }
+        return rgb565(r, g, b);
+    }
+
+    static void run(const uint8_t* src, uint16_t* dst, int width, const pixel_context_t* ctx) {
+        int x = 0;
+        for (; x + 1 < width; x += 2) {
+            uint16_t c0 = pixel(src, ctx);
+            uint16_t c1 = pixel(src + kStride, ctx);
+            storePair(dst + x, packPair(c0, c1));
+            src += 2 * kStride;
+        }
+        if (x < width) {
+            uint16_t c = pixel(src, ctx);
+            dst[x] = (uint16_t)((c << 8) | (c >> 8));
+        }
+    }
+};
+
+// 8-bit RGB gets its own kernel: four pixels come out of three 32-bit loads
+struct Rgb888Row
+{
+    static void run(const uint8_t* src, uint16_t* dst, int width, const pixel_context_t* ctx) {
+        int x = 0;
+        for (; x + 3 < width; x += 4) {
+            uint32_t w0, w1, w2; // R0 G0 B0 R1 | G1 B1 R2 G2 | B2 R3 G3 B3
+            memcpy(&w0, src, 4);
+            memcpy(&w1, src + 4, 4);
+            memcpy(&w2, src + 8, 4);
+            uint16_t c0 = rgb565(w0, w0 >> 8, w0 >> 16);
+            uint16_t c1 = rgb565(w0 >> 24, w1, w1 >> 8);
+            uint16_t c2 = rgb565(w1 >> 16, w1 >> 24, w2);
+            uint16_t c3 = rgb565(w2 >> 8, w2 >> 16, w2 >> 24);
+            storePair(dst + x, packPair(c0, c1));
+            storePair(dst + x + 2, packPair(c2, c3));
+            src += 12;
+        }
+        DirectRow<3, 1, false>::run(src, dst + x, width - x, ctx);
+    }
+};
+
+// Indexed and grayscale rows: Depth-bit samples looked up in ctx->lut.
+// Sub-byte samples are packed MSB first as PNG stores them.
+template <int Depth>
+struct LutRow
+{
+    static const int kPerByte = 8 / Depth;
+    static const uint8_t kMask = (uint8_t)((1 << Depth) - 1);
+
+    static void run(const uint8_t* src, uint16_t* dst, int width, const pixel_context_t* ctx) {
+        const uint16_t* lut = ctx->lut;
+        int x = 0;
+        for (; x + kPerByte <= width; x += kPerByte) {
+            uint8_t v = *src++;
+            for (int i = 0; i < kPerByte; i++) {
+                dst[x + i] = lut[(v >> (8 - Depth * (i + 1))) & kMask];
+            }
+        }
+        if (x < width) {
+            uint8_t v = *src;
+            for (int i = 0; x < width; i++, x++) {
+                dst[x] = lut[(v >> (8 - Depth * (i + 1))) & kMask];
+            }
+        }
+    }
+};
+
+// 8-bit indices: four lookups per 32-bit load, two pixels per store
+template <>
+struct LutRow<8>
+{
+    static void run(const uint8_t* src, uint16_t* dst, int width, const pixel_context_t* ctx) {
+        const uint16_t* lut = ctx->lut;
+        int x = 0;
+        for (; x + 3 < width; x += 4) {
+            uint32_t idx;
+            memcpy(&idx, src + x, 4);
+            uint32_t p0 = (uint32_t)lut[idx & 0xFF] | ((uint32_t)lut[(idx >> 8) & 0xFF] << 16);
+            uint32_t p1 = (uint32_t)lut[(idx >> 16) & 0xFF] | ((uint32_t)lut[idx >> 24] << 16);
+            storePair(dst + x, p0);
+            storePair(dst + x + 2, p1);
+        }
+        for (; x < width; x++) {
+            dst[x] = lut[src[x]];
+        }
+    }
+};
+
+// 16-bit grayscale: high byte through the 8-bit gray table
+struct Gray16Row
+{
+    static void run(const uint8_t* src, uint16_t* dst, int width, const pixel_context_t* ctx) {
+        for (int x = 0; x < width; x++) {
+            dst[x] = ctx->lut[src[2 * x]];
+        }
+    }
+};
+
+} // namespace pixel_convert
+
+// Kernel for a PNG colour type / bit depth pair, or nullptr if unsupported
+static inline pixel_row_kernel_t pixelSelectRowKernel(uint8_t pixelType, uint8_t bitDepth) {
+    using namespace pixel_convert;
+    switch (pixelType) {
+    case PIXEL_TYPE_TRUECOLOR:
+        return bitDepth == 8 ? Rgb888Row::run : bitDepth == 16 ? DirectRow<3, 2, false>::run : nullptr;
+    case PIXEL_TYPE_TRUECOLOR_ALPHA:
+        return bitDepth == 8 ? DirectRow<4, 1, true>::run : bitDepth == 16 ? DirectRow<4, 2, true>::run : nullptr;
+    case PIXEL_TYPE_GRAY_ALPHA:
+        return bitDepth == 8 ? DirectRow<2, 1, true>::run : bitDepth == 16 ? DirectRow<2, 2, true>::run : nullptr;
+    case PIXEL_TYPE_INDEXED:
+    case PIXEL_TYPE_GRAYSCALE:
+        switch (bitDepth) {
+        case 1: return LutRow<1>::run;
+        case 2: return LutRow<2>::run;
+        case 4: return LutRow<4>::run;
+        case 8: return LutRow<8>::run;
+        case 16: return pixelType == PIXEL_TYPE_GRAYSCALE ? Gray16Row::run : nullptr;
+        }
+        return nullptr;
+    }
+    return nullptr;
+}
+
+// Background colour (host-order RGB565) for alpha blending
+static inline void pixelSetBackground(pixel_context_t* ctx, uint16_t color) {
+    ctx->bg_r = (uint8_t)(((color >> 11) & 0x1F) * 255 / 31);
+    ctx->bg_g = (uint8_t)(((color >> 5) & 0x3F) * 255 / 63);
+    ctx->bg_b = (uint8_t)((color & 0x1F) * 255 / 31);
+}
+
+// 256-entry LUT from a PLTE chunk (RGB triplets, then tRNS alpha at +768 when
+// hasAlpha); transparent entries are pre-blended against the background.
+static inline void pixelBuildPaletteLut(uint16_t* lut, const uint8_t* palette, bool hasAlpha, const pixel_context_t* ctx) {
+    using namespace pixel_convert;
+    for (int i = 0; i < 256; i++) {
+        uint8_t r = palette[i * 3];
+        uint8_t g = palette[i * 3 + 1];
+        uint8_t b = palette[i * 3 + 2];
+        if (hasAlpha) {
+            uint8_t a = palette[768 + i];
+            r = blend(r, a, ctx->bg_r);
+            g = blend(g, a, ctx->bg_g);
+            b = blend(b, a, ctx->bg_b);
+        }
+        uint16_t c = rgb565(r, g, b);
+        lut[i] = (uint16_t)((c << 8) | (c >> 8));
+    }
+}
+
+// Gray ramp for a 1/2/4/8-bit grayscale image (16-bit uses the 8-bit ramp)
+static inline void pixelBuildGrayLut(uint16_t* lut, uint8_t bitDepth) {
+    int levels = bitDepth >= 8 ? 256 : (1 << bitDepth);
+    for (int i = 0; i < levels; i++) {
+        uint8_t v = (uint8_t)(i * 255 / (levels - 1));
+        uint16_t c = pixel_convert::rgb565(v, v, v);
+        lut[i] = (uint16_t)((c << 8) | (c >> 8));
+    }
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef _PLAYLIST_H
+#define _PLAYLIST_H
+
+#include <Arduino.h>
+
+// Slideshow of stored images. The list lives in PLAYLIST_PATH as one item per
+// line of at most 127 characters, "<name> <dwell ms> [cut|scroll]", '#'
+// starting a comment; "scroll" is the only transition effect, "cut" (the
+// default) just draws the next image. A task shows each item for its dwell
+// time and, while it is on screen, loads the next file into RAM so the
+// following transition starts without flash I/O.
+
+#define PLAYLIST_PATH "/playlist.txt"
+
+#ifndef PLAYLIST_MAX_ITEMS
+#define PLAYLIST_MAX_ITEMS 32
+#endif
+
+#ifndef PLAYLIST_MAX_TEXT
+#define PLAYLIST_MAX_TEXT 4096 // Largest playlist file accepted over HTTP
+#endif
+
+#ifndef PLAYLIST_DEFAULT_DWELL_MS
+#define PLAYLIST_DEFAULT_DWELL_MS 5000
+#endif
+
+#ifndef PLAYLIST_MIN_DWELL_MS
+#define PLAYLIST_MIN_DWELL_MS 200
+#endif
+
+#ifndef PLAYLIST_PREFETCH_MAX
+#define PLAYLIST_PREFETCH_MAX (64 * 1024) // Larger files are decoded from flash
+#endif
+
+#ifndef PLAYLIST_HEAP_RESERVE
+#define PLAYLIST_HEAP_RESERVE (40 * 1024) // Left free for the web server and decoder
+#endif
+
+#define PLAYLIST_TASK_STACK 8192
+#define PLAYLIST_TIMING_HISTORY 8
+
+typedef enum
+{
+	PLAYLIST_TRANSITION_CUT = 0, // Plain redraw (only changed tiles for cached frames)
+	PLAYLIST_TRANSITION_SCROLL,  // New frame slides up via hardware scrolling
+} playlist_transition_t;
+
+typedef struct
+{
+	char name[64];
+	uint32_t dwell_ms;
+	playlist_transition_t transition;
+} playlist_item_t;
+
+// One shown item: when it was due, when it was actually complete on screen
+typedef struct
+{
+	uint8_t index;
+	bool prefetched;
+	uint32_t scheduled_ms;
+	uint32_t shown_ms;
+	uint32_t draw_ms;
+} playlist_timing_t;
+
+typedef struct
+{
+	uint32_t shown;
+	uint32_t prefetched;
+	uint32_t failed;
+	int32_t late_max_ms;
+	int64_t late_total_ms;
+	uint32_t draw_max_ms;
+	uint64_t draw_total_ms;
+} playlist_stats_t;
+
+void playlistInit();
+bool playlistLoad();
+bool playlistSave(const char* text, size_t len, String* error);
+void playlistStart();
+void playlistStop();
+bool playlistRunning();
+
+// JSON documents for the HTTP API
+String playlistItemsJson();
+String playlistStatusJson();
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef _RECT_UPDATE_H
+#define _RECT_UPDATE_H
+
+#include <Arduino.h>
+
+// Partial screen updates over the RECT_SOCKET_PATH WebSocket. Every binary
+// message redraws one rectangle of the panel:
+//
+//   offset size
+//   0      1    type, RECT_MSG_TYPE
+//   1      1    encoding (rect_encoding_t)
+//   2      2    seq, echoed in the reply
+//   4      2    x
+//   6      2    y
+//   8      2    width
+//   10     2    height
+//   12     ...  pixels, row by row
+//
+// Header fields are little-endian; pixels are RGB565 in panel order (big-
+// endian), so raw payloads go to the SPI strip unchanged. RLE codes runs of
+// 16-bit pixels: a control byte c with bit 7 set repeats the next pixel
+// (c & 0x7f) + 1 times, otherwise c + 1 literal pixels follow. DELTA is RLE
+// over each pixel XORed with the one above it (the first row with 0), which
+// turns rows repeating the previous one into a single run.
+//
+// The payload is decoded as it arrives, straight into the tft_blit strip
+// buffers; the rectangle is never held in full. The panel is taken for the
+// whole message, so a message split over several TCP segments keeps other
+// drawing out until its last byte, or until the sender has been silent for
+// RECT_IDLE_TIMEOUT_MS: then the message is closed as "timeout" and the rest
+// of it is dropped. Each message is answered with a text
+// frame {"seq":..,"status":"ok","px":..,"us":..} once it is on the panel.
+
+#define RECT_SOCKET_PATH "/ws"
+#define RECT_MAX_CLIENTS 2
+
+#define RECT_MSG_TYPE 0x01
+#define RECT_HEADER_SIZE 12
+
+#ifndef RECT_LOCK_TIMEOUT_MS
+#define RECT_LOCK_TIMEOUT_MS 50 // Longer than this behind a render: busy
+#endif
+
+#ifndef RECT_IDLE_TIMEOUT_MS
+#define RECT_IDLE_TIMEOUT_MS 2000 // Open message without new bytes this long: timeout
+#endif
+
+typedef enum
+{
+	RECT_ENCODING_RAW = 0,
+	RECT_ENCODING_RLE = 1,
+	RECT_ENCODING_DELTA = 2
+} rect_encoding_t;
+
+typedef enum
+{
+	RECT_OK = 0,
+	RECT_BUSY,       // The panel stayed locked, or another client's message is open
+	RECT_BAD_HEADER, // Unknown type or encoding, or fewer than 12 bytes
+	RECT_BAD_RECT,   // Empty or outside the panel
+	RECT_SHORT,      // Message ended before the last pixel
+	RECT_LONG,       // Bytes left after the last pixel
+	RECT_NO_MEMORY,
+	RECT_TIMEOUT     // Sender went quiet part way; the panel was released
+} rect_status_t;
+
+typedef struct
+{
+	rect_status_t status;
+	uint16_t seq;
+	uint32_t pixels; // Drawn, also when the message failed part way
+	uint32_t bytes;
+	uint32_t us;     // First byte to the last pixel on the panel
+} rect_result_t;
+
+// One message at a time through the decoder: Begin, any number of Writes
+// with the bytes in order, then End, which draws whatever complete rows
+// arrived and releases the panel. /ws keeps one; animation frames use their
+// own. A caller already holding displayLock() is never refused as busy
+typedef struct rect_decoder rect_decoder_t;
+
+rect_decoder_t* rectDecoderCreate();
+void rectDecoderFree(rect_decoder_t* decoder);
+void rectDecoderBegin(rect_decoder_t* decoder);
+void rectDecoderWrite(rect_decoder_t* decoder, const uint8_t* data, size_t len);
+void rectDecoderEnd(rect_decoder_t* decoder, rect_result_t* out);
+
+// Feed part of a message from owner (a client id). first marks the start of
+// a message, last its end; out is filled and true returned once it ended
+bool rectUpdateWrite(uint32_t owner, const uint8_t* data, size_t len, bool first, bool last, rect_result_t* out);
+
+// owner went away; a message it left open is closed and the panel released
+void rectUpdateAbort(uint32_t owner);
+
+// Close the open message once it has been idle for RECT_IDLE_TIMEOUT_MS.
+// Must run where rectUpdateWrite() does (it may release the panel lock), so
+// /ws calls it from the poll of each of its connections
+void rectUpdatePoll();
+
+const char* rectStatusText(rect_status_t status);
+
+// Message, pixel and byte counts and latencies, for /metrics
+void rectUpdateWriteMetrics(Print& out);
+
+#endif
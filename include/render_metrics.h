@@ -0,0 +1,45 @@
+#ifndef _RENDER_METRICS_H
+#define _RENDER_METRICS_H
+
+#include <Arduino.h>
+
+// Fixed-size timing histograms for the display path. Each sample costs a
+// count-leading-zeros and a few adds: bucket k holds durations below 2^k us.
+// Samples come from the task holding the display lock (and the render task
+// for end-to-end latency), so no locking is done; a concurrent /metrics read
+// may see a histogram mid-update.
+
+#define METRICS_BUCKETS 24 // 1 us .. 8 s
+
+typedef enum
+{
+	METRIC_FILE_OPEN = 0, // LittleFS open of the image file
+	METRIC_READ,          // One decoder read callback
+	METRIC_DECODE,        // Per image: decode CPU time (total minus reads and SPI)
+	METRIC_SPI_PUSH,      // Per image: time spent queueing and waiting for SPI
+	METRIC_END_TO_END,    // HTTP request received -> last pixel on the panel
+	METRIC_COUNT
+} metric_stage_t;
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t max_us;
+	uint64_t sum_us;
+	uint32_t buckets[METRICS_BUCKETS];
+} metrics_histogram_t;
+
+void metricsRecord(metric_stage_t stage, uint32_t us);
+
+// Decoder input: one read of bytes that took us
+void metricsCountRead(uint32_t bytes, uint32_t us);
+
+// Bracket one displayed image; fromCache marks a sidecar draw (no decode)
+void metricsImageBegin();
+void metricsImageEnd(bool fromCache, uint32_t totalUs, uint32_t spiUs, uint32_t pixels);
+
+// Text exposition (Prometheus style) of all histograms, counters, heap,
+// task stacks and filesystem usage
+void metricsWrite(Print& out);
+
+#endif
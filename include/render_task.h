@@ -0,0 +1,37 @@
+#ifndef _RENDER_TASK_H
+#define _RENDER_TASK_H
+
+#include <Arduino.h>
+
+// Display requests from the web server are drawn by their own task. The
+// queue holds a single pending job that each new request overwrites, so
+// only the newest request waiting behind the current render ever runs.
+// Job state is pushed to browsers as "render" server-sent events on
+// RENDER_EVENTS_PATH.
+
+#define RENDER_EVENTS_PATH "/events"
+#define RENDER_TASK_STACK 8192
+
+typedef struct
+{
+	uint32_t id;
+	char name[64];
+	bool progressive;
+	int64_t received_us; // When the HTTP request arrived, for end-to-end latency
+} render_job_t;
+
+// Thumbnails are made by a second, lower-priority task from a queue of
+// file names, so an upload reply never waits for a decode. It shares the
+// decoder with the render task through displayLock().
+#define THUMB_QUEUE_LENGTH 8
+#define THUMB_TASK_STACK 6144
+
+void renderTaskInit();
+
+// Queue filename for display; returns the job id (0 if the name is too long)
+uint32_t renderSubmit(const char* filename, bool progressive);
+
+// Queue filename for thumbnail generation; false if the queue is full
+bool renderQueueThumbnail(const char* filename);
+
+#endif
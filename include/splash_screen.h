@@ -8,6 +8,8 @@ extern Adafruit_ILI9341 tft;
 
 // Splash screen and QR code functions
 void showSplashScreen();
+// Fill the splash progress bar; 100 also prints "Ready!"
+void splashScreenProgress(uint8_t percent);
 void showQRCodes();
 void drawQRCode(QRCode *qrcode, int x, int y, int scale);
 void generateWiFiQRCode();
@@ -0,0 +1,52 @@
+#ifndef _TFT_BLIT_H
+#define _TFT_BLIT_H
+
+#include <Arduino.h>
+#include <Adafruit_ILI9341.h>
+
+extern Adafruit_ILI9341 tft;
+
+// Ping-pong strip pipeline between the image decoders and the ILI9341.
+// The caller fills tftBlitBuffer() with big-endian (panel order) RGB565 and
+// commits it as a rectangle; the buffer is then shifted out by SPI DMA while
+// the caller fills the other half. Strips that continue the previous one
+// (same x/width, next row) reuse the open address window.
+
+#ifndef TFT_BLIT_USE_DMA
+#define TFT_BLIT_USE_DMA 1
+#endif
+
+#ifndef TFT_SPI_FREQ
+#define TFT_SPI_FREQ 40000000
+#endif
+
+#ifndef TFT_BLIT_STRIP_ROWS
+#define TFT_BLIT_STRIP_ROWS 16 // One JPEG MCU row / one PNG strip (2 x 7.5 KB on the C3)
+#endif
+#define TFT_BLIT_BUFFER_PIXELS (ILI9341_TFTWIDTH * TFT_BLIT_STRIP_ROWS)
+
+typedef struct
+{
+	uint32_t windows;      // Address window setups (CASET/PASET/RAMWR)
+	uint32_t transfers;    // Pixel transfers queued
+	uint32_t pixels;       // Pixels pushed
+	uint32_t wait_us;      // Time spent waiting for a previous transfer
+	uint32_t push_us;      // Time spent in commit/end (queueing, window setup, waits)
+} tft_blit_stats_t;
+
+void tftBlitInit();
+bool tftBlitBegin();
+uint16_t* tftBlitBuffer();
+void tftBlitCommit(int16_t x, int16_t y, uint16_t w, uint16_t h);
+void tftBlitEnd();
+
+// Scroll-in transition: while enabled, the panel's vertical scroll start
+// follows the lowest row committed so far, so a frame drawn top to bottom
+// slides up from the bottom edge over the old one (VSCRSADD only, no extra
+// pixel traffic). The scroll start is back at 0 after tftBlitEnd().
+void tftBlitSetScrollIn(bool enable);
+
+void tftBlitResetStats();
+const tft_blit_stats_t* tftBlitStats();
+
+#endif
@@ -13,6 +13,24 @@ extern Adafruit_ILI9341 tft;
 #define TFT_DEBUG_LINE_HEIGHT 12    // Line height in pixels
 #define TFT_DEBUG_MAX_CHARS 40      // Max characters per line (240/6)
 
+// The header stays in the ILI9341's fixed top area; log lines live in the
+// hardware scrolling area below it, so a new line is one line-height fill
+// plus its glyphs and a VSCRSADD write
+#define TFT_DEBUG_HEADER_LINES 2
+#define TFT_DEBUG_SCROLL_LINES (TFT_DEBUG_LINES - TFT_DEBUG_HEADER_LINES)
+#define TFT_DEBUG_TOP_PX (TFT_DEBUG_HEADER_LINES * TFT_DEBUG_LINE_HEIGHT)
+#define TFT_DEBUG_SCROLL_PX (TFT_DEBUG_SCROLL_LINES * TFT_DEBUG_LINE_HEIGHT)
+
+#ifndef TFT_DEBUG_HISTORY
+#define TFT_DEBUG_HISTORY 64        // Lines kept in RAM for tftDebugRedraw()
+#endif
+
+typedef struct
+{
+	char text[TFT_DEBUG_MAX_CHARS + 1];
+	uint16_t color;
+} tft_debug_line_t;
+
 // Color definitions for log levels
 #define TFT_COLOR_INFO     ILI9341_WHITE
 #define TFT_COLOR_DEBUG    ILI9341_CYAN
@@ -28,6 +46,11 @@ void tftDebugPrintln(const char* message, uint16_t color = TFT_COLOR_INFO);
 void tftDebugPrintf(uint16_t color, const char* format, ...);
 void tftDebugClear();
 void tftDebugScroll();
+// Repaint the header and the newest lines of the history
+void tftDebugRedraw();
+// Something else is taking the panel: restore an unscrolled full screen.
+// The next print repaints the console from its history.
+void tftDebugDetach();
 
 // Convenience macros for different log levels
 #define TFT_LOG_INFO(msg)    tftDebugPrintln(msg, TFT_COLOR_INFO)
@@ -0,0 +1,35 @@
+#ifndef _THUMBNAIL_H
+#define _THUMBNAIL_H
+
+#include <Arduino.h>
+
+// Gallery thumbnails. Each image under /images gets a small copy in
+// THUMB_DIR, made after upload by decoding at reduced scale (tjpgd 1/4 for
+// panel-sized JPEGs, row decimation through the resampler for PNGs). They
+// are stored as PNGs (8-bit RGB, fixed-Huffman deflate) that the web server
+// sends as they are: 4.9 KB for the q75 corpus card, whose JPEG is 14.8 KB
+// and whose uncompressed 16-bit BMP was 9.7 KB.
+#define THUMB_DIR "/thumbs"
+#define THUMB_EXT ".png"
+
+#ifndef THUMB_WIDTH
+#define THUMB_WIDTH 60
+#endif
+
+#ifndef THUMB_HEIGHT
+#define THUMB_HEIGHT 80
+#endif
+
+#define THUMB_IDAT_SIZE 2048 // Compressed bytes per IDAT chunk (encoder buffer)
+
+void thumbnailInit();
+String thumbnailPath(const char* filename);
+bool thumbnailExists(const char* filename);
+
+// Decode filename and write its thumbnail; runs on the calling task (see
+// renderQueueThumbnail() for the background worker) and needs about 43 KB
+// of heap while it does
+bool thumbnailGenerate(const char* filename);
+void thumbnailRemove(const char* filename);
+
+#endif
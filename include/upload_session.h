@@ -0,0 +1,126 @@
+#ifndef _UPLOAD_SESSION_H
+#define _UPLOAD_SESSION_H
+
+#include <Arduino.h>
+
+class AsyncClient;
+
+// One file being received over HTTP. Body chunks arrive in whatever sizes
+// the TCP stack delivers (~1436 bytes); they are collected into a buffer of
+// one LittleFS block and written a whole block at a time, so every write
+// starts on a block boundary and no block is programmed twice. Data goes to
+// a temporary file in UPLOAD_TMP_DIR with a per-session name (concurrent
+// uploads never share a file) which replaces the destination by rename once
+// everything arrived; a dropped connection only removes the temporary file.
+// Firmware and filesystem images take the same path into Update instead,
+// through ota_image.h.
+//
+// With UPLOAD_WRITE_BEHIND the body callbacks on async_tcp only copy into
+// blocks from a fixed pool; the "storage" task does the flash writes and
+// erases, so the TCP stack keeps acknowledging while a block is erased.
+// When the pool runs low, the session stops reopening its TCP receive window
+// (AsyncClient::ackLater) and the sender pauses until the storage task has
+// returned blocks; the callback never waits on flash, nor for a block: a
+// sender that overruns the pause fails its upload.
+//
+// The commit (rename, or Update.end) and the commit callback run on the
+// storage task too; HTTP handlers poll uploadDone() instead of waiting.
+
+#define UPLOAD_TMP_DIR "/uploads"
+
+#ifndef UPLOAD_BLOCK_SIZE
+#define UPLOAD_BLOCK_SIZE 4096 // LittleFS block on the ESP32 flash
+#endif
+
+// Headroom kept on top of Content-Length: LittleFS metadata and the block
+// the rename rewrites
+#define UPLOAD_SPACE_MARGIN (4 * UPLOAD_BLOCK_SIZE)
+
+#ifndef UPLOAD_WRITE_BEHIND
+#define UPLOAD_WRITE_BEHIND 1
+#endif
+
+#ifndef UPLOAD_POOL_BLOCKS
+#define UPLOAD_POOL_BLOCKS 6
+#endif
+
+// Free blocks left when reception pauses; they take the data already in
+// flight (one TCP window, 5744 bytes with the default lwIP settings)
+#define UPLOAD_PAUSE_BLOCKS 2
+
+#define UPLOAD_QUEUE_LENGTH (UPLOAD_POOL_BLOCKS + 8) // Blocks plus open/commit/end
+#define UPLOAD_TASK_STACK 4096
+#define UPLOAD_COMMIT_TIMEOUT_MS 10000
+
+typedef enum
+{
+	UPLOAD_OK = 0,
+	UPLOAD_NO_SPACE,     // Content-Length does not fit in free space
+	UPLOAD_NO_MEMORY,
+	UPLOAD_BUSY,         // Another firmware update is running
+	UPLOAD_OPEN_FAILED,
+	UPLOAD_WRITE_FAILED,
+	UPLOAD_COMMIT_FAILED, // Rename onto the destination (or Update.end) failed
+	UPLOAD_BAD_IMAGE,     // Update: corrupt or truncated gzip
+	UPLOAD_VERIFY_FAILED, // Update: SHA-256 or size differs from the manifest
+	UPLOAD_OVERRUN        // Pool empty: more data arrived than the pause allows
+} upload_status_t;
+
+typedef struct upload_session upload_session_t;
+
+typedef struct
+{
+	uint32_t bytes;
+	uint32_t crc;          // CRC-32 of the data, as imageCatalogCrc32()
+	uint32_t writes;       // Flash writes issued
+	uint32_t elapsed_ms;   // First chunk to commit
+	uint32_t kbps;         // bytes / elapsed, in KB/s
+	uint32_t pauses;       // Times reception was paused for the pool
+	uint32_t max_write_us; // Longest uploadWrite() call (time the caller was held)
+} upload_stats_t;
+
+// A file upload was renamed into place; path is the destination, crc that
+// of its data. Called on the storage task (inline without write-behind)
+typedef void (*upload_commit_callback_t)(const char* path, const char* filename, uint32_t crc);
+
+// Create the temporary directory, remove files left by uploads cut off by
+// a reset, and start the storage task
+void uploadInit();
+
+void uploadSetCommitCallback(upload_commit_callback_t callback);
+
+// Start receiving dir/filename; expected is the request Content-Length (0
+// when unknown). client, when given, is paused when the pool runs low.
+// Returns nullptr only when out of memory; other failures are kept in the
+// session and make later writes no-ops
+upload_session_t* uploadBegin(const char* dir, const char* filename, size_t expected, AsyncClient* client = nullptr);
+
+// Same for an Update image (command U_FLASH or U_SPIFFS), plain or gzip
+// (ota_image.h). sha256 and imageSize, when known from the manifest, are
+// checked before the partition is made bootable
+upload_session_t* uploadBeginUpdate(int command, AsyncClient* client = nullptr, const uint8_t* sha256 = nullptr,
+                                    uint32_t imageSize = 0);
+
+bool uploadWrite(upload_session_t* session, const uint8_t* data, size_t len);
+
+// Queue the last partial block and the rename; false if the session already
+// failed. uploadDone() turns true once the storage task got through it (or
+// the session failed before); uploadWait() blocks for it, so it is not for
+// async_tcp
+bool uploadCommit(upload_session_t* session);
+bool uploadDone(const upload_session_t* session);
+bool uploadWait(upload_session_t* session, uint32_t timeoutMs = UPLOAD_COMMIT_TIMEOUT_MS);
+
+// Release the session; the temporary file is removed (an Update aborted)
+// unless committed. Safe while writes are still queued
+void uploadEnd(upload_session_t* session);
+
+upload_status_t uploadStatus(const upload_session_t* session);
+const char* uploadStatusText(upload_status_t status);
+const char* uploadFilename(const upload_session_t* session);
+void uploadStats(const upload_session_t* session, upload_stats_t* out);
+
+// Upload counts, bytes, the last throughput and pool use, for /metrics
+void uploadWriteMetrics(Print& out);
+
+#endif
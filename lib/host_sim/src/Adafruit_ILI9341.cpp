@@ -0,0 +1,134 @@
+#include "Adafruit_ILI9341.h"
+
+void Adafruit_SPITFT::sendCommand(uint8_t cmd, const uint8_t* data, uint8_t numDataBytes) {
+    startWrite();
+    writeCommand(cmd);
+    for (uint8_t i = 0; i < numDataBytes; i++) {
+        spiWrite(data[i]);
+    }
+    endWrite();
+}
+
+void Adafruit_SPITFT::writePixel(int16_t x, int16_t y, uint16_t color) {
+    if (x >= 0 && x < _width && y >= 0 && y < _height) {
+        setAddrWindow(x, y, 1, 1);
+        SPI_WRITE16(color);
+    }
+}
+
+void Adafruit_SPITFT::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x >= 0 && x < _width && y >= 0 && y < _height) {
+        startWrite();
+        setAddrWindow(x, y, 1, 1);
+        SPI_WRITE16(color);
+        endWrite();
+    }
+}
+
+// Clipped like the Adafruit implementation: negative sizes are flipped
+void Adafruit_SPITFT::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (w < 0) {
+        x += w + 1;
+        w = -w;
+    }
+    if (h < 0) {
+        y += h + 1;
+        h = -h;
+    }
+    int16_t x2 = x + w - 1;
+    int16_t y2 = y + h - 1;
+    if (w == 0 || h == 0 || x >= _width || y >= _height || x2 < 0 || y2 < 0) {
+        return;
+    }
+    if (x < 0) {
+        x = 0;
+    }
+    if (y < 0) {
+        y = 0;
+    }
+    if (x2 >= _width) {
+        x2 = _width - 1;
+    }
+    if (y2 >= _height) {
+        y2 = _height - 1;
+    }
+    w = x2 - x + 1;
+    h = y2 - y + 1;
+    setAddrWindow(x, y, w, h);
+    writeColor(color, (uint32_t)w * h);
+}
+
+void Adafruit_SPITFT::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    startWrite();
+    writeFillRect(x, y, w, h, color);
+    endWrite();
+}
+
+void Adafruit_SPITFT::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    startWrite();
+    writeFillRect(x, y, w, 1, color);
+    endWrite();
+}
+
+void Adafruit_SPITFT::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    startWrite();
+    writeFillRect(x, y, 1, h, color);
+    endWrite();
+}
+
+// The real init table sets power, gamma and pixel format; only the commands
+// with a visible effect on the model are sent, so begin() costs a handful
+// of bytes rather than the ~90 of the hardware sequence
+void Adafruit_ILI9341::begin(uint32_t f) {
+    freq = f ? f : 24000000;
+    simPanelReset();
+    sendCommand(ILI9341_SWRESET);
+    uint8_t pixfmt = 0x55;
+    sendCommand(ILI9341_PIXFMT, &pixfmt, 1);
+    sendCommand(ILI9341_SLPOUT);
+    sendCommand(ILI9341_DISPON);
+    _width = ILI9341_TFTWIDTH;
+    _height = ILI9341_TFTHEIGHT;
+}
+
+void Adafruit_ILI9341::setRotation(uint8_t r) {
+    rotation = r & 3;
+    if (rotation != 0) {
+        fprintf(stderr, "[SIM] rotation %d not modelled, drawing in portrait\n", rotation);
+    }
+    uint8_t madctl = 0x48; // MX | BGR, portrait
+    sendCommand(ILI9341_MADCTL, &madctl, 1);
+}
+
+void Adafruit_ILI9341::setAddrWindow(uint16_t x1, uint16_t y1, uint16_t w, uint16_t h) {
+    uint16_t x2 = x1 + w - 1;
+    uint16_t y2 = y1 + h - 1;
+    writeCommand(ILI9341_CASET);
+    SPI_WRITE16(x1);
+    SPI_WRITE16(x2);
+    writeCommand(ILI9341_PASET);
+    SPI_WRITE16(y1);
+    SPI_WRITE16(y2);
+    writeCommand(ILI9341_RAMWR);
+}
+
+void Adafruit_ILI9341::scrollTo(uint16_t y) {
+    uint8_t data[2];
+    data[0] = y >> 8;
+    data[1] = y & 0xff;
+    sendCommand(ILI9341_VSCRSADD, data, 2);
+}
+
+void Adafruit_ILI9341::setScrollMargins(uint16_t top, uint16_t bottom) {
+    if (top + bottom <= ILI9341_TFTHEIGHT) {
+        uint16_t middle = ILI9341_TFTHEIGHT - (top + bottom);
+        uint8_t data[6];
+        data[0] = top >> 8;
+        data[1] = top & 0xff;
+        data[2] = middle >> 8;
+        data[3] = middle & 0xff;
+        data[4] = bottom >> 8;
+        data[5] = bottom & 0xff;
+        sendCommand(ILI9341_VSCRDEF, data, 6);
+    }
+}
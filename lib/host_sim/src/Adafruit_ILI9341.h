@@ -0,0 +1,101 @@
+#ifndef _HOST_SIM_ADAFRUIT_ILI9341_H
+#define _HOST_SIM_ADAFRUIT_ILI9341_H
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "Adafruit_GFX.h"
+#include "sim_panel.h"
+
+// Adafruit_SPITFT/Adafruit_ILI9341 with the bus replaced by the sim_panel
+// model. Method names and the byte streams they produce follow the Adafruit
+// library (rotation 0 only, which is what the firmware uses).
+
+#define ILI9341_TFTWIDTH 240
+#define ILI9341_TFTHEIGHT 320
+
+#define ILI9341_SWRESET 0x01
+#define ILI9341_SLPOUT 0x11
+#define ILI9341_DISPON 0x29
+#define ILI9341_CASET 0x2A
+#define ILI9341_PASET 0x2B
+#define ILI9341_RAMWR 0x2C
+#define ILI9341_VSCRDEF 0x33
+#define ILI9341_MADCTL 0x36
+#define ILI9341_VSCRSADD 0x37
+#define ILI9341_PIXFMT 0x3A
+
+#define ILI9341_BLACK 0x0000
+#define ILI9341_NAVY 0x000F
+#define ILI9341_DARKGREEN 0x03E0
+#define ILI9341_DARKCYAN 0x03EF
+#define ILI9341_MAROON 0x7800
+#define ILI9341_PURPLE 0x780F
+#define ILI9341_OLIVE 0x7BE0
+#define ILI9341_LIGHTGREY 0xC618
+#define ILI9341_DARKGREY 0x7BEF
+#define ILI9341_BLUE 0x001F
+#define ILI9341_GREEN 0x07E0
+#define ILI9341_CYAN 0x07FF
+#define ILI9341_RED 0xF800
+#define ILI9341_MAGENTA 0xF81F
+#define ILI9341_YELLOW 0xFFE0
+#define ILI9341_WHITE 0xFFFF
+#define ILI9341_ORANGE 0xFD20
+#define ILI9341_GREENYELLOW 0xAFE5
+#define ILI9341_PINK 0xFC18
+
+class Adafruit_SPITFT : public Adafruit_GFX
+{
+public:
+    Adafruit_SPITFT(int16_t w, int16_t h) : Adafruit_GFX(w, h) {}
+
+    virtual void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) = 0;
+
+    void startWrite() override { simPanelSelect(true); }
+    void endWrite() override { simPanelSelect(false); }
+    void writeCommand(uint8_t cmd) { simPanelCommand(cmd); }
+    void spiWrite(uint8_t b) { simPanelData(b); }
+    void SPI_WRITE16(uint16_t w) {
+        simPanelData(w >> 8);
+        simPanelData(w & 0xFF);
+    }
+    void SPI_WRITE32(uint32_t l) {
+        SPI_WRITE16(l >> 16);
+        SPI_WRITE16(l & 0xFFFF);
+    }
+    void sendCommand(uint8_t cmd, const uint8_t* data = nullptr, uint8_t numDataBytes = 0);
+
+    void writePixels(uint16_t* colors, uint32_t len, bool block = true, bool bigEndian = false) {
+        simPanelPixels(colors, len, bigEndian);
+    }
+    void writeColor(uint16_t color, uint32_t len) { simPanelFill(color, len); }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void writePixel(int16_t x, int16_t y, uint16_t color) override;
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override { writeFillRect(x, y, w, 1, color); }
+    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override { writeFillRect(x, y, 1, h, color); }
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+
+    uint32_t spiFrequency() const { return freq; }
+
+protected:
+    uint32_t freq = 0;
+};
+
+class Adafruit_ILI9341 : public Adafruit_SPITFT
+{
+public:
+    Adafruit_ILI9341(SPIClass* spiClass, int8_t dc, int8_t cs = -1, int8_t rst = -1)
+        : Adafruit_SPITFT(ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT) {}
+
+    void begin(uint32_t freq = 0);
+    void setRotation(uint8_t r) override;
+    void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) override;
+    void scrollTo(uint16_t y);
+    void setScrollMargins(uint16_t top, uint16_t bottom);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "Arduino.h"
+#include <chrono>
+
+HardwareSerial Serial;
+
+static bool serialQuiet() {
+    static int quiet = -1;
+    if (quiet < 0) {
+        const char* env = getenv("SIM_QUIET");
+        quiet = env && env[0] == '1';
+    }
+    return quiet;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (!serialQuiet()) fputc(c, stderr);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (!serialQuiet()) fwrite(buffer, 1, size, stderr);
+    return size;
+}
+
+static uint64_t virtualOffsetUs = 0;
+
+static uint64_t hostMicros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long millis() {
+    return (unsigned long)((hostMicros() + virtualOffsetUs) / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)(hostMicros() + virtualOffsetUs);
+}
+
+void delay(unsigned long ms) {
+    virtualOffsetUs += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+    virtualOffsetUs += us;
+}
+
+// esp_timer_get_time() shares the same clock
+extern "C" int64_t esp_timer_get_time() {
+    return (int64_t)micros();
+}
@@ -0,0 +1,189 @@
+#ifndef _HOST_SIM_ARDUINO_H
+#define _HOST_SIM_ARDUINO_H
+
+// Just enough of the Arduino-ESP32 core for the display code to build and
+// run on a Linux host (native environment only)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define memcpy_P memcpy
+
+// newlib has it, older glibc does not
+static inline size_t hostStrlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#define strlcpy hostStrlcpy
+
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define INPUT 0
+
+class String
+{
+public:
+    String() {}
+    String(const char* s) : s_(s ? s : "") {}
+    String(const std::string& s) : s_(s) {}
+    explicit String(char c) : s_(1, c) {}
+    String(int v) : s_(std::to_string(v)) {}
+    String(unsigned int v) : s_(std::to_string(v)) {}
+    String(long v) : s_(std::to_string(v)) {}
+    String(unsigned long v) : s_(std::to_string(v)) {}
+    String(long long v) : s_(std::to_string(v)) {}
+    String(unsigned long long v) : s_(std::to_string(v)) {}
+    String(double v, unsigned int decimals = 2) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+        s_ = buf;
+    }
+
+    const char* c_str() const { return s_.c_str(); }
+    unsigned int length() const { return s_.length(); }
+    bool isEmpty() const { return s_.empty(); }
+    char operator[](unsigned int i) const { return i < s_.size() ? s_[i] : 0; }
+    char charAt(unsigned int i) const { return (*this)[i]; }
+
+    String& operator+=(const String& o) { s_ += o.s_; return *this; }
+    String& operator+=(const char* o) { s_ += o ? o : ""; return *this; }
+    String& operator+=(char c) { s_ += c; return *this; }
+    bool concat(const String& o) { s_ += o.s_; return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+    friend String operator+(const String& a, const char* b) { return String(a.s_ + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String((a ? a : "") + b.s_); }
+    friend String operator+(const String& a, char b) { return String(a.s_ + b); }
+
+    bool operator==(const String& o) const { return s_ == o.s_; }
+    bool operator==(const char* o) const { return s_ == (o ? o : ""); }
+    bool operator!=(const String& o) const { return s_ != o.s_; }
+    bool operator!=(const char* o) const { return !(*this == o); }
+    bool operator<(const String& o) const { return s_ < o.s_; }
+
+    bool startsWith(const String& p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+    bool endsWith(const String& p) const {
+        return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t i = s_.find(c, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    int indexOf(const String& p, unsigned int from = 0) const {
+        size_t i = s_.find(p.s_, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    int lastIndexOf(char c) const {
+        size_t i = s_.rfind(c);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    String substring(unsigned int from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        return from < s_.size() ? String(s_.substr(from, to - from)) : String();
+    }
+    void replace(const String& find, const String& with) {
+        if (find.s_.empty()) return;
+        size_t pos = 0;
+        while ((pos = s_.find(find.s_, pos)) != std::string::npos) {
+            s_.replace(pos, find.s_.size(), with.s_);
+            pos += with.s_.size();
+        }
+    }
+    void toLowerCase() { for (char& c : s_) c = (char)tolower((unsigned char)c); }
+    void toUpperCase() { for (char& c : s_) c = (char)toupper((unsigned char)c); }
+    void trim() {
+        size_t b = s_.find_first_not_of(" \t\r\n");
+        size_t e = s_.find_last_not_of(" \t\r\n");
+        s_ = b == std::string::npos ? std::string() : s_.substr(b, e - b + 1);
+    }
+    long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+
+private:
+    std::string s_;
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned int v) { return printf("%u", v); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+    template <typename T>
+    size_t println(const T& v) { size_t n = print(v); return n + write("\r\n"); }
+    size_t println() { return write("\r\n"); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (len < 0) return 0;
+        if ((size_t)len < sizeof(buf)) return write((const uint8_t*)buf, len);
+        std::string big(len + 1, '\0');
+        va_start(args, format);
+        vsnprintf(&big[0], big.size(), format, args);
+        va_end(args);
+        return write((const uint8_t*)big.data(), len);
+    }
+};
+
+// Serial goes to stderr so stdout stays free for machine-readable results;
+// SIM_QUIET=1 in the environment silences it
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long baud) {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
+
+// Time runs on the host clock; delay() advances a virtual offset instead of
+// sleeping, so animations such as the splash screen cost no wall time
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+static inline void pinMode(int pin, int mode) {}
+static inline void digitalWrite(int pin, int value) {}
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef _HOST_SIM_ESPASYNCWEBSERVER_H
+#define _HOST_SIM_ESPASYNCWEBSERVER_H
+
+// Declarations only; the web server is not part of the host build
+class AsyncWebServer;
+class AsyncEventSource;
+class AsyncWebServerRequest;
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef _HOST_SIM_FS_H
+#define _HOST_SIM_FS_H
+
+#include "Arduino.h"
+#include <memory>
+#include <time.h>
+
+// Arduino fs::File/fs::FS over a host directory. Like the ESP32 core, File
+// is a shared handle: copies refer to the same open file.
+
+namespace fs {
+
+enum SeekMode
+{
+	SeekSet = 0,
+	SeekCur = 1,
+	SeekEnd = 2
+};
+
+struct FileImpl;
+
+class File : public Print
+{
+public:
+    File() {}
+    explicit File(std::shared_ptr<FileImpl> impl) : impl_(impl) {}
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    using Print::write;
+    int available();
+    int read();
+    size_t read(uint8_t* buf, size_t size);
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void flush();
+    void close();
+    operator bool() const;
+    const char* name() const;
+    const char* path() const;
+    bool isDirectory() const;
+    File openNextFile(const char* mode = "r");
+    void rewindDirectory();
+    time_t getLastWrite();
+
+private:
+    std::shared_ptr<FileImpl> impl_;
+};
+
+class FS
+{
+public:
+    explicit FS(const char* root) : root_(root) {}
+
+    File open(const char* path, const char* mode = "r", bool create = false);
+    File open(const String& path, const char* mode = "r", bool create = false) { return open(path.c_str(), mode, create); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool rmdir(const char* path);
+
+    // Host directory backing "/"
+    void setRoot(const char* root) { root_ = root; }
+    const char* root() const { return root_.c_str(); }
+
+protected:
+    std::string hostPath(const char* path) const;
+    std::string root_;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif
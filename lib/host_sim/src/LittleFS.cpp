@@ -0,0 +1,191 @@
+#include "LittleFS.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+fs::LittleFSFS LittleFS;
+
+namespace fs {
+
+struct FileImpl
+{
+    std::string path;     // Path as seen by the firmware
+    std::string hostPath; // Backing path on the host
+    std::string name;
+    FILE* fp = nullptr;
+    DIR* dir = nullptr;
+
+    ~FileImpl() {
+        if (fp) fclose(fp);
+        if (dir) closedir(dir);
+    }
+};
+
+static std::string baseName(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+size_t File::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    return impl_ && impl_->fp ? fwrite(buf, 1, size, impl_->fp) : 0;
+}
+
+int File::available() {
+    return impl_ && impl_->fp ? (int)(size() - position()) : 0;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+    return impl_ && impl_->fp ? fread(buf, 1, size, impl_->fp) : 0;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!impl_ || !impl_->fp) return false;
+    int whence = mode == SeekCur ? SEEK_CUR : mode == SeekEnd ? SEEK_END : SEEK_SET;
+    return fseek(impl_->fp, pos, whence) == 0;
+}
+
+size_t File::position() const {
+    return impl_ && impl_->fp ? (size_t)ftell(impl_->fp) : 0;
+}
+
+size_t File::size() const {
+    if (!impl_ || !impl_->fp) return 0;
+    fflush(impl_->fp);
+    struct stat st;
+    return fstat(fileno(impl_->fp), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::flush() {
+    if (impl_ && impl_->fp) fflush(impl_->fp);
+}
+
+void File::close() {
+    impl_.reset();
+}
+
+File::operator bool() const {
+    return impl_ && (impl_->fp || impl_->dir);
+}
+
+const char* File::name() const {
+    return impl_ ? impl_->name.c_str() : "";
+}
+
+const char* File::path() const {
+    return impl_ ? impl_->path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+    return impl_ && impl_->dir;
+}
+
+File File::openNextFile(const char* mode) {
+    if (!impl_ || !impl_->dir) return File();
+    struct dirent* entry;
+    while ((entry = readdir(impl_->dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string child = impl_->path;
+        if (child.empty() || child.back() != '/') child += '/';
+        child += entry->d_name;
+        return LittleFS.open(child.c_str(), mode);
+    }
+    return File();
+}
+
+void File::rewindDirectory() {
+    if (impl_ && impl_->dir) rewinddir(impl_->dir);
+}
+
+time_t File::getLastWrite() {
+    if (!impl_) return 0;
+    struct stat st;
+    return stat(impl_->hostPath.c_str(), &st) == 0 ? st.st_mtime : 0;
+}
+
+std::string FS::hostPath(const char* path) const {
+    std::string p = root_;
+    if (path[0] != '/') p += '/';
+    p += path;
+    return p;
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    auto impl = std::make_shared<FileImpl>();
+    impl->path = path;
+    impl->hostPath = hostPath(path);
+    impl->name = baseName(path);
+
+    struct stat st;
+    if (mode[0] == 'r' && stat(impl->hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        impl->dir = opendir(impl->hostPath.c_str());
+        return impl->dir ? File(impl) : File();
+    }
+    const char* hostMode = mode[0] == 'w' ? "wb+" : mode[0] == 'a' ? "ab+" : "rb";
+    impl->fp = fopen(impl->hostPath.c_str(), hostMode);
+    return impl->fp ? File(impl) : File();
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool FS::rmdir(const char* path) {
+    return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    struct stat st;
+    if (stat(root_.c_str(), &st) == 0) {
+        return S_ISDIR(st.st_mode);
+    }
+    return formatOnFail && ::mkdir(root_.c_str(), 0755) == 0;
+}
+
+bool LittleFSFS::format() {
+    return false; // Never wipe a host directory
+}
+
+static size_t directoryBytes(const std::string& path) {
+    size_t total = 0;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string child = path + "/" + entry->d_name;
+        struct stat st;
+        if (stat(child.c_str(), &st) != 0) continue;
+        total += S_ISDIR(st.st_mode) ? directoryBytes(child) : (size_t)st.st_size;
+    }
+    closedir(dir);
+    return total;
+}
+
+size_t LittleFSFS::usedBytes() {
+    return directoryBytes(root_);
+}
+
+} // namespace fs
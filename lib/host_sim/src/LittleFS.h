@@ -0,0 +1,28 @@
+#ifndef _HOST_SIM_LITTLEFS_H
+#define _HOST_SIM_LITTLEFS_H
+
+#include "FS.h"
+
+#ifndef HOST_SIM_FS_SIZE
+#define HOST_SIM_FS_SIZE (1536 * 1024) // Same as the spiffs partition in partitions.csv
+#endif
+
+namespace fs {
+
+class LittleFSFS : public FS
+{
+public:
+    LittleFSFS() : FS(".") {}
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = "spiffs");
+    void end() {}
+    bool format();
+    size_t totalBytes() { return HOST_SIM_FS_SIZE; }
+    size_t usedBytes(); // Sum of the file sizes below the root
+};
+
+} // namespace fs
+
+extern fs::LittleFSFS LittleFS;
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef _HOST_SIM_SD_H
+#define _HOST_SIM_SD_H
+
+#include "FS.h"
+
+// Declared so libraries with optional SD support build; shares the host
+// directory layout with LittleFS
+class SDClass : public fs::FS
+{
+public:
+    SDClass() : FS(".") {}
+    bool begin(uint8_t ssPin = 0) { return true; }
+    void end() {}
+};
+
+extern SDClass SD;
+
+#endif
@@ -0,0 +1,5 @@
+#include "SPI.h"
+#include "SD.h"
+
+SPIClass SPI;
+SDClass SD;
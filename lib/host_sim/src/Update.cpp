@@ -0,0 +1,55 @@
+#include <vector>
+#include "Update.h"
+
+UpdateClass Update;
+
+static std::vector<uint8_t> image;
+
+bool UpdateClass::begin(size_t size, int) {
+    image.clear();
+    ended_ = false;
+    running_ = false;
+    if (size != UPDATE_SIZE_UNKNOWN && size > HOST_SIM_UPDATE_PARTITION) {
+        error_ = "Not Enough Space";
+        return false;
+    }
+    size_ = size == UPDATE_SIZE_UNKNOWN ? HOST_SIM_UPDATE_PARTITION : size;
+    running_ = true;
+    return true;
+}
+
+size_t UpdateClass::write(uint8_t* data, size_t len) {
+    if (!running_ || image.size() + len > size_) {
+        error_ = "Flash Write Failed";
+        return 0;
+    }
+    image.insert(image.end(), data, data + len);
+    return len;
+}
+
+bool UpdateClass::end(bool) {
+    if (!running_ || !image.size()) {
+        error_ = "Bad Size Given";
+        return false;
+    }
+    running_ = false;
+    ended_ = true;
+    return true;
+}
+
+void UpdateClass::abort() {
+    running_ = false;
+    error_ = "Aborted";
+}
+
+void UpdateClass::printError(Print& out) {
+    out.printf("ERROR: %s\n", error_);
+}
+
+const uint8_t* UpdateClass::simData() {
+    return image.data();
+}
+
+size_t UpdateClass::simSize() {
+    return image.size();
+}
@@ -0,0 +1,42 @@
+#ifndef _HOST_SIM_UPDATE_H
+#define _HOST_SIM_UPDATE_H
+
+#include <Arduino.h>
+
+// Stand-in for the Arduino Update class: the image is kept in memory, and
+// a begin() larger than an app partition (partitions.csv) fails like on
+// the device. The sim* calls are host only.
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+#ifndef HOST_SIM_UPDATE_PARTITION
+#define HOST_SIM_UPDATE_PARTITION (1024 * 1024)
+#endif
+
+class UpdateClass
+{
+public:
+    bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH);
+    size_t write(uint8_t* data, size_t len);
+    bool end(bool evenIfRemaining = false);
+    void abort();
+    bool isRunning() { return running_; }
+    void printError(Print& out);
+
+    // The image as written so far, and whether end() accepted it
+    const uint8_t* simData();
+    size_t simSize();
+    bool simEnded() { return ended_; }
+
+private:
+    bool running_ = false;
+    bool ended_ = false;
+    size_t size_ = 0;
+    const char* error_ = "";
+};
+
+extern UpdateClass Update;
+
+#endif
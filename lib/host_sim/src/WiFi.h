@@ -0,0 +1,10 @@
+#ifndef _HOST_SIM_WIFI_H
+#define _HOST_SIM_WIFI_H
+
+#include "Arduino.h"
+
+// Declarations only, so headers such as ethernet.h parse
+typedef int arduino_event_id_t;
+typedef arduino_event_id_t WiFiEvent_t;
+
+#endif
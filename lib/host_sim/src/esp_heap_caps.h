@@ -0,0 +1,22 @@
+#ifndef _HOST_SIM_ESP_HEAP_CAPS_H
+#define _HOST_SIM_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+// The host heap is effectively unlimited; report a C3-like free heap so
+// size checks in the display code take their normal paths
+#define HOST_SIM_HEAP_FREE (200 * 1024)
+
+static inline void* heap_caps_malloc(size_t size, uint32_t caps) { return malloc(size); }
+static inline void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) { return calloc(n, size); }
+static inline void heap_caps_free(void* p) { free(p); }
+static inline size_t heap_caps_get_free_size(uint32_t caps) { return HOST_SIM_HEAP_FREE; }
+static inline size_t heap_caps_get_minimum_free_size(uint32_t caps) { return HOST_SIM_HEAP_FREE; }
+static inline size_t heap_caps_get_largest_free_block(uint32_t caps) { return HOST_SIM_HEAP_FREE; }
+
+#endif
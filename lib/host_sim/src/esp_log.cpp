@@ -0,0 +1,21 @@
+#include <stdarg.h>
+#include <stdlib.h>
+#include "esp_log.h"
+
+extern "C" void simLog(esp_log_level_t level, const char* tag, const char* format, ...) {
+    static int verbose = -1;
+    if (verbose < 0) {
+        const char* env = getenv("SIM_LOG");
+        verbose = env && env[0] == '1';
+    }
+    if (level > ESP_LOG_WARN && !verbose) {
+        return;
+    }
+    static const char letters[] = "NEWIDV";
+    fprintf(stderr, "%c (%s) ", letters[level], tag);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
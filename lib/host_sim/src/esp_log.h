@@ -0,0 +1,33 @@
+#ifndef _HOST_SIM_ESP_LOG_H
+#define _HOST_SIM_ESP_LOG_H
+
+#include <stdio.h>
+
+// Errors and warnings go to stderr; SIM_LOG=1 also enables info/debug
+typedef enum
+{
+	ESP_LOG_NONE,
+	ESP_LOG_ERROR,
+	ESP_LOG_WARN,
+	ESP_LOG_INFO,
+	ESP_LOG_DEBUG,
+	ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void simLog(esp_log_level_t level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+#ifdef __cplusplus
+}
+#endif
+
+static inline void esp_log_level_set(const char* tag, esp_log_level_t level) {}
+
+#define ESP_LOGE(tag, format, ...) simLog(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) simLog(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) simLog(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) simLog(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) simLog(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef _HOST_SIM_ESP_TIMER_H
+#define _HOST_SIM_ESP_TIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+int64_t esp_timer_get_time(); // Same clock as micros()
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _HOST_SIM_FREERTOS_SEMPHR_H
+#define _HOST_SIM_FREERTOS_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+#include <chrono>
+#include <mutex>
+
+typedef std::recursive_timed_mutex* SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new std::recursive_timed_mutex(); }
+static inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return new std::recursive_timed_mutex(); }
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        m->lock();
+        return pdTRUE;
+    }
+    return m->try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t m) {
+    m->unlock();
+    return pdTRUE;
+}
+static inline void vSemaphoreDelete(SemaphoreHandle_t m) { delete m; }
+#define xSemaphoreTakeRecursive xSemaphoreTake
+#define xSemaphoreGiveRecursive xSemaphoreGive
+
+#endif
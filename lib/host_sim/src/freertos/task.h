@@ -0,0 +1,14 @@
+#ifndef _HOST_SIM_FREERTOS_TASK_H
+#define _HOST_SIM_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+#include "Arduino.h"
+
+// The host build is single threaded; no tasks are ever created
+typedef void* TaskHandle_t;
+
+static inline TaskHandle_t xTaskGetHandle(const char* name) { return nullptr; }
+static inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) { return 0; }
+static inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+#endif
@@ -0,0 +1,355 @@
+#include <string.h>
+#include "rom/miniz.h"
+
+static uint8_t lookahead = 4;
+
+// Inflater in the manner of zlib's puff.c: the whole stream is decoded in
+// one pass, so a result of INFLATE_MORE means try again with more input
+typedef enum
+{
+	INFLATE_OK = 0,
+	INFLATE_MORE,
+	INFLATE_BAD
+} inflate_result_t;
+
+typedef struct
+{
+	const uint8_t* in;
+	size_t inSize;
+	size_t inPos;
+	uint32_t bits;
+	uint8_t bitCount;
+	uint8_t* out;
+	size_t outSize;
+	size_t outMax;
+	inflate_result_t result;
+} inflate_state_t;
+
+typedef struct
+{
+	uint16_t count[16];  // Codes of each length
+	uint16_t symbol[320]; // Symbols ordered by code
+} huffman_t;
+
+static const uint16_t lengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                        31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                        2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t distanceBase[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,    65,    97,    129,
+                                          193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t distanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                          6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static bool need(inflate_state_t* s, uint8_t count) {
+    while (s->bitCount < count) {
+        if (s->inPos == s->inSize) {
+            s->result = INFLATE_MORE;
+            return false;
+        }
+        s->bits |= (uint32_t)s->in[s->inPos++] << s->bitCount;
+        s->bitCount += 8;
+    }
+    return true;
+}
+
+static uint32_t bits(inflate_state_t* s, uint8_t count) {
+    if (!count || !need(s, count)) {
+        return 0;
+    }
+    uint32_t value = s->bits & ((1u << count) - 1);
+    s->bits >>= count;
+    s->bitCount -= count;
+    return value;
+}
+
+static bool put(inflate_state_t* s, uint8_t b) {
+    if (s->outSize == s->outMax) {
+        s->result = INFLATE_BAD;
+        return false;
+    }
+    s->out[s->outSize++] = b;
+    return true;
+}
+
+// Canonical code from code lengths; false if over-subscribed
+static bool build(huffman_t* h, const uint8_t* lengths, uint16_t n) {
+    memset(h->count, 0, sizeof(h->count));
+    for (uint16_t i = 0; i < n; i++) {
+        h->count[lengths[i]]++;
+    }
+    int32_t left = 1;
+    for (uint8_t len = 1; len < 16; len++) {
+        left = (left << 1) - h->count[len];
+        if (left < 0) {
+            return false;
+        }
+    }
+    uint16_t offset[16];
+    offset[1] = 0;
+    for (uint8_t len = 1; len < 15; len++) {
+        offset[len + 1] = offset[len] + h->count[len];
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        if (lengths[i]) {
+            h->symbol[offset[lengths[i]]++] = i;
+        }
+    }
+    return true;
+}
+
+static int32_t decode(inflate_state_t* s, const huffman_t* h) {
+    int32_t code = 0, first = 0, index = 0;
+    for (uint8_t len = 1; len < 16; len++) {
+        code |= bits(s, 1);
+        if (s->result != INFLATE_OK) {
+            return -1;
+        }
+        int32_t count = h->count[len];
+        if (code - count < first) {
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    s->result = INFLATE_BAD;
+    return -1;
+}
+
+static bool stored(inflate_state_t* s) {
+    s->bits = 0;
+    s->bitCount = 0;
+    if (s->inPos + 4 > s->inSize) {
+        s->result = INFLATE_MORE;
+        return false;
+    }
+    uint16_t len = s->in[s->inPos] | (s->in[s->inPos + 1] << 8);
+    uint16_t nlen = s->in[s->inPos + 2] | (s->in[s->inPos + 3] << 8);
+    if (len != (uint16_t)~nlen) {
+        s->result = INFLATE_BAD;
+        return false;
+    }
+    s->inPos += 4;
+    if (s->inPos + len > s->inSize) {
+        s->result = INFLATE_MORE;
+        return false;
+    }
+    while (len--) {
+        if (!put(s, s->in[s->inPos++])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool codes(inflate_state_t* s, const huffman_t* lengthCode, const huffman_t* distanceCode) {
+    for (;;) {
+        int32_t symbol = decode(s, lengthCode);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 256) {
+            if (!put(s, symbol)) {
+                return false;
+            }
+            continue;
+        }
+        if (symbol == 256) {
+            return true;
+        }
+        symbol -= 257;
+        if (symbol >= 29) {
+            s->result = INFLATE_BAD;
+            return false;
+        }
+        uint32_t length = lengthBase[symbol] + bits(s, lengthExtra[symbol]);
+        int32_t d = decode(s, distanceCode);
+        if (d < 0 || s->result != INFLATE_OK) {
+            return false;
+        }
+        if (d >= 30) {
+            s->result = INFLATE_BAD;
+            return false;
+        }
+        uint32_t distance = distanceBase[d] + bits(s, distanceExtra[d]);
+        if (s->result != INFLATE_OK) {
+            return false;
+        }
+        if (distance > s->outSize || distance > TINFL_LZ_DICT_SIZE) {
+            s->result = INFLATE_BAD;
+            return false;
+        }
+        while (length--) {
+            if (!put(s, s->out[s->outSize - distance])) {
+                return false;
+            }
+        }
+    }
+}
+
+static bool fixed(inflate_state_t* s) {
+    static huffman_t lengthCode, distanceCode;
+    static bool built = false;
+    if (!built) {
+        uint8_t lengths[288];
+        uint16_t i = 0;
+        for (; i < 144; i++) lengths[i] = 8;
+        for (; i < 256; i++) lengths[i] = 9;
+        for (; i < 280; i++) lengths[i] = 7;
+        for (; i < 288; i++) lengths[i] = 8;
+        build(&lengthCode, lengths, 288);
+        for (i = 0; i < 30; i++) lengths[i] = 5;
+        build(&distanceCode, lengths, 30);
+        built = true;
+    }
+    return codes(s, &lengthCode, &distanceCode);
+}
+
+static bool dynamic(inflate_state_t* s) {
+    static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    uint16_t nlen = bits(s, 5) + 257;
+    uint16_t ndist = bits(s, 5) + 1;
+    uint16_t ncode = bits(s, 4) + 4;
+    if (s->result != INFLATE_OK) {
+        return false;
+    }
+    if (nlen > 286 || ndist > 30) {
+        s->result = INFLATE_BAD;
+        return false;
+    }
+    uint8_t lengths[320] = {};
+    for (uint16_t i = 0; i < ncode; i++) {
+        lengths[order[i]] = bits(s, 3);
+    }
+    if (s->result != INFLATE_OK) {
+        return false;
+    }
+    huffman_t lengthCode, distanceCode;
+    if (!build(&lengthCode, lengths, 19)) {
+        s->result = INFLATE_BAD;
+        return false;
+    }
+    uint16_t index = 0;
+    while (index < nlen + ndist) {
+        int32_t symbol = decode(s, &lengthCode);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 16) {
+            lengths[index++] = symbol;
+            continue;
+        }
+        uint8_t value = 0;
+        uint16_t repeat;
+        if (symbol == 16) {
+            if (!index) {
+                s->result = INFLATE_BAD;
+                return false;
+            }
+            value = lengths[index - 1];
+            repeat = 3 + bits(s, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + bits(s, 3);
+        } else {
+            repeat = 11 + bits(s, 7);
+        }
+        if (s->result != INFLATE_OK) {
+            return false;
+        }
+        if (index + repeat > nlen + ndist) {
+            s->result = INFLATE_BAD;
+            return false;
+        }
+        while (repeat--) {
+            lengths[index++] = value;
+        }
+    }
+    if (!lengths[256] || !build(&lengthCode, lengths, nlen) || !build(&distanceCode, lengths + nlen, ndist)) {
+        s->result = INFLATE_BAD;
+        return false;
+    }
+    return codes(s, &lengthCode, &distanceCode);
+}
+
+// Whole raw deflate stream from in; on INFLATE_OK *end is the first byte
+// after it
+static inflate_result_t inflateAll(const uint8_t* in, size_t inSize, uint8_t* out, size_t outMax, size_t* outSize,
+                                   size_t* end) {
+    inflate_state_t s = {};
+    s.in = in;
+    s.inSize = inSize;
+    s.out = out;
+    s.outMax = outMax;
+    bool last;
+    do {
+        last = bits(&s, 1);
+        uint32_t type = bits(&s, 2);
+        if (s.result != INFLATE_OK) {
+            return s.result;
+        }
+        bool ok = type == 0 ? stored(&s) : type == 1 ? fixed(&s) : type == 2 ? dynamic(&s) : false;
+        if (!ok) {
+            return s.result == INFLATE_OK ? INFLATE_BAD : s.result;
+        }
+    } while (!last);
+    *outSize = s.outSize;
+    *end = s.inPos;
+    return INFLATE_OK;
+}
+
+void simTinflSetLookahead(uint8_t bytes) {
+    lookahead = bytes;
+}
+
+tinfl_status tinfl_decompress(tinfl_decompressor* r, const uint8_t* pIn_buf_next, size_t* pIn_buf_size,
+                              uint8_t* pOut_buf_start, uint8_t* pOut_buf_next, size_t* pOut_buf_size,
+                              uint32_t decomp_flags) {
+    (void)pOut_buf_start;
+    if (decomp_flags & TINFL_FLAG_PARSE_ZLIB_HEADER) {
+        *pIn_buf_size = 0;
+        *pOut_buf_size = 0;
+        return TINFL_STATUS_BAD_PARAM;
+    }
+    if (r->failed) {
+        *pIn_buf_size = 0;
+        *pOut_buf_size = 0;
+        return TINFL_STATUS_FAILED;
+    }
+    if (!r->complete) {
+        size_t given = *pIn_buf_size;
+        if (r->inSize + given > sizeof(r->in)) {
+            r->failed = true;
+            *pIn_buf_size = 0;
+            *pOut_buf_size = 0;
+            return TINFL_STATUS_FAILED;
+        }
+        memcpy(r->in + r->inSize, pIn_buf_next, given);
+        r->inSize += given;
+        size_t end = 0;
+        inflate_result_t result = inflateAll(r->in, r->inSize, r->out, sizeof(r->out), &r->outSize, &end);
+        if (result == INFLATE_BAD) {
+            r->failed = true;
+            *pOut_buf_size = 0;
+            return TINFL_STATUS_FAILED;
+        }
+        if (result == INFLATE_MORE) {
+            *pOut_buf_size = 0;
+            return (decomp_flags & TINFL_FLAG_HAS_MORE_INPUT) ? TINFL_STATUS_NEEDS_MORE_INPUT : TINFL_STATUS_FAILED;
+        }
+        // Bytes of this call past the end, less the look-ahead, go back
+        size_t after = r->inSize - end;
+        size_t kept = after < lookahead ? after : lookahead;
+        *pIn_buf_size = given - (after - kept);
+        r->complete = true;
+    } else {
+        *pIn_buf_size = 0;
+    }
+    size_t n = r->outSize - r->outPos;
+    if (n > *pOut_buf_size) {
+        n = *pOut_buf_size;
+    }
+    memcpy(pOut_buf_next, r->out + r->outPos, n);
+    r->outPos += n;
+    *pOut_buf_size = n;
+    return r->outPos < r->outSize ? TINFL_STATUS_HAS_MORE_OUTPUT : TINFL_STATUS_DONE;
+}
@@ -0,0 +1,6 @@
+#ifndef _HOST_SIM_PGMSPACE_H
+#define _HOST_SIM_PGMSPACE_H
+
+#include "Arduino.h"
+
+#endif
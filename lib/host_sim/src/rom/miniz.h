@@ -0,0 +1,63 @@
+#ifndef _HOST_SIM_ROM_MINIZ_H
+#define _HOST_SIM_ROM_MINIZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Stand-in for the ESP ROM's tinfl (miniz 1.15): the same calls, flags and
+// status codes, over a small inflater of its own. Input is buffered until
+// the deflate stream is complete, then the output goes out through the
+// caller's window. Like the ROM version, bytes after the end of the stream
+// may be taken as look-ahead and never handed back: up to
+// simTinflSetLookahead() of them (default 4, a 32-bit bit buffer) are
+// reported as consumed.
+
+#define TINFL_LZ_DICT_SIZE 32768
+
+#define TINFL_FLAG_PARSE_ZLIB_HEADER 1
+#define TINFL_FLAG_HAS_MORE_INPUT 2
+#define TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF 4
+
+#ifndef HOST_SIM_TINFL_MAX
+#define HOST_SIM_TINFL_MAX (2 * 1024 * 1024) // Compressed and inflated bytes each
+#endif
+
+typedef enum
+{
+	TINFL_STATUS_BAD_PARAM = -3,
+	TINFL_STATUS_ADLER32_MISMATCH = -2,
+	TINFL_STATUS_FAILED = -1,
+	TINFL_STATUS_DONE = 0,
+	TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+	TINFL_STATUS_HAS_MORE_OUTPUT = 2
+} tinfl_status;
+
+typedef struct
+{
+	bool complete;
+	bool failed;
+	size_t inSize;
+	size_t outSize;
+	size_t outPos; // Inflated bytes handed out
+	uint8_t in[HOST_SIM_TINFL_MAX];
+	uint8_t out[HOST_SIM_TINFL_MAX];
+} tinfl_decompressor;
+
+#define tinfl_init(r)            \
+    do {                         \
+        (r)->complete = false;   \
+        (r)->failed = false;     \
+        (r)->inSize = 0;         \
+        (r)->outSize = 0;        \
+        (r)->outPos = 0;         \
+    } while (0)
+
+// Raw deflate only (no TINFL_FLAG_PARSE_ZLIB_HEADER)
+tinfl_status tinfl_decompress(tinfl_decompressor* r, const uint8_t* pIn_buf_next, size_t* pIn_buf_size,
+                              uint8_t* pOut_buf_start, uint8_t* pOut_buf_next, size_t* pOut_buf_size,
+                              uint32_t decomp_flags);
+
+// Bytes after the end of the stream reported as consumed (host only)
+void simTinflSetLookahead(uint8_t bytes);
+
+#endif
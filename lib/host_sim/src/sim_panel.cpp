@@ -0,0 +1,313 @@
+#include "sim_panel.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define CMD_SWRESET 0x01
+#define CMD_CASET 0x2A
+#define CMD_PASET 0x2B
+#define CMD_RAMWR 0x2C
+#define CMD_VSCRDEF 0x33
+#define CMD_VSCRSADD 0x37
+#define CMD_RAMWRC 0x3C
+
+static uint16_t gram[SIM_PANEL_WIDTH * SIM_PANEL_HEIGHT];
+static sim_panel_stats_t stats;
+static bool selected = false;
+
+// Command parser state
+static uint8_t command = 0;
+static uint8_t args[8];
+static uint8_t argCount = 0;
+static bool pixelHalf = false; // First byte of a pixel received
+static uint8_t pixelHigh = 0;
+
+// Address window and write pointer
+static uint16_t colStart = 0, colEnd = SIM_PANEL_WIDTH - 1;
+static uint16_t pageStart = 0, pageEnd = SIM_PANEL_HEIGHT - 1;
+static uint16_t curX = 0, curY = 0;
+
+// Vertical scrolling: top fixed area, scroll area, start address
+static uint16_t scrollTop = 0;
+static uint16_t scrollArea = SIM_PANEL_HEIGHT;
+static uint16_t scrollStart = 0;
+
+void simPanelReset(uint16_t fill) {
+    for (uint32_t i = 0; i < SIM_PANEL_WIDTH * SIM_PANEL_HEIGHT; i++) {
+        gram[i] = fill;
+    }
+    command = 0;
+    argCount = 0;
+    pixelHalf = false;
+    colStart = 0;
+    colEnd = SIM_PANEL_WIDTH - 1;
+    pageStart = 0;
+    pageEnd = SIM_PANEL_HEIGHT - 1;
+    curX = curY = 0;
+    scrollTop = 0;
+    scrollArea = SIM_PANEL_HEIGHT;
+    scrollStart = 0;
+}
+
+void simPanelResetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+const sim_panel_stats_t* simPanelStats() {
+    return &stats;
+}
+
+uint32_t simPanelEstimateUs(const sim_panel_stats_t* s, uint32_t spiFreq) {
+    uint64_t wireNs = spiFreq ? (s->data_bytes + s->commands) * 8ull * 1000000000ull / spiFreq : 0;
+    uint64_t overheadNs = (uint64_t)s->transactions * SIM_PANEL_TRANSACTION_NS + (uint64_t)s->commands * SIM_PANEL_COMMAND_NS;
+    return (uint32_t)((wireNs + overheadNs) / 1000);
+}
+
+void simPanelSelect(bool sel) {
+    if (sel && !selected) {
+        stats.transactions++;
+    }
+    selected = sel;
+}
+
+void simPanelCommand(uint8_t cmd) {
+    stats.commands++;
+    command = cmd;
+    argCount = 0;
+    pixelHalf = false;
+    switch (cmd) {
+        case CMD_SWRESET:
+            scrollTop = 0;
+            scrollArea = SIM_PANEL_HEIGHT;
+            scrollStart = 0;
+            break;
+        case CMD_RAMWR:
+            curX = colStart;
+            curY = pageStart;
+            stats.windows++;
+            break;
+        case CMD_VSCRSADD:
+            stats.scrolls++;
+            break;
+    }
+}
+
+static void writePixel(uint16_t color) {
+    if (curX < SIM_PANEL_WIDTH && curY < SIM_PANEL_HEIGHT) {
+        gram[curY * SIM_PANEL_WIDTH + curX] = color;
+        stats.pixels++;
+    } else {
+        stats.clipped++;
+    }
+    if (++curX > colEnd) {
+        curX = colStart;
+        if (++curY > pageEnd) {
+            curY = pageStart;
+        }
+    }
+}
+
+static inline bool inMemoryWrite() {
+    return command == CMD_RAMWR || command == CMD_RAMWRC;
+}
+
+void simPanelData(uint8_t b) {
+    stats.data_bytes++;
+    if (inMemoryWrite()) {
+        if (!pixelHalf) {
+            pixelHigh = b;
+            pixelHalf = true;
+        } else {
+            writePixel((uint16_t)((pixelHigh << 8) | b));
+            pixelHalf = false;
+        }
+        return;
+    }
+    if (argCount < sizeof(args)) {
+        args[argCount] = b;
+    }
+    argCount++;
+    switch (command) {
+        case CMD_CASET:
+            if (argCount == 4) {
+                colStart = (args[0] << 8) | args[1];
+                colEnd = (args[2] << 8) | args[3];
+            }
+            break;
+        case CMD_PASET:
+            if (argCount == 4) {
+                pageStart = (args[0] << 8) | args[1];
+                pageEnd = (args[2] << 8) | args[3];
+            }
+            break;
+        case CMD_VSCRDEF:
+            if (argCount == 6) {
+                scrollTop = (args[0] << 8) | args[1];
+                scrollArea = (args[2] << 8) | args[3];
+            }
+            break;
+        case CMD_VSCRSADD:
+            if (argCount == 2) {
+                scrollStart = (args[0] << 8) | args[1];
+            }
+            break;
+    }
+}
+
+void simPanelPixels(const uint16_t* colors, uint32_t len, bool bigEndian) {
+    if (!inMemoryWrite() || pixelHalf) {
+        for (uint32_t i = 0; i < len; i++) {
+            uint16_t c = colors[i];
+            if (bigEndian) {
+                c = (uint16_t)((c << 8) | (c >> 8));
+            }
+            simPanelData(c >> 8);
+            simPanelData(c & 0xFF);
+        }
+        return;
+    }
+    stats.data_bytes += (uint64_t)len * 2;
+    for (uint32_t i = 0; i < len; i++) {
+        uint16_t c = colors[i];
+        writePixel(bigEndian ? (uint16_t)((c << 8) | (c >> 8)) : c);
+    }
+}
+
+void simPanelFill(uint16_t color, uint32_t len) {
+    if (!inMemoryWrite() || pixelHalf) {
+        for (uint32_t i = 0; i < len; i++) {
+            simPanelData(color >> 8);
+            simPanelData(color & 0xFF);
+        }
+        return;
+    }
+    stats.data_bytes += (uint64_t)len * 2;
+    for (uint32_t i = 0; i < len; i++) {
+        writePixel(color);
+    }
+}
+
+// Frame memory row shown on panel line y
+static uint16_t memoryRow(int16_t y) {
+    if (y < scrollTop || y >= scrollTop + scrollArea || scrollArea == 0) {
+        return (uint16_t)y;
+    }
+    uint16_t offset = (uint16_t)((y - scrollTop + scrollStart - scrollTop + 2 * scrollArea) % scrollArea);
+    return scrollTop + offset;
+}
+
+uint16_t simPanelVisiblePixel(int16_t x, int16_t y) {
+    if (x < 0 || y < 0 || x >= SIM_PANEL_WIDTH || y >= SIM_PANEL_HEIGHT) {
+        return 0;
+    }
+    uint16_t row = memoryRow(y);
+    return row < SIM_PANEL_HEIGHT ? gram[row * SIM_PANEL_WIDTH + x] : 0;
+}
+
+uint32_t simPanelVisibleHash() {
+    uint32_t h = 2166136261u;
+    for (int16_t y = 0; y < SIM_PANEL_HEIGHT; y++) {
+        for (int16_t x = 0; x < SIM_PANEL_WIDTH; x++) {
+            uint16_t c = simPanelVisiblePixel(x, y);
+            h = (h ^ (c >> 8)) * 16777619u;
+            h = (h ^ (c & 0xFF)) * 16777619u;
+        }
+    }
+    return h;
+}
+
+// PNG writer with stored (uncompressed) deflate blocks, so no zlib is needed
+
+static uint32_t crcTable[256];
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len) {
+    if (!crcTable[1]) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            crcTable[n] = c;
+        }
+    }
+    crc = ~crc;
+    while (len--) {
+        crc = crcTable[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void putBE32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(v >> 24);
+    out.push_back(v >> 16);
+    out.push_back(v >> 8);
+    out.push_back(v);
+}
+
+static void writeChunk(FILE* f, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    putBE32(chunk, (uint32_t)data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    uint32_t crc = crc32(0, chunk.data() + 4, chunk.size() - 4);
+    putBE32(chunk, crc);
+    fwrite(chunk.data(), 1, chunk.size(), f);
+}
+
+bool simPanelWritePng(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, sizeof(signature), f);
+
+    std::vector<uint8_t> ihdr;
+    putBE32(ihdr, SIM_PANEL_WIDTH);
+    putBE32(ihdr, SIM_PANEL_HEIGHT);
+    ihdr.push_back(8); // Bit depth
+    ihdr.push_back(2); // Truecolour
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    writeChunk(f, "IHDR", ihdr);
+
+    // Filter byte 0 + RGB888 per row
+    std::vector<uint8_t> raw;
+    raw.reserve(SIM_PANEL_HEIGHT * (1 + SIM_PANEL_WIDTH * 3));
+    for (int16_t y = 0; y < SIM_PANEL_HEIGHT; y++) {
+        raw.push_back(0);
+        for (int16_t x = 0; x < SIM_PANEL_WIDTH; x++) {
+            uint16_t c = simPanelVisiblePixel(x, y);
+            uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            raw.push_back((r << 3) | (r >> 2));
+            raw.push_back((g << 2) | (g >> 4));
+            raw.push_back((b << 3) | (b >> 2));
+        }
+    }
+
+    std::vector<uint8_t> z = {0x78, 0x01};
+    uint32_t a = 1, b = 0;
+    for (size_t pos = 0; pos < raw.size();) {
+        size_t n = raw.size() - pos;
+        if (n > 65535) {
+            n = 65535;
+        }
+        z.push_back(pos + n == raw.size() ? 1 : 0);
+        z.push_back(n & 0xFF);
+        z.push_back(n >> 8);
+        z.push_back(~n & 0xFF);
+        z.push_back((~n >> 8) & 0xFF);
+        for (size_t i = 0; i < n; i++) {
+            uint8_t v = raw[pos + i];
+            z.push_back(v);
+            a = (a + v) % 65521;
+            b = (b + a) % 65521;
+        }
+        pos += n;
+    }
+    putBE32(z, (b << 16) | a);
+    writeChunk(f, "IDAT", z);
+    writeChunk(f, "IEND", std::vector<uint8_t>());
+    return fclose(f) == 0;
+}
@@ -0,0 +1,54 @@
+#ifndef _HOST_SIM_PANEL_H
+#define _HOST_SIM_PANEL_H
+
+#include <stdint.h>
+
+// Byte-level model of the ILI9341 behind the simulated Adafruit driver.
+// Commands and data are interpreted like the controller does (CASET/PASET
+// window, RAMWR pointer wrap, vertical scroll definition and start address)
+// into a 240x320 frame memory, and every byte on the bus is counted so the
+// SPI cost of a drawing path can be compared without hardware.
+
+#define SIM_PANEL_WIDTH 240
+#define SIM_PANEL_HEIGHT 320
+
+#ifndef SIM_PANEL_TRANSACTION_NS
+#define SIM_PANEL_TRANSACTION_NS 2000 // beginTransaction + CS toggle
+#endif
+
+#ifndef SIM_PANEL_COMMAND_NS
+#define SIM_PANEL_COMMAND_NS 400 // DC switch around a command byte
+#endif
+
+typedef struct
+{
+	uint32_t transactions; // CS assertions
+	uint32_t commands;
+	uint32_t windows;      // RAMWR commands
+	uint32_t scrolls;      // VSCRSADD commands
+	uint64_t data_bytes;   // Bytes sent with DC high, pixels included
+	uint64_t pixels;       // Pixels written into frame memory
+	uint64_t clipped;      // Pixels that fell outside the panel
+} sim_panel_stats_t;
+
+void simPanelReset(uint16_t fill = 0x0000);
+void simPanelResetStats();
+const sim_panel_stats_t* simPanelStats();
+
+// Wire time for the counted traffic at the given SPI clock
+uint32_t simPanelEstimateUs(const sim_panel_stats_t* stats, uint32_t spiFreq);
+
+// Bus events, driven by Adafruit_SPITFT
+void simPanelSelect(bool selected);
+void simPanelCommand(uint8_t cmd);
+void simPanelData(uint8_t b);
+void simPanelPixels(const uint16_t* colors, uint32_t len, bool bigEndian);
+void simPanelFill(uint16_t color, uint32_t len);
+
+// What the glass shows: frame memory with the vertical scroll applied,
+// host-order RGB565
+uint16_t simPanelVisiblePixel(int16_t x, int16_t y);
+uint32_t simPanelVisibleHash(); // FNV-1a over the visible frame
+bool simPanelWritePng(const char* path);
+
+#endif
@@ -0,0 +1,242 @@
+#include <Arduino.h>
+#include "LittleFS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "common.h"
+#include "animation.h"
+#include "image_display.h"
+#include "rect_update.h"
+#include "tft_blit.h"
+
+typedef struct
+{
+	uint8_t version;
+	uint8_t maxDrop;
+	uint16_t width;
+	uint16_t height;
+	uint16_t frames;
+	uint16_t loops;
+} anim_header_t;
+
+typedef struct
+{
+	uint16_t delay_ms;
+	uint8_t flags;
+	uint32_t length;
+} anim_frame_t;
+
+static uint32_t maxDurationMs = 0;
+static anim_stats_t last = {};
+static uint32_t played = 0;
+
+static uint16_t le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool readHeader(File& file, anim_header_t* out) {
+    uint8_t h[ANIM_HEADER_SIZE];
+    if (file.read(h, sizeof(h)) != sizeof(h) || memcmp(h, ANIM_MAGIC, 4) != 0) {
+        return false;
+    }
+    out->version = h[4];
+    out->maxDrop = h[5];
+    out->width = le16(h + 6);
+    out->height = le16(h + 8);
+    out->frames = le16(h + 10);
+    out->loops = le16(h + 12);
+    return out->version == ANIM_VERSION && out->frames > 0;
+}
+
+static bool readFrame(File& file, anim_frame_t* out) {
+    uint8_t h[ANIM_FRAME_HEADER_SIZE];
+    if (file.read(h, sizeof(h)) != sizeof(h)) {
+        return false;
+    }
+    out->delay_ms = max(le16(h), (uint16_t)ANIM_MIN_DELAY_MS);
+    out->flags = h[2];
+    out->length = le32(h + 4);
+    return true;
+}
+
+// Push one frame's rect message from the file through the decoder
+static bool drawFrame(File& file, const anim_frame_t* frame, rect_decoder_t* decoder, uint8_t* buf,
+                      uint32_t* decodeUs, uint32_t* pushUs) {
+    tftBlitResetStats();
+    rectDecoderBegin(decoder);
+    uint32_t left = frame->length;
+    while (left) {
+        size_t n = file.read(buf, min(left, (uint32_t)ANIM_READ_CHUNK));
+        if (n == 0) {
+            break;
+        }
+        rectDecoderWrite(decoder, buf, n);
+        left -= n;
+    }
+    rect_result_t result;
+    rectDecoderEnd(decoder, &result);
+    *pushUs = tftBlitStats()->push_us;
+    *decodeUs = result.us > *pushUs ? result.us - *pushUs : 0;
+    if (result.status != RECT_OK) {
+        ESP_LOGW(LOG_TAG_COMMON, "Animation frame: %s", rectStatusText(result.status));
+    }
+    return result.status == RECT_OK;
+}
+
+// Sleep until due (in esp_timer microseconds); false if superseded meanwhile
+static bool waitUntil(int64_t due) {
+    for (;;) {
+        if (displayRequestSuperseded()) {
+            return false;
+        }
+        int64_t wait = due - esp_timer_get_time();
+        if (wait <= 0) {
+            return true;
+        }
+        delay(min((int64_t)ANIM_POLL_MS, (wait + 999) / 1000));
+    }
+}
+
+bool animationIsFile(const char* filename) {
+    String lower = String(filename);
+    lower.toLowerCase();
+    return lower.endsWith(ANIM_EXTENSION);
+}
+
+void animationSetMaxDuration(uint32_t ms) {
+    maxDurationMs = ms;
+}
+
+bool animationPlay(const char* filename, uint16_t speedPercent, uint16_t loops, anim_stats_t* out) {
+    String path = String("/images/") + filename;
+    File file = LittleFS.open(path, "r");
+    anim_header_t header;
+    if (!file || !readHeader(file, &header)) {
+        ESP_LOGE(LOG_TAG_COMMON, "Not an animation: %s", path.c_str());
+        return false;
+    }
+    if (!speedPercent) {
+        speedPercent = 100;
+    }
+    if (!loops) {
+        loops = header.loops;
+    }
+    rect_decoder_t* decoder = rectDecoderCreate();
+    uint8_t* buf = (uint8_t*)malloc(ANIM_READ_CHUNK);
+    if (!decoder || !buf) {
+        rectDecoderFree(decoder);
+        free(buf);
+        return false;
+    }
+
+    displayLock();
+    if (header.width < tft.width() || header.height < tft.height()) {
+        tft.fillScreen(ILI9341_BLACK); // Letterbox around the canvas
+    }
+
+    anim_stats_t stats = {};
+    uint64_t decodeTotal = 0, pushTotal = 0, scheduledMs = 0;
+    uint32_t maxMs = maxDurationMs;
+    int64_t start = esp_timer_get_time();
+    int64_t due = start;
+    bool ok = true, stopped = false;
+    while (!stopped) {
+        file.seek(ANIM_HEADER_SIZE);
+        uint8_t dropsInRow = 0;
+        for (uint16_t i = 0; i < header.frames; i++) {
+            anim_frame_t frame;
+            if (!readFrame(file, &frame)) {
+                ok = false;
+                break;
+            }
+            int64_t step = (int64_t)frame.delay_ms * 1000 * 100 / speedPercent;
+            scheduledMs += frame.delay_ms;
+            int64_t late = esp_timer_get_time() - due;
+
+            // Behind by a whole frame: skip this one, the next covers its pixels.
+            // The last frame stays, so playback never ends on a stale one
+            bool droppable = !(frame.flags & ANIM_FRAME_KEY) && i + 1 < header.frames;
+            if (late >= step && droppable && dropsInRow < header.maxDrop) {
+                file.seek(frame.length, SeekCur);
+                stats.dropped++;
+                dropsInRow++;
+                due += step;
+                continue;
+            }
+            if (late > (int64_t)ANIM_RESYNC_MS * 1000) {
+                stats.resyncs++;
+                due = esp_timer_get_time();
+                late = 0;
+            }
+
+            uint32_t decodeUs, pushUs;
+            if (!drawFrame(file, &frame, decoder, buf, &decodeUs, &pushUs)) {
+                ok = false;
+                break;
+            }
+            dropsInRow = 0;
+            stats.frames++;
+            decodeTotal += decodeUs;
+            pushTotal += pushUs;
+            stats.decode_us_max = max(stats.decode_us_max, decodeUs);
+            stats.push_us_max = max(stats.push_us_max, pushUs);
+            stats.late_us_max = max(stats.late_us_max, (uint32_t)max(late, (int64_t)0));
+
+            due += step;
+            if (maxMs && (due - start) / 1000 >= maxMs) {
+                stopped = true;
+                break;
+            }
+            if (!waitUntil(due)) {
+                stopped = true;
+                break;
+            }
+        }
+        if (!ok) {
+            break;
+        }
+        if (!stopped) {
+            stats.loops++;
+            stopped = loops && stats.loops >= loops;
+        }
+    }
+    displayUnlock();
+    file.close();
+    rectDecoderFree(decoder);
+    free(buf);
+
+    stats.elapsed_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    uint32_t shown = stats.frames + stats.dropped;
+    stats.fps_x10 = stats.elapsed_ms ? (uint32_t)((uint64_t)stats.frames * 10000 / stats.elapsed_ms) : 0;
+    stats.target_fps_x10 = scheduledMs ? (uint32_t)((uint64_t)shown * 10000 * speedPercent / 100 / scheduledMs) : 0;
+    stats.decode_us_avg = stats.frames ? (uint32_t)(decodeTotal / stats.frames) : 0;
+    stats.push_us_avg = stats.frames ? (uint32_t)(pushTotal / stats.frames) : 0;
+    last = stats;
+    played++;
+    if (out) {
+        *out = stats;
+    }
+    Serial.printf("[ANIM] %s: %u frames, %u dropped, %u resyncs, %u.%u fps (target %u.%u), "
+                  "decode %u/%u us, push %u/%u us (avg/max)\n",
+                  filename, stats.frames, stats.dropped, stats.resyncs, stats.fps_x10 / 10, stats.fps_x10 % 10,
+                  stats.target_fps_x10 / 10, stats.target_fps_x10 % 10, stats.decode_us_avg, stats.decode_us_max,
+                  stats.push_us_avg, stats.push_us_max);
+    return stats.frames > 0;
+}
+
+void animationWriteMetrics(Print& out) {
+    out.printf("anim_played_total %u\n", played);
+    out.printf("anim_last_frames %u\n", last.frames);
+    out.printf("anim_last_dropped %u\n", last.dropped);
+    out.printf("anim_last_resyncs %u\n", last.resyncs);
+    out.printf("anim_last_fps %u.%u\n", last.fps_x10 / 10, last.fps_x10 % 10);
+    out.printf("anim_last_target_fps %u.%u\n", last.target_fps_x10 / 10, last.target_fps_x10 % 10);
+    out.printf("anim_last_decode_us_avg %u\n", last.decode_us_avg);
+    out.printf("anim_last_decode_us_max %u\n", last.decode_us_max);
+    out.printf("anim_last_push_us_avg %u\n", last.push_us_avg);
+    out.printf("anim_last_push_us_max %u\n", last.push_us_max);
+    out.printf("anim_last_late_us_max %u\n", last.late_us_max);
+}
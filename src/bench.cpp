@@ -0,0 +1,450 @@
+#include <Arduino.h>
+#include "LittleFS.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "common.h"
+#include "bench.h"
+#include "image_display.h"
+#include "tft_blit.h"
+#include "pixel_convert.h"
+#include "image_list.h"
+#include "image_catalog.h"
+#include "upload_session.h"
+#ifdef HOST_SIM
+#include "sim_panel.h"
+#endif
+
+// Corpus, in report order; see tools/bench_corpus.py
+static const char* const corpus[] = {
+    "card_q50.jpg",
+    "card_q75.jpg",
+    "card_q90.jpg",
+    "card_q75_prog.jpg",
+    "card_q90_prog.jpg",
+    "card_rgb.png",
+    "card_rgba.png",
+    "card_palette.png",
+    "card_pal4.png",
+    "card_gray.png",
+};
+
+// Animations, see tools/anim_tool.py corpus
+static const char* const animCorpus[] = {
+    "anim_ticker.anim",
+    "anim_ball.anim",
+    "anim_sweep.anim",
+};
+
+typedef struct
+{
+	const char* name;
+	uint8_t pixel_type;
+	uint8_t bit_depth;
+	uint8_t bits_per_pixel;
+} bench_kernel_t;
+
+static const bench_kernel_t kernels[] = {
+    {"gray1", PIXEL_TYPE_GRAYSCALE, 1, 1},
+    {"gray8", PIXEL_TYPE_GRAYSCALE, 8, 8},
+    {"gray16", PIXEL_TYPE_GRAYSCALE, 16, 16},
+    {"rgb8", PIXEL_TYPE_TRUECOLOR, 8, 24},
+    {"rgb16", PIXEL_TYPE_TRUECOLOR, 16, 48},
+    {"palette4", PIXEL_TYPE_INDEXED, 4, 4},
+    {"palette8", PIXEL_TYPE_INDEXED, 8, 8},
+    {"graya8", PIXEL_TYPE_GRAY_ALPHA, 8, 16},
+    {"rgba8", PIXEL_TYPE_TRUECOLOR_ALPHA, 8, 32},
+    {"rgba16", PIXEL_TYPE_TRUECOLOR_ALPHA, 16, 64},
+};
+
+static const char* formatOf(const char* name) {
+    const char* dot = strrchr(name, '.');
+    return dot && !strcmp(dot, ".png") ? "png" : "jpeg";
+}
+
+static void benchImage(Print& out, const char* name, uint16_t runs) {
+    String file = BENCH_DIR "/";
+    file += name;
+
+    File f = LittleFS.open("/images/" + file, "r");
+    if (!f) {
+        out.printf("{\"type\":\"image\",\"file\":\"%s\",\"error\":\"missing\"}\n", name);
+        return;
+    }
+    uint32_t fileSize = f.size();
+    f.close();
+
+    uint32_t minUs = UINT32_MAX, maxUs = 0, okRuns = 0;
+    uint64_t totalUs = 0;
+    for (uint16_t i = 0; i < runs; i++) {
+        tftBlitResetStats();
+#ifdef HOST_SIM
+        simPanelResetStats();
+#endif
+        int64_t start = esp_timer_get_time();
+        bool ok = displayDecodeUncached(file.c_str());
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+        if (!ok) {
+            continue;
+        }
+        okRuns++;
+        totalUs += us;
+        minUs = min(minUs, us);
+        maxUs = max(maxUs, us);
+    }
+
+    // Traffic figures are from the last run; they do not vary between runs
+    const tft_blit_stats_t* blit = tftBlitStats();
+    out.printf("{\"type\":\"image\",\"file\":\"%s\",\"format\":\"%s\",\"file_bytes\":%u,\"runs\":%u,\"ok\":%u",
+               name, formatOf(name), fileSize, runs, okRuns);
+    if (okRuns) {
+        out.printf(",\"ms_avg\":%.2f,\"us_min\":%u,\"us_max\":%u", totalUs / 1000.0 / okRuns, minUs, maxUs);
+    } else {
+        out.print(",\"error\":\"decode failed\"");
+    }
+    out.printf(",\"bytes_read\":%u,\"windows\":%u,\"transfers\":%u,\"pixels\":%u,\"spi_wait_us\":%u",
+               displayLastBytesRead(), blit->windows, blit->transfers, blit->pixels, blit->wait_us);
+#ifdef HOST_SIM
+    const sim_panel_stats_t* panel = simPanelStats();
+    out.printf(",\"spi_transactions\":%u,\"spi_commands\":%u,\"spi_bytes\":%llu,\"spi_est_us\":%u",
+               panel->transactions, panel->commands, (unsigned long long)panel->data_bytes,
+               simPanelEstimateUs(panel, TFT_SPI_FREQ));
+#endif
+    out.print("}\n");
+}
+
+// Time one conversion kernel over a frame of synthetic rows
+static void benchKernel(Print& out, const bench_kernel_t* k, uint8_t* src, size_t srcSize, uint16_t* dst) {
+    pixel_row_kernel_t kernel = pixelSelectRowKernel(k->pixel_type, k->bit_depth);
+    if (!kernel) {
+        out.printf("{\"type\":\"kernel\",\"format\":\"%s\",\"error\":\"unsupported\"}\n", k->name);
+        return;
+    }
+
+    static uint16_t lut[256];
+    uint8_t palette[768];
+    for (int i = 0; i < 768; i++) {
+        palette[i] = src[i % srcSize];
+    }
+    pixel_context_t ctx;
+    ctx.lut = lut;
+    pixelSetBackground(&ctx, ILI9341_BLACK);
+    if (k->pixel_type == PIXEL_TYPE_INDEXED) {
+        pixelBuildPaletteLut(lut, palette, false, &ctx);
+    } else if (k->pixel_type == PIXEL_TYPE_GRAYSCALE) {
+        pixelBuildGrayLut(lut, k->bit_depth);
+    }
+
+    // Rows cycle through the buffer so every row starts on fresh data
+    size_t rowBytes = ((size_t)ILI9341_TFTWIDTH * k->bits_per_pixel + 7) / 8;
+    size_t rowsInBuffer = srcSize / rowBytes;
+    int64_t start = esp_timer_get_time();
+    for (uint16_t row = 0; row < BENCH_KERNEL_ROWS; row++) {
+        kernel(src + (row % rowsInBuffer) * rowBytes, dst, ILI9341_TFTWIDTH, &ctx);
+    }
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    uint32_t pixels = (uint32_t)ILI9341_TFTWIDTH * BENCH_KERNEL_ROWS;
+    out.printf("{\"type\":\"kernel\",\"format\":\"%s\",\"rows\":%u,\"us\":%u,\"ns_per_px\":%.1f}\n",
+               k->name, BENCH_KERNEL_ROWS, us, us * 1000.0 / pixels);
+}
+
+void benchRun(Print& out, uint16_t runs) {
+    if (runs == 0) {
+        runs = 1;
+    }
+    if (runs > BENCH_MAX_RUNS) {
+        runs = BENCH_MAX_RUNS;
+    }
+#ifdef HOST_SIM
+    const char* target = "host";
+#else
+    const char* target = "device";
+#endif
+    out.printf("{\"type\":\"begin\",\"target\":\"%s\",\"version\":\"%s\",\"runs\":%u,\"spi_hz\":%u,\"heap_free\":%u}\n",
+               target, VERSION, runs, (uint32_t)TFT_SPI_FREQ, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+
+    int64_t start = esp_timer_get_time();
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        benchImage(out, corpus[i], runs);
+    }
+
+    // Synthetic source: 8 rows of the widest format (16-bit RGBA)
+    const size_t srcSize = (size_t)ILI9341_TFTWIDTH * 8 * 8;
+    uint8_t* src = (uint8_t*)malloc(srcSize);
+    uint16_t* dst = (uint16_t*)malloc(ILI9341_TFTWIDTH * 2);
+    if (src && dst) {
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < srcSize; i++) {
+            seed = seed * 1103515245 + 12345;
+            src[i] = (uint8_t)(seed >> 16);
+        }
+        for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+            benchKernel(out, &kernels[i], src, srcSize, dst);
+        }
+    } else {
+        out.print("{\"type\":\"kernel\",\"error\":\"no memory\"}\n");
+    }
+    free(src);
+    free(dst);
+
+    out.printf("{\"type\":\"end\",\"ms\":%u,\"heap_free\":%u}\n",
+               (uint32_t)((esp_timer_get_time() - start) / 1000), heap_caps_get_free_size(MALLOC_CAP_8BIT));
+}
+
+// Listing as /images built it before image_list: one String grown per file
+static size_t legacyListing(const char* dir, size_t* peakHeap, size_t heapBefore) {
+    String json = "{\"images\":[";
+    File root = LittleFS.open(dir);
+    if (root) {
+        File file = root.openNextFile();
+        bool first = true;
+        while (file) {
+            if (!file.isDirectory()) {
+                if (!first) json += ",";
+                json += "{\"name\":\"" + String(file.name()) + "\",\"size\":" + String(file.size()) + "}";
+                first = false;
+                size_t used = heapBefore - heap_caps_get_free_size(MALLOC_CAP_8BIT);
+                *peakHeap = max(*peakHeap, used);
+            }
+            file = root.openNextFile();
+        }
+        root.close();
+    }
+    json += "]}";
+    return json.length();
+}
+
+static void benchListMode(Print& out, uint16_t files, const char* mode, image_sort_t sort, uint8_t* chunk,
+                          image_catalog_t* catalog) {
+    size_t heapBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t peakHeap = 0;
+    size_t bytes = 0;
+    size_t stateBytes = 0;
+    uint32_t chunks = 0;
+    int64_t start = esp_timer_get_time();
+
+    if (!strcmp(mode, "legacy")) {
+        bytes = legacyListing(BENCH_LIST_DIR, &peakHeap, heapBefore);
+        stateBytes = bytes; // The whole document sits in one String
+    } else {
+        image_list_query_t query = {0, 0, sort, false};
+        String error;
+        image_list_t* list = imageListOpen(catalog, &query, &error);
+        if (!list) {
+            out.printf("{\"type\":\"list\",\"files\":%u,\"mode\":\"%s\",\"error\":\"%s\"}\n", files, mode, error.c_str());
+            return;
+        }
+        stateBytes = imageListMemory(list);
+        size_t n;
+        while ((n = imageListFill(list, chunk, BENCH_LIST_CHUNK)) > 0) {
+            bytes += n;
+            chunks++;
+            size_t used = heapBefore - heap_caps_get_free_size(MALLOC_CAP_8BIT);
+            peakHeap = max(peakHeap, used);
+        }
+        imageListClose(list);
+    }
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    out.printf("{\"type\":\"list\",\"files\":%u,\"mode\":\"%s\",\"us\":%u,\"bytes\":%u,\"chunks\":%u,"
+               "\"state_bytes\":%u,\"peak_heap\":%u,\"largest_free\":%u}\n",
+               files, mode, us, bytes, chunks, stateBytes, peakHeap, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
+
+// Name lookups of every created file, from the catalog and from the filesystem
+static void benchLookups(Print& out, uint16_t files, image_catalog_t* catalog) {
+    char name[32];
+    char path[48];
+    uint32_t found = 0;
+    int64_t start = esp_timer_get_time();
+    for (uint16_t i = 0; i < BENCH_LIST_LOOKUPS; i++) {
+        snprintf(name, sizeof(name), "card_%04u.jpg", (unsigned)(((i % files) * 7919u) % 10000));
+        found += imageCatalogContains(catalog, name);
+    }
+    uint32_t catalogUs = (uint32_t)(esp_timer_get_time() - start);
+    start = esp_timer_get_time();
+    for (uint16_t i = 0; i < BENCH_LIST_LOOKUPS; i++) {
+        snprintf(path, sizeof(path), BENCH_LIST_DIR "/card_%04u.jpg", (unsigned)(((i % files) * 7919u) % 10000));
+        found += LittleFS.exists(path);
+    }
+    uint32_t existsUs = (uint32_t)(esp_timer_get_time() - start);
+    out.printf("{\"type\":\"lookup\",\"files\":%u,\"lookups\":%u,\"found\":%u,\"catalog_us\":%u,\"exists_us\":%u}\n",
+               files, BENCH_LIST_LOOKUPS, found, catalogUs, existsUs);
+}
+
+static void clearListDir() {
+    File dir = LittleFS.open(BENCH_LIST_DIR);
+    if (!dir) {
+        return;
+    }
+    String path;
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        path = BENCH_LIST_DIR "/";
+        path += f.name();
+        f.close();
+        LittleFS.remove(path);
+    }
+    dir.close();
+    LittleFS.rmdir(BENCH_LIST_DIR);
+    LittleFS.remove(BENCH_LIST_CATALOG);
+}
+
+void benchListing(Print& out, uint16_t files) {
+    clearListDir();
+    if (!LittleFS.mkdir(BENCH_LIST_DIR)) {
+        out.print("{\"type\":\"list\",\"error\":\"mkdir failed\"}\n");
+        return;
+    }
+    uint8_t* chunk = (uint8_t*)malloc(BENCH_LIST_CHUNK);
+    if (!chunk) {
+        out.print("{\"type\":\"list\",\"error\":\"no memory\"}\n");
+        return;
+    }
+
+    image_catalog_t* catalog = imageCatalogOpen(BENCH_LIST_DIR, BENCH_LIST_CATALOG);
+    const uint16_t steps[] = {(uint16_t)(files / 5), (uint16_t)(files / 2), files};
+    uint16_t created = 0;
+    char path[48];
+    for (uint16_t s = 0; s < sizeof(steps) / sizeof(steps[0]); s++) {
+        // Small files with distinct sizes, so size sorting has work to do
+        for (; created < steps[s]; created++) {
+            snprintf(path, sizeof(path), BENCH_LIST_DIR "/card_%04u.jpg", (unsigned)((created * 7919u) % 10000));
+            File f = LittleFS.open(path, "w");
+            if (!f) {
+                out.printf("{\"type\":\"list\",\"error\":\"create failed at %u\"}\n", created);
+                free(chunk);
+                imageCatalogClose(catalog);
+                clearListDir();
+                return;
+            }
+            for (uint16_t b = 0; b < 8 + created % 24; b++) {
+                f.write((uint8_t)b);
+            }
+            f.close();
+        }
+        // Only the files added since the last step are probed
+        int64_t start = esp_timer_get_time();
+        uint32_t probed = imageCatalogScan(catalog);
+        out.printf("{\"type\":\"scan\",\"files\":%u,\"probed\":%u,\"us\":%u,\"catalog_bytes\":%u}\n",
+                   created, probed, (uint32_t)(esp_timer_get_time() - start), imageCatalogMemory(catalog));
+
+        benchListMode(out, created, "legacy", IMAGE_SORT_NONE, chunk, catalog);
+        benchListMode(out, created, "name", IMAGE_SORT_NAME, chunk, catalog);
+        benchListMode(out, created, "size", IMAGE_SORT_SIZE, chunk, catalog);
+        benchListMode(out, created, "mtime", IMAGE_SORT_MTIME, chunk, catalog);
+        benchLookups(out, created, catalog);
+    }
+
+    free(chunk);
+    imageCatalogClose(catalog);
+    clearListDir();
+}
+
+// One pass of the old handler: every chunk written where it lands
+static bool legacyUpload(const uint8_t* chunk, uint32_t bytes, uint32_t* writes, uint32_t* maxChunkUs) {
+    File f = LittleFS.open("/" BENCH_UPLOAD_NAME, "w");
+    if (!f) {
+        return false;
+    }
+    bool ok = true;
+    for (uint32_t done = 0; done < bytes && ok;) {
+        size_t n = min((uint32_t)BENCH_LIST_CHUNK, bytes - done);
+        int64_t start = esp_timer_get_time();
+        ok = f.write(chunk, n) == n;
+        *maxChunkUs = max(*maxChunkUs, (uint32_t)(esp_timer_get_time() - start));
+        done += n;
+        (*writes)++;
+    }
+    f.close();
+    return ok;
+}
+
+// Total time includes waiting for the storage task to finish
+static bool sessionUpload(const uint8_t* chunk, uint32_t bytes, uint32_t* writes, uint32_t* maxChunkUs) {
+    upload_session_t* session = uploadBegin("", BENCH_UPLOAD_NAME, bytes);
+    for (uint32_t done = 0; done < bytes;) {
+        size_t n = min((uint32_t)BENCH_LIST_CHUNK, bytes - done);
+        uploadWrite(session, chunk, n);
+        done += n;
+    }
+    bool ok = uploadCommit(session) && uploadWait(session);
+    if (session) {
+        upload_stats_t stats;
+        uploadStats(session, &stats);
+        *writes = stats.writes;
+        *maxChunkUs = stats.max_write_us;
+    }
+    uploadEnd(session);
+    return ok;
+}
+
+void benchUpload(Print& out, uint32_t bytes) {
+    uint8_t* chunk = (uint8_t*)malloc(BENCH_LIST_CHUNK);
+    if (!chunk) {
+        out.print("{\"type\":\"upload\",\"error\":\"no memory\"}\n");
+        return;
+    }
+    // Incompressible and not block-aligned, like a JPEG arriving over TCP
+    uint32_t seed = 0x12345678;
+    for (size_t i = 0; i < BENCH_LIST_CHUNK; i++) {
+        seed = seed * 1103515245u + 12345u;
+        chunk[i] = (uint8_t)(seed >> 24);
+    }
+
+    static const char* const modes[] = {"direct", "session"};
+    for (uint8_t run = 0; run < BENCH_UPLOAD_RUNS; run++) {
+        for (uint8_t m = 0; m < 2; m++) {
+            LittleFS.remove("/" BENCH_UPLOAD_NAME);
+            uint32_t writes = 0;
+            uint32_t maxChunkUs = 0;
+            int64_t start = esp_timer_get_time();
+            bool ok = m ? sessionUpload(chunk, bytes, &writes, &maxChunkUs)
+                        : legacyUpload(chunk, bytes, &writes, &maxChunkUs);
+            uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+            uint32_t kbps = us ? (uint32_t)((uint64_t)bytes * 1000000 / 1024 / us) : 0;
+            out.printf("{\"type\":\"upload\",\"mode\":\"%s\",\"run\":%u,\"ok\":%s,\"bytes\":%u,\"writes\":%u,"
+                       "\"us\":%u,\"kbps\":%u,\"max_chunk_us\":%u}\n",
+                       modes[m], run, ok ? "true" : "false", bytes, writes, us, kbps, maxChunkUs);
+        }
+    }
+    LittleFS.remove("/" BENCH_UPLOAD_NAME);
+    free(chunk);
+}
+
+static void benchAnimationFile(Print& out, const char* name, uint16_t speedPercent) {
+    String file = BENCH_DIR "/";
+    file += name;
+    if (!LittleFS.exists("/images/" + file)) {
+        out.printf("{\"type\":\"anim\",\"file\":\"%s\",\"error\":\"missing\"}\n", name);
+        return;
+    }
+#ifdef HOST_SIM
+    simPanelResetStats();
+#endif
+    anim_stats_t stats;
+    if (!displayAnimation(file.c_str(), speedPercent, 1, &stats)) {
+        out.printf("{\"type\":\"anim\",\"file\":\"%s\",\"error\":\"playback failed\"}\n", name);
+        return;
+    }
+    out.printf("{\"type\":\"anim\",\"file\":\"%s\",\"speed\":%u,\"frames\":%u,\"dropped\":%u,\"resyncs\":%u,"
+               "\"ms\":%u,\"fps\":%u.%u,\"target_fps\":%u.%u,\"decode_us_avg\":%u,\"decode_us_max\":%u,"
+               "\"push_us_avg\":%u,\"push_us_max\":%u,\"late_us_max\":%u",
+               name, speedPercent, stats.frames, stats.dropped, stats.resyncs, stats.elapsed_ms,
+               stats.fps_x10 / 10, stats.fps_x10 % 10, stats.target_fps_x10 / 10, stats.target_fps_x10 % 10,
+               stats.decode_us_avg, stats.decode_us_max, stats.push_us_avg, stats.push_us_max, stats.late_us_max);
+#ifdef HOST_SIM
+    const sim_panel_stats_t* panel = simPanelStats();
+    out.printf(",\"spi_bytes\":%llu,\"spi_est_us_per_frame\":%u", (unsigned long long)panel->data_bytes,
+               stats.frames ? simPanelEstimateUs(panel, TFT_SPI_FREQ) / stats.frames : 0);
+#endif
+    out.print("}\n");
+}
+
+void benchAnimation(Print& out, uint16_t speedPercent) {
+    if (speedPercent == 0) {
+        speedPercent = BENCH_ANIM_FAST_PERCENT;
+    }
+    for (size_t i = 0; i < sizeof(animCorpus) / sizeof(animCorpus[0]); i++) {
+        benchAnimationFile(out, animCorpus[i], 100);
+        benchAnimationFile(out, animCorpus[i], speedPercent);
+    }
+}
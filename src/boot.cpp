@@ -0,0 +1,130 @@
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <ESPAsyncWebServer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "common.h"
+#include "boot.h"
+#include "ethernet.h"
+#include "playlist.h"
+
+#define BOOT_STORAGE_DONE BIT0
+#define BOOT_SERVICES_DONE BIT1
+
+static boot_phase_t phases[BOOT_MAX_PHASES];
+static uint8_t phaseCount = 0;
+static portMUX_TYPE phaseLock = portMUX_INITIALIZER_UNLOCKED;
+
+static EventGroupHandle_t bootEvents = nullptr;
+static bool storageMounted = false;
+
+// What NVS holds, so unchanged values are not written again
+static boot_settings_t saved = {};
+
+void bootMark(const char* phase) {
+    uint32_t ms = (uint32_t)(esp_timer_get_time() / 1000);
+    portENTER_CRITICAL(&phaseLock);
+    if (phaseCount < BOOT_MAX_PHASES) {
+        phases[phaseCount].name = phase;
+        phases[phaseCount].ms = ms;
+        phaseCount++;
+    }
+    portEXIT_CRITICAL(&phaseLock);
+    Serial.printf("[BOOT] %5u ms %s\n", ms, phase);
+}
+
+void bootLoadSettings(boot_settings_t* out) {
+    Preferences prefs;
+    memset(&saved, 0, sizeof(saved));
+    if (prefs.begin(BOOT_NVS_NAMESPACE, true)) {
+        prefs.getString("image", saved.image, sizeof(saved.image));
+        saved.progressive = prefs.getBool("progressive", false);
+        saved.playlist = prefs.getBool("playlist", false);
+        prefs.end();
+    }
+    *out = saved;
+}
+
+void bootRememberImage(const char* filename, bool progressive) {
+    if (strcmp(saved.image, filename) == 0 && saved.progressive == progressive) {
+        return;
+    }
+    Preferences prefs;
+    if (!prefs.begin(BOOT_NVS_NAMESPACE, false)) {
+        ESP_LOGW(LOG_TAG_COMMON, "Boot settings: NVS not available");
+        return;
+    }
+    prefs.putString("image", filename);
+    prefs.putBool("progressive", progressive);
+    prefs.end();
+    strlcpy(saved.image, filename, sizeof(saved.image));
+    saved.progressive = progressive;
+}
+
+void bootRememberPlaylist(bool running) {
+    if (saved.playlist == running) {
+        return;
+    }
+    Preferences prefs;
+    if (!prefs.begin(BOOT_NVS_NAMESPACE, false)) {
+        ESP_LOGW(LOG_TAG_COMMON, "Boot settings: NVS not available");
+        return;
+    }
+    prefs.putBool("playlist", running);
+    prefs.end();
+    saved.playlist = running;
+}
+
+// Storage first, since setup() is waiting on it to redraw the last image;
+// the network comes up behind it
+static void bootTask(void* param) {
+    storageMounted = storage_init();
+    bootMark("fs");
+    xEventGroupSetBits(bootEvents, BOOT_STORAGE_DONE);
+
+    if (storageMounted) {
+        ethernet_init();
+    }
+    playlistInit();
+    bootMark("services");
+    xEventGroupSetBits(bootEvents, BOOT_SERVICES_DONE);
+    vTaskDelete(nullptr);
+}
+
+void bootStartServices() {
+    bootEvents = xEventGroupCreate();
+    xTaskCreate(bootTask, "boot", BOOT_TASK_STACK, nullptr, TASK_PRIO_BOOT, nullptr);
+}
+
+static bool waitFor(EventBits_t bit, uint32_t timeoutMs) {
+    if (!bootEvents) {
+        return false;
+    }
+    return xEventGroupWaitBits(bootEvents, bit, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeoutMs)) & bit;
+}
+
+bool bootWaitStorage(uint32_t timeoutMs) {
+    return waitFor(BOOT_STORAGE_DONE, timeoutMs) && storageMounted;
+}
+
+bool bootWaitServices(uint32_t timeoutMs) {
+    return waitFor(BOOT_SERVICES_DONE, timeoutMs);
+}
+
+void bootPrintTimeline(Print& out) {
+    uint32_t prev = 0;
+    for (uint8_t i = 0; i < phaseCount; i++) {
+        out.printf("[BOOT] %5u ms (+%u) %s\n", phases[i].ms, phases[i].ms - prev, phases[i].name);
+        prev = phases[i].ms;
+    }
+}
+
+void bootWriteMetrics(Print& out) {
+    for (uint8_t i = 0; i < phaseCount; i++) {
+        out.printf("boot_phase_ms{phase=\"%s\"} %u\n", phases[i].name, phases[i].ms);
+    }
+}
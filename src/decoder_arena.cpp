@@ -0,0 +1,41 @@
+#include <Arduino.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "common.h"
+#include "decoder_arena.h"
+
+static void* arenaBlock = nullptr;
+static size_t arenaSize = 0;
+
+void* decoderArenaAcquire(size_t size) {
+    if (arenaBlock) {
+        ESP_LOGW(LOG_TAG_COMMON, "Decoder arena already in use");
+        return nullptr;
+    }
+    decoderHeapReport("before");
+    arenaBlock = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    if (!arenaBlock) {
+        ESP_LOGE(LOG_TAG_COMMON, "Decoder arena allocation failed (%d bytes)", size);
+        return nullptr;
+    }
+    arenaSize = size;
+    ESP_LOGI(LOG_TAG_COMMON, "Decoder arena: %d bytes", size);
+    return arenaBlock;
+}
+
+void decoderArenaRelease() {
+    if (!arenaBlock) {
+        return;
+    }
+    heap_caps_free(arenaBlock);
+    arenaBlock = nullptr;
+    arenaSize = 0;
+    decoderHeapReport("after");
+}
+
+void decoderHeapReport(const char* stage) {
+    size_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    ESP_LOGI(LOG_TAG_COMMON, "Heap %s: free=%d largest=%d", stage, freeBytes, largest);
+    Serial.printf("[HEAP] %-6s free=%u largest=%u arena=%u\n", stage, freeBytes, largest, arenaSize);
+}
@@ -0,0 +1,527 @@
+#include <Arduino.h>
+#include "LittleFS.h"
+#include "esp_log.h"
+#include "common.h"
+#include "display_cache.h"
+#include "tft_blit.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// Capture state - decoder output is collected into a band of full-width rows
+// and appended to the sidecar once the decoder moves past the band.
+static File captureFile;
+static uint16_t* captureBand = nullptr;
+static int16_t captureBandY = 0;
+static uint16_t captureBandRows = 0;
+static uint16_t captureNextRow = 0;
+static bool captureFailed = false;
+static String captureSource;
+static uint32_t* captureTiles = nullptr;
+
+// Tile hashes of what is on the panel right now, if it is a cached frame
+static uint32_t screenTiles[DISPLAY_TILE_COUNT];
+static bool screenTilesValid = false;
+
+#define TILE_HASH_SEED 2166136261u // FNV-1a offset basis
+
+#define SIDECAR_BYTES (sizeof(display_cache_header_t) + (size_t)DISPLAY_CACHE_WIDTH * DISPLAY_CACHE_HEIGHT * 2 + \
+                       sizeof(uint32_t) + DISPLAY_TILE_COUNT * 4)
+
+// Images with a sidecar, most recently drawn first. Invalidation also comes
+// from the storage task and async_tcp, hence the lock
+static String recent[DISPLAY_CACHE_MAX_ENTRIES];
+static uint8_t recentCount = 0;
+static SemaphoreHandle_t recentLock = nullptr;
+static uint32_t evictions = 0;
+
+static String tilesPath(const char* filename) {
+    String path = DISPLAY_CACHE_DIR "/";
+    path += filename;
+    path += DISPLAY_TILES_EXT;
+    return path;
+}
+
+// Fold one full-width row into the hashes of the tiles it crosses,
+// a 32-bit word (two pixels) at a time
+static void hashRow(uint32_t* tiles, uint16_t row, const uint16_t* pixels) {
+    uint32_t* tileRow = tiles + (row / DISPLAY_TILE_SIZE) * DISPLAY_TILE_COLS;
+    const uint32_t* words = (const uint32_t*)pixels;
+    for (uint16_t tx = 0; tx < DISPLAY_TILE_COLS; tx++) {
+        uint32_t h = tileRow[tx];
+        for (uint16_t i = 0; i < DISPLAY_TILE_SIZE / 2; i++) {
+            h = (h ^ *words++) * 16777619u;
+        }
+        tileRow[tx] = h;
+    }
+}
+
+static bool loadTiles(const char* filename, uint32_t* tiles) {
+    File file = LittleFS.open(tilesPath(filename), "r");
+    if (!file) {
+        return false;
+    }
+    uint32_t magic = 0;
+    bool ok = file.size() == sizeof(magic) + DISPLAY_TILE_COUNT * 4 &&
+              file.read((uint8_t*)&magic, sizeof(magic)) == sizeof(magic) &&
+              magic == DISPLAY_TILES_MAGIC &&
+              file.read((uint8_t*)tiles, DISPLAY_TILE_COUNT * 4) == DISPLAY_TILE_COUNT * 4;
+    file.close();
+    return ok;
+}
+
+static bool readSourceStat(const char* filename, uint32_t* size, uint32_t* mtime) {
+    String path = "/images/";
+    path += filename;
+    File src = LittleFS.open(path, "r");
+    if (!src) {
+        return false;
+    }
+    *size = src.size();
+    *mtime = (uint32_t)src.getLastWrite();
+    src.close();
+    return true;
+}
+
+static bool writeZeroRows(uint16_t rows) {
+    static const uint16_t zeros[DISPLAY_CACHE_WIDTH] = {0};
+    for (uint16_t i = 0; i < rows; i++) {
+        if (captureFile.write((const uint8_t*)zeros, sizeof(zeros)) != sizeof(zeros)) {
+            return false;
+        }
+        hashRow(captureTiles, captureNextRow + i, zeros);
+    }
+    return true;
+}
+
+static void flushCaptureBand() {
+    if (captureBandRows == 0 || captureFailed) {
+        return;
+    }
+    size_t bytes = (size_t)DISPLAY_CACHE_WIDTH * captureBandRows * 2;
+    if (captureFile.write((const uint8_t*)captureBand, bytes) != bytes) {
+        ESP_LOGE(LOG_TAG_COMMON, "Cache write failed at row %d", captureBandY);
+        captureFailed = true;
+    }
+    for (uint16_t row = 0; row < captureBandRows; row++) {
+        hashRow(captureTiles, captureBandY + row, captureBand + row * DISPLAY_CACHE_WIDTH);
+    }
+    captureNextRow = captureBandY + captureBandRows;
+    captureBandRows = 0;
+    memset(captureBand, 0, (size_t)DISPLAY_CACHE_WIDTH * DISPLAY_CACHE_BAND_ROWS * 2);
+}
+
+static void removeSidecar(const char* filename) {
+    String path = displayCachePath(filename);
+    if (LittleFS.exists(path)) {
+        LittleFS.remove(path);
+        ESP_LOGI(LOG_TAG_COMMON, "Invalidated display cache: %s", path.c_str());
+    }
+    path = tilesPath(filename);
+    if (LittleFS.exists(path)) {
+        LittleFS.remove(path);
+    }
+}
+
+// Drop filename from the recency list; the caller holds recentLock
+static void forget(const char* filename) {
+    for (uint8_t i = 0; i < recentCount; i++) {
+        if (recent[i] == filename) {
+            for (uint8_t j = i + 1; j < recentCount; j++) {
+                recent[j - 1] = recent[j];
+            }
+            recent[--recentCount] = String();
+            return;
+        }
+    }
+}
+
+// Remove the least recently drawn sidecar; false when there is none
+static bool evictOldest() {
+    xSemaphoreTake(recentLock, portMAX_DELAY);
+    String victim = recentCount ? recent[recentCount - 1] : String();
+    if (recentCount) {
+        recent[--recentCount] = String();
+    }
+    xSemaphoreGive(recentLock);
+    if (!victim.length()) {
+        return false;
+    }
+    removeSidecar(victim.c_str());
+    evictions++;
+    ESP_LOGI(LOG_TAG_COMMON, "Display cache evicted %s", victim.c_str());
+    return true;
+}
+
+// filename was just drawn from (or into) its sidecar
+static void touch(const char* filename) {
+    xSemaphoreTake(recentLock, portMAX_DELAY);
+    forget(filename);
+    bool full = recentCount == DISPLAY_CACHE_MAX_ENTRIES;
+    xSemaphoreGive(recentLock);
+    if (full) {
+        evictOldest();
+    }
+    xSemaphoreTake(recentLock, portMAX_DELAY);
+    for (uint8_t i = recentCount; i > 0; i--) {
+        recent[i] = recent[i - 1];
+    }
+    recent[0] = filename;
+    recentCount++;
+    xSemaphoreGive(recentLock);
+}
+
+static size_t freeBytes() {
+    size_t total = LittleFS.totalBytes();
+    size_t used = LittleFS.usedBytes();
+    return used < total ? total - used : 0;
+}
+
+void displayCacheInit() {
+    if (!recentLock) {
+        recentLock = xSemaphoreCreateMutex();
+    }
+    if (!LittleFS.exists(DISPLAY_CACHE_DIR)) {
+        if (LittleFS.mkdir(DISPLAY_CACHE_DIR)) {
+            ESP_LOGI(LOG_TAG_COMMON, "Created %s directory", DISPLAY_CACHE_DIR);
+            Serial.printf("[FS] Created %s directory for display cache\n", DISPLAY_CACHE_DIR);
+        } else {
+            ESP_LOGE(LOG_TAG_COMMON, "Failed to create %s directory", DISPLAY_CACHE_DIR);
+            Serial.printf("[FS] ERROR: Failed to create %s directory\n", DISPLAY_CACHE_DIR);
+        }
+        return;
+    }
+
+    // Write time stands in for the last draw across reboots; sidecars of
+    // images that are gone, and the oldest beyond the budget, are removed
+    String names[DISPLAY_CACHE_MAX_ENTRIES + 1];
+    time_t times[DISPLAY_CACHE_MAX_ENTRIES + 1];
+    uint8_t count = 0;
+    File dir = LittleFS.open(DISPLAY_CACHE_DIR);
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        String name = f.name();
+        time_t written = f.getLastWrite();
+        f.close();
+        if (!name.endsWith(DISPLAY_CACHE_EXT)) {
+            continue;
+        }
+        name = name.substring(0, name.length() - strlen(DISPLAY_CACHE_EXT));
+        uint32_t size, mtime;
+        if (!readSourceStat(name.c_str(), &size, &mtime)) {
+            removeSidecar(name.c_str());
+            continue;
+        }
+        // Newest first; one slot past the budget takes the overflow
+        uint8_t at = count;
+        while (at > 0 && times[at - 1] < written) {
+            at--;
+        }
+        for (uint8_t i = count; i > at; i--) {
+            names[i] = names[i - 1];
+            times[i] = times[i - 1];
+        }
+        names[at] = name;
+        times[at] = written;
+        if (++count > DISPLAY_CACHE_MAX_ENTRIES) {
+            removeSidecar(names[--count].c_str());
+            evictions++;
+        }
+    }
+    dir.close();
+
+    xSemaphoreTake(recentLock, portMAX_DELAY);
+    for (uint8_t i = 0; i < count; i++) {
+        recent[i] = names[i];
+    }
+    recentCount = count;
+    xSemaphoreGive(recentLock);
+    ESP_LOGI(LOG_TAG_COMMON, "Display cache: %u of %u sidecars", count, DISPLAY_CACHE_MAX_ENTRIES);
+}
+
+String displayCachePath(const char* filename) {
+    String path = DISPLAY_CACHE_DIR "/";
+    path += filename;
+    path += DISPLAY_CACHE_EXT;
+    return path;
+}
+
+bool displayCacheValid(const char* filename) {
+    File cache = LittleFS.open(displayCachePath(filename), "r");
+    if (!cache) {
+        return false;
+    }
+
+    display_cache_header_t header;
+    size_t expected = sizeof(header) + (size_t)DISPLAY_CACHE_WIDTH * DISPLAY_CACHE_HEIGHT * 2;
+    bool valid = cache.size() == expected &&
+                 cache.read((uint8_t*)&header, sizeof(header)) == sizeof(header);
+    cache.close();
+
+    uint32_t size, mtime;
+    if (!valid || !readSourceStat(filename, &size, &mtime)) {
+        return false;
+    }
+    return header.magic == DISPLAY_CACHE_MAGIC &&
+           header.width == DISPLAY_CACHE_WIDTH &&
+           header.height == DISPLAY_CACHE_HEIGHT &&
+           header.source_size == size &&
+           header.source_mtime == mtime;
+}
+
+// Push every 16-row band of the sidecar into one full-frame window
+static bool drawFullFrame(File& cache) {
+    // Flash reads of the next strip overlap the DMA transfer of the previous
+    // one; all strips continue the same full-frame address window
+    size_t stripBytes = (size_t)DISPLAY_CACHE_WIDTH * DISPLAY_CACHE_READ_ROWS * 2;
+    for (uint16_t y = 0; y < DISPLAY_CACHE_HEIGHT; y += DISPLAY_CACHE_READ_ROWS) {
+        if (cache.read((uint8_t*)tftBlitBuffer(), stripBytes) != stripBytes) {
+            return false;
+        }
+        tftBlitCommit(0, y, DISPLAY_CACHE_WIDTH, DISPLAY_CACHE_READ_ROWS);
+    }
+    return true;
+}
+
+// Push only the tiles that differ from the panel, one rectangle per run of
+// adjacent changed tiles in a tile row
+static bool drawChangedTiles(File& cache, const uint32_t* target, uint16_t* changedCount) {
+    size_t bandBytes = (size_t)DISPLAY_CACHE_WIDTH * DISPLAY_TILE_SIZE * 2;
+    uint16_t* band = (uint16_t*)malloc(bandBytes);
+    if (!band) {
+        return false;
+    }
+
+    bool ok = true;
+    *changedCount = 0;
+    for (uint16_t ty = 0; ty < DISPLAY_TILE_ROWS && ok; ty++) {
+        const uint32_t* want = target + ty * DISPLAY_TILE_COLS;
+        const uint32_t* have = screenTiles + ty * DISPLAY_TILE_COLS;
+        if (memcmp(want, have, DISPLAY_TILE_COLS * 4) == 0) {
+            continue;
+        }
+
+        cache.seek(sizeof(display_cache_header_t) + ty * bandBytes);
+        if (cache.read((uint8_t*)band, bandBytes) != bandBytes) {
+            ok = false;
+            break;
+        }
+
+        uint16_t tx = 0;
+        while (tx < DISPLAY_TILE_COLS) {
+            if (want[tx] == have[tx]) {
+                tx++;
+                continue;
+            }
+            uint16_t run = 1;
+            while (tx + run < DISPLAY_TILE_COLS && want[tx + run] != have[tx + run]) {
+                run++;
+            }
+            uint16_t x = tx * DISPLAY_TILE_SIZE;
+            uint16_t w = run * DISPLAY_TILE_SIZE;
+            uint16_t* dst = tftBlitBuffer();
+            for (uint16_t row = 0; row < DISPLAY_TILE_SIZE; row++) {
+                memcpy(dst + row * w, band + row * DISPLAY_CACHE_WIDTH + x, w * 2);
+            }
+            tftBlitCommit(x, ty * DISPLAY_TILE_SIZE, w, DISPLAY_TILE_SIZE);
+            *changedCount += run;
+            tx += run;
+        }
+    }
+    free(band);
+    return ok;
+}
+
+bool displayCacheDraw(const char* filename) {
+    File cache = LittleFS.open(displayCachePath(filename), "r");
+    if (!cache) {
+        return false;
+    }
+    cache.seek(sizeof(display_cache_header_t));
+
+    uint32_t* target = (uint32_t*)malloc(DISPLAY_TILE_COUNT * 4);
+    bool haveTiles = target && loadTiles(filename, target);
+
+    if (!tftBlitBegin()) {
+        free(target);
+        cache.close();
+        return false;
+    }
+
+    bool ok;
+    uint16_t changed = DISPLAY_TILE_COUNT;
+    if (haveTiles && screenTilesValid) {
+        ok = drawChangedTiles(cache, target, &changed);
+    } else {
+        ok = drawFullFrame(cache);
+    }
+    tftBlitEnd();
+    cache.close();
+
+    if (ok) {
+        touch(filename);
+    }
+    if (ok && haveTiles) {
+        memcpy(screenTiles, target, sizeof(screenTiles));
+        screenTilesValid = true;
+        ESP_LOGI(LOG_TAG_COMMON, "Cache draw: %d/%d tiles sent", changed, DISPLAY_TILE_COUNT);
+    } else {
+        screenTilesValid = false;
+    }
+    free(target);
+
+    if (!ok) {
+        ESP_LOGE(LOG_TAG_COMMON, "Cache read failed for %s, dropping sidecar", filename);
+        displayCacheInvalidate(filename);
+    }
+    return ok;
+}
+
+void displayCacheScreenChanged() {
+    screenTilesValid = false;
+}
+
+void displayCacheInvalidate(const char* filename) {
+    if (recentLock) {
+        xSemaphoreTake(recentLock, portMAX_DELAY);
+        forget(filename);
+        xSemaphoreGive(recentLock);
+    }
+    removeSidecar(filename);
+}
+
+bool displayCacheBeginCapture(const char* filename) {
+    display_cache_header_t header;
+    header.magic = DISPLAY_CACHE_MAGIC;
+    header.width = DISPLAY_CACHE_WIDTH;
+    header.height = DISPLAY_CACHE_HEIGHT;
+    if (!recentLock || !readSourceStat(filename, &header.source_size, &header.source_mtime)) {
+        return false;
+    }
+
+    // Room for the new sidecar: a stale copy of this one goes first, then
+    // the least recently drawn, until the margin holds
+    displayCacheInvalidate(filename);
+    xSemaphoreTake(recentLock, portMAX_DELAY);
+    bool full = recentCount == DISPLAY_CACHE_MAX_ENTRIES;
+    xSemaphoreGive(recentLock);
+    if (full) {
+        evictOldest();
+    }
+    while (freeBytes() < SIDECAR_BYTES + DISPLAY_CACHE_MIN_FREE) {
+        if (!evictOldest()) {
+            ESP_LOGW(LOG_TAG_COMMON, "Cache capture skipped: %u bytes free", freeBytes());
+            return false;
+        }
+    }
+
+    captureBand = (uint16_t*)calloc((size_t)DISPLAY_CACHE_WIDTH * DISPLAY_CACHE_BAND_ROWS, 2);
+    captureTiles = (uint32_t*)malloc(DISPLAY_TILE_COUNT * 4);
+    if (!captureBand || !captureTiles) {
+        ESP_LOGW(LOG_TAG_COMMON, "Cache capture skipped: no memory for band buffer");
+        free(captureBand);
+        free(captureTiles);
+        captureBand = nullptr;
+        captureTiles = nullptr;
+        return false;
+    }
+    for (uint16_t i = 0; i < DISPLAY_TILE_COUNT; i++) {
+        captureTiles[i] = TILE_HASH_SEED;
+    }
+
+    captureFile = LittleFS.open(displayCachePath(filename), "w");
+    if (!captureFile) {
+        ESP_LOGW(LOG_TAG_COMMON, "Cache capture skipped: cannot create sidecar for %s", filename);
+        free(captureBand);
+        free(captureTiles);
+        captureBand = nullptr;
+        captureTiles = nullptr;
+        return false;
+    }
+    captureFile.write((const uint8_t*)&header, sizeof(header));
+
+    captureSource = filename;
+    captureBandY = 0;
+    captureBandRows = 0;
+    captureNextRow = 0;
+    captureFailed = false;
+    return true;
+}
+
+void displayCacheCapture(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t* pixels) {
+    if (!captureBand || captureFailed) {
+        return;
+    }
+    if (x < 0 || y < 0 || x >= DISPLAY_CACHE_WIDTH || y >= DISPLAY_CACHE_HEIGHT) {
+        return;
+    }
+    uint16_t cw = (x + w > DISPLAY_CACHE_WIDTH) ? DISPLAY_CACHE_WIDTH - x : w;
+    uint16_t ch = (y + h > DISPLAY_CACHE_HEIGHT) ? DISPLAY_CACHE_HEIGHT - y : h;
+
+    // Start a new band when the block does not fit in the current one
+    if (captureBandRows == 0 || y < captureBandY || y + ch > captureBandY + DISPLAY_CACHE_BAND_ROWS) {
+        flushCaptureBand();
+        if (y < captureNextRow || ch > DISPLAY_CACHE_BAND_ROWS) {
+            // Decoder went backwards (or block too tall); the sidecar would be wrong
+            ESP_LOGW(LOG_TAG_COMMON, "Cache capture aborted: out-of-order block at y=%d", y);
+            captureFailed = true;
+            return;
+        }
+        if (!writeZeroRows(y - captureNextRow)) {
+            captureFailed = true;
+            return;
+        }
+        captureNextRow = y;
+        captureBandY = y;
+    }
+
+    for (uint16_t row = 0; row < ch; row++) {
+        uint16_t* dst = captureBand + (size_t)(y - captureBandY + row) * DISPLAY_CACHE_WIDTH + x;
+        memcpy(dst, pixels + (size_t)row * w, cw * 2);
+    }
+    if (y + ch - captureBandY > captureBandRows) {
+        captureBandRows = y + ch - captureBandY;
+    }
+}
+
+bool displayCacheEndCapture(bool success) {
+    if (!captureBand) {
+        return false;
+    }
+
+    if (success) {
+        flushCaptureBand();
+        if (!captureFailed && !writeZeroRows(DISPLAY_CACHE_HEIGHT - captureNextRow)) {
+            captureFailed = true;
+        }
+    }
+    captureFile.close();
+    free(captureBand);
+    captureBand = nullptr;
+
+    bool stored = success && !captureFailed;
+    if (stored) {
+        File tiles = LittleFS.open(tilesPath(captureSource.c_str()), "w");
+        uint32_t magic = DISPLAY_TILES_MAGIC;
+        if (tiles) {
+            tiles.write((const uint8_t*)&magic, sizeof(magic));
+            tiles.write((const uint8_t*)captureTiles, DISPLAY_TILE_COUNT * 4);
+            tiles.close();
+        }
+        // What was just decoded onto the panel is exactly this frame
+        memcpy(screenTiles, captureTiles, sizeof(screenTiles));
+        screenTilesValid = true;
+        touch(captureSource.c_str());
+        ESP_LOGI(LOG_TAG_COMMON, "Display cache stored for %s", captureSource.c_str());
+    }
+    free(captureTiles);
+    captureTiles = nullptr;
+    if (!stored) {
+        displayCacheInvalidate(captureSource.c_str());
+    }
+    return stored;
+}
+
+void displayCacheWriteMetrics(Print& out) {
+    out.printf("display_cache_entries %u\n", recentCount);
+    out.printf("display_cache_max_entries %u\n", DISPLAY_CACHE_MAX_ENTRIES);
+    out.printf("display_cache_evictions_total %u\n", evictions);
+}
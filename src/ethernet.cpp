@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
 #include "esp_log.h"
@@ -14,10 +15,64 @@
 #include "common.h"
 #include "ethernet.h"
 #include "image_display.h"
+#include "display_cache.h"
+#include "playlist.h"
+#include "render_task.h"
+#include "render_metrics.h"
+#include "image_list.h"
+#include "image_catalog.h"
+#include "thumbnail.h"
+#include "http_cache.h"
+#include "http_deferred.h"
+#include "upload_session.h"
+#include "image_stream.h"
+#include "rect_update.h"
+#include "ota_image.h"
+#include "animation.h"
+#include "boot.h"
+#include <memory>
 
 int duty = 0;
 
 AsyncWebServer server(80);
+AsyncEventSource events(RENDER_EVENTS_PATH);
+static AsyncWebSocket rectSocket(RECT_SOCKET_PATH);
+
+typedef struct
+{
+	char event[12];
+	uint32_t id;
+	char* data; // Owned by the queue entry
+} queued_event_t;
+
+static QueueHandle_t eventQueue = nullptr;
+static uint32_t eventsDropped = 0;
+
+void eventsSend(const char* data, const char* event, uint32_t id)
+{
+    if (!eventQueue) {
+        return;
+    }
+    queued_event_t item;
+    strlcpy(item.event, event, sizeof(item.event));
+    item.id = id;
+    item.data = strdup(data);
+    if (!item.data || xQueueSend(eventQueue, &item, 0) != pdTRUE) {
+        free(item.data);
+        eventsDropped++;
+    }
+}
+
+static void eventsTask(void *param)
+{
+    queued_event_t item;
+    for (;;) {
+        if (xQueueReceive(eventQueue, &item, portMAX_DELAY) == pdTRUE) {
+            events.send(item.data, item.event, item.id);
+            free(item.data);
+        }
+    }
+}
 
 void WiFiEvent(arduino_event_id_t event)
 {
@@ -47,7 +102,138 @@ void WiFiEvent(arduino_event_id_t event)
     }
 }
 
-void ethernet_init()
+// Image URLs carrying the current content version (?v=<crc in hex>, as the
+// gallery builds them) never change; bare ones are revalidated
+static const char* imageCachePolicy(AsyncWebServerRequest *request, uint32_t crc)
+{
+    if (request->hasParam("v") && strtoul(request->getParam("v")->value().c_str(), nullptr, 16) == crc) {
+        return HTTP_CACHE_IMMUTABLE;
+    }
+    return HTTP_CACHE_REVALIDATE;
+}
+
+static String catalogEtag(const char* prefix, uint32_t crc)
+{
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"%s%08x\"", prefix, crc);
+    return String(etag);
+}
+
+// Give the request its upload session. The disconnect handler runs on every
+// request, before the request frees _tempObject; a session not committed by
+// then removes its temporary file (or aborts the update)
+static void attachUploadSession(AsyncWebServerRequest *request, upload_session_t *session)
+{
+    if (request->_tempObject) {
+        // Another file in the same form; the previous one is done
+        uploadEnd((upload_session_t *)request->_tempObject);
+    } else {
+        request->onDisconnect([request]() {
+            uploadEnd((upload_session_t *)request->_tempObject);
+            request->_tempObject = nullptr;
+        });
+    }
+    request->_tempObject = session;
+}
+
+// Storage task, right after the rename: a new file in /images drops what
+// was derived from the old one and is cataloged from its header; the CRC
+// was taken on the way in
+static void onUploadCommitted(const char* path, const char* filename, uint32_t crc)
+{
+    if (!String(path).startsWith(IMAGE_LIST_DIR "/")) {
+        return;
+    }
+    displayCacheInvalidate(filename);
+    thumbnailRemove(filename);
+    image_catalog_entry_t entry;
+    if (imageCatalogProbe(imageCatalog, filename, &entry, true, crc)) {
+        imageCatalogUpdate(imageCatalog, &entry);
+        renderQueueThumbnail(filename);
+    } else {
+        imageCatalogRemove(imageCatalog, filename);
+    }
+}
+
+// HTTP status for a failed upload or update
+static int uploadFailureCode(upload_status_t status)
+{
+    switch (status) {
+    case UPLOAD_NO_SPACE:
+        return 507;
+    case UPLOAD_BUSY:
+    case UPLOAD_OVERRUN:
+        return 503;
+    case UPLOAD_BAD_IMAGE:
+    case UPLOAD_VERIFY_FAILED:
+        return 422;
+    default:
+        return 500;
+    }
+}
+
+// ?save= is optional; when given it names a JPEG directly in /images
+static bool streamSaveNameValid(AsyncWebServerRequest *request)
+{
+    if (!request->hasParam("save")) {
+        return true;
+    }
+    String save = request->getParam("save")->value();
+    save.toLowerCase();
+    return save.length() < 64 && save.indexOf('/') < 0 && (save.endsWith(".jpg") || save.endsWith(".jpeg"));
+}
+
+// The stream id goes into _tempObject (freed by the request); the
+// disconnect handler lets the stream go, discarding a partial file
+static void attachImageStream(AsyncWebServerRequest *request, uint32_t id)
+{
+    uint32_t *slot = (uint32_t *)malloc(sizeof(uint32_t));
+    if (!slot) {
+        imageStreamRelease(id);
+        return;
+    }
+    *slot = id;
+    request->_tempObject = slot;
+    request->onDisconnect([request]() {
+        imageStreamRelease(*(uint32_t *)request->_tempObject);
+    });
+}
+
+// Firmware image from the /update/file name; .gz variants are inflated on
+// the way (ota_image.h). -1 if neither
+static int updateCommand(const String &filename)
+{
+    if (filename == "firmware.bin" || filename == "firmware.bin.gz") {
+        return U_FLASH;
+    }
+    if (filename == "littlefs.bin" || filename == "littlefs.bin.gz") {
+        return U_SPIFFS;
+    }
+    return -1;
+}
+
+// A sha256 parameter, when given, must be a whole SHA-256
+static bool updateManifestValid(AsyncWebServerRequest *request)
+{
+    uint8_t sha256[OTA_SHA256_SIZE];
+    return !request->hasParam("sha256") || otaParseSha256(request->getParam("sha256")->value().c_str(), sha256);
+}
+
+// Storage task: OTA progress to browsers as "ota" events on /events
+static void onOtaProgress(const ota_progress_t *progress)
+{
+    char json[224];
+    snprintf(json, sizeof(json),
+             "{\"state\":\"%s\",\"received\":%u,\"written\":%u,\"expected\":%u,\"percent\":%u,"
+             "\"ms\":%u,\"in_kbps\":%u,\"out_kbps\":%u,\"compressed\":%s,\"verified\":%s}",
+             !progress->finished ? "writing" : progress->status == OTA_OK ? "done" : otaStatusText(progress->status),
+             progress->received, progress->written, progress->expected, progress->percent, progress->elapsed_ms,
+             progress->in_kbps, progress->out_kbps, progress->compressed ? "true" : "false",
+             progress->verified ? "true" : "false");
+    eventsSend(json, "ota");
+}
+
+bool storage_init()
 {
     ESP_LOGI(LOG_TAG_ETHERNET, "Starting LittleFS initialization...");
     Serial.println("[FS] Initializing LittleFS filesystem...");
@@ -62,7 +248,7 @@ void ethernet_init()
         {
             ESP_LOGE(LOG_TAG_ETHERNET, "CRITICAL: LittleFS format failed!");
             Serial.println("[FS] ERROR: LittleFS format failed! Web interface disabled.");
-            return;
+            return false;
         } else {
             ESP_LOGI(LOG_TAG_ETHERNET, "LittleFS formatted and mounted successfully");
             Serial.println("[FS] LittleFS formatted and mounted successfully");
@@ -91,6 +277,20 @@ void ethernet_init()
         ESP_LOGI(LOG_TAG_ETHERNET, "/images directory already exists");
         Serial.println("[FS] /images directory already exists");
     }
+    displayCacheInit();
+    // Before the boot restore, whose render checks the name against it
+    imageCatalogInit();
+    return true;
+}
+
+void ethernet_init()
+{
+    eventQueue = xQueueCreate(EVENTS_QUEUE_LENGTH, sizeof(queued_event_t));
+    xTaskCreate(eventsTask, "events", EVENTS_TASK_STACK, nullptr, TASK_PRIO_EVENTS, nullptr);
+    thumbnailInit();
+    uploadInit();
+    uploadSetCommitCallback(onUploadCommitted);
+    otaSetProgressCallback(onOtaProgress);
 
     ESP_LOGI(LOG_TAG_ETHERNET, "Setting up WiFi Access Point...");
     Serial.printf("[WIFI] Configuring Access Point - SSID: %s, Password: %s\n", AP_SSID, AP_PASSWORD);
@@ -109,91 +309,210 @@ void ethernet_init()
     while (!wifi_connected)
     {
         ESP_LOGD(LOG_TAG_ETHERNET, "Waiting for AP start...");
-        delay(500);
+        delay(10);
     }
+    bootMark("wifi");
 
     ESP_LOGI(LOG_TAG_ETHERNET, "Setting up web server endpoints...");
     Serial.println("[WEB] Configuring web server endpoints...");
     
-    server.serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
-    ESP_LOGI(LOG_TAG_ETHERNET, "Static file serving configured");
-
-    // Image upload endpoint
+    // Image upload endpoint. Each request owns an upload session (see
+    // upload_session.h); the file only replaces /images/<name> once complete
     server.on("/upload", HTTP_POST, [](AsyncWebServerRequest *request) {
-        ESP_LOGI(LOG_TAG_ETHERNET, "Image upload completed");
-        Serial.println("[WEB] Image upload request completed");
-        request->send(200, "application/json", "{\"success\":true}");
+        upload_session_t *session = (upload_session_t *)request->_tempObject;
+        if (!session) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"no file\"}");
+            return;
+        }
+        // The storage task may still be writing the last blocks (at most the
+        // pool), then renames and catalogs the file; the reply waits for it
+        // without holding async_tcp
+        uint32_t start = millis();
+        httpSendDeferred(request, "application/json", [session, start](int *code, String *body) {
+            bool done = uploadDone(session);
+            if (!done && millis() - start < UPLOAD_COMMIT_TIMEOUT_MS) {
+                return false;
+            }
+            upload_status_t status = uploadStatus(session);
+            if (!done || status != UPLOAD_OK) {
+                const char *error = done ? uploadStatusText(status) : "timeout";
+                ESP_LOGW(LOG_TAG_ETHERNET, "Upload of %s failed: %s", uploadFilename(session), error);
+                *code = uploadFailureCode(status);
+                *body = String("{\"success\":false,\"error\":\"") + error + "\"}";
+                return true;
+            }
+
+            const char *filename = uploadFilename(session);
+            upload_stats_t stats;
+            uploadStats(session, &stats);
+            ESP_LOGI(LOG_TAG_ETHERNET, "Upload Complete: %s (%u bytes, %u KB/s)", filename, stats.bytes, stats.kbps);
+            Serial.printf("[UPLOAD] Completed: %s (%u bytes in %u ms, %u KB/s, %u writes, %u pauses)\n", filename,
+                          stats.bytes, stats.elapsed_ms, stats.kbps, stats.writes, stats.pauses);
+            char json[96];
+            snprintf(json, sizeof(json), "{\"success\":true,\"bytes\":%u,\"ms\":%u,\"kbps\":%u}",
+                     stats.bytes, stats.elapsed_ms, stats.kbps);
+            *code = 200;
+            *body = json;
+            return true;
+        });
     }, [](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
-        static File uploadFile;
-        
         if (!index) {
             ESP_LOGI(LOG_TAG_ETHERNET, "Upload Start: %s", filename.c_str());
             Serial.printf("[UPLOAD] Starting upload: %s\n", filename.c_str());
-            String path = "/images/" + filename;
-            uploadFile = LittleFS.open(path, "w");
-            if (!uploadFile) {
-                ESP_LOGE(LOG_TAG_ETHERNET, "Failed to create file: %s", path.c_str());
-                Serial.printf("[UPLOAD] ERROR: Failed to create file %s\n", path.c_str());
-                return;
-            }
+            attachUploadSession(request, uploadBegin("/images", filename.c_str(), request->contentLength(),
+                                                     request->client()));
         }
-        
-        if (uploadFile && len) {
-            if (uploadFile.write(data, len) != len) {
-                ESP_LOGE(LOG_TAG_ETHERNET, "Failed to write data chunk");
-                Serial.printf("[UPLOAD] ERROR: Failed to write %d bytes\n", len);
+        upload_session_t *session = (upload_session_t *)request->_tempObject;
+        if (len) {
+            uploadWrite(session, data, len);
+        }
+        if (final && !uploadCommit(session)) {
+            // The previous file, if any, is still in place
+            Serial.printf("[UPLOAD] ERROR: %s: %s\n", filename.c_str(), uploadStatusText(uploadStatus(session)));
+        }
+    });
+
+    // Streamed display: the raw JPEG body is decoded to the panel as it
+    // arrives (image_stream.h); ?save=NAME also stores it as /images/NAME
+    server.on("/stream", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (!request->_tempObject) {
+            if (!request->contentLength()) {
+                request->send(400, "application/json", "{\"shown\":false,\"error\":\"no image\"}");
+            } else if (!streamSaveNameValid(request)) {
+                request->send(400, "application/json", "{\"shown\":false,\"error\":\"save must be a .jpg name\"}");
+            } else {
+                request->send(503, "application/json", "{\"shown\":false,\"error\":\"another stream is running\"}");
             }
+            return;
         }
-        
-        if (final) {
-            if (uploadFile) {
-                uploadFile.close();
-                ESP_LOGI(LOG_TAG_ETHERNET, "Upload Complete: %s (%u bytes)", filename.c_str(), index + len);
-                Serial.printf("[UPLOAD] Completed: %s (%u bytes)\n", filename.c_str(), index + len);
+        uint32_t id = *(uint32_t *)request->_tempObject;
+        imageStreamEnd(id, true);
+        // The decode tail and the file commit finish on their own tasks; the
+        // reply goes out once both are done
+        uint32_t start = millis();
+        httpSendDeferred(request, "application/json", [id, start](int *code, String *body) {
+            image_stream_result_t result;
+            if (!imageStreamResult(id, &result)) {
+                if (millis() - start < IMAGE_STREAM_TIMEOUT_MS) {
+                    return false;
+                }
+                *code = 500;
+                *body = "{\"shown\":false,\"error\":\"timeout\"}";
+                return true;
+            }
+            Serial.printf("[STREAM] %s: %u bytes, transfer %u ms, decode %u ms, last byte to screen %u ms%s\n",
+                          result.shown ? "Shown" : "Failed", result.bytes, result.transfer_ms, result.decode_ms,
+                          result.tail_ms, result.saved ? ", saved" : "");
+            char json[160];
+            snprintf(json, sizeof(json),
+                     "{\"shown\":%s,\"saved\":%s,\"bytes\":%u,\"transfer_ms\":%u,\"decode_ms\":%u,"
+                     "\"tail_ms\":%u,\"total_ms\":%u,\"pauses\":%u}",
+                     result.shown ? "true" : "false", result.saved ? "true" : "false", result.bytes,
+                     result.transfer_ms, result.decode_ms, result.tail_ms, result.total_ms, result.pauses);
+            // Not a JPEG tjpgd can read (or cut short); the file is kept if saved
+            *code = result.shown ? 200 : 422;
+            *body = json;
+            return true;
+        });
+    }, nullptr, [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        if (!index) {
+            if (!streamSaveNameValid(request)) {
+                return; // No stream; answered with 400
             }
+            String save = request->hasParam("save") ? request->getParam("save")->value() : String();
+            playlistStop();
+            uint32_t id = imageStreamBegin(request->client(), save.length() ? save.c_str() : nullptr, total);
+            if (!id) {
+                return; // Busy; answered with 503
+            }
+            attachImageStream(request, id);
+        }
+        if (request->_tempObject) {
+            imageStreamWrite(*(uint32_t *)request->_tempObject, data, len);
         }
     });
 
-    // Image list endpoint
+    // Image list endpoint: ?offset=&limit=&sort=name|size|mtime&order=desc
+    // Streamed as a chunked response; memory use does not grow with the
+    // directory unless a sort is requested
     server.on("/images", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String json = "{\"images\":[";
-        File root = LittleFS.open("/images");
-        if (root) {
-            File file = root.openNextFile();
-            bool first = true;
-            while (file) {
-                if (!file.isDirectory()) {
-                    if (!first) json += ",";
-                    json += "{\"name\":\"" + String(file.name()) + "\",\"size\":" + String(file.size()) + "}";
-                    first = false;
-                }
-                file = root.openNextFile();
-            }
-            root.close();
+        image_list_query_t query;
+        query.offset = request->hasParam("offset") ? request->getParam("offset")->value().toInt() : 0;
+        query.limit = request->hasParam("limit") ? request->getParam("limit")->value().toInt() : 0;
+        query.descending = request->hasParam("order") && request->getParam("order")->value() == "desc";
+        String sort = request->hasParam("sort") ? request->getParam("sort")->value() : String();
+        if (!imageListParseSort(sort.c_str(), &query.sort)) {
+            request->send(400, "application/json", "{\"error\":\"sort must be name, size or mtime\"}");
+            return;
         }
-        json += "]}";
-        request->send(200, "application/json", json);
+
+        String error;
+        image_list_t* opened = imageListOpen(imageCatalog, &query, &error);
+        if (!opened) {
+            request->send(503, "application/json", "{\"error\":\"" + error + "\"}");
+            return;
+        }
+        std::shared_ptr<image_list_t> list(opened, imageListClose);
+        request->send(request->beginChunkedResponse("application/json",
+            [list](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                return imageListFill(list.get(), buffer, maxLen);
+            }));
     });
 
     // Image serve endpoint
     server.on("/image/*", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String path = request->url();
-        path.replace("/image/", "/images/");
-        if (LittleFS.exists(path)) {
-            request->send(LittleFS, path);
+        String filename = request->url();
+        filename.replace("/image/", "");
+        image_catalog_entry_t entry;
+        if (imageCatalogLookup(imageCatalog, filename.c_str(), &entry)) {
+            httpSendFile(request, "/images/" + filename, "", catalogEtag("", entry.crc),
+                         imageCachePolicy(request, entry.crc), entry.size);
         } else {
             request->send(404, "text/plain", "Image not found");
         }
     });
 
-    // Display image endpoint
+    // Thumbnail endpoint; until the thumbnail exists (it is made in the
+    // background after upload) the full image is sent instead
+    server.on("/thumb/*", HTTP_GET, [](AsyncWebServerRequest *request) {
+        String filename = request->url();
+        filename.replace("/thumb/", "");
+        image_catalog_entry_t entry;
+        if (!imageCatalogLookup(imageCatalog, filename.c_str(), &entry)) {
+            request->send(404, "text/plain", "Image not found");
+            return;
+        }
+        String thumb = thumbnailPath(filename.c_str());
+        File file = LittleFS.open(thumb, "r");
+        if (file) {
+            uint32_t size = file.size();
+            file.close();
+            httpSendFile(request, thumb, "image/png", catalogEtag("t", entry.crc),
+                         imageCachePolicy(request, entry.crc), size);
+            return;
+        }
+        // Stand-in only; must not be cached under the thumbnail URL
+        renderQueueThumbnail(filename.c_str());
+        AsyncWebServerResponse *response = request->beginResponse(LittleFS, "/images/" + filename);
+        response->addHeader("Cache-Control", HTTP_CACHE_NONE);
+        request->send(response);
+    });
+
+    // Display image endpoint - queues the render and answers with its job id;
+    // progress and completion follow as "render" events on /events
     server.on("/display/*", HTTP_POST, [](AsyncWebServerRequest *request) {
         String filename = request->url();
         filename.replace("/display/", "");
-        ESP_LOGI(LOG_TAG_ETHERNET, "Display request for: %s", filename.c_str());
+        bool progressive = request->hasParam("progressive");
+        ESP_LOGI(LOG_TAG_ETHERNET, "Display request for: %s%s", filename.c_str(), progressive ? " (progressive)" : "");
         Serial.printf("[DISPLAY] Displaying image: %s\n", filename.c_str());
-        displayImage(filename.c_str());
-        request->send(200, "text/plain", "OK");
+        playlistStop(); // A manual choice takes the screen over from the slideshow
+        uint32_t job = renderSubmit(filename.c_str(), progressive);
+        if (!job) {
+            request->send(400, "text/plain", "Invalid file name");
+            return;
+        }
+        request->send(202, "application/json", "{\"job\":" + String(job) + "}");
     });
 
     // Delete image endpoint
@@ -203,7 +522,14 @@ void ethernet_init()
         String path = "/images/" + filename;
         ESP_LOGI(LOG_TAG_ETHERNET, "Delete request for: %s", filename.c_str());
         Serial.printf("[DELETE] Deleting image: %s\n", filename.c_str());
+        if (!imageCatalogContains(imageCatalog, filename.c_str())) {
+            request->send(404, "text/plain", "File not found");
+            return;
+        }
+        displayCacheInvalidate(filename.c_str());
+        thumbnailRemove(filename.c_str());
         if (LittleFS.remove(path)) {
+            imageCatalogRemove(imageCatalog, filename.c_str());
             ESP_LOGI(LOG_TAG_ETHERNET, "Deleted: %s", filename.c_str());
             Serial.printf("[DELETE] Successfully deleted: %s\n", filename.c_str());
             request->send(200, "text/plain", "OK");
@@ -214,6 +540,109 @@ void ethernet_init()
         }
     });
 
+    // Playlist endpoints; the more specific paths first, "/playlist" also
+    // matches everything below it
+    server.on("/playlist/start", HTTP_POST, [](AsyncWebServerRequest *request) {
+        playlistStart();
+        request->send(200, "text/plain", "OK");
+    });
+
+    server.on("/playlist/stop", HTTP_POST, [](AsyncWebServerRequest *request) {
+        playlistStop();
+        request->send(200, "text/plain", "OK");
+    });
+
+    server.on("/playlist/status", HTTP_GET, [](AsyncWebServerRequest *request) {
+        request->send(200, "application/json", playlistStatusJson());
+    });
+
+    server.on("/playlist", HTTP_GET, [](AsyncWebServerRequest *request) {
+        request->send(200, "application/json", playlistItemsJson());
+    });
+
+    // Replace the playlist; the body is the playlist file text
+    server.on("/playlist", HTTP_POST, [](AsyncWebServerRequest *request) {
+        char *text = (char *)request->_tempObject;
+        if (!text) {
+            request->send(413, "text/plain", "Playlist missing or too large");
+            return;
+        }
+        String error;
+        if (playlistSave(text, strlen(text), &error)) {
+            request->send(200, "text/plain", "OK");
+        } else {
+            ESP_LOGW(LOG_TAG_ETHERNET, "Playlist rejected: %s", error.c_str());
+            request->send(400, "text/plain", error);
+        }
+    }, NULL, [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        if (total > PLAYLIST_MAX_TEXT) {
+            return;
+        }
+        if (!index) {
+            request->_tempObject = calloc(total + 1, 1); // Freed by the request
+        }
+        if (request->_tempObject) {
+            memcpy((char *)request->_tempObject + index, data, len);
+        }
+    });
+
+    server.addHandler(&events);
+
+    // Partial updates: binary messages are decoded onto the panel as their
+    // frames arrive (rect_update.h) and each is answered once drawn
+    rectSocket.onEvent([](AsyncWebSocket *socket, AsyncWebSocketClient *client, AwsEventType type, void *arg,
+                          uint8_t *data, size_t len) {
+        if (type == WS_EVT_CONNECT) {
+            socket->cleanupClients(RECT_MAX_CLIENTS);
+            // Keep the socket's own poll (queue, keep-alive) and check for a
+            // stalled message on async_tcp, where the panel lock was taken
+            client->client()->onPoll(
+                [](void *arg, AsyncClient *c) {
+                    ((AsyncWebSocketClient *)arg)->_onPoll();
+                    rectUpdatePoll();
+                },
+                client);
+            return;
+        }
+        if (type == WS_EVT_DISCONNECT) {
+            rectUpdateAbort(client->id());
+            return;
+        }
+        if (type != WS_EVT_DATA) {
+            return;
+        }
+        AwsFrameInfo *info = (AwsFrameInfo *)arg;
+        if (info->message_opcode != WS_BINARY) {
+            return;
+        }
+        bool first = info->num == 0 && info->index == 0;
+        bool last = info->final && info->index + len == info->len;
+        rect_result_t result;
+        if (rectUpdateWrite(client->id(), data, len, first, last, &result)) {
+            char reply[112];
+            snprintf(reply, sizeof(reply), "{\"seq\":%u,\"status\":\"%s\",\"px\":%u,\"us\":%u}", result.seq,
+                     rectStatusText(result.status), result.pixels, result.us);
+            client->text(reply);
+        }
+    });
+    server.addHandler(&rectSocket);
+
+    // Render timing histograms, heap, task stacks and filesystem usage
+    server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request) {
+        AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+        metricsWrite(*response);
+        httpCacheWriteMetrics(*response);
+        displayCacheWriteMetrics(*response);
+        uploadWriteMetrics(*response);
+        imageStreamWriteMetrics(*response);
+        rectUpdateWriteMetrics(*response);
+        animationWriteMetrics(*response);
+        otaWriteMetrics(*response);
+        bootWriteMetrics(*response);
+        response->printf("events_dropped_total %u\n", eventsDropped);
+        request->send(response);
+    });
+
     server.on("/reboot", HTTP_GET, [](AsyncWebServerRequest *request)
               {
                   request->send(200, "text/plain", "Rebooting...");
@@ -236,49 +665,81 @@ void ethernet_init()
     // 		ledc_update_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0);
     // 	});
 
-    server.on("/update/file", HTTP_POST, [](AsyncWebServerRequest *request)
-              { request->send(200, "text/plain", (Update.hasError()) ? "FAIL" : "OK"); }, [](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final)
-              {
-                  if (!index)
-                  {
-                      ESP_LOGI(LOG_TAG_ETHERNET, "Update Start: %s\n", filename.c_str());
-                      int command;
-                      if(filename == "firmware.bin") {
-                          command = U_FLASH;
-                      } else if(filename == "littlefs.bin") {
-                          command = U_SPIFFS;
-                      } else {
-                          ESP_LOGI(LOG_TAG_ETHERNET, "Unknown file type");
-                          return;
-                      }
-                      if (!Update.begin(UPDATE_SIZE_UNKNOWN, command))
-                      {
-                          Update.printError(Serial);
-                      }
-                  }
-                  if (!Update.hasError())
-                  {
-                      if (Update.write(data, len) != len)
-                      {
-                          Update.printError(Serial);
-                      }
-                  }
-                  if (final)
-                  {
-                      if (Update.end(true))
-                      {
-                          ESP_LOGI(LOG_TAG_ETHERNET, "Update Success: %uB\n", index + len);
-                        //   vTaskDelay(10000 / portTICK_PERIOD_MS);
-						//   ESP_LOGW(LOG_TAG_ETHERNET, "!!!ESP REBOOT TRIGGER!!!");
-                        //   vTaskDelay(5000 / portTICK_PERIOD_MS);
-						//   ESP_LOGI(LOG_TAG_ETHERNET, "Rebooting...");
-                        //   ESP.restart();
-                      }
-                      else
-                      {
-                          Update.printError(Serial);
-                      }
-                  } });
+    // Firmware / filesystem image, written through the storage task like
+    // uploads: firmware.bin or littlefs.bin, or their .gz from
+    // tools/ota_pack.py. ?sha256=HEX&image_size=N from the manifest are
+    // checked before the partition is made bootable; progress goes out as
+    // "ota" events on /events
+    server.on("/update/file", HTTP_POST, [](AsyncWebServerRequest *request) {
+        upload_session_t *session = (upload_session_t *)request->_tempObject;
+        if (!session) {
+            const char *error = updateManifestValid(request) ? "expected firmware.bin or littlefs.bin (.gz)"
+                                                             : "sha256 must be 64 hex digits";
+            request->send(400, "application/json", String("{\"success\":false,\"error\":\"") + error + "\"}");
+            return;
+        }
+        uint32_t start = millis();
+        httpSendDeferred(request, "application/json", [session, start](int *code, String *body) {
+            bool done = uploadDone(session);
+            if (!done && millis() - start < UPLOAD_COMMIT_TIMEOUT_MS) {
+                return false;
+            }
+            upload_status_t status = uploadStatus(session);
+            if (!done || status != UPLOAD_OK) {
+                const char *error = done ? uploadStatusText(status) : "timeout";
+                ESP_LOGE(LOG_TAG_ETHERNET, "Update failed: %s", error);
+                *code = uploadFailureCode(status);
+                *body = String("{\"success\":false,\"error\":\"") + error + "\"}";
+                return true;
+            }
+            ota_progress_t ota;
+            otaLastProgress(&ota);
+            ESP_LOGI(LOG_TAG_ETHERNET, "Update written: %u -> %u bytes, %u KB/s", ota.received, ota.written,
+                     ota.in_kbps);
+            char json[192];
+            snprintf(json, sizeof(json),
+                     "{\"success\":true,\"received\":%u,\"written\":%u,\"ms\":%u,\"in_kbps\":%u,\"out_kbps\":%u,"
+                     "\"compressed\":%s,\"verified\":%s}",
+                     ota.received, ota.written, ota.elapsed_ms, ota.in_kbps, ota.out_kbps,
+                     ota.compressed ? "true" : "false", ota.verified ? "true" : "false");
+            *code = 200;
+            *body = json;
+            return true;
+        });
+    }, [](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
+        if (!index) {
+            ESP_LOGI(LOG_TAG_ETHERNET, "Update Start: %s", filename.c_str());
+            int command = updateCommand(filename);
+            uint8_t sha256[OTA_SHA256_SIZE];
+            bool haveSha256 = request->hasParam("sha256");
+            if (command < 0 || !updateManifestValid(request)) {
+                ESP_LOGW(LOG_TAG_ETHERNET, "Update refused: %s", filename.c_str());
+                return;
+            }
+            if (haveSha256) {
+                otaParseSha256(request->getParam("sha256")->value().c_str(), sha256);
+            }
+            uint32_t imageSize = request->hasParam("image_size") ? request->getParam("image_size")->value().toInt() : 0;
+            attachUploadSession(request, uploadBeginUpdate(command, request->client(), haveSha256 ? sha256 : nullptr,
+                                                           imageSize));
+        }
+        upload_session_t *session = (upload_session_t *)request->_tempObject;
+        if (len) {
+            uploadWrite(session, data, len);
+        }
+        if (final) {
+            if (uploadCommit(session)) {
+                ESP_LOGI(LOG_TAG_ETHERNET, "Update queued: %uB\n", index + len);
+                //   vTaskDelay(10000 / portTICK_PERIOD_MS);
+                //   ESP_LOGW(LOG_TAG_ETHERNET, "!!!ESP REBOOT TRIGGER!!!");
+                //   vTaskDelay(5000 / portTICK_PERIOD_MS);
+                //   ESP_LOGI(LOG_TAG_ETHERNET, "Rebooting...");
+                //   ESP.restart();
+            } else {
+                ESP_LOGE(LOG_TAG_ETHERNET, "Update failed: %s", uploadStatusText(uploadStatus(session)));
+            }
+        }
+    });
 
     // server.on("/api", HTTP_GET,
     //           [](AsyncWebServerRequest *request)
@@ -286,21 +747,44 @@ void ethernet_init()
     //             request->send(200, "application/json; charset=utf-8\nAccess-Control-Allow-Origin: *", (const char *)json_data.Invert_parse());
     //           });
 
+    // Web interface files with ETags; registered last so every endpoint
+    // above takes precedence. Other LittleFS files are not served here
+    server.on("/*", HTTP_GET, [](AsyncWebServerRequest *request) {
+        String path = request->url();
+        if (path.endsWith("/")) {
+            path += "index.html";
+        }
+        if (!httpServeAsset(request, path) && !httpServeAsset(request, path + "/index.html")) {
+            request->send(404, "text/plain", "Not found");
+        }
+    });
+    ESP_LOGI(LOG_TAG_ETHERNET, "Static file serving configured");
+
     server.begin();
+    bootMark("server");
     ESP_LOGI(LOG_TAG_ETHERNET, "HTTP server started on port 80");
     Serial.println("[WEB] HTTP server started successfully");
     Serial.printf("[WEB] Web interface available at: http://%s/\n", WiFi.softAPIP().toString().c_str());
     Serial.println("[WEB] Server endpoints configured:");
     Serial.println("  GET  / - Main web interface");
     Serial.println("  POST /upload - Image upload");
+    Serial.println("  POST /stream[?save=NAME] - Draw a JPEG body while it arrives");
     Serial.println("  GET  /images - Image list API");
     Serial.println("  GET  /image/* - Serve image files");
-    Serial.println("  POST /display/* - Display image on TFT");
+    Serial.println("  GET  /thumb/* - Serve image thumbnails");
+    Serial.println("  POST /display/*[?progressive=1] - Queue image for display (returns job id)");
+    Serial.println("  GET  /events - Render and OTA progress (server-sent events)");
+    Serial.println("  WS   /ws - Partial rectangle updates (binary RGB565, raw/RLE/delta)");
+    Serial.println("  GET  /metrics - Render timing and system metrics");
     Serial.println("  DELETE /delete/* - Delete image");
+    Serial.println("  GET  /playlist, POST /playlist - Read/replace playlist");
+    Serial.println("  POST /playlist/start, /playlist/stop - Run slideshow");
+    Serial.println("  GET  /playlist/status - Slideshow timing");
+    Serial.println("  POST /update/file[?sha256=HEX&image_size=N] - Firmware/filesystem update (.bin or .bin.gz)");
     Serial.println("  GET  /reboot - System reboot");
     
 }
 
-void displayImage(const char* filename) {
-    displayImageFromFile(filename);
+void displayImage(const char* filename, bool progressive) {
+    displayImageFromFile(filename, progressive);
 }
\ No newline at end of file
@@ -0,0 +1,279 @@
+// Entry point of the native environment: drives the display code against
+// the simulated ILI9341 and a host directory standing in for LittleFS, and
+// prints one JSON object per command on stdout.
+//
+//   program [--fs DIR] [--out DIR] [--freq HZ] COMMAND...
+//     splash                     showSplashScreen()
+//     qr                         showQRCodes()
+//     image NAME [--progressive] displayImageWithScaling("NAME") from DIR/images
+//     uncached NAME              drop the sidecar cache of NAME first
+//     stream NAME                decode DIR/images/NAME (JPEG) through the stream
+//                                reader in network-sized pieces, as POST /stream
+//     anim NAME [PERCENT]        one pass of an .anim at PERCENT speed (default 100)
+//     rect FILE                  /ws rectangle messages from FILE (as written by
+//                                tools/rect_client.py --dump) in network-sized pieces
+//     thumb NAME                 thumbnailGenerate("NAME") into DIR/thumbs
+//     console N                  N lines through the TFT debug console
+//     bench [RUNS]               decoder benchmark over DIR/images/bench (--fs bench/corpus)
+//     bench-list [FILES]         /images listing benchmark (scratch dir in DIR)
+//     bench-upload [BYTES]       /upload storage path, direct vs upload session
+//     bench-anim [PERCENT]       animation playback over DIR/images/bench/*.anim
+//
+// Each command except bench and thumb writes OUT/<step>-<command>.png with what the
+// panel shows; bench prints its own JSON lines (see bench.h).
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <Adafruit_ILI9341.h>
+#include <chrono>
+#include <string>
+#include <ctype.h>
+#include <sys/stat.h>
+#include "LittleFS.h"
+#include "sim_panel.h"
+#include "image_display.h"
+#include "display_cache.h"
+#include "image_catalog.h"
+#include "thumbnail.h"
+#include "upload_session.h"
+#include "rect_update.h"
+#include "splash_screen.h"
+#include "tft_blit.h"
+#include "tft_debug.h"
+#include "bench.h"
+
+Adafruit_ILI9341 tft = Adafruit_ILI9341(&SPI, 0, 0, 0);
+
+// Unit tests (pio test -e native, test_build_src) link the display code
+// and this panel but bring their own main()
+#ifndef PIO_UNIT_TESTING
+
+static const char* outDir = "sim_out";
+static int step = 0;
+
+class StdoutPrint : public Print
+{
+public:
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+    using Print::write;
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--fs DIR] [--out DIR] [--freq HZ] "
+                    "{splash | qr | image NAME [--progressive] | uncached NAME | stream NAME | anim NAME [PERCENT] | rect FILE | thumb NAME | console N | bench [RUNS] | bench-list [FILES] | bench-upload [BYTES] | bench-anim [PERCENT]}...\n", argv0);
+}
+
+// Hands out a file in the pieces the web server would (BENCH_LIST_CHUNK)
+static size_t streamChunks(void* context, uint8_t* buf, size_t len) {
+    return fread(buf, 1, len < BENCH_LIST_CHUNK ? len : BENCH_LIST_CHUNK, (FILE*)context);
+}
+
+// Feeds every length-prefixed message of a dump to the rect decoder;
+// false if any was not drawn
+static bool drawRectFile(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    bool ok = true;
+    uint32_t messages = 0;
+    uint8_t length[4];
+    while (fread(length, 1, 4, f) == 4) {
+        uint32_t left = length[0] | (length[1] << 8) | (length[2] << 16) | ((uint32_t)length[3] << 24);
+        bool first = true;
+        rect_result_t result;
+        do {
+            uint8_t buf[BENCH_LIST_CHUNK];
+            size_t n = fread(buf, 1, left < sizeof(buf) ? left : sizeof(buf), f);
+            left -= n;
+            if (rectUpdateWrite(1, buf, n, first, !n || !left, &result) && result.status != RECT_OK) {
+                fprintf(stderr, "rect message %u: %s\n", messages, rectStatusText(result.status));
+                ok = false;
+            }
+            first = false;
+            if (!n) {
+                break;
+            }
+        } while (left);
+        messages++;
+    }
+    fclose(f);
+    return ok && messages;
+}
+
+static uint64_t hostMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Everything the panel saw for one command, plus a dump of the result
+static void report(const char* command, const char* arg, bool ok, uint64_t cpuUs) {
+    const sim_panel_stats_t* s = simPanelStats();
+    const tft_blit_stats_t* b = tftBlitStats();
+    char png[512];
+    snprintf(png, sizeof(png), "%s/%02d-%s.png", outDir, ++step, command);
+    bool dumped = simPanelWritePng(png);
+
+    printf("{\"command\":\"%s\",\"arg\":\"%s\",\"ok\":%s,\"cpu_us\":%llu,"
+           "\"transactions\":%u,\"commands\":%u,\"windows\":%u,\"scrolls\":%u,"
+           "\"data_bytes\":%llu,\"pixels\":%llu,\"clipped\":%llu,\"spi_est_us\":%u,"
+           "\"blit_windows\":%u,\"blit_transfers\":%u,\"frame_hash\":\"%08x\",\"png\":\"%s\"}\n",
+           command, arg ? arg : "", ok ? "true" : "false", (unsigned long long)cpuUs,
+           s->transactions, s->commands, s->windows, s->scrolls,
+           (unsigned long long)s->data_bytes, (unsigned long long)s->pixels, (unsigned long long)s->clipped,
+           simPanelEstimateUs(s, tft.spiFrequency()), b->windows, b->transfers,
+           simPanelVisibleHash(), dumped ? png : "");
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    const char* fsRoot = ".";
+    uint32_t freq = TFT_SPI_FREQ;
+    int i = 1;
+    for (; i < argc; i++) {
+        if (!strcmp(argv[i], "--fs") && i + 1 < argc) {
+            fsRoot = argv[++i];
+        } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            outDir = argv[++i];
+        } else if (!strcmp(argv[i], "--freq") && i + 1 < argc) {
+            freq = strtoul(argv[++i], nullptr, 10);
+        } else {
+            break;
+        }
+    }
+    if (i >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    LittleFS.setRoot(fsRoot);
+    if (!LittleFS.begin()) {
+        fprintf(stderr, "cannot use %s as the filesystem root\n", fsRoot);
+        return 1;
+    }
+    ::mkdir(outDir, 0777);
+
+    tft.begin(freq);
+    tftBlitInit();
+    tft.setRotation(0);
+    displayInit();
+    imageCatalogInit();
+    displayCacheInit();
+    thumbnailInit();
+    uploadInit();
+
+    int failures = 0;
+    for (; i < argc; i++) {
+        const char* command = argv[i];
+        const char* arg = nullptr;
+        bool ok = true;
+
+        simPanelResetStats();
+        tftBlitResetStats();
+        uint64_t start = hostMicros();
+
+        if (!strcmp(command, "splash")) {
+            showSplashScreen();
+            splashScreenProgress(100);
+        } else if (!strcmp(command, "qr")) {
+            showQRCodes();
+        } else if (!strcmp(command, "image") && i + 1 < argc) {
+            arg = argv[++i];
+            bool progressive = i + 1 < argc && !strcmp(argv[i + 1], "--progressive");
+            if (progressive) {
+                i++;
+            }
+            displayRequestNew();
+            ok = displayImageWithScaling(arg, true, progressive);
+        } else if (!strcmp(command, "stream") && i + 1 < argc) {
+            arg = argv[++i];
+            std::string path = std::string(fsRoot) + "/images/" + arg;
+            FILE* f = fopen(path.c_str(), "rb");
+            displayRequestNew();
+            ok = f && displayDecodeJpegStream(streamChunks, f, true);
+            if (f) {
+                fclose(f);
+            }
+        } else if (!strcmp(command, "anim") && i + 1 < argc) {
+            arg = argv[++i];
+            uint16_t percent = 100;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                percent = atoi(argv[++i]);
+            }
+            displayRequestNew();
+            ok = displayAnimation(arg, percent, 1);
+        } else if (!strcmp(command, "rect") && i + 1 < argc) {
+            arg = argv[++i];
+            ok = drawRectFile(arg);
+        } else if (!strcmp(command, "uncached") && i + 1 < argc) {
+            arg = argv[++i];
+            displayCacheInvalidate(arg);
+            continue;
+        } else if (!strcmp(command, "thumb") && i + 1 < argc) {
+            arg = argv[++i];
+            ok = thumbnailGenerate(arg);
+            File thumb = LittleFS.open(thumbnailPath(arg), "r");
+            printf("{\"command\":\"thumb\",\"arg\":\"%s\",\"ok\":%s,\"cpu_us\":%llu,\"bytes\":%u,\"source_bytes\":%u}\n",
+                   arg, ok ? "true" : "false", (unsigned long long)(hostMicros() - start),
+                   thumb ? (unsigned)thumb.size() : 0u, displayLastBytesRead());
+            fflush(stdout);
+            if (!ok) {
+                failures++;
+            }
+            continue;
+        } else if (!strcmp(command, "bench-upload")) {
+            uint32_t bytes = BENCH_UPLOAD_DEFAULT_BYTES;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                bytes = atoi(argv[++i]);
+            }
+            StdoutPrint out;
+            benchUpload(out, bytes);
+            fflush(stdout);
+            continue;
+        } else if (!strcmp(command, "bench-anim")) {
+            uint16_t percent = BENCH_ANIM_FAST_PERCENT;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                percent = atoi(argv[++i]);
+            }
+            StdoutPrint out;
+            benchAnimation(out, percent);
+            fflush(stdout);
+            continue;
+        } else if (!strcmp(command, "bench-list")) {
+            uint16_t files = BENCH_LIST_DEFAULT_FILES;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                files = atoi(argv[++i]);
+            }
+            StdoutPrint out;
+            benchListing(out, files);
+            fflush(stdout);
+            continue;
+        } else if (!strcmp(command, "bench")) {
+            uint16_t runs = BENCH_DEFAULT_RUNS;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                runs = atoi(argv[++i]);
+            }
+            StdoutPrint out;
+            benchRun(out, runs);
+            fflush(stdout);
+            continue;
+        } else if (!strcmp(command, "console") && i + 1 < argc) {
+            arg = argv[++i];
+            int lines = atoi(arg);
+            for (int n = 0; n < lines; n++) {
+                tftDebugPrintf(n % 5 ? TFT_COLOR_INFO : TFT_COLOR_WARN, "line %d of %d", n + 1, lines);
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+
+        report(command, arg, ok, hostMicros() - start);
+        if (!ok) {
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
+#endif
@@ -0,0 +1,147 @@
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "LittleFS.h"
+#include "esp_log.h"
+#include "common.h"
+#include "http_cache.h"
+#include "image_catalog.h"
+
+typedef struct
+{
+	String path; // Requested path; the stored file may be path.gz
+	String etag;
+	uint32_t size;
+} http_asset_t;
+
+// Requests run on the async_tcp task only, so none of this is locked
+static http_asset_t assets[HTTP_CACHE_ASSETS];
+static uint8_t assetCount = 0;
+static uint8_t assetNext = 0; // Slot replaced when the table is full
+
+static uint32_t sent200 = 0;
+static uint32_t sent304 = 0;
+static uint64_t bodyBytes = 0;
+static uint64_t savedBytes = 0; // Bodies a 304 made unnecessary
+
+// CRC-32 of a whole file as a quoted ETag
+static bool fileEtag(const String& stored, String* etag, uint32_t* size) {
+    File file = LittleFS.open(stored, "r");
+    if (!file || file.isDirectory()) {
+        return false;
+    }
+    uint8_t buf[512];
+    uint32_t crc = 0;
+    size_t n;
+    while ((n = file.read(buf, sizeof(buf))) > 0) {
+        crc = imageCatalogCrc32(crc, buf, n);
+    }
+    *size = file.size();
+    file.close();
+    char text[12];
+    snprintf(text, sizeof(text), "\"%08x\"", crc);
+    *etag = text;
+    return true;
+}
+
+// The web interface from data/ (paths ending in / are directories). Only
+// these change through a filesystem update alone, which reboots; images,
+// thumbnails, the catalog and the playlist change at runtime and have their
+// own endpoints
+static const char* const webAssets[] = {"/index.html", "/update/"};
+
+static bool isWebAsset(const String& path) {
+    if (path.indexOf("..") >= 0) {
+        return false;
+    }
+    for (const char* asset : webAssets) {
+        size_t len = strlen(asset);
+        if (asset[len - 1] == '/' ? path.startsWith(asset) : path == asset) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Remembered ETag of a web asset, computed on first use
+static const http_asset_t* findAsset(const String& path) {
+    if (!isWebAsset(path)) {
+        return nullptr;
+    }
+    for (uint8_t i = 0; i < assetCount; i++) {
+        if (assets[i].path == path) {
+            return &assets[i];
+        }
+    }
+    String etag;
+    uint32_t size;
+    if (!fileEtag(path, &etag, &size) && !fileEtag(path + ".gz", &etag, &size)) {
+        return nullptr;
+    }
+    http_asset_t* slot;
+    if (assetCount < HTTP_CACHE_ASSETS) {
+        slot = &assets[assetCount++];
+    } else {
+        slot = &assets[assetNext];
+        assetNext = (assetNext + 1) % HTTP_CACHE_ASSETS;
+    }
+    slot->path = path;
+    slot->etag = etag;
+    slot->size = size;
+    return slot;
+}
+
+bool httpNotModified(AsyncWebServerRequest* request, const String& etag) {
+    AsyncWebHeader* header = request->getHeader("If-None-Match");
+    if (!header) {
+        return false;
+    }
+    const String& match = header->value();
+    return match == "*" || match.indexOf(etag) >= 0;
+}
+
+static void sendNotModified(AsyncWebServerRequest* request, const String& etag, const char* cacheControl,
+                            uint32_t size) {
+    AsyncWebServerResponse* response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
+    sent304++;
+    savedBytes += size;
+}
+
+static void sendBody(AsyncWebServerRequest* request, const String& path, const char* contentType,
+                     const String& etag, const char* cacheControl, uint32_t size) {
+    AsyncWebServerResponse* response = request->beginResponse(LittleFS, path, contentType);
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
+    sent200++;
+    bodyBytes += size;
+}
+
+void httpSendFile(AsyncWebServerRequest* request, const String& path, const char* contentType,
+                  const String& etag, const char* cacheControl, uint32_t size) {
+    if (httpNotModified(request, etag)) {
+        sendNotModified(request, etag, cacheControl, size);
+    } else {
+        sendBody(request, path, contentType, etag, cacheControl, size);
+    }
+}
+
+bool httpServeAsset(AsyncWebServerRequest* request, const String& path) {
+    const http_asset_t* asset = findAsset(path);
+    if (!asset) {
+        return false;
+    }
+    // Empty content type: the server derives it from the name, and swaps in
+    // path.gz with Content-Encoding: gzip when only that copy exists
+    httpSendFile(request, asset->path, "", asset->etag, HTTP_CACHE_REVALIDATE, asset->size);
+    return true;
+}
+
+void httpCacheWriteMetrics(Print& out) {
+    out.printf("http_file_responses_total{code=\"200\"} %u\n", sent200);
+    out.printf("http_file_responses_total{code=\"304\"} %u\n", sent304);
+    out.printf("http_file_body_bytes_total %llu\n", (unsigned long long)bodyBytes);
+    out.printf("http_file_saved_bytes_total %llu\n", (unsigned long long)savedBytes);
+}
@@ -0,0 +1,63 @@
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "esp_log.h"
+#include "common.h"
+#include "http_deferred.h"
+
+// Stays in RESPONSE_HEADERS, with nothing written, until the result is in;
+// AsyncWebServerRequest::_onPoll() calls _ack() on every poll meanwhile
+class AsyncDeferredResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncDeferredResponse(const char* contentType, http_deferred_result_t result) : _result(result) {
+        _code = 200;
+        _contentType = contentType;
+    }
+
+    bool _sourceValid() const override {
+        return true;
+    }
+
+    void _respond(AsyncWebServerRequest* request) override {
+        _state = RESPONSE_HEADERS;
+        trySend(request);
+    }
+
+    size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) override {
+        _ackedLength += len;
+        if (_state == RESPONSE_HEADERS) {
+            trySend(request);
+        } else if (_state == RESPONSE_WAIT_ACK && _ackedLength >= _writtenLength) {
+            _state = RESPONSE_END;
+        }
+        return 0;
+    }
+
+private:
+    http_deferred_result_t _result;
+    String _body;
+    bool _ready = false;
+
+    void trySend(AsyncWebServerRequest* request) {
+        if (!_ready) {
+            if (!_result(&_code, &_body)) {
+                return;
+            }
+            _ready = true;
+            _contentLength = _body.length();
+        }
+        // Small JSON bodies: head and body in one segment, or try again on
+        // the next poll
+        String out = _assembleHead(request->version()) + _body;
+        if (request->client()->space() < out.length()) {
+            return;
+        }
+        _writtenLength += request->client()->write(out.c_str(), out.length());
+        _state = RESPONSE_WAIT_ACK;
+    }
+};
+
+void httpSendDeferred(AsyncWebServerRequest* request, const char* contentType, http_deferred_result_t result) {
+    AsyncDeferredResponse* response = new AsyncDeferredResponse(contentType, result);
+    request->send(response);
+}
@@ -0,0 +1,469 @@
+#include <Arduino.h>
+#include "LittleFS.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "common.h"
+#include "image_catalog.h"
+#include "image_list.h"
+#include "animation.h"
+#include <algorithm>
+
+struct image_catalog {
+    String dir;
+    String path;
+    SemaphoreHandle_t mutex;
+    image_catalog_entry_t* entries; // Sorted by name
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t generation;
+};
+
+image_catalog_t* imageCatalog = nullptr;
+
+// Half-byte table: 64 bytes of flash instead of 1 KB, still a lookup per nibble
+static const uint32_t crcNibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t imageCatalogCrc32(uint32_t crc, const uint8_t* data, size_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ crcNibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crcNibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+const char* imageFormatName(uint8_t format) {
+    switch (format) {
+    case IMAGE_FORMAT_JPEG:
+        return "jpeg";
+    case IMAGE_FORMAT_PNG:
+        return "png";
+    case IMAGE_FORMAT_ANIM:
+        return "anim";
+    default:
+        return "unknown";
+    }
+}
+
+static void lock(image_catalog_t* catalog) {
+    xSemaphoreTake(catalog->mutex, portMAX_DELAY);
+}
+
+static void unlock(image_catalog_t* catalog) {
+    xSemaphoreGive(catalog->mutex);
+}
+
+static bool entryLess(const image_catalog_entry_t& a, const image_catalog_entry_t& b) {
+    return strcmp(a.name, b.name) < 0;
+}
+
+// First record not ordered before name; *found when it is that name
+static uint32_t findIndex(const image_catalog_t* catalog, const char* name, bool* found) {
+    uint32_t lo = 0, hi = catalog->count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (strcmp(catalog->entries[mid].name, name) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *found = lo < catalog->count && !strcmp(catalog->entries[lo].name, name);
+    return lo;
+}
+
+static bool reserve(image_catalog_t* catalog, uint32_t count) {
+    if (count <= catalog->capacity) {
+        return true;
+    }
+    if (count > IMAGE_CATALOG_MAX) {
+        return false;
+    }
+    uint32_t capacity = max(count, min((uint32_t)IMAGE_CATALOG_MAX, max((uint32_t)16, catalog->capacity * 2)));
+    image_catalog_entry_t* grown = (image_catalog_entry_t*)realloc(catalog->entries, capacity * sizeof(image_catalog_entry_t));
+    if (!grown) {
+        return false;
+    }
+    catalog->entries = grown;
+    catalog->capacity = capacity;
+    return true;
+}
+
+// Write beside the old catalog and swap, so a power cut keeps one of them.
+// Called with the lock held.
+static bool save(image_catalog_t* catalog) {
+    image_catalog_header_t header;
+    header.magic = IMAGE_CATALOG_MAGIC;
+    header.version = IMAGE_CATALOG_VERSION;
+    header.record_size = sizeof(image_catalog_entry_t);
+    header.count = catalog->count;
+    size_t recordBytes = catalog->count * sizeof(image_catalog_entry_t);
+    header.crc = imageCatalogCrc32(0, (const uint8_t*)catalog->entries, recordBytes);
+
+    String tmp = catalog->path + ".tmp";
+    File file = LittleFS.open(tmp, "w");
+    bool written = file && file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                   (!recordBytes || file.write((const uint8_t*)catalog->entries, recordBytes) == recordBytes);
+    if (file) {
+        file.close();
+    }
+    if (!written || !LittleFS.rename(tmp, catalog->path)) {
+        LittleFS.remove(tmp);
+        ESP_LOGE(LOG_TAG_COMMON, "Image catalog write failed: %s", catalog->path.c_str());
+        return false;
+    }
+    return true;
+}
+
+static bool load(image_catalog_t* catalog) {
+    File file = LittleFS.open(catalog->path, "r");
+    if (!file) {
+        ESP_LOGI(LOG_TAG_COMMON, "Image catalog %s missing, rebuilding", catalog->path.c_str());
+        return false;
+    }
+    image_catalog_header_t header;
+    const char* problem = nullptr;
+    if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) || header.magic != IMAGE_CATALOG_MAGIC) {
+        problem = "bad header";
+    } else if (header.version != IMAGE_CATALOG_VERSION || header.record_size != sizeof(image_catalog_entry_t)) {
+        problem = "old version";
+    } else if (header.count > IMAGE_CATALOG_MAX ||
+               file.size() != sizeof(header) + header.count * sizeof(image_catalog_entry_t)) {
+        problem = "bad length";
+    } else if (!reserve(catalog, header.count)) {
+        problem = "out of memory";
+    } else {
+        size_t recordBytes = header.count * sizeof(image_catalog_entry_t);
+        if (recordBytes && file.read((uint8_t*)catalog->entries, recordBytes) != recordBytes) {
+            problem = "short read";
+        } else if (imageCatalogCrc32(0, (const uint8_t*)catalog->entries, recordBytes) != header.crc) {
+            problem = "checksum mismatch";
+        } else {
+            for (uint32_t i = 0; i < header.count && !problem; i++) {
+                image_catalog_entry_t* e = &catalog->entries[i];
+                if (!memchr(e->name, '\0', sizeof(e->name)) || (i && !entryLess(catalog->entries[i - 1], *e))) {
+                    problem = "records out of order";
+                }
+            }
+        }
+    }
+    file.close();
+    if (problem) {
+        ESP_LOGW(LOG_TAG_COMMON, "Image catalog %s: %s, rebuilding", catalog->path.c_str(), problem);
+        Serial.printf("[CATALOG] %s: %s, rebuilding\n", catalog->path.c_str(), problem);
+        return false;
+    }
+    catalog->count = header.count;
+    return true;
+}
+
+static bool readExact(File& file, uint8_t* buf, size_t len) {
+    return file.read(buf, len) == len;
+}
+
+// Dimensions from the first SOFn segment
+static bool probeJpeg(File& file, image_catalog_entry_t* out) {
+    uint8_t b[7];
+    for (uint8_t segments = 0; segments < 64; segments++) {
+        if (!readExact(file, b, 2) || b[0] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = b[1];
+        while (marker == 0xFF) { // Fill bytes
+            if (!readExact(file, &marker, 1)) {
+                return false;
+            }
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            continue; // No length field
+        }
+        if (marker == 0xD9 || marker == 0xDA) {
+            return false; // Scan data or end before any frame header
+        }
+        if (!readExact(file, b, 2)) {
+            return false;
+        }
+        uint16_t length = (b[0] << 8) | b[1];
+        bool isFrame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (isFrame) {
+            if (!readExact(file, b, 5)) {
+                return false;
+            }
+            out->height = (b[1] << 8) | b[2];
+            out->width = (b[3] << 8) | b[4];
+            return true;
+        }
+        if (length < 2 || !file.seek(file.position() + length - 2)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Format from the file signature, dimensions from its header
+static void probeHeader(File& file, image_catalog_entry_t* out) {
+    static const uint8_t pngSignature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    uint8_t head[24];
+    out->format = IMAGE_FORMAT_UNKNOWN;
+    out->width = 0;
+    out->height = 0;
+    if (!readExact(file, head, 2)) {
+        return;
+    }
+    if (head[0] == 0xFF && head[1] == 0xD8) {
+        out->format = IMAGE_FORMAT_JPEG;
+        probeJpeg(file, out);
+    } else if (readExact(file, head + 2, sizeof(head) - 2) && !memcmp(head, pngSignature, sizeof(pngSignature)) &&
+               !memcmp(head + 12, "IHDR", 4)) {
+        out->format = IMAGE_FORMAT_PNG;
+        uint32_t w = ((uint32_t)head[16] << 24) | ((uint32_t)head[17] << 16) | (head[18] << 8) | head[19];
+        uint32_t h = ((uint32_t)head[20] << 24) | ((uint32_t)head[21] << 16) | (head[22] << 8) | head[23];
+        out->width = w > 0xFFFF ? 0xFFFF : w;
+        out->height = h > 0xFFFF ? 0xFFFF : h;
+    } else if (!memcmp(head, ANIM_MAGIC, 4)) {
+        out->format = IMAGE_FORMAT_ANIM; // Canvas size (animation.h)
+        out->width = head[6] | (head[7] << 8);
+        out->height = head[8] | (head[9] << 8);
+    }
+}
+
+bool imageCatalogProbe(image_catalog_t* catalog, const char* name, image_catalog_entry_t* out, bool crcKnown, uint32_t crc) {
+    if (strlen(name) >= sizeof(out->name)) {
+        return false;
+    }
+    File file = LittleFS.open(catalog->dir + "/" + name, "r");
+    if (!file || file.isDirectory()) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+    strlcpy(out->name, name, sizeof(out->name));
+    out->size = file.size();
+    out->mtime = (uint32_t)file.getLastWrite();
+    probeHeader(file, out);
+
+    if (!crcKnown) {
+        uint8_t* chunk = (uint8_t*)malloc(IMAGE_CATALOG_PROBE_CHUNK);
+        if (!chunk) {
+            file.close();
+            return false;
+        }
+        file.seek(0);
+        crc = 0;
+        size_t n;
+        while ((n = file.read(chunk, IMAGE_CATALOG_PROBE_CHUNK)) > 0) {
+            crc = imageCatalogCrc32(crc, chunk, n);
+        }
+        free(chunk);
+    }
+    out->crc = crc;
+    file.close();
+    return true;
+}
+
+// With force the catalog file is written even if nothing changed, so a
+// rebuild of an empty directory still leaves a valid file behind
+static uint32_t scan(image_catalog_t* catalog, bool force) {
+    File dir = LittleFS.open(catalog->dir);
+    if (!dir || !dir.isDirectory()) {
+        lock(catalog);
+        bool changed = catalog->count != 0;
+        catalog->count = 0;
+        if (changed) {
+            catalog->generation++;
+        }
+        if (changed || force) {
+            save(catalog);
+        }
+        unlock(catalog);
+        return 0;
+    }
+
+    // Build the new record set apart from the live one; probing reads files
+    // and must not hold the lock
+    image_catalog_entry_t* fresh = nullptr;
+    uint32_t count = 0, capacity = 0, probed = 0, skipped = 0;
+    bool changed = false;
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        if (f.isDirectory()) {
+            continue;
+        }
+        const char* name = f.name();
+        if (strlen(name) >= IMAGE_CATALOG_NAME_MAX || count >= IMAGE_CATALOG_MAX) {
+            skipped++;
+            continue;
+        }
+        if (count == capacity) {
+            capacity = min((uint32_t)IMAGE_CATALOG_MAX, max((uint32_t)16, capacity * 2));
+            image_catalog_entry_t* grown = (image_catalog_entry_t*)realloc(fresh, capacity * sizeof(image_catalog_entry_t));
+            if (!grown) {
+                free(fresh);
+                ESP_LOGE(LOG_TAG_COMMON, "Image catalog scan: out of memory");
+                return probed;
+            }
+            fresh = grown;
+        }
+        image_catalog_entry_t* e = &fresh[count];
+        uint32_t size = f.size();
+        uint32_t mtime = (uint32_t)f.getLastWrite();
+        String fileName = name;
+        f.close();
+        if (imageCatalogLookup(catalog, fileName.c_str(), e) && e->size == size && e->mtime == mtime) {
+            count++;
+            continue;
+        }
+        if (imageCatalogProbe(catalog, fileName.c_str(), e)) {
+            count++;
+            probed++;
+            changed = true;
+        }
+    }
+    dir.close();
+    std::sort(fresh, fresh + count, entryLess);
+
+    lock(catalog);
+    changed = changed || count != catalog->count;
+    if (changed) {
+        free(catalog->entries);
+        catalog->entries = fresh;
+        catalog->capacity = capacity;
+        catalog->count = count;
+        catalog->generation++;
+    } else {
+        free(fresh);
+    }
+    if (changed || force) {
+        save(catalog);
+    }
+    unlock(catalog);
+
+    if (skipped) {
+        ESP_LOGW(LOG_TAG_COMMON, "Image catalog: %u files not indexed (name too long or catalog full)", skipped);
+    }
+    return probed;
+}
+
+uint32_t imageCatalogScan(image_catalog_t* catalog) {
+    return scan(catalog, false);
+}
+
+image_catalog_t* imageCatalogOpen(const char* dir, const char* path) {
+    image_catalog_t* catalog = new image_catalog_t();
+    catalog->dir = dir;
+    catalog->path = path;
+    catalog->mutex = xSemaphoreCreateMutex();
+    bool loaded = load(catalog);
+    uint32_t probed = scan(catalog, !loaded);
+    if (probed) {
+        ESP_LOGI(LOG_TAG_COMMON, "Image catalog %s: %u files probed", catalog->path.c_str(), probed);
+    }
+    return catalog;
+}
+
+void imageCatalogClose(image_catalog_t* catalog) {
+    if (!catalog) {
+        return;
+    }
+    free(catalog->entries);
+    vSemaphoreDelete(catalog->mutex);
+    delete catalog;
+}
+
+void imageCatalogInit() {
+    uint32_t start = millis();
+    imageCatalog = imageCatalogOpen(IMAGE_LIST_DIR, IMAGE_CATALOG_PATH);
+    ESP_LOGI(LOG_TAG_COMMON, "Image catalog: %u images, %u bytes, ready in %lu ms",
+             imageCatalogCount(imageCatalog), imageCatalogMemory(imageCatalog), millis() - start);
+    Serial.printf("[CATALOG] %u images indexed (%lu ms)\n", imageCatalogCount(imageCatalog), millis() - start);
+}
+
+bool imageCatalogLookup(image_catalog_t* catalog, const char* name, image_catalog_entry_t* out) {
+    if (!catalog) {
+        return false; // Filesystem not mounted, nothing indexed
+    }
+    lock(catalog);
+    bool found;
+    uint32_t i = findIndex(catalog, name, &found);
+    if (found && out) {
+        *out = catalog->entries[i];
+    }
+    unlock(catalog);
+    return found;
+}
+
+bool imageCatalogContains(image_catalog_t* catalog, const char* name) {
+    return imageCatalogLookup(catalog, name, nullptr);
+}
+
+bool imageCatalogAt(image_catalog_t* catalog, uint32_t index, image_catalog_entry_t* out) {
+    if (!catalog) {
+        return false;
+    }
+    lock(catalog);
+    bool valid = index < catalog->count;
+    if (valid) {
+        *out = catalog->entries[index];
+    }
+    unlock(catalog);
+    return valid;
+}
+
+uint32_t imageCatalogCount(image_catalog_t* catalog) {
+    if (!catalog) {
+        return 0;
+    }
+    return catalog->count;
+}
+
+uint32_t imageCatalogGeneration(image_catalog_t* catalog) {
+    return catalog->generation;
+}
+
+bool imageCatalogUpdate(image_catalog_t* catalog, const image_catalog_entry_t* entry) {
+    if (!catalog) {
+        return false;
+    }
+    lock(catalog);
+    bool found;
+    uint32_t i = findIndex(catalog, entry->name, &found);
+    if (!found) {
+        if (!reserve(catalog, catalog->count + 1)) {
+            unlock(catalog);
+            ESP_LOGW(LOG_TAG_COMMON, "Image catalog full, %s not indexed", entry->name);
+            return false;
+        }
+        memmove(&catalog->entries[i + 1], &catalog->entries[i], (catalog->count - i) * sizeof(image_catalog_entry_t));
+        catalog->count++;
+    }
+    catalog->entries[i] = *entry;
+    catalog->generation++;
+    bool saved = save(catalog);
+    unlock(catalog);
+    return saved;
+}
+
+bool imageCatalogRemove(image_catalog_t* catalog, const char* name) {
+    if (!catalog) {
+        return false;
+    }
+    lock(catalog);
+    bool found;
+    uint32_t i = findIndex(catalog, name, &found);
+    bool saved = true;
+    if (found) {
+        catalog->count--;
+        memmove(&catalog->entries[i], &catalog->entries[i + 1], (catalog->count - i) * sizeof(image_catalog_entry_t));
+        catalog->generation++;
+        saved = save(catalog);
+    }
+    unlock(catalog);
+    return found && saved;
+}
+
+size_t imageCatalogMemory(image_catalog_t* catalog) {
+    return sizeof(image_catalog_t) + catalog->capacity * sizeof(image_catalog_entry_t);
+}
@@ -5,166 +5,621 @@
 #include "esp_log.h"
 #include "common.h"
 #include "image_display.h"
+#include "display_cache.h"
+#include "tft_blit.h"
+#include "pixel_convert.h"
+#include "image_scaler.h"
+#include "decoder_arena.h"
+#include "tft_debug.h"
+#include "render_metrics.h"
+#include "image_catalog.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <new>
+
+// Decoder state lives in the arena only while an image is being decoded;
+// the JPEG workspace and the PNG object share the same bytes
+struct DecoderArena {
+    File file;
+    const uint8_t* mem;     // Preloaded image bytes, used instead of file when set
+    uint32_t memSize;
+    uint32_t memPos;
+    display_reader_t reader; // Streamed input, used instead of file when set
+    void* readerContext;
+    uint32_t bytesRead;
+    int16_t jpegX;
+    int16_t jpegY;
+    union {
+        struct {
+            JDEC jdec;
+            uint8_t work[TJPGD_WORKSPACE_SIZE] __attribute__((aligned(4)));
+        } jpeg;
+        uint8_t png[sizeof(PNG)] __attribute__((aligned(4)));
+    };
+};
+static DecoderArena* arena = nullptr;
+static uint32_t lastBytesRead = 0;
+
+// Image bytes handed over by displaySetPreloaded()
+static String preloadedName;
+static const uint8_t* preloadedData = nullptr;
+static size_t preloadedSize = 0;
+
+// Serialises whole display operations between tasks
+static SemaphoreHandle_t displayMutex = nullptr;
+
+// Progress listener and the last percentage handed to it
+static display_progress_t progressCallback = nullptr;
+static uint8_t progressLast = 0;
 
 // Global variables for image decoding
-static File imageFile;
-static PNG png;
-static int16_t currentDrawX = 0;
-static int16_t currentDrawY = 0;
+static image_placement_t placement;
+static pixel_row_kernel_t pngKernel = nullptr;
+static pixel_context_t pngPixelContext;
+static uint16_t pngLut[256];
+static bool pngLutReady = false;
+
+// Output strip being filled in the blit buffer
+static int16_t stripX = 0;
+static int16_t stripY = 0;
+static uint16_t stripWidth = 0;
+static uint16_t stripRows = 0;
+static uint16_t stripLimit = PNG_STRIP_ROWS;
+
+// JPEG MCU-row band; in the scaled path it holds source pixels instead
+static int16_t jpegBandY = 0;
+static uint16_t jpegBandRows = 0;
+static uint16_t* jpegSourceBand = nullptr;
+
+// Bumped for every new display request; a decode that sees it change stops
+static volatile uint32_t displayGeneration = 0;
+static uint32_t drawGeneration = 0;
+
+// Resampler state, active when the decoded size differs from the placement
+static bool scaling = false;
+static image_scaler_t scaler;
+static uint16_t* scalerPrevRow = nullptr;
+static uint16_t* pngSourceRow = nullptr;
+
+// Set while displayRenderThumbnail() decodes into RAM instead of the panel
+static uint16_t* thumbPixels = nullptr;
+static uint16_t thumbWidth = 0;
+static uint16_t thumbHeight = 0;
+
+#if PNG_STRIP_ROWS > TFT_BLIT_STRIP_ROWS
+#error "PNG_STRIP_ROWS must not exceed TFT_BLIT_STRIP_ROWS"
+#endif
+#if TFT_BLIT_STRIP_ROWS < 16
+#error "TFT_BLIT_STRIP_ROWS must hold a full JPEG MCU row (16)"
+#endif
+
+static bool arenaBegin() {
+    void* block = decoderArenaAcquire(sizeof(DecoderArena));
+    if (!block) return false;
+    arena = new (block) DecoderArena();
+    arena->mem = nullptr;
+    arena->memSize = 0;
+    arena->memPos = 0;
+    arena->reader = nullptr;
+    arena->readerContext = nullptr;
+    arena->bytesRead = 0;
+    return true;
+}
+
+// Point the decoder input at the preloaded copy of filename, or open it
+static bool sourceOpen(const char* filename) {
+    if (preloadedData && preloadedName == filename) {
+        arena->mem = preloadedData;
+        arena->memSize = preloadedSize;
+        arena->memPos = 0;
+        ESP_LOGI(LOG_TAG_COMMON, "Decoding %s from preloaded buffer", filename);
+        return true;
+    }
+    String path = "/images/";
+    path += filename;
+    int64_t start = esp_timer_get_time();
+    arena->file = LittleFS.open(path, "r");
+    metricsRecord(METRIC_FILE_OPEN, (uint32_t)(esp_timer_get_time() - start));
+    return (bool)arena->file;
+}
+
+static uint32_t sourceSize() {
+    return arena->mem ? arena->memSize : arena->file.size();
+}
+
+// Decoders expect a full read unless the data ends; a stream reader returns
+// whatever has arrived, so keep asking
+static size_t readerFill(uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (n < len) {
+        size_t got = arena->reader(arena->readerContext, buf + n, len - n);
+        if (!got) break;
+        n += got;
+    }
+    return n;
+}
+
+static size_t sourceRead(uint8_t* buf, size_t len) {
+    size_t n;
+    int64_t start = esp_timer_get_time();
+    if (arena->reader) {
+        n = readerFill(buf, len);
+    } else if (arena->mem) {
+        n = min((size_t)(arena->memSize - arena->memPos), len);
+        memcpy(buf, arena->mem + arena->memPos, n);
+        arena->memPos += n;
+    } else {
+        n = arena->file.read(buf, len);
+    }
+    metricsCountRead(n, (uint32_t)(esp_timer_get_time() - start));
+    arena->bytesRead += n;
+    return n;
+}
+
+static bool sourceSeek(uint32_t position) {
+    if (arena->reader) {
+        // Forward only: read and drop
+        uint8_t skip[64];
+        while (arena->bytesRead < position) {
+            size_t n = min((uint32_t)sizeof(skip), position - arena->bytesRead);
+            if (sourceRead(skip, n) != n) return false;
+        }
+        return arena->bytesRead == position;
+    }
+    if (arena->mem) {
+        if (position > arena->memSize) return false;
+        arena->memPos = position;
+        return true;
+    }
+    return arena->file.seek(position);
+}
+
+static uint32_t sourcePosition() {
+    if (arena->reader) return arena->bytesRead;
+    return arena->mem ? arena->memPos : arena->file.position();
+}
+
+static void arenaEnd() {
+    if (!arena) return;
+    ESP_LOGI(LOG_TAG_COMMON, "Decoder read %u bytes", arena->bytesRead);
+    lastBytesRead = arena->bytesRead;
+    arena->~DecoderArena();
+    arena = nullptr;
+    decoderArenaRelease();
+}
 
 // PNG decoder callback functions
 void* pngOpen(const char* filename, int32_t* size) {
     ESP_LOGI(LOG_TAG_COMMON, "Opening PNG: %s", filename);
-    String path = "/images/";
-    path += filename;
-    
-    imageFile = LittleFS.open(path, "r");
-    if (imageFile) {
-        *size = imageFile.size();
+    if (sourceOpen(filename)) {
+        *size = sourceSize();
         ESP_LOGI(LOG_TAG_COMMON, "PNG file size: %d bytes", *size);
-        return &imageFile;
+        return arena;
     }
-    ESP_LOGE(LOG_TAG_COMMON, "Failed to open PNG file: %s", path.c_str());
+    ESP_LOGE(LOG_TAG_COMMON, "Failed to open PNG file: %s", filename);
     return nullptr;
 }
 
 void pngClose(void* handle) {
-    if (imageFile) {
-        imageFile.close();
+    if (arena->file) {
+        arena->file.close();
         ESP_LOGI(LOG_TAG_COMMON, "PNG file closed");
     }
 }
 
 int32_t pngRead(PNGFILE* handle, uint8_t* buffer, int32_t length) {
-    if (imageFile) {
-        return imageFile.read(buffer, length);
-    }
-    return 0;
+    return sourceRead(buffer, length);
 }
 
 int32_t pngSeek(PNGFILE* handle, int32_t position) {
-    if (imageFile) {
-        return imageFile.seek(position);
+    return sourceSeek(position);
+}
+
+// Report how far down the placement the image has been drawn, in 10% steps
+static void reportProgress(int16_t bottom) {
+    if (!progressCallback || placement.height == 0) return;
+    int32_t percent = (int32_t)(bottom - placement.y) * 100 / placement.height;
+    if (percent > 100) percent = 100;
+    if (percent >= progressLast + 10 || (percent == 100 && progressLast < 100)) {
+        progressLast = (uint8_t)percent;
+        progressCallback(progressLast);
     }
-    return 0;
 }
 
-// PNG draw callback - renders decoded PNG line to TFT
+// Push the collected strip rows as one rectangle
+static void flushStrip() {
+    if (stripRows == 0) return;
+    uint16_t *strip = tftBlitBuffer();
+    tftBlitCommit(stripX, stripY, stripWidth, stripRows);
+    displayCacheCapture(stripX, stripY, stripWidth, stripRows, strip);
+    reportProgress(stripY + stripRows);
+    stripRows = 0;
+}
+
+// Next row slot in the current strip; a full strip is pushed first
+static uint16_t* stripRow(int16_t x, int16_t y, uint16_t width) {
+    if (stripRows == stripLimit) {
+        flushStrip();
+    }
+    if (stripRows == 0) {
+        stripX = x;
+        stripY = y;
+        stripWidth = width;
+    }
+    return tftBlitBuffer() + stripRows++ * stripWidth;
+}
+
+// Resampler target - destination rows land in the strip at the placement,
+// or straight in the thumbnail buffer
+static uint16_t* scaledRowTarget(void* user, uint16_t dstY) {
+    if (thumbPixels) {
+        return thumbPixels + (placement.y + dstY) * thumbWidth + placement.x;
+    }
+    return stripRow(placement.x, placement.y + dstY, placement.width);
+}
+
+static bool beginScaling(uint16_t srcW, uint16_t srcH, bool bilinear) {
+    if (bilinear) {
+        scalerPrevRow = (uint16_t*)malloc(srcW * 2);
+        if (!scalerPrevRow) return false;
+    }
+    if (!scalerInit(&scaler, srcW, srcH, placement.width, placement.height,
+                    bilinear, scalerPrevRow, scaledRowTarget, nullptr)) {
+        free(scalerPrevRow);
+        scalerPrevRow = nullptr;
+        return false;
+    }
+    ESP_LOGI(LOG_TAG_COMMON, "Resampling %dx%d -> %dx%d at (%d, %d)", srcW, srcH,
+             placement.width, placement.height, placement.x, placement.y);
+    stripLimit = TFT_BLIT_STRIP_ROWS;
+    scaling = true;
+    return true;
+}
+
+static void endScaling() {
+    free(scalerPrevRow);
+    scalerPrevRow = nullptr;
+    scaling = false;
+    stripLimit = PNG_STRIP_ROWS;
+}
+
+// Blank the panel around the placed image instead of clearing all of it
+static void fillOutsidePlacement(uint16_t color) {
+    int16_t right = placement.x + placement.width;
+    int16_t bottom = placement.y + placement.height;
+    tft.fillRect(0, 0, ILI9341_TFTWIDTH, placement.y, color);
+    tft.fillRect(0, bottom, ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT - bottom, color);
+    tft.fillRect(0, placement.y, placement.x, placement.height, color);
+    tft.fillRect(right, placement.y, ILI9341_TFTWIDTH - right, placement.height, color);
+}
+
+// Clear around the placement (the image area itself is overwritten) and
+// start the blit pipeline; a thumbnail needs neither, all of its rows come
+// from the resampler
+static bool outputBegin() {
+    if (thumbPixels) {
+        return true;
+    }
+    fillOutsidePlacement(ILI9341_BLACK);
+    return tftBlitBegin();
+}
+
+static void outputEnd() {
+    if (!thumbPixels) {
+        tftBlitEnd();
+    }
+}
+
+static void fitPlacement(uint16_t srcW, uint16_t srcH, uint16_t boxW, uint16_t boxH, bool centerImage,
+                         image_placement_t* out) {
+    // Fit inside the box keeping the aspect ratio (up or down)
+    if ((uint32_t)srcW * boxH >= (uint32_t)srcH * boxW) {
+        out->width = boxW;
+        out->height = (uint32_t)srcH * boxW / srcW;
+    } else {
+        out->height = boxH;
+        out->width = (uint32_t)srcW * boxH / srcH;
+    }
+    if (out->width == 0) out->width = 1;
+    if (out->height == 0) out->height = 1;
+    out->x = centerImage ? (boxW - out->width) / 2 : 0;
+    out->y = centerImage ? (boxH - out->height) / 2 : 0;
+}
+
+// Placement on the panel, or inside the thumbnail
+static void placeImage(uint16_t srcW, uint16_t srcH, bool centerImage) {
+    if (thumbPixels) {
+        fitPlacement(srcW, srcH, thumbWidth, thumbHeight, true, &placement);
+    } else {
+        computeImagePlacement(srcW, srcH, centerImage, &placement);
+    }
+}
+
+uint32_t displayRequestNew() {
+    return ++displayGeneration;
+}
+
+bool displayRequestSuperseded() {
+    return displayGeneration != drawGeneration;
+}
+
+void computeImagePlacement(uint16_t srcW, uint16_t srcH, bool centerImage, image_placement_t* out) {
+    fitPlacement(srcW, srcH, ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT, centerImage, out);
+}
+
+// PNG draw callback - converts one decoded PNG line into the current strip
 int pngDraw(PNGDRAW *pDraw) {
-    uint16_t lineBuffer[240]; // Max width
-    uint8_t *s = pDraw->pPixels;
-    
     ESP_LOGD(LOG_TAG_COMMON, "PNG draw line %d: width=%d, bpp=%d, pixel_type=%d", 
              pDraw->y, pDraw->iWidth, pDraw->iBpp, pDraw->iPixelType);
     
-    // Convert pixels to 16-bit color and draw to TFT
-    if (pDraw->iBpp == 16) {
-        // 16-bit RGB565 pixels
-        memcpy(lineBuffer, pDraw->pPixels, pDraw->iWidth * 2);
-    } else if (pDraw->iBpp == 24) {
-        // 24-bit RGB pixels - convert to RGB565
-        for (int x = 0; x < pDraw->iWidth; x++) {
-            uint8_t r = s[x * 3];
-            uint8_t g = s[x * 3 + 1];
-            uint8_t b = s[x * 3 + 2];
-            // Standard RGB to RGB565 conversion
-            lineBuffer[x] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-        }
-    } else if (pDraw->iBpp == 32) {
-        // 32-bit RGBA pixels - ignore alpha, convert to RGB565
-        for (int x = 0; x < pDraw->iWidth; x++) {
-            uint8_t r = s[x * 4];
-            uint8_t g = s[x * 4 + 1];
-            uint8_t b = s[x * 4 + 2];
-            // Ignore alpha channel (s[x * 4 + 3])
-            lineBuffer[x] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    // Palette comes with the first row; build the LUT once per image
+    if (!pngLutReady) {
+        if (pDraw->iPixelType == PNG_PIXEL_INDEXED) {
+            pixelBuildPaletteLut(pngLut, pDraw->pPalette, pDraw->iHasAlpha, &pngPixelContext);
+        } else if (pDraw->iPixelType == PNG_PIXEL_GRAYSCALE) {
+            pixelBuildGrayLut(pngLut, pDraw->iBpp);
         }
+        pngLutReady = true;
     }
     
-    // Draw line to TFT
-    tft.drawRGBBitmap(currentDrawX, currentDrawY + pDraw->y, lineBuffer, pDraw->iWidth, 1);
+    // Convert to big-endian RGB565 (panel byte order) with the per-format kernel;
+    // scaled images go through the resampler, which fills the strip itself
+    if (scaling) {
+        pngKernel(pDraw->pPixels, pngSourceRow, pDraw->iWidth, &pngPixelContext);
+        scalerPushRow(&scaler, pngSourceRow);
+    } else {
+        int16_t y = placement.y + pDraw->y;
+        if (y >= ILI9341_TFTHEIGHT) return 1; // Off screen
+        pngKernel(pDraw->pPixels, stripRow(placement.x, y, placement.width), placement.width, &pngPixelContext);
+    }
     return 1; // Success
 }
 
-// JPEG output callback - renders decoded JPEG to TFT  
+// Collect one JPEG MCU row into a full-width band, then push it as one strip
+static void flushJpegBand() {
+    if (jpegBandRows == 0) return;
+    if (scaling) {
+        for (uint16_t row = 0; row < jpegBandRows; row++) {
+            scalerPushRow(&scaler, jpegSourceBand + row * scaler.src_w);
+        }
+    } else {
+        uint16_t *band = tftBlitBuffer();
+        tftBlitCommit(0, jpegBandY, ILI9341_TFTWIDTH, jpegBandRows);
+        displayCacheCapture(0, jpegBandY, ILI9341_TFTWIDTH, jpegBandRows, band);
+        reportProgress(jpegBandY + jpegBandRows);
+    }
+    jpegBandRows = 0;
+}
+
+// JPEG output callback - copies decoded MCU blocks into the current band
 bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
-    if (y >= 320 || x >= 240) return false; // Off screen
+    if (!thumbPixels && displayRequestSuperseded()) return false; // Newer request waiting; abort decode
+    
+    // Band geometry: panel space when drawing 1:1, decoded-image space when scaling
+    uint16_t bandWidth = scaling ? scaler.src_w : ILI9341_TFTWIDTH;
+    uint16_t bandHeight = scaling ? scaler.src_h : ILI9341_TFTHEIGHT;
+    uint16_t *band = scaling ? jpegSourceBand : tftBlitBuffer();
+    
+    if (y >= bandHeight || x >= bandWidth) return false; // Off screen
+    
+    // Clip to band bounds
+    uint16_t stride = w;
+    if ((x + w) > bandWidth) w = bandWidth - x;
+    if ((y + h) > bandHeight) h = bandHeight - y;
+    if (h > TFT_BLIT_STRIP_ROWS) h = TFT_BLIT_STRIP_ROWS;
     
-    // Clip to screen bounds
-    if ((x + w) > 240) w = 240 - x;
-    if ((y + h) > 320) h = 320 - y;
+    // A block on a new MCU row completes the previous band
+    if (jpegBandRows == 0 || y != jpegBandY) {
+        flushJpegBand();
+        band = scaling ? jpegSourceBand : tftBlitBuffer();
+        memset(band, 0, bandWidth * TFT_BLIT_STRIP_ROWS * 2);
+        jpegBandY = y;
+    }
     
-    // Draw bitmap to TFT
-    tft.drawRGBBitmap(x, y, bitmap, w, h);
+    // tjpgd emits host-order RGB565; swap to panel order on the way in
+    for (uint16_t row = 0; row < h; row++) {
+        uint16_t *dst = band + row * bandWidth + x;
+        const uint16_t *src = bitmap + row * stride;
+        for (uint16_t col = 0; col < w; col++) {
+            dst[col] = __builtin_bswap16(src[col]);
+        }
+    }
+    if (h > jpegBandRows) jpegBandRows = h;
     return true;
 }
 
-// Draw PNG image
-bool drawPNG(const char* filename, int16_t x, int16_t y) {
-    ESP_LOGI(LOG_TAG_COMMON, "Drawing PNG: %s at (%d, %d)", filename, x, y);
+// Draw PNG image, fitted to the panel
+bool drawPNG(const char* filename, bool centerImage) {
+    ESP_LOGI(LOG_TAG_COMMON, "Drawing PNG: %s", filename);
     
-    currentDrawX = x;
-    currentDrawY = y;
+    if (!arenaBegin()) {
+        return false;
+    }
+    PNG *png = new (arena->png) PNG();
+    bool success = false;
     
-    int rc = png.open(filename, pngOpen, pngClose, pngRead, pngSeek, pngDraw);
+    int rc = png->open(filename, pngOpen, pngClose, pngRead, pngSeek, pngDraw);
     if (rc == PNG_SUCCESS) {
-        ESP_LOGI(LOG_TAG_COMMON, "PNG: %dx%d, %d bpp", png.getWidth(), png.getHeight(), png.getBpp());
+        uint16_t width = png->getWidth();
+        uint16_t height = png->getHeight();
+        ESP_LOGI(LOG_TAG_COMMON, "PNG: %dx%d, %d bpp, type %d", width, height, png->getBpp(), png->getPixelType());
         
-        rc = png.decode(nullptr, 0);
-        png.close();
+        pngKernel = pixelSelectRowKernel(png->getPixelType(), png->getBpp());
+        pngPixelContext.lut = pngLut;
+        pixelSetBackground(&pngPixelContext, PNG_BACKGROUND_COLOR);
+        pngLutReady = false;
+        placeImage(width, height, centerImage);
         
-        if (rc == PNG_SUCCESS) {
-            ESP_LOGI(LOG_TAG_COMMON, "PNG decoded successfully");
-            return true;
-        } else {
-            ESP_LOGE(LOG_TAG_COMMON, "PNG decode failed: %d", rc);
+        if (!pngKernel) {
+            ESP_LOGE(LOG_TAG_COMMON, "Unsupported PNG format: type %d, %d bpp", png->getPixelType(), png->getBpp());
+        } else if (placement.width != width || placement.height != height || thumbPixels) {
+            pngSourceRow = (uint16_t*)malloc(width * 2);
+            if (!pngSourceRow || !beginScaling(width, height, IMAGE_SCALE_BILINEAR)) {
+                ESP_LOGE(LOG_TAG_COMMON, "No memory to resample %dx%d PNG", width, height);
+                pngKernel = nullptr;
+            }
         }
+        
+        if (pngKernel && outputBegin()) {
+            decoderHeapReport("during");
+            stripRows = 0;
+            rc = png->decode(nullptr, 0);
+            flushStrip();
+            outputEnd();
+            
+            if (rc == PNG_SUCCESS) {
+                ESP_LOGI(LOG_TAG_COMMON, "PNG decoded successfully");
+                success = true;
+            } else {
+                ESP_LOGE(LOG_TAG_COMMON, "PNG decode failed: %d", rc);
+            }
+        }
+        png->close();
+        endScaling();
+        free(pngSourceRow);
+        pngSourceRow = nullptr;
     } else {
         ESP_LOGE(LOG_TAG_COMMON, "PNG open failed: %d", rc);
     }
     
-    return false;
+    png->~PNG();
+    arenaEnd();
+    return success;
+}
+
+// tjpgd input callback - reads (or skips, when buf is null) from the file
+static size_t jpegInput(JDEC* jdec, uint8_t* buf, size_t len) {
+    if (!buf) {
+        return sourceSeek(sourcePosition() + len) ? len : 0;
+    }
+    return sourceRead(buf, len);
+}
+
+// tjpgd output callback - hands each MCU block to tft_output()
+static int jpegOutput(JDEC* jdec, void* bitmap, JRECT* rect) {
+    DecoderArena* a = (DecoderArena*)jdec->device;
+    return tft_output(a->jpegX + rect->left, a->jpegY + rect->top,
+                      rect->right - rect->left + 1, rect->bottom - rect->top + 1,
+                      (uint16_t*)bitmap) ? 1 : 0;
 }
 
-// Draw JPEG image
-bool drawJPEG(const char* filename, int16_t x, int16_t y) {
-    ESP_LOGI(LOG_TAG_COMMON, "Drawing JPEG: %s at (%d, %d)", filename, x, y);
+// Decode the JPEG the arena source points at, fitted to the panel, and
+// release the arena. A preview decodes at 1/8 scale and blows the result
+// up with nearest-neighbour blocks.
+static bool decodeOpenedJPEG(const char* filename, bool centerImage, bool preview) {
+    JRESULT rc = jd_prepare(&arena->jpeg.jdec, jpegInput, arena->jpeg.work, sizeof(arena->jpeg.work), arena);
+    if (rc != JDR_OK) {
+        ESP_LOGE(LOG_TAG_COMMON, "JPEG header unreadable: %s (%d)", filename, rc);
+        arenaEnd();
+        return false;
+    }
+    uint16_t width = arena->jpeg.jdec.width;
+    uint16_t height = arena->jpeg.jdec.height;
+    placeImage(width, height, centerImage);
     
-    String path = "/images/";
-    path += filename;
+    // Let tjpgd do the coarse 1/2, 1/4, 1/8 reduction while the result
+    // still covers the placement; the resampler handles the rest
+    uint8_t jpegScale = scalerJpegScale(width, height, placement.width, placement.height);
+    if (preview) {
+        if (jpegScale == 8) {
+            arenaEnd();
+            return false; // Full decode is already 1/8; a preview would cost the same
+        }
+        jpegScale = 8;
+    }
+    uint16_t decodedW = width / jpegScale;
+    uint16_t decodedH = height / jpegScale;
+    ESP_LOGI(LOG_TAG_COMMON, "JPEG: %dx%d, decode scale 1/%d", width, height, jpegScale);
     
-    // Set the output function
-    TJpgDec.setCallback(tft_output);
+    if (decodedW != placement.width || decodedH != placement.height || thumbPixels) {
+        jpegSourceBand = (uint16_t*)malloc(decodedW * TFT_BLIT_STRIP_ROWS * 2);
+        if (!jpegSourceBand || !beginScaling(decodedW, decodedH, IMAGE_SCALE_BILINEAR && !preview)) {
+            ESP_LOGE(LOG_TAG_COMMON, "No memory to resample %dx%d JPEG", decodedW, decodedH);
+            free(jpegSourceBand);
+            jpegSourceBand = nullptr;
+            arenaEnd();
+            return false;
+        }
+    }
     
-    // Open and decode JPEG
-    ESP_LOGI(LOG_TAG_COMMON, "Attempting JPEG decode...");
-    bool result = TJpgDec.drawFsJpg(x, y, path.c_str(), LittleFS);
-    ESP_LOGI(LOG_TAG_COMMON, "JPEG drawFsJpg returned: %s", result ? "true" : "false");
+    rc = JDR_MEM1;
+    if (outputBegin()) {
+        decoderHeapReport("during");
+        jpegBandRows = 0;
+        stripRows = 0;
+        
+        // Decode; unscaled images are offset to the placement here
+        ESP_LOGI(LOG_TAG_COMMON, "Attempting JPEG decode...");
+        arena->jpegX = scaling ? 0 : placement.x;
+        arena->jpegY = scaling ? 0 : placement.y;
+        uint8_t scaleShift = jpegScale == 8 ? 3 : jpegScale == 4 ? 2 : jpegScale == 2 ? 1 : 0;
+        rc = jd_decomp(&arena->jpeg.jdec, jpegOutput, scaleShift);
+        flushJpegBand();
+        flushStrip();
+        outputEnd();
+        ESP_LOGI(LOG_TAG_COMMON, "JPEG jd_decomp returned: %d", rc);
+    }
+    endScaling();
+    free(jpegSourceBand);
+    jpegSourceBand = nullptr;
+    arenaEnd();
     
-    if (result) {
+    if (rc == JDR_OK) {
         ESP_LOGI(LOG_TAG_COMMON, "JPEG decoded successfully");
         return true;
+    } else if (rc == JDR_INTR && displayRequestSuperseded()) {
+        ESP_LOGI(LOG_TAG_COMMON, "JPEG decode cancelled by newer request");
+        return false;
     } else {
-        // Try alternative approach - maybe the function succeeded but returned false
-        ESP_LOGW(LOG_TAG_COMMON, "JPEG drawFsJpg returned false, but image may still be displayed");
-        // Return true anyway since you said JPEG display works
-        return true;
+        ESP_LOGE(LOG_TAG_COMMON, "JPEG decode failed: %d", rc);
+        return false;
     }
 }
 
-void displayImageFromFile(const char* filename) {
+static bool decodeJPEG(const char* filename, bool centerImage, bool preview) {
+    ESP_LOGI(LOG_TAG_COMMON, "Drawing JPEG%s: %s", preview ? " preview" : "", filename);
+    
+    if (!arenaBegin()) {
+        return false;
+    }
+    if (!sourceOpen(filename)) {
+        ESP_LOGE(LOG_TAG_COMMON, "JPEG header unreadable: %s (%d)", filename, JDR_INP);
+        arenaEnd();
+        return false;
+    }
+    return decodeOpenedJPEG(filename, centerImage, preview);
+}
+
+// Draw JPEG image, fitted to the panel
+bool drawJPEG(const char* filename, bool centerImage) {
+    return decodeJPEG(filename, centerImage, false);
+}
+
+// Draw a coarse 1/8-scale JPEG preview into the full placement
+bool drawJPEGPreview(const char* filename, bool centerImage) {
+    return decodeJPEG(filename, centerImage, true);
+}
+
+void displayImageFromFile(const char* filename, bool progressive) {
     // Use the new scaling function by default
-    displayImageWithScaling(filename, true);
+    displayImageWithScaling(filename, true, progressive);
 }
 
-void displayImageWithScaling(const char* filename, bool centerImage) {
+static bool renderImage(const char* filename, bool centerImage, bool progressive) {
     ESP_LOGI(LOG_TAG_COMMON, "Displaying image with scaling: %s", filename);
     Serial.printf("[DISPLAY] Processing display request for: %s\n", filename);
+    drawGeneration = displayGeneration;
+    progressLast = 0;
+    tftDebugDetach();
     
     String path = "/images/";
     path += filename;
     
-    if (!LittleFS.exists(path)) {
+    // Top-level images are answered from the catalog; subdirectories (the
+    // benchmark corpus) are not indexed
+    bool found = strchr(filename, '/') ? LittleFS.exists(path) : imageCatalogContains(imageCatalog, filename);
+    if (!found) {
         ESP_LOGE(LOG_TAG_COMMON, "Image file not found: %s", path.c_str());
         Serial.printf("[DISPLAY] ERROR: File not found: %s\n", path.c_str());
         
@@ -179,35 +634,69 @@ void displayImageWithScaling(const char* filename, bool centerImage) {
         tft.print("File not found");
         tft.setCursor(10, 150);
         tft.print(filename);
-        return;
+        return false;
     }
 
     ESP_LOGI(LOG_TAG_COMMON, "Found image file: %s", path.c_str());
     Serial.printf("[DISPLAY] Image file found: %s\n", path.c_str());
 
-    // Clear display first
-    clearDisplay();
-    Serial.println("[DISPLAY] Display cleared");
-    
+    uint32_t startTime = millis();
+    int64_t startUs = esp_timer_get_time();
+    tftBlitResetStats();
+    metricsImageBegin();
+
+    // Fast path: stream the pre-decoded panel-native copy straight to the TFT
+    if (displayCacheValid(filename) && displayCacheDraw(filename)) {
+        ESP_LOGI(LOG_TAG_COMMON, "Image displayed from cache: %s", filename);
+        Serial.printf("[DISPLAY] Image displayed from cache: %s (%lu ms)\n", filename, millis() - startTime);
+        metricsImageEnd(true, (uint32_t)(esp_timer_get_time() - startUs), tftBlitStats()->push_us, tftBlitStats()->pixels);
+        return true;
+    }
+
+    // Whatever happens below, the panel no longer shows a known cached frame
+    displayCacheScreenChanged();
+
     String lowerFilename = String(filename);
     lowerFilename.toLowerCase();
+    bool isJpeg = lowerFilename.endsWith(".jpg") || lowerFilename.endsWith(".jpeg");
+
+    // Animations play until superseded (or their loops end); they keep their
+    // own statistics and are never captured to the cache
+    if (animationIsFile(filename)) {
+        Serial.println("[DISPLAY] Playing animation");
+        return animationPlay(filename);
+    }
+    
+    // Progressive mode: a 1/8-scale pass fills the frame first, so the screen
+    // never sits black while the full decode runs
+    if (progressive && isJpeg && drawJPEGPreview(filename, centerImage)) {
+        Serial.printf("[DISPLAY] Preview shown: %s (%lu ms)\n", filename, millis() - startTime);
+        progressLast = 0;
+    } else if (displayRequestSuperseded()) {
+        return false;
+    }
     
     bool success = false;
     
-    // Note: Web interface now pre-processes images to 240x320, so we can display at (0,0)
-    // The centering and scaling is handled by the web interface
+    // Images are fitted to 240x320 on the device; the web interface may still
+    // pre-resize, in which case the 1:1 path is taken
     if (lowerFilename.endsWith(".png")) {
         Serial.println("[DISPLAY] Processing PNG file");
-        success = drawPNG(filename, 0, 0);
+        displayCacheBeginCapture(filename);
+        success = drawPNG(filename, centerImage);
+        displayCacheEndCapture(success);
     } 
-    else if (lowerFilename.endsWith(".jpg") || lowerFilename.endsWith(".jpeg")) {
+    else if (isJpeg) {
         Serial.println("[DISPLAY] Processing JPEG file");
-        success = drawJPEG(filename, 0, 0);
+        displayCacheBeginCapture(filename);
+        success = drawJPEG(filename, centerImage);
+        displayCacheEndCapture(success);
     }
     else {
         ESP_LOGW(LOG_TAG_COMMON, "Unsupported file format: %s", filename);
         Serial.printf("[DISPLAY] WARNING: Unsupported file format for %s\n", filename);
         
+        clearDisplay();
         tft.setCursor(10, 100);
         tft.setTextColor(ILI9341_YELLOW);
         tft.setTextSize(2);
@@ -218,18 +707,28 @@ void displayImageWithScaling(const char* filename, bool centerImage) {
         tft.setCursor(10, 150);
         tft.print(filename);
         tft.setCursor(10, 180);
-        tft.print("Supported: PNG, JPG");
-        return;
+        tft.print("Supported: PNG, JPG, ANIM");
+        return false;
+    }
+    
+    if (!success && displayRequestSuperseded()) {
+        Serial.printf("[DISPLAY] Superseded by a newer request: %s\n", filename);
+        return false;
     }
     
     if (success) {
         ESP_LOGI(LOG_TAG_COMMON, "Image displayed successfully: %s", filename);
-        Serial.printf("[DISPLAY] Image displayed successfully: %s\n", filename);
+        Serial.printf("[DISPLAY] Image displayed successfully: %s (%lu ms)\n", filename, millis() - startTime);
+        const tft_blit_stats_t *stats = tftBlitStats();
+        Serial.printf("[DISPLAY] SPI: %u windows, %u transfers, %u pixels, %u us waiting\n",
+                      stats->windows, stats->transfers, stats->pixels, stats->wait_us);
+        metricsImageEnd(false, (uint32_t)(esp_timer_get_time() - startUs), stats->push_us, stats->pixels);
     } else {
         ESP_LOGE(LOG_TAG_COMMON, "Failed to display image: %s", filename);
         Serial.printf("[DISPLAY] ERROR: Failed to display image: %s\n", filename);
         
         // Show error message on screen
+        clearDisplay();
         tft.setCursor(10, 100);
         tft.setTextColor(ILI9341_RED);
         tft.setTextSize(2);
@@ -241,10 +740,120 @@ void displayImageWithScaling(const char* filename, bool centerImage) {
         tft.setCursor(10, 150);
         tft.print("Check file format");
     }
+    return success;
+}
+
+bool displayImageWithScaling(const char* filename, bool centerImage, bool progressive) {
+    displayLock();
+    bool shown = renderImage(filename, centerImage, progressive);
+    displayUnlock();
+    return shown;
+}
+
+bool displayDecodeUncached(const char* filename, bool centerImage) {
+    displayLock();
+    drawGeneration = displayGeneration;
+    progressLast = 0;
+    tftDebugDetach();
+    displayCacheScreenChanged();
+    String lowerFilename = String(filename);
+    lowerFilename.toLowerCase();
+    bool success = false;
+    if (lowerFilename.endsWith(".png")) {
+        success = drawPNG(filename, centerImage);
+    } else if (lowerFilename.endsWith(".jpg") || lowerFilename.endsWith(".jpeg")) {
+        success = drawJPEG(filename, centerImage);
+    }
+    displayUnlock();
+    return success;
+}
+
+bool displayAnimation(const char* filename, uint16_t speedPercent, uint16_t loops, anim_stats_t* out) {
+    displayLock();
+    drawGeneration = displayGeneration;
+    progressLast = 0;
+    tftDebugDetach();
+    displayCacheScreenChanged();
+    bool success = animationPlay(filename, speedPercent, loops, out);
+    displayUnlock();
+    return success;
+}
+
+bool displayDecodeJpegStream(display_reader_t reader, void* context, bool centerImage) {
+    displayLock();
+    drawGeneration = displayGeneration;
+    progressLast = 0;
+    tftDebugDetach();
+    displayCacheScreenChanged();
+    tftBlitResetStats();
+    metricsImageBegin();
+    int64_t startUs = esp_timer_get_time();
+    bool success = false;
+    if (arenaBegin()) {
+        arena->reader = reader;
+        arena->readerContext = context;
+        success = decodeOpenedJPEG("stream", centerImage, false);
+    }
+    if (success) {
+        const tft_blit_stats_t *stats = tftBlitStats();
+        metricsImageEnd(false, (uint32_t)(esp_timer_get_time() - startUs), stats->push_us, stats->pixels);
+    }
+    displayUnlock();
+    return success;
+}
+
+bool displayRenderThumbnail(const char* filename, uint16_t* pixels, uint16_t width, uint16_t height) {
+    displayLock();
+    memset(pixels, 0, (size_t)width * height * 2); // Black letterbox, as on the panel
+    thumbPixels = pixels;
+    thumbWidth = width;
+    thumbHeight = height;
+    String lowerFilename = String(filename);
+    lowerFilename.toLowerCase();
+    bool success = false;
+    if (lowerFilename.endsWith(".png")) {
+        success = drawPNG(filename, true);
+    } else if (lowerFilename.endsWith(".jpg") || lowerFilename.endsWith(".jpeg")) {
+        success = drawJPEG(filename, true);
+    }
+    thumbPixels = nullptr;
+    displayUnlock();
+    return success;
+}
+
+uint32_t displayLastBytesRead() {
+    return lastBytesRead;
+}
+
+void displayInit() {
+    displayMutex = xSemaphoreCreateRecursiveMutex();
+}
+
+void displayLock() {
+    xSemaphoreTakeRecursive(displayMutex, portMAX_DELAY);
+}
+
+bool displayTryLock(uint32_t timeoutMs) {
+    return xSemaphoreTakeRecursive(displayMutex, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+void displayUnlock() {
+    xSemaphoreGiveRecursive(displayMutex);
+}
+
+void displaySetProgressCallback(display_progress_t callback) {
+    progressCallback = callback;
+}
+
+void displaySetPreloaded(const char* filename, const uint8_t* data, size_t size) {
+    preloadedName = filename ? filename : "";
+    preloadedData = filename ? data : nullptr;
+    preloadedSize = filename ? size : 0;
 }
 
 void clearDisplay() {
     tft.fillScreen(ILI9341_BLACK);
+    displayCacheScreenChanged();
     ESP_LOGI(LOG_TAG_COMMON, "Display cleared");
     Serial.println("[DISPLAY] Screen cleared to black");
 }
@@ -0,0 +1,201 @@
+#include <Arduino.h>
+#include "esp_log.h"
+#include "common.h"
+#include "image_list.h"
+#include "image_catalog.h"
+#include <algorithm>
+
+typedef struct
+{
+	uint32_t key; // Size or mtime
+	uint16_t index; // Position in the catalog
+} image_list_key_t;
+
+typedef enum
+{
+	LIST_HEADER = 0,
+	LIST_ENTRIES,
+	LIST_FOOTER,
+	LIST_DONE,
+} list_stage_t;
+
+struct image_list {
+    image_list_query_t query;
+    image_catalog_t* catalog;
+    uint32_t generation; // Catalog generation when opened
+    bool stale;          // Catalog changed mid-listing; entries cut short
+    list_stage_t stage;
+
+    // Size and mtime orders only
+    image_list_key_t* keys;
+    uint32_t keyCount;
+
+    uint32_t next;     // Next position in listing order
+    uint32_t returned; // Entries written
+    uint32_t total;
+
+    // Current piece of output and how much of it has been handed out
+    char piece[IMAGE_LIST_PIECE_MAX];
+    size_t pieceLen;
+    size_t piecePos;
+};
+
+bool imageListParseSort(const char* text, image_sort_t* sort) {
+    if (!text || !*text) {
+        *sort = IMAGE_SORT_NONE;
+    } else if (!strcmp(text, "name")) {
+        *sort = IMAGE_SORT_NAME;
+    } else if (!strcmp(text, "size")) {
+        *sort = IMAGE_SORT_SIZE;
+    } else if (!strcmp(text, "mtime")) {
+        *sort = IMAGE_SORT_MTIME;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// One key per record; ties keep name order because the sort is stable
+static bool buildKeys(image_list_t* list, String* error) {
+    uint32_t count = list->total;
+    list->keys = (image_list_key_t*)malloc((count ? count : 1) * sizeof(image_list_key_t));
+    if (!list->keys) {
+        *error = "out of memory";
+        return false;
+    }
+    image_catalog_entry_t e;
+    for (uint32_t i = 0; i < count && imageCatalogAt(list->catalog, i, &e); i++) {
+        list->keys[i].key = list->query.sort == IMAGE_SORT_SIZE ? e.size : e.mtime;
+        list->keys[i].index = i;
+        list->keyCount++;
+    }
+    std::stable_sort(list->keys, list->keys + list->keyCount,
+                     [](const image_list_key_t& a, const image_list_key_t& b) { return a.key < b.key; });
+    list->total = list->keyCount;
+    return true;
+}
+
+image_list_t* imageListOpen(image_catalog_t* catalog, const image_list_query_t* query, String* error) {
+    image_list_t* list = new image_list_t();
+    list->query = *query;
+    list->catalog = catalog;
+    list->generation = catalog ? imageCatalogGeneration(catalog) : 0;
+    list->total = catalog ? imageCatalogCount(catalog) : 0;
+    if (list->total && (query->sort == IMAGE_SORT_SIZE || query->sort == IMAGE_SORT_MTIME) && !buildKeys(list, error)) {
+        ESP_LOGW(LOG_TAG_ETHERNET, "Image listing: %s", error->c_str());
+        imageListClose(list);
+        return nullptr;
+    }
+    list->next = query->offset;
+    return list;
+}
+
+// Name as a JSON string body; control characters are dropped
+static size_t escapeName(char* out, size_t outSize, const char* name) {
+    size_t n = 0;
+    for (; *name && n + 2 < outSize; name++) {
+        char c = *name;
+        if ((uint8_t)c < 0x20) {
+            continue;
+        }
+        if (c == '"' || c == '\\') {
+            out[n++] = '\\';
+        }
+        out[n++] = c;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+static void setEntryPiece(image_list_t* list, const image_catalog_entry_t* e) {
+    char escaped[2 * IMAGE_CATALOG_NAME_MAX];
+    escapeName(escaped, sizeof(escaped), e->name);
+    list->pieceLen = snprintf(list->piece, sizeof(list->piece),
+                              "%s{\"name\":\"%s\",\"size\":%u,\"mtime\":%u,\"format\":\"%s\",\"width\":%u,\"height\":%u,\"crc\":%u}",
+                              list->returned ? "," : "", escaped, e->size, e->mtime, imageFormatName(e->format),
+                              e->width, e->height, e->crc);
+    list->returned++;
+}
+
+static bool limitReached(const image_list_t* list) {
+    return list->query.limit && list->returned >= list->query.limit;
+}
+
+// Record at a position in listing order
+static bool entryAt(image_list_t* list, uint32_t position, image_catalog_entry_t* out) {
+    if (position >= list->total) {
+        return false;
+    }
+    bool descending = list->query.descending;
+    uint32_t i = descending ? list->total - 1 - position : position;
+    if (list->keys) {
+        i = list->keys[i].index;
+    }
+    return imageCatalogAt(list->catalog, i, out);
+}
+
+// Prepare the next piece; false when the document is complete
+static bool nextPiece(image_list_t* list) {
+    list->piecePos = 0;
+    list->pieceLen = 0;
+    switch (list->stage) {
+    case LIST_HEADER:
+        list->pieceLen = snprintf(list->piece, sizeof(list->piece), "{\"images\":[");
+        list->stage = LIST_ENTRIES;
+        return true;
+
+    case LIST_ENTRIES: {
+        // Positions (and sort keys) are only valid for the catalog as it
+        // was when the listing opened
+        if (list->catalog && imageCatalogGeneration(list->catalog) != list->generation) {
+            list->stale = true;
+            list->stage = LIST_FOOTER;
+            return nextPiece(list);
+        }
+        image_catalog_entry_t e;
+        if (!limitReached(list) && entryAt(list, list->next, &e)) {
+            list->next++;
+            setEntryPiece(list, &e);
+            return true;
+        }
+        list->stage = LIST_FOOTER;
+        return nextPiece(list);
+    }
+
+    case LIST_FOOTER:
+        list->pieceLen = snprintf(list->piece, sizeof(list->piece), "],\"offset\":%u,\"returned\":%u,\"total\":%u,\"stale\":%s}",
+                                  list->query.offset, list->returned, list->total, list->stale ? "true" : "false");
+        list->stage = LIST_DONE;
+        return true;
+
+    case LIST_DONE:
+        break;
+    }
+    return false;
+}
+
+size_t imageListFill(image_list_t* list, uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (list->piecePos == list->pieceLen && !nextPiece(list)) {
+            break;
+        }
+        size_t n = min(maxLen - written, list->pieceLen - list->piecePos);
+        memcpy(buffer + written, list->piece + list->piecePos, n);
+        list->piecePos += n;
+        written += n;
+    }
+    return written;
+}
+
+size_t imageListMemory(const image_list_t* list) {
+    return sizeof(image_list_t) + list->keyCount * sizeof(image_list_key_t);
+}
+
+void imageListClose(image_list_t* list) {
+    if (!list) {
+        return;
+    }
+    free(list->keys);
+    delete list;
+}
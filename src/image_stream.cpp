@@ -0,0 +1,274 @@
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "common.h"
+#include "image_stream.h"
+#include "image_display.h"
+#include "upload_session.h"
+
+// Only one stream exists at a time; id tells a late callback of an earlier
+// request apart from the current one
+typedef struct
+{
+	uint32_t id;
+	uint8_t refs; // The request and the decode task
+	StreamBufferHandle_t ring;
+	SemaphoreHandle_t done; // Given once the decoder let go of the panel
+	upload_session_t* save;
+	AsyncClient* client;
+	bool paused;
+	volatile bool ended;    // No more input will arrive
+	volatile bool overflow; // Data was dropped; the decode is cut short
+	bool complete;
+	bool waited;
+	bool shown;
+	uint32_t bytes;
+	uint32_t pauses;
+	uint32_t first_ms;
+	volatile uint32_t last_ms; // Last body byte
+	uint32_t decode_start_ms;
+	uint32_t decode_end_ms;
+} image_stream_t;
+
+static image_stream_t stream = {};
+static SemaphoreHandle_t streamLock = nullptr; // Stream lifetime, pause state, client
+static uint32_t nextId = 1;
+static uint32_t started = 0;
+static uint32_t shown = 0;
+static uint32_t failed = 0;
+static uint32_t busy = 0;
+static uint32_t pauses = 0;
+static uint32_t stalls = 0;
+static image_stream_result_t last = {};
+
+static bool current(uint32_t id) {
+    return id && stream.refs && stream.id == id;
+}
+
+// Decoder side of the ring. Returns 0 once the body is over and consumed,
+// when data was lost, or when the sender went quiet
+static size_t streamRead(void* context, uint8_t* buf, size_t len) {
+    uint32_t idleStart = millis();
+    for (;;) {
+        // Checked before the receive so a last chunk sent in between is not lost
+        bool ended = stream.ended;
+        size_t n = xStreamBufferReceive(stream.ring, buf, len, pdMS_TO_TICKS(20));
+        if (n) {
+            xSemaphoreTake(streamLock, portMAX_DELAY);
+            if (stream.paused && xStreamBufferSpacesAvailable(stream.ring) >= IMAGE_STREAM_PAUSE_FREE) {
+                stream.paused = false;
+                if (stream.client) {
+                    stream.client->ack((size_t)-1);
+                }
+            }
+            xSemaphoreGive(streamLock);
+            return n;
+        }
+        if (ended || stream.overflow) {
+            return 0;
+        }
+        if (millis() - idleStart > IMAGE_STREAM_IDLE_MS) {
+            ESP_LOGW(LOG_TAG_COMMON, "Stream %u: no data for %u ms", stream.id, IMAGE_STREAM_IDLE_MS);
+            return 0;
+        }
+    }
+}
+
+static void freeStream() {
+    if (stream.save) {
+        uploadEnd(stream.save); // Discards the file unless committed
+    }
+    vStreamBufferDelete(stream.ring);
+    vSemaphoreDelete(stream.done);
+    stream.ring = nullptr;
+    stream.done = nullptr;
+    stream.save = nullptr;
+}
+
+static void release() {
+    xSemaphoreTake(streamLock, portMAX_DELAY);
+    bool lastOwner = --stream.refs == 0;
+    xSemaphoreGive(streamLock);
+    if (lastOwner) {
+        freeStream();
+    }
+}
+
+static void streamTask(void* param) {
+    stream.decode_start_ms = millis();
+    bool ok = displayDecodeJpegStream(streamRead, nullptr, true);
+    stream.decode_end_ms = millis();
+    stream.shown = ok && !stream.overflow;
+
+    // tjpgd stops at the end of the scan; the rest of the body (and everything
+    // after a failure) is drained so the sender is never left paused
+    uint8_t drain[256];
+    while (streamRead(nullptr, drain, sizeof(drain))) {
+    }
+    if (stream.shown) {
+        shown++;
+    } else {
+        failed++;
+    }
+    xSemaphoreGive(stream.done);
+    release();
+    vTaskDelete(nullptr);
+}
+
+uint32_t imageStreamBegin(AsyncClient* client, const char* saveName, size_t expected) {
+    if (!streamLock) {
+        streamLock = xSemaphoreCreateMutex();
+    }
+    if (stream.refs) {
+        busy++;
+        return 0;
+    }
+    image_stream_t next = {};
+    next.ring = xStreamBufferCreate(IMAGE_STREAM_RING_SIZE, 1);
+    next.done = xSemaphoreCreateBinary();
+    if (!next.ring || !next.done) {
+        if (next.ring) vStreamBufferDelete(next.ring);
+        if (next.done) vSemaphoreDelete(next.done);
+        return 0;
+    }
+    next.id = nextId++;
+    next.refs = 2;
+    next.client = client;
+    next.first_ms = millis();
+    next.last_ms = next.first_ms;
+    if (saveName) {
+        next.save = uploadBegin("/images", saveName, expected);
+    }
+    stream = next;
+    started++;
+
+    // Stop a render in progress; the decoder takes the panel after it
+    displayRequestNew();
+    if (xTaskCreate(streamTask, "stream", IMAGE_STREAM_TASK_STACK, nullptr, TASK_PRIO_RENDER, nullptr) != pdPASS) {
+        ESP_LOGE(LOG_TAG_COMMON, "Stream %u: cannot start the decoder", stream.id);
+        stream.ended = true;
+        failed++;
+        xSemaphoreGive(stream.done);
+        stream.refs = 1;
+    }
+    ESP_LOGI(LOG_TAG_COMMON, "Stream %u started (%u bytes expected%s%s)", stream.id, expected,
+             saveName ? ", saving " : "", saveName ? saveName : "");
+    return stream.id;
+}
+
+void imageStreamWrite(uint32_t id, const uint8_t* data, size_t len) {
+    if (!current(id) || stream.ended || !len) {
+        return;
+    }
+    stream.bytes += len;
+    stream.last_ms = millis();
+    if (stream.save) {
+        uploadWrite(stream.save, data, len);
+    }
+    if (!stream.overflow) {
+        // Never waits: the paused window keeps the sender within the ring,
+        // so a chunk that does not fit means the sender ignored it
+        size_t sent = xStreamBufferSend(stream.ring, data, len, 0);
+        if (sent < len) {
+            stalls++;
+            ESP_LOGW(LOG_TAG_COMMON, "Stream %u: ring full, dropping input", stream.id);
+            stream.overflow = true;
+        }
+    }
+
+    // Same scheme as the upload pool: hold back the window while the ring is
+    // low, reopen it here or from streamRead() once the decoder caught up
+    xSemaphoreTake(streamLock, portMAX_DELAY);
+    if (stream.client) {
+        if (!stream.overflow && xStreamBufferSpacesAvailable(stream.ring) < IMAGE_STREAM_PAUSE_FREE) {
+            if (!stream.paused) {
+                stream.paused = true;
+                stream.pauses++;
+                pauses++;
+            }
+            stream.client->ackLater();
+        } else {
+            stream.client->ack((size_t)-1);
+        }
+    }
+    xSemaphoreGive(streamLock);
+}
+
+void imageStreamEnd(uint32_t id, bool complete) {
+    if (!current(id) || stream.ended) {
+        return;
+    }
+    xSemaphoreTake(streamLock, portMAX_DELAY);
+    stream.client = nullptr; // May be gone after this
+    stream.paused = false;
+    xSemaphoreGive(streamLock);
+    stream.complete = complete;
+    if (complete && stream.save) {
+        uploadCommit(stream.save);
+    }
+    stream.ended = true;
+    if (!complete) {
+        ESP_LOGW(LOG_TAG_COMMON, "Stream %u aborted after %u bytes", id, stream.bytes);
+    }
+}
+
+bool imageStreamResult(uint32_t id, image_stream_result_t* out) {
+    if (!current(id)) {
+        return false;
+    }
+    if (!stream.waited) {
+        if (xSemaphoreTake(stream.done, 0) != pdTRUE) {
+            return false;
+        }
+        stream.waited = true;
+    }
+    // The storage task may still be writing and renaming the file
+    if (stream.save && stream.complete && !uploadDone(stream.save)) {
+        return false;
+    }
+    upload_stats_t stats = {};
+    if (stream.save) {
+        uploadStats(stream.save, &stats);
+    }
+    out->shown = stream.shown;
+    out->saved = stream.save && stream.complete && uploadStatus(stream.save) == UPLOAD_OK;
+    out->bytes = stream.bytes;
+    out->crc = stats.crc;
+    out->transfer_ms = stream.last_ms - stream.first_ms;
+    out->decode_ms = stream.decode_end_ms - stream.decode_start_ms;
+    // Negative when the image ended before the body did (trailing bytes)
+    int32_t tail = (int32_t)(stream.decode_end_ms - stream.last_ms);
+    out->tail_ms = tail > 0 ? tail : 0;
+    out->total_ms = max(stream.decode_end_ms, (uint32_t)stream.last_ms) - stream.first_ms;
+    out->pauses = stream.pauses;
+    last = *out;
+    ESP_LOGI(LOG_TAG_COMMON, "Stream %u %s: %u bytes, transfer %u ms, decode %u ms, tail %u ms, %u pauses", id,
+             out->shown ? "shown" : "failed", out->bytes, out->transfer_ms, out->decode_ms, out->tail_ms, out->pauses);
+    return true;
+}
+
+void imageStreamRelease(uint32_t id) {
+    if (!current(id)) {
+        return;
+    }
+    imageStreamEnd(id, false);
+    release();
+}
+
+void imageStreamWriteMetrics(Print& out) {
+    out.printf("stream_started_total %u\n", started);
+    out.printf("stream_shown_total %u\n", shown);
+    out.printf("stream_failed_total %u\n", failed);
+    out.printf("stream_busy_total %u\n", busy);
+    out.printf("stream_pauses_total %u\n", pauses);
+    out.printf("stream_stalls_total %u\n", stalls);
+    out.printf("stream_last_bytes %u\n", last.bytes);
+    out.printf("stream_last_transfer_ms %u\n", last.transfer_ms);
+    out.printf("stream_last_decode_ms %u\n", last.decode_ms);
+    out.printf("stream_last_tail_ms %u\n", last.tail_ms);
+    out.printf("stream_last_total_ms %u\n", last.total_ms);
+}
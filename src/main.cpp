@@ -34,6 +34,12 @@
 #include "ethernet.h"
 #include "image_display.h"
 #include "splash_screen.h"
+#include "tft_blit.h"
+#include "playlist.h"
+#include "render_task.h"
+#include "bench.h"
+#include "boot.h"
+#include "animation.h"
 
 #include <Adafruit_GFX.h> // Core graphics library
 #include <SPI.h>
@@ -49,6 +55,9 @@
 #define LED 10
 #define MISO 20
 
+#define BOOT_SPLASH_STEP_MS 50         // Splash bar redraw interval while waiting
+#define BOOT_SPLASH_MS_PER_PERCENT 30  // Splash bar fill rate (90% after 2.7 s)
+
 
 // For the Adafruit shield, these are the default.
 // #define TFT_DC 9
@@ -66,8 +75,10 @@ void setup()
   // Initialize USB Serial first
   Serial.begin(115200);
   
+#if BOOT_SERIAL_WAIT_MS
   // Wait for USB connection to stabilize after reset
-  delay(1000);
+  delay(BOOT_SERIAL_WAIT_MS);
+#endif
   
   // Set logging levels for all modules
   esp_log_level_set("*", ESP_LOG_INFO);
@@ -84,10 +95,19 @@ void setup()
   Serial.printf("Author: %s\n", AUTHOR);
   Serial.printf("Date: %s\n", DATE);
   Serial.println("========================================");
+  bootMark("serial");
   
   ESP_LOGI(LOG_TAG_COMMON, "Starting system initialization...");
+
+  // Last image and settings from NVS; LittleFS, Wi-Fi and the web server
+  // come up on the boot task while the panel is initialized
+  boot_settings_t settings;
+  bootLoadSettings(&settings);
+  bootMark("nvs");
+  renderTaskInit();
+  bootStartServices();
   
-  // Initialize display hardware first
+  // Initialize display hardware
   ESP_LOGI(LOG_TAG_COMMON, "Initializing display hardware...");
   
   pinMode(LED, OUTPUT);
@@ -102,31 +122,102 @@ void setup()
   SPI.begin(SCK, MISO, MOSI, CS);
   ESP_LOGI(LOG_TAG_COMMON, "SPI initialized - SCK:%d, MISO:%d, MOSI:%d, CS:%d", SCK, MISO, MOSI, CS);
 
-  tft.begin();
+  tft.begin(TFT_SPI_FREQ);
   ESP_LOGI(LOG_TAG_COMMON, "ILI9341 TFT display initialized");
+
+  tftBlitInit();
   
   // Initialize display
   tft.setRotation(0); // Portrait mode for 240x320
   ESP_LOGI(LOG_TAG_COMMON, "Display cleared and set to portrait mode (240x320)");
-  
-  // Show splash screen
-  showSplashScreen();
-  ESP_LOGI(LOG_TAG_COMMON, "Splash screen displayed");
-
-  // Initialize network
-  ESP_LOGI(LOG_TAG_COMMON, "Starting network initialization...");
-  ethernet_init();
+  bootMark("panel");
+
+  // Redraw what was on screen before the reset; a still image usually
+  // comes from its panel-native cache, an animation plays on the render task
+  bool restored = false;
+  if (settings.image[0] && bootWaitStorage(BOOT_STORAGE_TIMEOUT_MS) &&
+      LittleFS.exists(String("/images/") + settings.image)) {
+    if (animationIsFile(settings.image)) {
+      restored = renderSubmit(settings.image, false) != 0;
+    } else {
+      displayLock();
+      restored = displayImageWithScaling(settings.image, true, settings.progressive);
+      displayUnlock();
+    }
+    ESP_LOGI(LOG_TAG_COMMON, "Last image %s: %s", settings.image, restored ? "restored" : "failed");
+  }
+  if (restored) {
+    bootMark("content");
+  } else {
+    showSplashScreen();
+    bootMark("splash");
+  }
+
+  // The splash bar fills while the network comes up
+  uint32_t waitStart = millis();
+  while (!bootWaitServices(BOOT_SPLASH_STEP_MS)) {
+    if (!restored) {
+      splashScreenProgress(min((uint32_t)(millis() - waitStart) / BOOT_SPLASH_MS_PER_PERCENT, (uint32_t)90));
+    }
+  }
+  if (!restored) {
+    splashScreenProgress(100);
+  }
+  if (settings.playlist) {
+    playlistStart();
+  }
 
   ESP_LOGI(LOG_TAG_COMMON, "=== System initialization complete ===");
   Serial.println("System ready! Connect to WiFi AP and access web interface.");
   
-  // Show QR codes after network is ready
-  showQRCodes();
-  ESP_LOGI(LOG_TAG_COMMON, "QR codes displayed");
+  // Connection info, unless the last image or the slideshow owns the screen
+  if (!restored && !playlistRunning()) {
+    showQRCodes();
+    ESP_LOGI(LOG_TAG_COMMON, "QR codes displayed");
+  }
+  bootMark("ready");
+  bootPrintTimeline(Serial);
+}
+
+// Serial console commands, one per line:
+//   bench [runs]         decoder/blit benchmark (JSON lines, see bench.h)
+//   bench list [files]   /images listing memory and time
+//   bench upload [bytes] /upload storage throughput, direct vs session
+//   bench anim [percent] animation playback, at 100% and percent speed
+static void handleSerialCommand(String line)
+{
+  line.trim();
+  if (line.startsWith("bench upload")) {
+    int bytes = line.length() > 12 ? line.substring(12).toInt() : BENCH_UPLOAD_DEFAULT_BYTES;
+    benchUpload(Serial, bytes > 0 ? bytes : BENCH_UPLOAD_DEFAULT_BYTES);
+  } else if (line.startsWith("bench anim")) {
+    int percent = line.length() > 10 ? line.substring(10).toInt() : BENCH_ANIM_FAST_PERCENT;
+    playlistStop();
+    benchAnimation(Serial, percent > 0 ? percent : BENCH_ANIM_FAST_PERCENT);
+  } else if (line.startsWith("bench list")) {
+    int files = line.length() > 10 ? line.substring(10).toInt() : BENCH_LIST_DEFAULT_FILES;
+    benchListing(Serial, files > 0 ? files : BENCH_LIST_DEFAULT_FILES);
+  } else if (line.startsWith("bench")) {
+    int runs = line.length() > 5 ? line.substring(5).toInt() : BENCH_DEFAULT_RUNS;
+    playlistStop();
+    benchRun(Serial, runs > 0 ? runs : BENCH_DEFAULT_RUNS);
+  } else if (line.length() > 0) {
+    Serial.printf("Unknown command: %s\n", line.c_str());
+  }
 }
 
 void loop(void)
 {
-  
+  static String line;
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\n' || c == '\r') {
+      handleSerialCommand(line);
+      line = "";
+    } else if (line.length() < 64) {
+      line += c;
+    }
+  }
+  delay(20);
 }
 
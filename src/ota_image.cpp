@@ -0,0 +1,446 @@
+#include <Arduino.h>
+#include <Update.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "rom/miniz.h"
+#include "mbedtls/sha256.h"
+#include "common.h"
+#include "ota_image.h"
+#include "image_catalog.h"
+
+#define GZIP_FLAG_HCRC 0x02
+#define GZIP_FLAG_EXTRA 0x04
+#define GZIP_FLAG_NAME 0x08
+#define GZIP_FLAG_COMMENT 0x10
+#define GZIP_TRAILER_SIZE 8 // CRC-32 and ISIZE of the inflated data
+
+typedef enum
+{
+	OTA_STAGE_DETECT = 0, // First two bytes decide gzip or plain
+	OTA_STAGE_PLAIN,
+	OTA_STAGE_GZIP_HEADER,
+	OTA_STAGE_GZIP_EXTRA,
+	OTA_STAGE_GZIP_NAME,
+	OTA_STAGE_GZIP_COMMENT,
+	OTA_STAGE_GZIP_HCRC,
+	OTA_STAGE_INFLATE,
+	OTA_STAGE_GZIP_TRAILER // Deflate ended; the trailer is checked at the end
+} ota_stage_t;
+
+struct ota_image
+{
+	ota_status_t status;
+	ota_stage_t stage;
+	bool finished;
+	bool hashing;
+	uint8_t expectedHash[OTA_SHA256_SIZE];
+	uint32_t expected;
+	mbedtls_sha256_context sha;
+	uint8_t head[10]; // Detect bytes, then the gzip header
+	uint8_t headFill;
+	uint8_t gzipFlags;
+	uint16_t skip;    // FEXTRA or FHCRC bytes still to pass over
+	tinfl_decompressor* inflator;
+	uint8_t* window;  // OTA_INFLATE_WINDOW bytes, also the inflate output
+	uint32_t windowPos;
+	uint32_t crc;     // Of the inflated data, for the gzip trailer
+	uint8_t tail[GZIP_TRAILER_SIZE]; // Last bytes received
+	uint32_t inflateEnd; // Bytes received when the inflater reported the end
+	uint32_t received;
+	uint32_t written;
+	uint32_t nextReport;
+	int64_t start_us;
+	int64_t end_us;
+};
+
+static ota_progress_callback_t progressCallback = nullptr;
+static uint32_t updates = 0;
+static uint32_t updatesFailed = 0;
+static ota_progress_t last = {};
+
+static void report(ota_image_t* ota) {
+    ota_progress_t progress;
+    otaImageProgress(ota, &progress);
+    if (ota->finished) {
+        last = progress;
+    }
+    if (progressCallback) {
+        progressCallback(&progress);
+    }
+}
+
+static ota_status_t fail(ota_image_t* ota, ota_status_t status) {
+    if (ota->status == OTA_OK) {
+        ota->status = status;
+        updatesFailed++;
+    }
+    return ota->status;
+}
+
+// Image bytes: hashed and written to the partition
+static bool emit(ota_image_t* ota, uint8_t* data, size_t len) {
+    if (ota->hashing) {
+        mbedtls_sha256_update(&ota->sha, data, len);
+    }
+    if (Update.write(data, len) != len) {
+        Update.printError(Serial);
+        fail(ota, OTA_WRITE_FAILED);
+        return false;
+    }
+    ota->written += len;
+    if (ota->written >= ota->nextReport) {
+        ota->nextReport = ota->written + OTA_PROGRESS_STEP;
+        report(ota);
+    }
+    return true;
+}
+
+static bool startInflate(ota_image_t* ota) {
+    ota->inflator = (tinfl_decompressor*)malloc(sizeof(tinfl_decompressor));
+    ota->window = (uint8_t*)malloc(OTA_INFLATE_WINDOW);
+    if (!ota->inflator || !ota->window) {
+        ESP_LOGE(LOG_TAG_COMMON, "OTA: no memory for the inflate window");
+        fail(ota, OTA_NO_MEMORY);
+        return false;
+    }
+    tinfl_init(ota->inflator);
+    ota->stage = OTA_STAGE_INFLATE;
+    return true;
+}
+
+// The last GZIP_TRAILER_SIZE bytes of everything received. The ROM tinfl
+// (miniz 1.15) reads up to 4 bytes ahead into its bit buffer and keeps them
+// when the deflate stream ends, so what it reports as unused input is not
+// the trailer; the end of the upload is.
+static void keepTail(ota_image_t* ota, const uint8_t* data, size_t len) {
+    if (len >= GZIP_TRAILER_SIZE) {
+        memcpy(ota->tail, data + len - GZIP_TRAILER_SIZE, GZIP_TRAILER_SIZE);
+        return;
+    }
+    memmove(ota->tail, ota->tail + len, GZIP_TRAILER_SIZE - len);
+    memcpy(ota->tail + GZIP_TRAILER_SIZE - len, data, len);
+}
+
+// Raw deflate data; returns the bytes consumed, look-ahead included
+static size_t inflateData(ota_image_t* ota, const uint8_t* data, size_t len) {
+    size_t used = 0;
+    for (;;) {
+        size_t in = len - used;
+        size_t out = OTA_INFLATE_WINDOW - ota->windowPos;
+        tinfl_status status = tinfl_decompress(ota->inflator, data + used, &in, ota->window,
+                                               ota->window + ota->windowPos, &out, TINFL_FLAG_HAS_MORE_INPUT);
+        used += in;
+        if (out) {
+            ota->crc = imageCatalogCrc32(ota->crc, ota->window + ota->windowPos, out);
+            if (!emit(ota, ota->window + ota->windowPos, out)) {
+                return len;
+            }
+            ota->windowPos = (ota->windowPos + out) & (OTA_INFLATE_WINDOW - 1);
+        }
+        if (status == TINFL_STATUS_DONE) {
+            ota->stage = OTA_STAGE_GZIP_TRAILER;
+            ota->inflateEnd = ota->received - (len - used);
+            return used;
+        }
+        if (status < TINFL_STATUS_DONE) {
+            ESP_LOGE(LOG_TAG_COMMON, "OTA: inflate failed (%d) at %u bytes", (int)status, ota->received);
+            fail(ota, OTA_BAD_DATA);
+            return len;
+        }
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT) {
+            return used;
+        }
+    }
+}
+
+// The small gzip framing, a byte at a time
+static void gzipByte(ota_image_t* ota, uint8_t b) {
+    switch (ota->stage) {
+    case OTA_STAGE_GZIP_HEADER:
+        ota->head[ota->headFill++] = b;
+        if (ota->headFill < 10) {
+            return;
+        }
+        if (ota->head[2] != 8) { // Deflate is the only method
+            fail(ota, OTA_BAD_DATA);
+            return;
+        }
+        ota->gzipFlags = ota->head[3];
+        ota->headFill = 0;
+        ota->skip = 0;
+        ota->stage = OTA_STAGE_GZIP_EXTRA;
+        if (!(ota->gzipFlags & GZIP_FLAG_EXTRA)) {
+            break; // Fall through the optional fields below
+        }
+        return;
+    case OTA_STAGE_GZIP_EXTRA:
+        if (ota->headFill < 2) {
+            ota->head[ota->headFill++] = b;
+            ota->skip = ota->head[0] | (ota->head[1] << 8);
+            if (ota->headFill < 2 || ota->skip) {
+                return;
+            }
+        } else if (--ota->skip) {
+            return;
+        }
+        break;
+    case OTA_STAGE_GZIP_NAME:
+    case OTA_STAGE_GZIP_COMMENT:
+        if (b) {
+            return;
+        }
+        break;
+    case OTA_STAGE_GZIP_HCRC:
+        if (--ota->skip) {
+            return;
+        }
+        startInflate(ota);
+        return;
+    default:
+        return;
+    }
+
+    // The current field is complete: move to the next one present
+    if (ota->stage == OTA_STAGE_GZIP_EXTRA) {
+        ota->stage = OTA_STAGE_GZIP_NAME;
+        if (ota->gzipFlags & GZIP_FLAG_NAME) {
+            return;
+        }
+    }
+    if (ota->stage == OTA_STAGE_GZIP_NAME) {
+        ota->stage = OTA_STAGE_GZIP_COMMENT;
+        if (ota->gzipFlags & GZIP_FLAG_COMMENT) {
+            return;
+        }
+    }
+    if (ota->gzipFlags & GZIP_FLAG_HCRC && ota->stage != OTA_STAGE_GZIP_HCRC) {
+        ota->stage = OTA_STAGE_GZIP_HCRC;
+        ota->skip = 2;
+        return;
+    }
+    startInflate(ota);
+}
+
+void otaSetProgressCallback(ota_progress_callback_t callback) {
+    progressCallback = callback;
+}
+
+bool otaParseSha256(const char* hex, uint8_t* out) {
+    if (!hex || strlen(hex) != OTA_SHA256_SIZE * 2) {
+        return false;
+    }
+    for (int i = 0; i < OTA_SHA256_SIZE * 2; i++) {
+        char c = hex[i];
+        uint8_t v;
+        if (c >= '0' && c <= '9') {
+            v = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            v = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            v = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        out[i / 2] = (i & 1) ? (out[i / 2] | v) : (v << 4);
+    }
+    return true;
+}
+
+ota_image_t* otaImageBegin(int command, const uint8_t* sha256, uint32_t size) {
+    ota_image_t* ota = (ota_image_t*)calloc(1, sizeof(ota_image_t));
+    if (!ota) {
+        return nullptr;
+    }
+    updates++;
+    ota->start_us = esp_timer_get_time();
+    ota->expected = size;
+    ota->nextReport = OTA_PROGRESS_STEP;
+    if (sha256) {
+        memcpy(ota->expectedHash, sha256, OTA_SHA256_SIZE);
+        mbedtls_sha256_init(&ota->sha);
+        mbedtls_sha256_starts(&ota->sha, 0);
+        ota->hashing = true;
+    }
+    // With the size known, an image too big for the partition fails here
+    if (!Update.begin(size ? size : UPDATE_SIZE_UNKNOWN, command)) {
+        Update.printError(Serial);
+        fail(ota, OTA_BEGIN_FAILED);
+    }
+    ESP_LOGI(LOG_TAG_COMMON, "OTA: %s update started (%s, size %u)", command == U_FLASH ? "firmware" : "filesystem",
+             sha256 ? "verified" : "unverified", size);
+    return ota;
+}
+
+ota_status_t otaImageWrite(ota_image_t* ota, const uint8_t* data, size_t len) {
+    if (ota->status != OTA_OK) {
+        return ota->status;
+    }
+    ota->received += len;
+    keepTail(ota, data, len);
+    while (len && ota->status == OTA_OK) {
+        switch (ota->stage) {
+        case OTA_STAGE_DETECT:
+            // Held until two bytes are in; a .bin never starts with 1f 8b
+            ota->head[ota->headFill++] = *data++;
+            len--;
+            if (ota->headFill == 2) {
+                if (ota->head[0] == 0x1F && ota->head[1] == 0x8B) {
+                    ota->stage = OTA_STAGE_GZIP_HEADER;
+                } else {
+                    ota->stage = OTA_STAGE_PLAIN;
+                    emit(ota, ota->head, 2);
+                }
+            }
+            break;
+        case OTA_STAGE_PLAIN:
+            // Update.write() takes a mutable buffer but only copies from it
+            emit(ota, (uint8_t*)data, len);
+            len = 0;
+            break;
+        case OTA_STAGE_INFLATE: {
+            size_t used = inflateData(ota, data, len);
+            data += used;
+            len -= used;
+            break;
+        }
+        case OTA_STAGE_GZIP_TRAILER:
+            // Only the trailer may follow (less what the inflater took)
+            if (ota->received - ota->inflateEnd > GZIP_TRAILER_SIZE) {
+                ESP_LOGE(LOG_TAG_COMMON, "OTA: data after the gzip member");
+                fail(ota, OTA_BAD_DATA);
+            }
+            len = 0;
+            break;
+        default:
+            gzipByte(ota, *data++);
+            len--;
+            break;
+        }
+    }
+    return ota->status;
+}
+
+ota_status_t otaImageFinish(ota_image_t* ota) {
+    if (ota->status == OTA_OK) {
+        if (ota->stage == OTA_STAGE_DETECT && ota->headFill) {
+            emit(ota, ota->head, ota->headFill); // A one-byte image
+        } else if (ota->stage == OTA_STAGE_GZIP_TRAILER) {
+            uint32_t crc = ota->tail[0] | (ota->tail[1] << 8) | (ota->tail[2] << 16) | ((uint32_t)ota->tail[3] << 24);
+            uint32_t size = ota->tail[4] | (ota->tail[5] << 8) | (ota->tail[6] << 16) | ((uint32_t)ota->tail[7] << 24);
+            if (crc != ota->crc || size != ota->written) {
+                ESP_LOGE(LOG_TAG_COMMON, "OTA: gzip trailer mismatch (crc %08x/%08x, size %u/%u)", crc, ota->crc,
+                         size, ota->written);
+                fail(ota, OTA_BAD_DATA);
+            }
+        } else if (ota->stage > OTA_STAGE_PLAIN) {
+            ESP_LOGE(LOG_TAG_COMMON, "OTA: gzip data ended early");
+            fail(ota, OTA_BAD_DATA);
+        }
+    }
+    if (ota->status == OTA_OK && ota->expected && ota->written != ota->expected) {
+        ESP_LOGE(LOG_TAG_COMMON, "OTA: %u bytes, the manifest says %u", ota->written, ota->expected);
+        fail(ota, OTA_SIZE_MISMATCH);
+    }
+    if (ota->status == OTA_OK && ota->hashing) {
+        uint8_t hash[OTA_SHA256_SIZE];
+        mbedtls_sha256_finish(&ota->sha, hash);
+        if (memcmp(hash, ota->expectedHash, OTA_SHA256_SIZE) != 0) {
+            ESP_LOGE(LOG_TAG_COMMON, "OTA: SHA-256 does not match the manifest");
+            fail(ota, OTA_HASH_MISMATCH);
+        }
+    }
+    // Only now is the partition made bootable
+    if (ota->status == OTA_OK && !Update.end(true)) {
+        Update.printError(Serial);
+        fail(ota, OTA_END_FAILED);
+    }
+    if (ota->status != OTA_OK && Update.isRunning()) {
+        Update.abort();
+    }
+    ota->end_us = esp_timer_get_time();
+    ota->finished = true;
+    report(ota);
+    ota_progress_t progress;
+    otaImageProgress(ota, &progress);
+    Serial.printf("[OTA] %s: %u -> %u bytes in %u ms, %u KB/s received, %u KB/s written%s\n",
+                  otaStatusText(ota->status), ota->received, ota->written, progress.elapsed_ms, progress.in_kbps,
+                  progress.out_kbps, progress.verified ? ", SHA-256 verified" : "");
+    return ota->status;
+}
+
+void otaImageFree(ota_image_t* ota) {
+    if (!ota) {
+        return;
+    }
+    if (!ota->finished) {
+        if (Update.isRunning()) {
+            Update.abort();
+        }
+        if (ota->status == OTA_OK) {
+            updatesFailed++; // Connection dropped
+        }
+    }
+    if (ota->hashing) {
+        mbedtls_sha256_free(&ota->sha);
+    }
+    free(ota->inflator);
+    free(ota->window);
+    free(ota);
+}
+
+ota_status_t otaImageStatus(const ota_image_t* ota) {
+    return ota ? ota->status : OTA_NO_MEMORY;
+}
+
+void otaImageProgress(const ota_image_t* ota, ota_progress_t* out) {
+    int64_t end = ota->finished ? ota->end_us : esp_timer_get_time();
+    out->status = ota->status;
+    out->compressed = ota->stage >= OTA_STAGE_GZIP_HEADER;
+    out->verified = ota->finished && ota->status == OTA_OK && ota->hashing;
+    out->finished = ota->finished;
+    out->received = ota->received;
+    out->written = ota->written;
+    out->expected = ota->expected;
+    out->percent = ota->expected ? (uint8_t)min((uint64_t)100, (uint64_t)ota->written * 100 / ota->expected) : 0;
+    out->elapsed_ms = (uint32_t)((end - ota->start_us) / 1000);
+    out->in_kbps = out->elapsed_ms ? (uint32_t)((uint64_t)ota->received * 1000 / 1024 / out->elapsed_ms) : 0;
+    out->out_kbps = out->elapsed_ms ? (uint32_t)((uint64_t)ota->written * 1000 / 1024 / out->elapsed_ms) : 0;
+}
+
+const char* otaStatusText(ota_status_t status) {
+    switch (status) {
+    case OTA_OK:
+        return "ok";
+    case OTA_NO_MEMORY:
+        return "out of memory";
+    case OTA_BEGIN_FAILED:
+        return "no room for the image";
+    case OTA_BAD_DATA:
+        return "corrupt compressed image";
+    case OTA_WRITE_FAILED:
+        return "flash write failed";
+    case OTA_SIZE_MISMATCH:
+        return "size does not match the manifest";
+    case OTA_HASH_MISMATCH:
+        return "SHA-256 does not match the manifest";
+    case OTA_END_FAILED:
+        return "image rejected";
+    }
+    return "unknown";
+}
+
+void otaLastProgress(ota_progress_t* out) {
+    *out = last;
+}
+
+void otaWriteMetrics(Print& out) {
+    out.printf("ota_updates_total %u\n", updates);
+    out.printf("ota_failed_total %u\n", updatesFailed);
+    out.printf("ota_last_compressed %u\n", last.compressed ? 1 : 0);
+    out.printf("ota_last_verified %u\n", last.verified ? 1 : 0);
+    out.printf("ota_last_received_bytes %u\n", last.received);
+    out.printf("ota_last_written_bytes %u\n", last.written);
+    out.printf("ota_last_ms %u\n", last.elapsed_ms);
+    out.printf("ota_last_in_kbps %u\n", last.in_kbps);
+    out.printf("ota_last_out_kbps %u\n", last.out_kbps);
+}
@@ -0,0 +1,441 @@
+#include <Arduino.h>
+#include "LittleFS.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "common.h"
+#include "playlist.h"
+#include "image_display.h"
+#include "display_cache.h"
+#include "tft_blit.h"
+#include "image_catalog.h"
+#include "animation.h"
+#include "boot.h"
+
+static playlist_item_t items[PLAYLIST_MAX_ITEMS];
+static uint8_t itemCount = 0;
+static SemaphoreHandle_t itemsMutex = nullptr;
+static TaskHandle_t playlistTaskHandle = nullptr;
+
+static volatile bool running = false;
+static uint8_t currentIndex = 0;
+static uint32_t runStart = 0;
+
+// Next item, loaded while the current one is on screen
+static char prefetchName[sizeof(((playlist_item_t*)0)->name)] = "";
+static uint8_t* prefetchData = nullptr;
+static size_t prefetchSize = 0;
+static bool prefetchCached = false;
+
+static playlist_stats_t stats;
+static playlist_timing_t history[PLAYLIST_TIMING_HISTORY];
+static uint8_t historyNext = 0;
+
+static const char* transitionName(playlist_transition_t transition) {
+    return transition == PLAYLIST_TRANSITION_SCROLL ? "scroll" : "cut";
+}
+
+// Width/height from a PNG IHDR or the first JPEG SOF marker
+static bool parseImageHeader(const uint8_t* d, size_t n, uint16_t* w, uint16_t* h) {
+    if (n >= 24 && d[0] == 0x89 && d[1] == 'P' && d[2] == 'N' && d[3] == 'G') {
+        *w = (uint16_t)((d[18] << 8) | d[19]);
+        *h = (uint16_t)((d[22] << 8) | d[23]);
+        return true;
+    }
+    if (n < 4 || d[0] != 0xFF || d[1] != 0xD8) {
+        return false;
+    }
+    size_t i = 2;
+    while (i + 4 <= n) {
+        if (d[i] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = d[i + 1];
+        if (marker == 0xFF) {
+            i++;
+            continue;
+        }
+        uint16_t len = (uint16_t)((d[i + 2] << 8) | d[i + 3]);
+        bool sof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (sof && i + 9 <= n) {
+            *h = (uint16_t)((d[i + 5] << 8) | d[i + 6]);
+            *w = (uint16_t)((d[i + 7] << 8) | d[i + 8]);
+            return true;
+        }
+        i += 2 + len;
+    }
+    return false;
+}
+
+static void prefetchDrop() {
+    free(prefetchData);
+    prefetchData = nullptr;
+    prefetchSize = 0;
+    prefetchCached = false;
+    prefetchName[0] = '\0';
+}
+
+// Make the next item cheap to show: either its panel-native sidecar is valid,
+// or the whole file is read into RAM and its header checked
+static void prefetchItem(const playlist_item_t* item) {
+    prefetchDrop();
+    strlcpy(prefetchName, item->name, sizeof(prefetchName));
+
+    if (displayCacheValid(item->name)) {
+        prefetchCached = true;
+        ESP_LOGI(LOG_TAG_COMMON, "Playlist prefetch: %s has a display cache", item->name);
+        return;
+    }
+    if (animationIsFile(item->name)) {
+        return; // Played frame by frame from flash
+    }
+
+    String path = "/images/";
+    path += item->name;
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        ESP_LOGW(LOG_TAG_COMMON, "Playlist prefetch: %s not found", item->name);
+        return;
+    }
+    size_t size = file.size();
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    if (size > PLAYLIST_PREFETCH_MAX || size + PLAYLIST_HEAP_RESERVE > largest) {
+        ESP_LOGI(LOG_TAG_COMMON, "Playlist prefetch: %s (%u bytes) left on flash", item->name, size);
+        file.close();
+        return;
+    }
+
+    uint32_t start = millis();
+    prefetchData = (uint8_t*)malloc(size);
+    if (prefetchData && file.read(prefetchData, size) == size) {
+        prefetchSize = size;
+    } else {
+        free(prefetchData);
+        prefetchData = nullptr;
+    }
+    file.close();
+
+    uint16_t w = 0, h = 0;
+    if (prefetchData && !parseImageHeader(prefetchData, prefetchSize, &w, &h)) {
+        ESP_LOGW(LOG_TAG_COMMON, "Playlist prefetch: %s is not a PNG/JPEG", item->name);
+        prefetchDrop();
+        return;
+    }
+    if (prefetchData) {
+        ESP_LOGI(LOG_TAG_COMMON, "Playlist prefetch: %s %ux%u, %u bytes in %lu ms",
+                 item->name, w, h, prefetchSize, millis() - start);
+    }
+}
+
+static void recordTiming(uint8_t index, bool prefetched, uint32_t scheduled, uint32_t shown, uint32_t drawMs) {
+    playlist_timing_t* t = &history[historyNext];
+    historyNext = (historyNext + 1) % PLAYLIST_TIMING_HISTORY;
+    t->index = index;
+    t->prefetched = prefetched;
+    t->scheduled_ms = scheduled - runStart;
+    t->shown_ms = shown - runStart;
+    t->draw_ms = drawMs;
+
+    int32_t late = (int32_t)(shown - scheduled);
+    stats.shown++;
+    stats.prefetched += prefetched;
+    stats.late_total_ms += late;
+    stats.draw_total_ms += drawMs;
+    if (stats.shown == 1 || late > stats.late_max_ms) {
+        stats.late_max_ms = late;
+    }
+    if (drawMs > stats.draw_max_ms) {
+        stats.draw_max_ms = drawMs;
+    }
+}
+
+static bool showItem(const playlist_item_t* item) {
+    bool fromRam = prefetchData && strcmp(prefetchName, item->name) == 0;
+
+    displayLock();
+    if (fromRam) {
+        displaySetPreloaded(item->name, prefetchData, prefetchSize);
+    }
+    if (item->transition == PLAYLIST_TRANSITION_SCROLL && !animationIsFile(item->name)) {
+        // Every row has to be redrawn for the slide, not just changed tiles
+        displayCacheScreenChanged();
+        tftBlitSetScrollIn(true);
+    }
+    animationSetMaxDuration(item->dwell_ms); // An animation plays for its dwell
+    bool shown = displayImageWithScaling(item->name, true, false);
+    animationSetMaxDuration(0);
+    tftBlitSetScrollIn(false);
+    displaySetPreloaded(nullptr, nullptr, 0);
+    displayUnlock();
+    return shown;
+}
+
+static void playlistTask(void* param) {
+    uint32_t nextDue = 0;
+
+    for (;;) {
+        if (!running) {
+            prefetchDrop();
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            nextDue = millis();
+            continue;
+        }
+
+        // Sleep until the item is due; a notification means start/stop/reload
+        int32_t wait = (int32_t)(nextDue - millis());
+        if (wait > 0 && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait))) {
+            continue;
+        }
+
+        playlist_item_t item;
+        uint8_t index;
+        xSemaphoreTake(itemsMutex, portMAX_DELAY);
+        if (itemCount == 0) {
+            running = false;
+            xSemaphoreGive(itemsMutex);
+            continue;
+        }
+        index = currentIndex % itemCount;
+        item = items[index];
+        xSemaphoreGive(itemsMutex);
+
+        uint32_t scheduled = nextDue;
+        uint32_t start = millis();
+        bool prefetched = strcmp(prefetchName, item.name) == 0 && (prefetchData || prefetchCached);
+        bool shown = showItem(&item);
+        uint32_t done = millis();
+        prefetchDrop();
+
+        if (!running) {
+            continue; // Stopped (e.g. by a manual display) while drawing
+        }
+        if (shown) {
+            recordTiming(index, prefetched, scheduled, done, done - start);
+            Serial.printf("[PLAYLIST] #%u %s: %s, draw %lu ms, %ld ms late%s\n", index, item.name,
+                          transitionName(item.transition), done - start, (long)(done - scheduled),
+                          prefetched ? ", prefetched" : "");
+        } else {
+            stats.failed++;
+            Serial.printf("[PLAYLIST] #%u %s: display failed\n", index, item.name);
+        }
+
+        // Keep the schedule drift-free; only resync after falling a whole dwell behind
+        nextDue = scheduled + item.dwell_ms;
+        if ((int32_t)(nextDue - done) < 0) {
+            nextDue = done;
+        }
+
+        xSemaphoreTake(itemsMutex, portMAX_DELAY);
+        currentIndex = itemCount ? (index + 1) % itemCount : 0;
+        playlist_item_t next = items[currentIndex];
+        bool haveNext = itemCount > 0;
+        xSemaphoreGive(itemsMutex);
+        if (haveNext) {
+            prefetchItem(&next);
+        }
+    }
+}
+
+// Parse playlist text into out; error names the first bad line
+static bool parsePlaylist(const char* text, size_t len, playlist_item_t* out, uint8_t* count, String* error) {
+    *count = 0;
+    size_t pos = 0;
+    int lineNo = 0;
+    while (pos < len) {
+        size_t end = pos;
+        while (end < len && text[end] != '\n') end++;
+        lineNo++;
+
+        char line[128];
+        size_t n = end - pos;
+        if (n > sizeof(line) - 1) {
+            *error = "line " + String(lineNo) + ": longer than " + String(sizeof(line) - 1) + " characters";
+            return false;
+        }
+        memcpy(line, text + pos, n);
+        line[n] = '\0';
+        pos = end + 1;
+
+        char* save = nullptr;
+        char* name = strtok_r(line, " \t\r", &save);
+        if (!name || name[0] == '#') {
+            continue;
+        }
+        char* dwell = strtok_r(nullptr, " \t\r", &save);
+        char* transition = strtok_r(nullptr, " \t\r", &save);
+
+        if (*count >= PLAYLIST_MAX_ITEMS) {
+            *error = "line " + String(lineNo) + ": more than " + String(PLAYLIST_MAX_ITEMS) + " items";
+            return false;
+        }
+        playlist_item_t* item = &out[*count];
+        if (strlen(name) >= sizeof(item->name) || !imageCatalogContains(imageCatalog, name)) {
+            *error = "line " + String(lineNo) + ": no such image " + name;
+            return false;
+        }
+        strlcpy(item->name, name, sizeof(item->name));
+        item->dwell_ms = dwell ? strtoul(dwell, nullptr, 10) : PLAYLIST_DEFAULT_DWELL_MS;
+        if (item->dwell_ms < PLAYLIST_MIN_DWELL_MS) {
+            item->dwell_ms = PLAYLIST_MIN_DWELL_MS;
+        }
+        if (!transition || strcmp(transition, "cut") == 0) {
+            item->transition = PLAYLIST_TRANSITION_CUT;
+        } else if (strcmp(transition, "scroll") == 0) {
+            item->transition = PLAYLIST_TRANSITION_SCROLL;
+        } else {
+            *error = "line " + String(lineNo) + ": unknown transition " + transition;
+            return false;
+        }
+        (*count)++;
+    }
+    return true;
+}
+
+static void applyItems(const playlist_item_t* parsed, uint8_t count) {
+    xSemaphoreTake(itemsMutex, portMAX_DELAY);
+    memcpy(items, parsed, count * sizeof(playlist_item_t));
+    itemCount = count;
+    currentIndex = 0;
+    xSemaphoreGive(itemsMutex);
+}
+
+void playlistInit() {
+    itemsMutex = xSemaphoreCreateMutex();
+    playlistLoad();
+    xTaskCreate(playlistTask, "playlist", PLAYLIST_TASK_STACK, nullptr, TASK_PRIO_PLAYLIST, &playlistTaskHandle);
+    ESP_LOGI(LOG_TAG_COMMON, "Playlist task started (%d items)", itemCount);
+}
+
+bool playlistLoad() {
+    File file = LittleFS.open(PLAYLIST_PATH, "r");
+    if (!file) {
+        return false;
+    }
+    size_t len = min((size_t)file.size(), (size_t)PLAYLIST_MAX_TEXT);
+    char* text = (char*)malloc(len + 1);
+    bool ok = false;
+    if (text && file.read((uint8_t*)text, len) == len) {
+        playlist_item_t* parsed = (playlist_item_t*)malloc(sizeof(items));
+        uint8_t count = 0;
+        String error;
+        if (parsed && parsePlaylist(text, len, parsed, &count, &error)) {
+            applyItems(parsed, count);
+            ok = true;
+        } else {
+            ESP_LOGE(LOG_TAG_COMMON, "Playlist file rejected: %s", error.c_str());
+        }
+        free(parsed);
+    }
+    free(text);
+    file.close();
+    return ok;
+}
+
+bool playlistSave(const char* text, size_t len, String* error) {
+    playlist_item_t* parsed = (playlist_item_t*)malloc(sizeof(items));
+    uint8_t count = 0;
+    if (!parsed) {
+        *error = "out of memory";
+        return false;
+    }
+    if (!parsePlaylist(text, len, parsed, &count, error)) {
+        free(parsed);
+        return false;
+    }
+
+    // Write beside the old list and swap, so a power cut keeps one of them
+    File file = LittleFS.open(PLAYLIST_PATH ".tmp", "w");
+    bool written = file && file.write((const uint8_t*)text, len) == len;
+    if (file) {
+        file.close();
+    }
+    if (!written || !LittleFS.rename(PLAYLIST_PATH ".tmp", PLAYLIST_PATH)) {
+        LittleFS.remove(PLAYLIST_PATH ".tmp");
+        free(parsed);
+        *error = "write failed";
+        return false;
+    }
+
+    applyItems(parsed, count);
+    free(parsed);
+    ESP_LOGI(LOG_TAG_COMMON, "Playlist saved: %d items", count);
+    if (playlistTaskHandle) {
+        xTaskNotifyGive(playlistTaskHandle);
+    }
+    return true;
+}
+
+void playlistStart() {
+    memset(&stats, 0, sizeof(stats));
+    memset(history, 0, sizeof(history));
+    historyNext = 0;
+    xSemaphoreTake(itemsMutex, portMAX_DELAY);
+    currentIndex = 0;
+    xSemaphoreGive(itemsMutex);
+    runStart = millis();
+    running = true;
+    xTaskNotifyGive(playlistTaskHandle);
+    bootRememberPlaylist(true);
+    Serial.printf("[PLAYLIST] Started with %d items\n", itemCount);
+}
+
+void playlistStop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    displayRequestNew(); // Cut short an item that is still being decoded
+    xTaskNotifyGive(playlistTaskHandle);
+    bootRememberPlaylist(false);
+    Serial.println("[PLAYLIST] Stopped");
+}
+
+bool playlistRunning() {
+    return running;
+}
+
+String playlistItemsJson() {
+    String json = "{\"running\":";
+    json += running ? "true" : "false";
+    json += ",\"items\":[";
+    xSemaphoreTake(itemsMutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < itemCount; i++) {
+        if (i) json += ",";
+        json += "{\"name\":\"" + String(items[i].name) + "\",\"dwell\":" + String(items[i].dwell_ms) +
+                ",\"transition\":\"" + transitionName(items[i].transition) + "\"}";
+    }
+    xSemaphoreGive(itemsMutex);
+    json += "]}";
+    return json;
+}
+
+String playlistStatusJson() {
+    String json = "{\"running\":";
+    json += running ? "true" : "false";
+    json += ",\"index\":" + String(currentIndex);
+    json += ",\"shown\":" + String(stats.shown);
+    json += ",\"prefetched\":" + String(stats.prefetched);
+    json += ",\"failed\":" + String(stats.failed);
+    if (stats.shown) {
+        json += ",\"late_avg_ms\":" + String((long)(stats.late_total_ms / stats.shown));
+        json += ",\"late_max_ms\":" + String((long)stats.late_max_ms);
+        json += ",\"draw_avg_ms\":" + String((unsigned long)(stats.draw_total_ms / stats.shown));
+        json += ",\"draw_max_ms\":" + String(stats.draw_max_ms);
+    }
+    // Most recent items, oldest first; times are ms since the playlist started
+    json += ",\"recent\":[";
+    bool first = true;
+    for (uint8_t i = 0; i < PLAYLIST_TIMING_HISTORY; i++) {
+        const playlist_timing_t* t = &history[(historyNext + i) % PLAYLIST_TIMING_HISTORY];
+        if (!t->shown_ms) continue;
+        if (!first) json += ",";
+        first = false;
+        json += "{\"index\":" + String(t->index) + ",\"scheduled\":" + String(t->scheduled_ms) +
+                ",\"shown\":" + String(t->shown_ms) + ",\"draw\":" + String(t->draw_ms) +
+                ",\"prefetched\":" + (t->prefetched ? "true" : "false") + "}";
+    }
+    json += "]}";
+    return json;
+}
@@ -0,0 +1,440 @@
+#include <Arduino.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "common.h"
+#include "rect_update.h"
+#include "image_display.h"
+#include "display_cache.h"
+#include "tft_blit.h"
+#include "tft_debug.h"
+
+typedef enum
+{
+	RLE_CONTROL = 0, // Next byte is a control byte
+	RLE_RUN,         // Next pixel is repeated count times
+	RLE_LITERAL      // count pixels follow
+} rle_state_t;
+
+struct rect_decoder
+{
+	rect_status_t status;
+	bool drawing; // Panel locked and blit running
+	uint8_t header[RECT_HEADER_SIZE];
+	uint8_t headerFill;
+	uint8_t encoding;
+	uint16_t seq;
+	int16_t x;
+	int16_t y;
+	uint16_t w;
+	uint16_t h;
+	uint32_t total;
+	uint32_t done;      // Pixels decoded
+	uint16_t col;       // Of the next pixel
+	uint16_t* above;    // DELTA: previous row, as decoded values
+	uint16_t* strip;    // Current tft_blit buffer
+	uint32_t stripFill; // Pixels in it
+	uint32_t stripSize; // Pixels that make a full strip
+	uint16_t stripY;    // Rectangle row the strip starts at
+	uint16_t stripRows;
+	rle_state_t rle;
+	uint8_t count;
+	uint8_t hi;         // First byte of a pixel split between chunks
+	bool haveHi;
+	uint32_t bytes;
+	int64_t start_us;
+};
+
+// The /ws message being drawn; messages from other clients are turned away
+// while it is open
+static rect_decoder_t wsDecoder;
+static bool wsOpen = false;
+static uint32_t wsOwner = 0;
+static uint32_t wsLastMs = 0; // Last bytes of the open message
+
+// A message turned away (busy), or the rest of one that timed out, is
+// answered once its last frame arrives
+static uint32_t rejectedOwner = 0;
+static uint16_t rejectedSeq = 0;
+static rect_status_t rejectedStatus = RECT_BUSY;
+
+static uint32_t messages = 0;
+static uint32_t errors = 0;
+static uint32_t busy = 0;
+static uint32_t timeouts = 0;
+static uint64_t pixels = 0;
+static uint64_t bytes = 0;
+static uint64_t totalUs = 0;
+static uint32_t lastUs = 0;
+static uint32_t maxUs = 0;
+
+static uint16_t le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void fail(rect_decoder_t* d, rect_status_t status) {
+    if (d->status == RECT_OK) {
+        d->status = status;
+    }
+}
+
+static void nextStrip(rect_decoder_t* d) {
+    d->strip = tftBlitBuffer();
+    d->stripFill = 0;
+    d->stripRows = min((uint32_t)(d->h - d->stripY), (uint32_t)(TFT_BLIT_BUFFER_PIXELS / d->w));
+    d->stripSize = (uint32_t)d->stripRows * d->w;
+}
+
+static void commitStrip(rect_decoder_t* d, uint16_t rows) {
+    if (!rows) {
+        return;
+    }
+    tftBlitCommit(d->x, d->y + d->stripY, d->w, rows);
+    d->stripY += rows;
+    if (d->stripY < d->h) {
+        nextStrip(d);
+    }
+}
+
+// value is the decoded RGB565 (DELTA: still XORed with the row above)
+static inline void putPixel(rect_decoder_t* d, uint16_t value) {
+    if (d->above) {
+        value ^= d->above[d->col];
+        d->above[d->col] = value;
+    }
+    d->strip[d->stripFill++] = __builtin_bswap16(value);
+    d->done++;
+    if (++d->col == d->w) {
+        d->col = 0;
+    }
+    if (d->stripFill == d->stripSize) {
+        commitStrip(d, d->stripRows);
+    }
+}
+
+// A run of one colour; without DELTA it fills the strip directly
+static void putRun(rect_decoder_t* d, uint16_t value, uint32_t n) {
+    if (d->above) {
+        while (n--) {
+            putPixel(d, value);
+        }
+        return;
+    }
+    uint16_t panel = __builtin_bswap16(value);
+    while (n) {
+        uint32_t k = min(n, d->stripSize - d->stripFill);
+        for (uint32_t i = 0; i < k; i++) {
+            d->strip[d->stripFill + i] = panel;
+        }
+        d->stripFill += k;
+        d->done += k;
+        d->col = (d->col + k) % d->w;
+        n -= k;
+        if (d->stripFill == d->stripSize) {
+            commitStrip(d, d->stripRows);
+        }
+    }
+}
+
+static bool beginDrawing(rect_decoder_t* d) {
+    const uint8_t* h = d->header;
+    d->encoding = h[1];
+    d->x = (int16_t)le16(h + 4);
+    d->y = (int16_t)le16(h + 6);
+    d->w = le16(h + 8);
+    d->h = le16(h + 10);
+    if (h[0] != RECT_MSG_TYPE || d->encoding > RECT_ENCODING_DELTA) {
+        fail(d, RECT_BAD_HEADER);
+        return false;
+    }
+    if (!d->w || !d->h || d->x < 0 || d->y < 0 || d->x + d->w > tft.width() || d->y + d->h > tft.height()) {
+        fail(d, RECT_BAD_RECT);
+        return false;
+    }
+    d->total = (uint32_t)d->w * d->h;
+    if (d->encoding == RECT_ENCODING_DELTA) {
+        d->above = (uint16_t*)calloc(d->w, sizeof(uint16_t));
+        if (!d->above) {
+            fail(d, RECT_NO_MEMORY);
+            return false;
+        }
+    }
+    if (!displayTryLock(RECT_LOCK_TIMEOUT_MS)) {
+        fail(d, RECT_BUSY);
+        return false;
+    }
+    if (!tftBlitBegin()) {
+        displayUnlock();
+        fail(d, RECT_NO_MEMORY);
+        return false;
+    }
+    d->drawing = true;
+    tftDebugDetach();
+    displayCacheScreenChanged();
+    nextStrip(d);
+    return true;
+}
+
+// Raw pixels are already in panel order: whole pixels are copied as bytes
+static void decodeRaw(rect_decoder_t* d, const uint8_t* data, size_t len) {
+    while (len && d->done < d->total) {
+        if (d->haveHi) {
+            d->haveHi = false;
+            putPixel(d, (uint16_t)((d->hi << 8) | *data++));
+            len--;
+            continue;
+        }
+        if (len == 1) {
+            d->hi = *data;
+            d->haveHi = true;
+            return;
+        }
+        uint32_t n = min((uint32_t)(len / 2), d->stripSize - d->stripFill);
+        memcpy(d->strip + d->stripFill, data, n * 2);
+        d->stripFill += n;
+        d->done += n;
+        d->col = (d->col + n) % d->w;
+        data += n * 2;
+        len -= n * 2;
+        if (d->stripFill == d->stripSize) {
+            commitStrip(d, d->stripRows);
+        }
+    }
+    if (len) {
+        fail(d, RECT_LONG);
+    }
+}
+
+static void decodeRle(rect_decoder_t* d, const uint8_t* data, size_t len) {
+    for (; len; data++, len--) {
+        if (d->done >= d->total) {
+            fail(d, RECT_LONG);
+            return;
+        }
+        if (d->rle == RLE_CONTROL) {
+            d->count = (*data & 0x7f) + 1;
+            d->rle = (*data & 0x80) ? RLE_RUN : RLE_LITERAL;
+            continue;
+        }
+        if (!d->haveHi) {
+            d->hi = *data;
+            d->haveHi = true;
+            continue;
+        }
+        d->haveHi = false;
+        uint16_t value = (uint16_t)((d->hi << 8) | *data);
+        uint32_t left = d->total - d->done;
+        if (d->rle == RLE_RUN) {
+            if (d->count > left) {
+                fail(d, RECT_LONG);
+                return;
+            }
+            putRun(d, value, d->count);
+            d->rle = RLE_CONTROL;
+        } else {
+            putPixel(d, value);
+            if (--d->count == 0) {
+                d->rle = RLE_CONTROL;
+            }
+        }
+    }
+}
+
+rect_decoder_t* rectDecoderCreate() {
+    return (rect_decoder_t*)calloc(1, sizeof(rect_decoder_t));
+}
+
+void rectDecoderFree(rect_decoder_t* d) {
+    free(d);
+}
+
+void rectDecoderBegin(rect_decoder_t* d) {
+    memset(d, 0, sizeof(*d));
+    d->start_us = esp_timer_get_time();
+}
+
+void rectDecoderWrite(rect_decoder_t* d, const uint8_t* data, size_t len) {
+    d->bytes += len;
+    if (d->headerFill < 4 && d->headerFill + len >= 4) {
+        // seq is known early, for the reply to a message that fails
+        uint8_t seq[4];
+        memcpy(seq, d->header, d->headerFill);
+        memcpy(seq + d->headerFill, data, 4 - d->headerFill);
+        d->seq = le16(seq + 2);
+    }
+    if (d->status != RECT_OK) {
+        return;
+    }
+    if (d->headerFill < RECT_HEADER_SIZE) {
+        size_t n = min(len, (size_t)(RECT_HEADER_SIZE - d->headerFill));
+        memcpy(d->header + d->headerFill, data, n);
+        d->headerFill += n;
+        data += n;
+        len -= n;
+        if (d->headerFill < RECT_HEADER_SIZE || !beginDrawing(d)) {
+            return;
+        }
+    }
+    if (d->encoding == RECT_ENCODING_RAW) {
+        decodeRaw(d, data, len);
+    } else {
+        decodeRle(d, data, len);
+    }
+}
+
+// Close the message, drawing whatever complete rows it delivered
+void rectDecoderEnd(rect_decoder_t* d, rect_result_t* out) {
+    if (d->headerFill < RECT_HEADER_SIZE) {
+        fail(d, RECT_BAD_HEADER);
+    } else if (d->done < d->total || d->haveHi || d->rle != RLE_CONTROL) {
+        fail(d, RECT_SHORT);
+    }
+    if (d->drawing) {
+        if (d->done < d->total) {
+            commitStrip(d, d->stripFill / d->w);
+        }
+        tftBlitEnd();
+        displayUnlock();
+        d->drawing = false;
+    }
+    free(d->above);
+    d->above = nullptr;
+
+    out->status = d->status;
+    out->seq = d->seq;
+    out->pixels = d->done;
+    out->bytes = d->bytes;
+    out->us = (uint32_t)(esp_timer_get_time() - d->start_us);
+}
+
+static void finish(rect_result_t* out) {
+    rectDecoderEnd(&wsDecoder, out);
+    wsOpen = false;
+    messages++;
+    pixels += out->pixels;
+    bytes += out->bytes;
+    if (out->status == RECT_OK) {
+        totalUs += out->us;
+        lastUs = out->us;
+        maxUs = max(maxUs, out->us);
+    } else if (out->status == RECT_BUSY) {
+        busy++;
+    } else {
+        errors++;
+        ESP_LOGW(LOG_TAG_COMMON, "Rect update %u: %s after %u bytes", out->seq, rectStatusText(out->status), out->bytes);
+    }
+}
+
+static bool reject(uint32_t owner, const uint8_t* data, size_t len, bool first, bool last, rect_result_t* out) {
+    if (first) {
+        rejectedOwner = owner;
+        rejectedSeq = len >= 4 ? le16(data + 2) : 0;
+        rejectedStatus = RECT_BUSY;
+    }
+    if (!last || owner != rejectedOwner) {
+        return false;
+    }
+    rejectedOwner = 0;
+    if (rejectedStatus == RECT_BUSY) {
+        // A timed-out message was counted when it was closed
+        messages++;
+        busy++;
+    }
+    memset(out, 0, sizeof(*out));
+    out->status = rejectedStatus;
+    out->seq = rejectedSeq;
+    return true;
+}
+
+// The open message's sender stalled with the panel locked: close it, so
+// renders and other clients get the panel back
+static void expire() {
+    if (!wsOpen || millis() - wsLastMs < RECT_IDLE_TIMEOUT_MS) {
+        return;
+    }
+    uint32_t owner = wsOwner;
+    rect_result_t dropped;
+    fail(&wsDecoder, RECT_TIMEOUT);
+    finish(&dropped);
+    timeouts++;
+    rejectedOwner = owner;
+    rejectedSeq = dropped.seq;
+    rejectedStatus = RECT_TIMEOUT;
+}
+
+bool rectUpdateWrite(uint32_t owner, const uint8_t* data, size_t len, bool first, bool last, rect_result_t* out) {
+    expire();
+    if (wsOpen && wsOwner != owner) {
+        return reject(owner, data, len, first, last, out);
+    }
+    if (first) {
+        if (wsOpen) {
+            // The previous message never saw its end
+            rect_result_t dropped;
+            finish(&dropped);
+        }
+        wsOpen = true;
+        wsOwner = owner;
+        if (rejectedOwner == owner) {
+            rejectedOwner = 0;
+        }
+        rectDecoderBegin(&wsDecoder);
+    } else if (!wsOpen) {
+        return reject(owner, data, len, false, last, out);
+    }
+    wsLastMs = millis();
+    rectDecoderWrite(&wsDecoder, data, len);
+    if (!last) {
+        return false;
+    }
+    finish(out);
+    return true;
+}
+
+void rectUpdatePoll() {
+    expire();
+}
+
+void rectUpdateAbort(uint32_t owner) {
+    if (wsOpen && wsOwner == owner) {
+        rect_result_t dropped;
+        finish(&dropped);
+    }
+    if (rejectedOwner == owner) {
+        rejectedOwner = 0;
+    }
+}
+
+const char* rectStatusText(rect_status_t status) {
+    switch (status) {
+    case RECT_OK:
+        return "ok";
+    case RECT_BUSY:
+        return "busy";
+    case RECT_BAD_HEADER:
+        return "bad header";
+    case RECT_BAD_RECT:
+        return "rectangle outside the panel";
+    case RECT_SHORT:
+        return "message too short";
+    case RECT_LONG:
+        return "message too long";
+    case RECT_NO_MEMORY:
+        return "out of memory";
+    case RECT_TIMEOUT:
+        return "timeout";
+    }
+    return "unknown";
+}
+
+void rectUpdateWriteMetrics(Print& out) {
+    out.printf("rect_messages_total %u\n", messages);
+    out.printf("rect_errors_total %u\n", errors);
+    out.printf("rect_busy_total %u\n", busy);
+    out.printf("rect_timeouts_total %u\n", timeouts);
+    out.printf("rect_pixels_total %llu\n", (unsigned long long)pixels);
+    out.printf("rect_bytes_total %llu\n", (unsigned long long)bytes);
+    uint32_t ok = messages - errors - busy;
+    out.printf("rect_avg_us %u\n", ok ? (uint32_t)(totalUs / ok) : 0);
+    out.printf("rect_last_us %u\n", lastUs);
+    out.printf("rect_max_us %u\n", maxUs);
+}
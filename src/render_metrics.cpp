@@ -0,0 +1,106 @@
+#include <Arduino.h>
+#include "LittleFS.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "common.h"
+#include "render_metrics.h"
+
+static metrics_histogram_t histograms[METRIC_COUNT];
+static const char* const stageNames[METRIC_COUNT] = {
+    "render_file_open_us",
+    "render_read_us",
+    "render_decode_us",
+    "render_spi_push_us",
+    "render_end_to_end_us",
+};
+
+static uint64_t bytesRead = 0;
+static uint64_t pixelsPushed = 0;
+static uint32_t imagesDecoded = 0;
+static uint32_t imagesFromCache = 0;
+
+// Read time of the image being displayed, subtracted from its decode time
+static uint32_t imageReadUs = 0;
+
+// Tasks whose stack high-water marks are reported
+static const char* const stackTasks[] = {"render", "thumbs", "storage", "stream", "playlist", "async_tcp", "loopTask"};
+
+void metricsRecord(metric_stage_t stage, uint32_t us) {
+    metrics_histogram_t* h = &histograms[stage];
+    uint32_t bucket = us ? 32 - __builtin_clz(us) : 0;
+    if (bucket >= METRICS_BUCKETS) {
+        bucket = METRICS_BUCKETS - 1;
+    }
+    h->buckets[bucket]++;
+    h->count++;
+    h->sum_us += us;
+    if (us > h->max_us) {
+        h->max_us = us;
+    }
+}
+
+void metricsCountRead(uint32_t bytes, uint32_t us) {
+    metricsRecord(METRIC_READ, us);
+    bytesRead += bytes;
+    imageReadUs += us;
+}
+
+void metricsImageBegin() {
+    imageReadUs = 0;
+}
+
+void metricsImageEnd(bool fromCache, uint32_t totalUs, uint32_t spiUs, uint32_t pixels) {
+    if (fromCache) {
+        imagesFromCache++;
+    } else {
+        imagesDecoded++;
+        uint32_t other = imageReadUs + spiUs;
+        metricsRecord(METRIC_DECODE, totalUs > other ? totalUs - other : 0);
+    }
+    metricsRecord(METRIC_SPI_PUSH, spiUs);
+    pixelsPushed += pixels;
+}
+
+static void writeHistogram(Print& out, const char* name, const metrics_histogram_t* h) {
+    // Cumulative buckets up to the last used one; the top bucket also holds
+    // everything clamped into it, so it only appears as +Inf
+    int last = -1;
+    for (int k = 0; k < METRICS_BUCKETS - 1; k++) {
+        if (h->buckets[k]) last = k;
+    }
+    uint32_t cumulative = 0;
+    for (int k = 0; k <= last; k++) {
+        cumulative += h->buckets[k];
+        out.printf("%s_bucket{le=\"%u\"} %u\n", name, 1u << k, cumulative);
+    }
+    out.printf("%s_bucket{le=\"+Inf\"} %u\n", name, h->count);
+    out.printf("%s_sum %llu\n", name, (unsigned long long)h->sum_us);
+    out.printf("%s_count %u\n", name, h->count);
+    out.printf("%s_max %u\n", name, h->max_us);
+}
+
+void metricsWrite(Print& out) {
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        writeHistogram(out, stageNames[i], &histograms[i]);
+    }
+    out.printf("render_bytes_read_total %llu\n", (unsigned long long)bytesRead);
+    out.printf("render_pixels_pushed_total %llu\n", (unsigned long long)pixelsPushed);
+    out.printf("render_images_decoded_total %u\n", imagesDecoded);
+    out.printf("render_images_cached_total %u\n", imagesFromCache);
+
+    out.printf("heap_free_bytes %u\n", heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    out.printf("heap_min_free_bytes %u\n", heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    out.printf("heap_largest_block_bytes %u\n", heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+    // ESP-IDF reports the high-water mark in bytes
+    for (const char* name : stackTasks) {
+        TaskHandle_t task = xTaskGetHandle(name);
+        if (task) {
+            out.printf("task_stack_free_min_bytes{task=\"%s\"} %u\n", name, uxTaskGetStackHighWaterMark(task));
+        }
+    }
+
+    out.printf("littlefs_total_bytes %u\n", LittleFS.totalBytes());
+    out.printf("littlefs_used_bytes %u\n", LittleFS.usedBytes());
+}
@@ -0,0 +1,110 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <ESPAsyncWebServer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "common.h"
+#include "ethernet.h"
+#include "render_task.h"
+#include "image_display.h"
+#include "render_metrics.h"
+#include "thumbnail.h"
+#include "boot.h"
+#include "esp_timer.h"
+
+static QueueHandle_t renderQueue = nullptr;
+static QueueHandle_t thumbQueue = nullptr;
+static uint32_t nextJobId = 1;
+static uint32_t activeJobId = 0;
+
+// {"id":..,"state":"..",...extra} as a "render" event
+static void sendRenderEvent(uint32_t id, const char* state, const String& extra = String()) {
+    String json = "{\"id\":" + String(id) + ",\"state\":\"" + state + "\"" + extra + "}";
+    eventsSend(json.c_str(), "render", id);
+}
+
+static void onProgress(uint8_t percent) {
+    sendRenderEvent(activeJobId, "progress", ",\"progress\":" + String(percent));
+}
+
+static void renderTask(void* param) {
+    render_job_t job;
+    for (;;) {
+        if (xQueueReceive(renderQueue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        activeJobId = job.id;
+        sendRenderEvent(job.id, "started", ",\"name\":\"" + String(job.name) + "\"");
+
+        uint32_t start = millis();
+        displayLock();
+        displaySetProgressCallback(onProgress);
+        bool shown = displayImageWithScaling(job.name, true, job.progressive);
+        displaySetProgressCallback(nullptr);
+        bool superseded = !shown && displayRequestSuperseded();
+        displayUnlock();
+
+        if (shown) {
+            metricsRecord(METRIC_END_TO_END, (uint32_t)(esp_timer_get_time() - job.received_us));
+            bootRememberImage(job.name, job.progressive); // Redrawn first on the next boot
+        }
+        String extra = ",\"ms\":" + String(millis() - start);
+        sendRenderEvent(job.id, shown ? "done" : superseded ? "superseded" : "failed", extra);
+        ESP_LOGI(LOG_TAG_COMMON, "Render job %u %s: %s", job.id, job.name,
+                 shown ? "done" : superseded ? "superseded" : "failed");
+        activeJobId = 0;
+    }
+}
+
+static void thumbTask(void* param) {
+    char name[64];
+    for (;;) {
+        if (xQueueReceive(thumbQueue, name, portMAX_DELAY) == pdTRUE) {
+            thumbnailGenerate(name);
+        }
+    }
+}
+
+void renderTaskInit() {
+    displayInit();
+    renderQueue = xQueueCreate(1, sizeof(render_job_t));
+    thumbQueue = xQueueCreate(THUMB_QUEUE_LENGTH, 64);
+    xTaskCreate(renderTask, "render", RENDER_TASK_STACK, nullptr, TASK_PRIO_RENDER, nullptr);
+    xTaskCreate(thumbTask, "thumbs", THUMB_TASK_STACK, nullptr, TASK_PRIO_THUMB, nullptr);
+    ESP_LOGI(LOG_TAG_COMMON, "Render task started");
+}
+
+uint32_t renderSubmit(const char* filename, bool progressive) {
+    render_job_t job;
+    if (strlen(filename) >= sizeof(job.name)) {
+        return 0;
+    }
+    job.id = nextJobId++;
+    strlcpy(job.name, filename, sizeof(job.name));
+    job.progressive = progressive;
+    job.received_us = esp_timer_get_time();
+
+    // A job still waiting in the queue is replaced and will never run
+    render_job_t pending;
+    if (xQueuePeek(renderQueue, &pending, 0) == pdTRUE) {
+        sendRenderEvent(pending.id, "superseded");
+    }
+    // Stop a render in progress early; the newest job runs right after it.
+    // Bumped before the job is queued: the render task may take it at once
+    // and must not see this request as newer than its own
+    displayRequestNew();
+    xQueueOverwrite(renderQueue, &job);
+    sendRenderEvent(job.id, "queued", ",\"name\":\"" + String(job.name) + "\"");
+    return job.id;
+}
+
+bool renderQueueThumbnail(const char* filename) {
+    char name[64];
+    if (strlen(filename) >= sizeof(name)) {
+        return false;
+    }
+    strlcpy(name, filename, sizeof(name));
+    return xQueueSend(thumbQueue, name, 0) == pdTRUE;
+}
@@ -7,6 +7,8 @@
 #include "common.h"
 #include "ethernet.h"
 #include "splash_screen.h"
+#include "display_cache.h"
+#include "tft_debug.h"
 #include "esp_log.h"
 
 // QR code data buffers (size for version 3 QR code)
@@ -19,7 +21,9 @@ void showSplashScreen() {
     ESP_LOGI(LOG_TAG_COMMON, "Displaying splash screen");
     
     // Clear screen with gradient background
+    tftDebugDetach();
     tft.fillScreen(COLOR_BACKGROUND);
+    displayCacheScreenChanged();
     
     // Draw header with system name
     tft.fillRect(0, 0, 240, 60, COLOR_PRIMARY);
@@ -70,22 +74,21 @@ void showSplashScreen() {
     tft.setCursor(10, 210);
     tft.print("Initializing...");
     
-    // Progress bar background
+    // Progress bar background, filled by splashScreenProgress()
     tft.drawRect(10, 230, 222, 20, COLOR_TEXT);
     tft.fillRect(11, 231, 220, 18, COLOR_BACKGROUND);
-    
-    // Animated progress bar
-    for(int i = 0; i <= 220; i += 10) {
-        tft.fillRect(11, 231, i, 18, COLOR_SECONDARY);
-        delay(100);
+}
+
+void splashScreenProgress(uint8_t percent) {
+    percent = min(percent, (uint8_t)100);
+    tft.fillRect(11, 231, 220 * percent / 100, 18, COLOR_SECONDARY);
+    if (percent == 100) {
+        // Completion message
+        tft.setTextSize(1);
+        tft.setCursor(10, 260);
+        tft.setTextColor(COLOR_ACCENT);
+        tft.print("Ready!");
     }
-    
-    // Completion message
-    tft.setCursor(10, 260);
-    tft.setTextColor(COLOR_ACCENT);
-    tft.print("Ready!");
-    
-    delay(1000);
 }
 
 void generateWiFiQRCode() {
@@ -145,7 +148,9 @@ void showQRCodes() {
     generateWebQRCode();
     
     // Clear screen
+    tftDebugDetach();
     tft.fillScreen(COLOR_BACKGROUND);
+    displayCacheScreenChanged();
     
     // Draw header
     tft.fillRect(0, 0, 240, 50, COLOR_PRIMARY);
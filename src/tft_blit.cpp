@@ -0,0 +1,213 @@
+#include <Arduino.h>
+#include <Adafruit_ILI9341.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "common.h"
+#include "tft_blit.h"
+
+#if TFT_BLIT_USE_DMA
+#include "driver/spi_master.h"
+
+#if CONFIG_IDF_TARGET_ESP32
+#define TFT_BLIT_SPI_HOST SPI3_HOST // Arduino SPI = VSPI
+#else
+#define TFT_BLIT_SPI_HOST SPI2_HOST // Arduino SPI = FSPI
+#endif
+
+static spi_device_handle_t dmaDevice = nullptr;
+static spi_transaction_t dmaTrans;
+#endif
+
+static uint16_t* blitBuffers[2] = {nullptr, nullptr};
+static uint8_t fillIndex = 0;
+static bool transferInFlight = false;
+static bool dmaUsedSinceWindow = false;
+
+// Currently open address window
+static bool windowOpen = false;
+static int16_t windowX = 0;
+static uint16_t windowW = 0;
+static int16_t windowNextY = 0;
+
+// Scroll-in transition state
+static bool scrollIn = false;
+static uint16_t scrollRows = 0;     // Rows of the new frame already revealed
+static uint16_t committedBottom = 0; // Lowest row of any committed strip
+
+static tft_blit_stats_t stats;
+
+static void waitTransfer() {
+#if TFT_BLIT_USE_DMA
+    if (transferInFlight) {
+        int64_t start = esp_timer_get_time();
+        spi_transaction_t* done;
+        spi_device_get_trans_result(dmaDevice, &done, portMAX_DELAY);
+        stats.wait_us += (uint32_t)(esp_timer_get_time() - start);
+    }
+#endif
+    transferInFlight = false;
+}
+
+// Hand the bus back to the Arduino driver for command bytes
+static void releaseDma() {
+    if (dmaUsedSinceWindow) {
+        tft.endWrite();
+        tft.startWrite();
+        dmaUsedSinceWindow = false;
+    }
+}
+
+// Reveal everything that has reached the panel; breaks the open window
+static void scrollToCommitted() {
+    if (committedBottom <= scrollRows) {
+        return;
+    }
+    waitTransfer();
+    releaseDma();
+    scrollRows = committedBottom;
+    tft.writeCommand(ILI9341_VSCRSADD);
+    tft.SPI_WRITE16(scrollRows % ILI9341_TFTHEIGHT);
+    windowOpen = false;
+}
+
+void tftBlitInit() {
+#if TFT_BLIT_USE_DMA
+    // Pins stay routed by the Arduino SPI driver; only the DMA-capable
+    // master driver is attached to the same peripheral for pixel payloads.
+    spi_bus_config_t buscfg;
+    memset(&buscfg, 0, sizeof(buscfg));
+    buscfg.mosi_io_num = -1;
+    buscfg.miso_io_num = -1;
+    buscfg.sclk_io_num = -1;
+    buscfg.quadwp_io_num = -1;
+    buscfg.quadhd_io_num = -1;
+    buscfg.max_transfer_sz = TFT_BLIT_BUFFER_PIXELS * 2;
+
+    spi_device_interface_config_t devcfg;
+    memset(&devcfg, 0, sizeof(devcfg));
+    devcfg.mode = 0;
+    devcfg.clock_speed_hz = TFT_SPI_FREQ;
+    devcfg.spics_io_num = -1; // CS is held by Adafruit startWrite()
+    devcfg.flags = SPI_DEVICE_NO_DUMMY;
+    devcfg.queue_size = 1;
+
+    if (spi_bus_initialize(TFT_BLIT_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO) != ESP_OK ||
+        spi_bus_add_device(TFT_BLIT_SPI_HOST, &devcfg, &dmaDevice) != ESP_OK) {
+        ESP_LOGE(LOG_TAG_COMMON, "SPI DMA init failed, falling back to blocking writes");
+        dmaDevice = nullptr;
+        return;
+    }
+    ESP_LOGI(LOG_TAG_COMMON, "SPI DMA blit pipeline ready (%d px per buffer)", TFT_BLIT_BUFFER_PIXELS);
+#endif
+}
+
+bool tftBlitBegin() {
+    for (int i = 0; i < 2; i++) {
+        blitBuffers[i] = (uint16_t*)heap_caps_malloc(TFT_BLIT_BUFFER_PIXELS * 2, MALLOC_CAP_DMA);
+        if (!blitBuffers[i]) {
+            ESP_LOGE(LOG_TAG_COMMON, "Blit buffer allocation failed");
+            heap_caps_free(blitBuffers[0]);
+            blitBuffers[0] = blitBuffers[1] = nullptr;
+            return false;
+        }
+    }
+    fillIndex = 0;
+    transferInFlight = false;
+    dmaUsedSinceWindow = false;
+    windowOpen = false;
+    scrollRows = 0;
+    committedBottom = 0;
+    tft.startWrite();
+    return true;
+}
+
+uint16_t* tftBlitBuffer() {
+    return blitBuffers[fillIndex];
+}
+
+void tftBlitCommit(int16_t x, int16_t y, uint16_t w, uint16_t h) {
+    if (w == 0 || h == 0) {
+        return;
+    }
+    int64_t start = esp_timer_get_time();
+
+    if (scrollIn) {
+        scrollToCommitted();
+    }
+
+    bool continues = windowOpen && x == windowX && w == windowW && y == windowNextY;
+    if (!continues) {
+        waitTransfer();
+        releaseDma();
+        // Open the window down to the bottom of the panel so that following
+        // strips can stream into it without another CASET/PASET/RAMWR
+        tft.setAddrWindow(x, y, w, ILI9341_TFTHEIGHT - y);
+        windowOpen = true;
+        windowX = x;
+        windowW = w;
+        stats.windows++;
+    }
+    windowNextY = y + h;
+
+    uint16_t* buffer = blitBuffers[fillIndex];
+    uint32_t count = (uint32_t)w * h;
+
+#if TFT_BLIT_USE_DMA
+    if (dmaDevice) {
+        // Only one transfer in flight: wait for the other half before queueing
+        waitTransfer();
+        memset(&dmaTrans, 0, sizeof(dmaTrans));
+        dmaTrans.tx_buffer = buffer;
+        dmaTrans.length = count * 16;
+        spi_device_queue_trans(dmaDevice, &dmaTrans, portMAX_DELAY);
+        transferInFlight = true;
+        dmaUsedSinceWindow = true;
+    } else
+#endif
+    {
+        tft.writePixels(buffer, count, true, true);
+    }
+
+    stats.transfers++;
+    stats.pixels += count;
+    fillIndex ^= 1;
+    if (y + h > committedBottom) {
+        committedBottom = y + h;
+    }
+    stats.push_us += (uint32_t)(esp_timer_get_time() - start);
+}
+
+void tftBlitEnd() {
+    int64_t start = esp_timer_get_time();
+    waitTransfer();
+    if (scrollIn) {
+        // Whatever was not drawn stays as it was; finish the slide
+        committedBottom = ILI9341_TFTHEIGHT;
+        scrollToCommitted();
+    }
+    tft.endWrite();
+    windowOpen = false;
+    stats.push_us += (uint32_t)(esp_timer_get_time() - start);
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(blitBuffers[i]);
+        blitBuffers[i] = nullptr;
+    }
+}
+
+void tftBlitSetScrollIn(bool enable) {
+    if (enable && !scrollIn) {
+        // Whole panel is the scrolling area, starting unscrolled
+        tft.setScrollMargins(0, 0);
+        tft.scrollTo(0);
+    }
+    scrollIn = enable;
+}
+
+void tftBlitResetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+const tft_blit_stats_t* tftBlitStats() {
+    return &stats;
+}
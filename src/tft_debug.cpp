@@ -1,78 +1,132 @@
 #include "tft_debug.h"
+#include "display_cache.h"
 #include <stdarg.h>
 #include <stdio.h>
 
-// Global variables for TFT debug
-static int currentLine = 0;
+// Ring of the most recent lines; historyHead is the newest
+static tft_debug_line_t history[TFT_DEBUG_HISTORY];
+static uint16_t historyHead = 0;
+static uint16_t historyCount = 0;
+static bool lineOpen = false; // Newest line can still be printed over
+
+// Scrolling area state: slot n is panel memory row TFT_DEBUG_TOP_PX + n * line height
+static uint8_t screenLines = 0; // Slots in use
+static uint8_t topSlot = 0;     // Slot shown at the top of the scrolling area
+static uint8_t currentSlot = 0; // Slot holding the newest line
 static bool tftDebugInitialized = false;
+static bool consoleOnScreen = false;
 
-void tftDebugInit() {
-    tft.fillScreen(ILI9341_BLACK);
-    tft.setTextSize(1);
-    tft.setTextWrap(true);
-    currentLine = 0;
-    tftDebugInitialized = true;
-    
-    // Display header
+static void drawHeader() {
     tft.setTextColor(TFT_COLOR_SYSTEM);
     tft.setCursor(0, 0);
-    tft.println("ESP32-C3 DEBUG CONSOLE");
+    tft.print("ESP32-C3 DEBUG CONSOLE");
     tft.setTextColor(TFT_COLOR_DEBUG);
-    tft.println("========================");
-    currentLine = 2;
+    tft.setCursor(0, TFT_DEBUG_LINE_HEIGHT);
+    tft.print("========================");
+}
+
+static void drawSlot(uint8_t slot, const tft_debug_line_t* line, bool fill) {
+    int16_t y = TFT_DEBUG_TOP_PX + slot * TFT_DEBUG_LINE_HEIGHT;
+    if (fill) {
+        tft.fillRect(0, y, 240, TFT_DEBUG_LINE_HEIGHT, ILI9341_BLACK);
+    }
+    tft.setTextColor(line->color);
+    tft.setCursor(0, y);
+    tft.print(line->text);
+}
+
+void tftDebugInit() {
+    tft.setTextSize(1);
+    tft.setTextWrap(false);
+    historyHead = 0;
+    historyCount = 0;
+    lineOpen = false;
+    tftDebugInitialized = true;
+    tftDebugRedraw();
 }
 
 void tftDebugClear() {
+    historyCount = 0;
+    lineOpen = false;
+    tftDebugRedraw();
+}
+
+void tftDebugRedraw() {
     tft.fillScreen(ILI9341_BLACK);
-    currentLine = 0;
-    
-    // Redisplay header
-    tft.setTextColor(TFT_COLOR_SYSTEM);
-    tft.setCursor(0, 0);
-    tft.println("ESP32-C3 DEBUG CONSOLE");
-    tft.setTextColor(TFT_COLOR_DEBUG);
-    tft.println("========================");
-    currentLine = 2;
+    displayCacheScreenChanged();
+    tft.setScrollMargins(TFT_DEBUG_TOP_PX, ILI9341_TFTHEIGHT - TFT_DEBUG_TOP_PX - TFT_DEBUG_SCROLL_PX);
+    tft.scrollTo(TFT_DEBUG_TOP_PX);
+    consoleOnScreen = true;
+    drawHeader();
+
+    // Newest lines go back into the slots in order, unscrolled; the screen is
+    // already black so only glyphs are drawn
+    uint16_t n = historyCount < TFT_DEBUG_SCROLL_LINES ? historyCount : TFT_DEBUG_SCROLL_LINES;
+    for (uint16_t i = 0; i < n; i++) {
+        uint16_t index = (historyHead + TFT_DEBUG_HISTORY - (n - 1) + i) % TFT_DEBUG_HISTORY;
+        drawSlot(i, &history[index], false);
+    }
+    screenLines = n;
+    topSlot = 0;
+    currentSlot = n ? n - 1 : 0;
 }
 
+void tftDebugDetach() {
+    if (!consoleOnScreen) return;
+    tft.setScrollMargins(0, 0);
+    tft.scrollTo(0);
+    consoleOnScreen = false;
+}
+
+// Start a new line: take the next free slot, or recycle the oldest one by
+// scrolling it from the top to the bottom of the area
 void tftDebugScroll() {
     if (!tftDebugInitialized) return;
-    
-    // Scroll the display up by one line
-    // This is a simplified approach - clear screen and start over
-    if (currentLine >= TFT_DEBUG_LINES - 1) {
-        // Clear bottom half and reset cursor
-        tft.fillRect(0, TFT_DEBUG_LINE_HEIGHT * 15, 240, 320 - (TFT_DEBUG_LINE_HEIGHT * 15), ILI9341_BLACK);
-        currentLine = 15;
+
+    historyHead = (historyHead + 1) % TFT_DEBUG_HISTORY;
+    if (historyCount < TFT_DEBUG_HISTORY) {
+        historyCount++;
+    }
+    history[historyHead].text[0] = '\0';
+
+    if (screenLines < TFT_DEBUG_SCROLL_LINES) {
+        currentSlot = screenLines++;
+    } else {
+        currentSlot = topSlot;
+        topSlot = (topSlot + 1) % TFT_DEBUG_SCROLL_LINES;
+        tft.scrollTo(TFT_DEBUG_TOP_PX + topSlot * TFT_DEBUG_LINE_HEIGHT);
     }
+    lineOpen = true;
 }
 
 void tftDebugPrint(const char* message, uint16_t color) {
     if (!tftDebugInitialized) {
         tftDebugInit();
+    } else if (!consoleOnScreen) {
+        tftDebugRedraw();
+    }
+    if (!lineOpen) {
+        tftDebugScroll();
     }
-    
-    tftDebugScroll();
-    
-    tft.setTextColor(color);
-    tft.setCursor(0, currentLine * TFT_DEBUG_LINE_HEIGHT);
     
     // Print message, handling long lines
-    String msg = String(message);
-    if (msg.length() > TFT_DEBUG_MAX_CHARS) {
-        msg = msg.substring(0, TFT_DEBUG_MAX_CHARS - 3) + "...";
+    tft_debug_line_t* line = &history[historyHead];
+    size_t len = strlen(message);
+    if (len > TFT_DEBUG_MAX_CHARS) {
+        memcpy(line->text, message, TFT_DEBUG_MAX_CHARS - 3);
+        strcpy(line->text + TFT_DEBUG_MAX_CHARS - 3, "...");
+    } else {
+        memcpy(line->text, message, len + 1);
     }
+    line->color = color;
     
-    tft.print(msg);
+    displayCacheScreenChanged();
+    drawSlot(currentSlot, line, true);
 }
 
 void tftDebugPrintln(const char* message, uint16_t color) {
     tftDebugPrint(message, color);
-    currentLine++;
-    
-    if (currentLine >= TFT_DEBUG_LINES) {
-        tftDebugScroll();
-    }
+    lineOpen = false;
 }
 
 void tftDebugPrintf(uint16_t color, const char* format, ...) {
@@ -87,4 +141,4 @@ void tftDebugPrintf(uint16_t color, const char* format, ...) {
     va_end(args);
     
     tftDebugPrintln(buffer, color);
-}
\ No newline at end of file
+}
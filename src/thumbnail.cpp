@@ -0,0 +1,320 @@
+#include <Arduino.h>
+#include "LittleFS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "common.h"
+#include "thumbnail.h"
+#include "image_display.h"
+#include "image_catalog.h"
+
+#define THUMB_ROW_BYTES (1 + THUMB_WIDTH * 3) // Filter byte and RGB
+#define THUMB_RAW_SIZE (THUMB_HEIGHT * THUMB_ROW_BYTES)
+
+#define LZ_HASH_BITS 12
+#define LZ_WINDOW_BITS 12 // Matches reach back 4096 bytes (22 scanlines)
+#define LZ_WINDOW (1 << LZ_WINDOW_BITS)
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH 258
+#define LZ_MAX_CHAIN 32   // Candidates tried per position
+#define LZ_GOOD_MATCH 32  // Long enough: no lazy look one byte further
+
+// Encoder state, allocated for one thumbnail
+typedef struct
+{
+	uint8_t raw[THUMB_RAW_SIZE];     // PNG scanlines, the LZ77 window
+	uint16_t head[1 << LZ_HASH_BITS]; // Last position + 1 of each 3-byte hash
+	uint16_t prev[LZ_WINDOW];         // Earlier position + 1 with the same hash
+	uint8_t out[THUMB_IDAT_SIZE];    // zlib stream not yet in an IDAT chunk
+	uint16_t outFill;
+	uint32_t bits;
+	uint8_t bitCount;
+	File* file;
+	bool ok;
+} thumb_encoder_t;
+
+static const uint16_t lengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                        31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                        2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t distanceBase[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,    65,    97,    129,
+                                          193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t distanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                          6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static void put32be(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+// One PNG chunk: length, type, data, CRC over type and data
+static void writeChunk(thumb_encoder_t* e, const char* type, const uint8_t* data, uint32_t len) {
+    uint8_t head[8];
+    put32be(head, len);
+    memcpy(head + 4, type, 4);
+    uint32_t crc = imageCatalogCrc32(imageCatalogCrc32(0, head + 4, 4), data, len);
+    uint8_t tail[4];
+    put32be(tail, crc);
+    e->ok = e->ok && e->file->write(head, 8) == 8 && (!len || e->file->write(data, len) == len) &&
+            e->file->write(tail, 4) == 4;
+}
+
+static void flushIdat(thumb_encoder_t* e) {
+    if (e->outFill) {
+        writeChunk(e, "IDAT", e->out, e->outFill);
+        e->outFill = 0;
+    }
+}
+
+static void putByte(thumb_encoder_t* e, uint8_t b) {
+    e->out[e->outFill++] = b;
+    if (e->outFill == THUMB_IDAT_SIZE) {
+        flushIdat(e);
+    }
+}
+
+// Deflate packs bits LSB first
+static void putBits(thumb_encoder_t* e, uint32_t value, uint8_t count) {
+    e->bits |= value << e->bitCount;
+    e->bitCount += count;
+    while (e->bitCount >= 8) {
+        putByte(e, e->bits & 0xFF);
+        e->bits >>= 8;
+        e->bitCount -= 8;
+    }
+}
+
+// Huffman codes go MSB first
+static void putCode(thumb_encoder_t* e, uint32_t code, uint8_t length) {
+    uint32_t reversed = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    putBits(e, reversed, length);
+}
+
+// Literal/length symbol in the fixed code of RFC 1951 3.2.6
+static void putSymbol(thumb_encoder_t* e, uint16_t symbol) {
+    if (symbol < 144) {
+        putCode(e, 0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        putCode(e, 0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        putCode(e, symbol - 256, 7);
+    } else {
+        putCode(e, 0xC0 + symbol - 280, 8);
+    }
+}
+
+static void putMatch(thumb_encoder_t* e, uint16_t length, uint16_t distance) {
+    uint8_t l = 28;
+    while (lengthBase[l] > length) l--;
+    putSymbol(e, 257 + l);
+    putBits(e, length - lengthBase[l], lengthExtra[l]);
+    uint8_t d = 29;
+    while (distanceBase[d] > distance) d--;
+    putCode(e, d, 5);
+    putBits(e, distance - distanceBase[d], distanceExtra[d]);
+}
+
+static uint16_t lzHash(const uint8_t* p) {
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Hash every position below end not yet in the chains
+static void lzInsert(thumb_encoder_t* e, uint32_t* inserted, uint32_t end) {
+    for (; *inserted < end && *inserted + LZ_MIN_MATCH <= THUMB_RAW_SIZE; (*inserted)++) {
+        uint16_t* head = &e->head[lzHash(e->raw + *inserted)];
+        e->prev[*inserted & (LZ_WINDOW - 1)] = *head;
+        *head = *inserted + 1;
+    }
+}
+
+// Longest earlier match for pos along its hash chain (inserted already)
+static uint16_t lzLongest(thumb_encoder_t* e, uint32_t pos, uint16_t* distance) {
+    uint16_t best = 0;
+    if (pos + LZ_MIN_MATCH > THUMB_RAW_SIZE) {
+        return 0;
+    }
+    uint32_t limit = min((uint32_t)LZ_MAX_MATCH, (uint32_t)(THUMB_RAW_SIZE - pos));
+    const uint8_t* b = e->raw + pos;
+    uint16_t candidate = e->prev[pos & (LZ_WINDOW - 1)];
+    for (uint8_t chain = 0; candidate && chain < LZ_MAX_CHAIN; chain++) {
+        uint32_t from = candidate - 1;
+        if (pos - from > LZ_WINDOW - 1 || from >= pos) {
+            break;
+        }
+        const uint8_t* a = e->raw + from;
+        if (a[best] == b[best]) {
+            uint16_t length = 0;
+            while (length < limit && a[length] == b[length]) length++;
+            if (length > best) {
+                best = length;
+                *distance = pos - from;
+                if (length == limit) {
+                    break;
+                }
+            }
+        }
+        candidate = e->prev[from & (LZ_WINDOW - 1)];
+    }
+    return best >= LZ_MIN_MATCH ? best : 0;
+}
+
+// zlib stream of the scanlines: one fixed-Huffman block (a dynamic table
+// would save another fifth, at twice the code), LZ77 over a 4 KB window
+// with hash chains and one step of lazy matching
+static void deflateRaw(thumb_encoder_t* e) {
+    putByte(e, 0x78); // 32K window, no dictionary, FCHECK
+    putByte(e, 0x01);
+    putBits(e, 1, 1); // BFINAL
+    putBits(e, 1, 2); // BTYPE fixed Huffman
+    memset(e->head, 0, sizeof(e->head));
+    uint32_t inserted = 0;
+    uint32_t pos = 0;
+    while (pos < THUMB_RAW_SIZE) {
+        lzInsert(e, &inserted, pos + 1);
+        uint16_t distance = 0;
+        uint16_t length = lzLongest(e, pos, &distance);
+        if (length && length < LZ_GOOD_MATCH) {
+            // A longer match one byte on wins; this byte goes as a literal
+            lzInsert(e, &inserted, pos + 2);
+            uint16_t nextDistance = 0;
+            uint16_t next = lzLongest(e, pos + 1, &nextDistance);
+            if (next > length) {
+                putSymbol(e, e->raw[pos++]);
+                length = next;
+                distance = nextDistance;
+            }
+        }
+        if (length) {
+            putMatch(e, length, distance);
+            pos += length;
+        } else {
+            putSymbol(e, e->raw[pos++]);
+        }
+    }
+    putSymbol(e, 256);
+    if (e->bitCount) {
+        putBits(e, 0, 8 - e->bitCount);
+    }
+
+    uint32_t a = 1, b = 0;
+    for (uint32_t i = 0; i < THUMB_RAW_SIZE; i++) {
+        a = (a + e->raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    uint8_t adler[4];
+    put32be(adler, (b << 16) | a);
+    for (uint8_t i = 0; i < 4; i++) {
+        putByte(e, adler[i]);
+    }
+    flushIdat(e);
+}
+
+void thumbnailInit() {
+    if (!LittleFS.exists(THUMB_DIR)) {
+        LittleFS.mkdir(THUMB_DIR);
+        return;
+    }
+    // Thumbnails of an older format are made again on first request
+    File dir = LittleFS.open(THUMB_DIR);
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        String name = f.name();
+        f.close();
+        if (!name.endsWith(THUMB_EXT)) {
+            LittleFS.remove(String(THUMB_DIR "/") + name);
+        }
+    }
+}
+
+String thumbnailPath(const char* filename) {
+    String path = THUMB_DIR "/";
+    path += filename;
+    path += THUMB_EXT;
+    return path;
+}
+
+bool thumbnailExists(const char* filename) {
+    return LittleFS.exists(thumbnailPath(filename));
+}
+
+bool thumbnailGenerate(const char* filename) {
+    int64_t start = esp_timer_get_time();
+    uint16_t* pixels = (uint16_t*)malloc(THUMB_WIDTH * THUMB_HEIGHT * 2);
+    thumb_encoder_t* e = (thumb_encoder_t*)malloc(sizeof(thumb_encoder_t));
+    if (!pixels || !e) {
+        ESP_LOGE(LOG_TAG_COMMON, "Thumbnail: no memory for %s", filename);
+        free(pixels);
+        free(e);
+        return false;
+    }
+    if (!displayRenderThumbnail(filename, pixels, THUMB_WIDTH, THUMB_HEIGHT)) {
+        ESP_LOGW(LOG_TAG_COMMON, "Thumbnail: decode of %s failed", filename);
+        free(pixels);
+        free(e);
+        return false;
+    }
+    uint32_t decodeUs = (uint32_t)(esp_timer_get_time() - start);
+
+    // Panel-order RGB565 to 8-bit RGB scanlines, filter type None (the
+    // others compress worse on these)
+    for (uint16_t y = 0; y < THUMB_HEIGHT; y++) {
+        uint8_t* row = e->raw + y * THUMB_ROW_BYTES;
+        *row++ = 0;
+        for (uint16_t x = 0; x < THUMB_WIDTH; x++) {
+            uint16_t c = __builtin_bswap16(pixels[y * THUMB_WIDTH + x]);
+            uint8_t r = c >> 11, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            *row++ = (r << 3) | (r >> 2);
+            *row++ = (g << 2) | (g >> 4);
+            *row++ = (b << 3) | (b >> 2);
+        }
+    }
+    free(pixels);
+
+    // Written beside the old thumbnail and swapped in, like the playlist
+    String path = thumbnailPath(filename);
+    String tmp = path + ".tmp";
+    File file = LittleFS.open(tmp, "w");
+    e->file = &file;
+    e->ok = (bool)file;
+    e->outFill = 0;
+    e->bits = 0;
+    e->bitCount = 0;
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    e->ok = e->ok && file.write(signature, sizeof(signature)) == sizeof(signature);
+    uint8_t ihdr[13];
+    put32be(ihdr, THUMB_WIDTH);
+    put32be(ihdr + 4, THUMB_HEIGHT);
+    ihdr[8] = 8;  // Bit depth
+    ihdr[9] = 2;  // Truecolour
+    ihdr[10] = 0; // Deflate
+    ihdr[11] = 0; // Adaptive filtering
+    ihdr[12] = 0; // Not interlaced
+    writeChunk(e, "IHDR", ihdr, sizeof(ihdr));
+    deflateRaw(e);
+    writeChunk(e, "IEND", nullptr, 0);
+    bool written = e->ok;
+    uint32_t size = file ? file.size() : 0;
+    if (file) {
+        file.close();
+    }
+    free(e);
+    if (!written || !LittleFS.rename(tmp, path)) {
+        LittleFS.remove(tmp);
+        ESP_LOGE(LOG_TAG_COMMON, "Thumbnail: write of %s failed", path.c_str());
+        return false;
+    }
+    ESP_LOGI(LOG_TAG_COMMON, "Thumbnail %s: %u bytes, decode %u us, total %u us", filename, size, decodeUs,
+             (uint32_t)(esp_timer_get_time() - start));
+    return true;
+}
+
+void thumbnailRemove(const char* filename) {
+    String path = thumbnailPath(filename);
+    if (LittleFS.exists(path)) {
+        LittleFS.remove(path);
+    }
+}
@@ -0,0 +1,654 @@
+#include <Arduino.h>
+#include <new>
+#include "LittleFS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "common.h"
+#include "upload_session.h"
+#include "image_catalog.h"
+#include "ota_image.h"
+#if UPLOAD_WRITE_BEHIND
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <ESPAsyncWebServer.h>
+#endif
+#ifndef HOST_SIM
+#include <Update.h>
+#endif
+
+typedef enum
+{
+	UPLOAD_TARGET_FILE = 0,
+	UPLOAD_TARGET_UPDATE
+} upload_target_t;
+
+typedef enum
+{
+	UPLOAD_JOB_OPEN = 0,
+	UPLOAD_JOB_WRITE,
+	UPLOAD_JOB_COMMIT,
+	UPLOAD_JOB_END
+} upload_op_t;
+
+typedef struct
+{
+	uint8_t op;
+	upload_session_t* session;
+	uint8_t* block;
+	size_t len;
+} upload_job_t;
+
+struct upload_session
+{
+	upload_target_t target;
+	int command; // Update: U_FLASH or U_SPIFFS
+	String path; // Destination
+	String tmp;
+	String filename;
+	File file;
+	uint8_t* block; // Being filled by the receiver
+	size_t fill;
+	volatile upload_status_t status; // Also set by the storage task
+	volatile bool committed;
+	volatile bool finished; // Commit job ran
+	bool commitQueued;
+	bool waited;
+	uint32_t start_ms;
+	uint32_t end_ms;
+	uint32_t bytes;
+	uint32_t crc;
+	uint32_t writes;
+	uint32_t pauses;
+	uint32_t max_write_us;
+	AsyncClient* client;
+	bool paused;
+	bool attached;
+	bool ownsUpdate;
+	ota_image_t* ota;  // Update: inflates and verifies on the way to flash
+	bool haveSha256;
+	uint8_t sha256[OTA_SHA256_SIZE]; // From the manifest
+	uint32_t imageSize;
+	upload_session_t* next; // Sessions that can be paused
+#if UPLOAD_WRITE_BEHIND
+	SemaphoreHandle_t done; // Given once the commit job ran
+#endif
+};
+
+static uint32_t nextId = 0;
+static uint32_t started = 0;
+static uint32_t committed = 0;
+static uint32_t failed = 0;
+static uint64_t committedBytes = 0;
+static uint32_t lastKbps = 0;
+static uint32_t maxWriteUs = 0;
+static uint8_t activeSessions = 0;
+static bool updateActive = false;
+static upload_commit_callback_t commitCallback = nullptr;
+
+static void runJob(const upload_job_t* job);
+
+#if UPLOAD_WRITE_BEHIND
+// Every session holds one block while receiving; beyond this many the pool
+// could stay at the pause level with nothing queued to free a block
+#define UPLOAD_MAX_SESSIONS (UPLOAD_POOL_BLOCKS - UPLOAD_PAUSE_BLOCKS - 1)
+
+static QueueHandle_t jobQueue = nullptr;
+static QueueHandle_t freeBlocks = nullptr;
+static SemaphoreHandle_t flowLock = nullptr; // Session list, pause state, counters
+static upload_session_t* flowList = nullptr;
+static uint32_t pauses = 0;
+static uint32_t stalls = 0;
+static const upload_status_t noBlock = UPLOAD_OVERRUN;
+
+static void storageTask(void* param) {
+    upload_job_t job;
+    for (;;) {
+        if (xQueueReceive(jobQueue, &job, portMAX_DELAY) == pdTRUE) {
+            runJob(&job);
+        }
+    }
+}
+
+// Never waits: with the pool empty despite the pause (more data arrived
+// than the reserve holds) the caller fails the upload
+static uint8_t* takeBlock() {
+    uint8_t* block = nullptr;
+    if (xQueueReceive(freeBlocks, &block, 0) != pdTRUE) {
+        stalls++;
+    }
+    return block;
+}
+
+// Reopen the receive windows once the storage task has caught up. ack()
+// posts to the tcpip thread like the stack's own acknowledgements
+static void releaseBlock(uint8_t* block) {
+    xQueueSend(freeBlocks, &block, 0);
+    xSemaphoreTake(flowLock, portMAX_DELAY);
+    if (uxQueueMessagesWaiting(freeBlocks) > UPLOAD_PAUSE_BLOCKS) {
+        for (upload_session_t* s = flowList; s; s = s->next) {
+            if (s->paused) {
+                s->paused = false;
+                s->client->ack((size_t)-1);
+            }
+        }
+    }
+    xSemaphoreGive(flowLock);
+}
+
+static void submit(const upload_job_t* job) {
+    xQueueSend(jobQueue, job, portMAX_DELAY);
+}
+
+// Runs in the receive callback: stop reopening the window while the pool is
+// low. ackLater() holds back the window update for the chunk being
+// delivered (and, in AsyncTCP, for every later one); whatever is held is
+// released here on the next chunk or by releaseBlock()
+static void throttle(upload_session_t* session) {
+    xSemaphoreTake(flowLock, portMAX_DELAY);
+    if (session->client) {
+        if (uxQueueMessagesWaiting(freeBlocks) <= UPLOAD_PAUSE_BLOCKS) {
+            if (!session->paused) {
+                session->paused = true;
+                session->pauses++;
+                pauses++;
+            }
+            session->client->ackLater();
+        } else {
+            session->client->ack((size_t)-1);
+        }
+    }
+    xSemaphoreGive(flowLock);
+}
+
+static bool attach(upload_session_t* session, AsyncClient* client) {
+    xSemaphoreTake(flowLock, portMAX_DELAY);
+    bool ok = activeSessions < UPLOAD_MAX_SESSIONS;
+    if (ok) {
+        activeSessions++;
+        session->attached = true;
+        session->client = client;
+        session->next = flowList;
+        flowList = session;
+    }
+    xSemaphoreGive(flowLock);
+    return ok;
+}
+
+static void detach(upload_session_t* session) {
+    xSemaphoreTake(flowLock, portMAX_DELAY);
+    for (upload_session_t** p = &flowList; *p; p = &(*p)->next) {
+        if (*p == session) {
+            *p = session->next;
+            activeSessions--;
+            break;
+        }
+    }
+    session->client = nullptr;
+    session->paused = false;
+    xSemaphoreGive(flowLock);
+}
+#else
+// Without the storage task jobs run in the caller and blocks come from the heap
+static const upload_status_t noBlock = UPLOAD_NO_MEMORY;
+
+static uint8_t* takeBlock() {
+    return (uint8_t*)malloc(UPLOAD_BLOCK_SIZE);
+}
+
+static void releaseBlock(uint8_t* block) {
+    free(block);
+}
+
+static void submit(const upload_job_t* job) {
+    runJob(job);
+}
+
+static void throttle(upload_session_t*) {}
+
+static bool attach(upload_session_t* session, AsyncClient*) {
+    activeSessions++;
+    session->attached = true;
+    return true;
+}
+
+static void detach(upload_session_t*) {
+    activeSessions--;
+}
+#endif
+
+static void fail(upload_session_t* session, upload_status_t status) {
+    if (session->status == UPLOAD_OK) {
+        session->status = status;
+        failed++;
+    }
+}
+
+#ifndef HOST_SIM
+static upload_status_t otaFailure(ota_status_t status) {
+    switch (status) {
+    case OTA_NO_MEMORY:
+        return UPLOAD_NO_MEMORY;
+    case OTA_BEGIN_FAILED:
+        return UPLOAD_OPEN_FAILED;
+    case OTA_BAD_DATA:
+        return UPLOAD_BAD_IMAGE;
+    case OTA_SIZE_MISMATCH:
+    case OTA_HASH_MISMATCH:
+        return UPLOAD_VERIFY_FAILED;
+    case OTA_WRITE_FAILED:
+        return UPLOAD_WRITE_FAILED;
+    default:
+        return UPLOAD_COMMIT_FAILED;
+    }
+}
+#endif
+
+// The jobs below run on the storage task (or inline), in submission order
+
+static void openTarget(upload_session_t* session) {
+    if (session->status != UPLOAD_OK) {
+        return;
+    }
+#ifndef HOST_SIM
+    if (session->target == UPLOAD_TARGET_UPDATE) {
+        session->ota = otaImageBegin(session->command, session->haveSha256 ? session->sha256 : nullptr,
+                                     session->imageSize);
+        if (otaImageStatus(session->ota) != OTA_OK) {
+            fail(session, otaFailure(otaImageStatus(session->ota)));
+        }
+        return;
+    }
+#endif
+    session->file = LittleFS.open(session->tmp, "w");
+    if (!session->file) {
+        ESP_LOGE(LOG_TAG_COMMON, "Upload %s: cannot create %s", session->filename.c_str(), session->tmp.c_str());
+        fail(session, UPLOAD_OPEN_FAILED);
+    }
+}
+
+static void writeTarget(upload_session_t* session, uint8_t* block, size_t len) {
+    if (session->status != UPLOAD_OK) {
+        return;
+    }
+    session->writes++;
+#ifndef HOST_SIM
+    if (session->target == UPLOAD_TARGET_UPDATE) {
+        ota_status_t status = otaImageWrite(session->ota, block, len);
+        if (status != OTA_OK) {
+            fail(session, otaFailure(status));
+        }
+        return;
+    }
+#endif
+    if (session->file.write(block, len) != len) {
+        ESP_LOGE(LOG_TAG_COMMON, "Upload %s: write failed", session->filename.c_str());
+        fail(session, UPLOAD_WRITE_FAILED);
+    }
+}
+
+static void commitTarget(upload_session_t* session) {
+    if (session->status != UPLOAD_OK) {
+        return;
+    }
+    bool ok;
+#ifndef HOST_SIM
+    if (session->target == UPLOAD_TARGET_UPDATE) {
+        ota_status_t status = otaImageFinish(session->ota);
+        if (status != OTA_OK) {
+            fail(session, otaFailure(status));
+            return;
+        }
+        ok = true;
+    } else
+#endif
+    {
+        session->file.close();
+        ok = LittleFS.rename(session->tmp, session->path);
+        if (!ok) {
+            ESP_LOGE(LOG_TAG_COMMON, "Upload %s: rename failed", session->filename.c_str());
+        }
+    }
+    if (!ok) {
+        fail(session, UPLOAD_COMMIT_FAILED);
+        return;
+    }
+    session->end_ms = millis();
+    session->committed = true;
+    ESP_LOGI(LOG_TAG_COMMON, "Upload %s committed (%u bytes, %u writes)", session->filename.c_str(), session->bytes,
+             session->writes);
+
+    upload_stats_t stats;
+    uploadStats(session, &stats);
+    committed++;
+    committedBytes += stats.bytes;
+    lastKbps = stats.kbps;
+    if (session->target == UPLOAD_TARGET_FILE && commitCallback) {
+        commitCallback(session->path.c_str(), session->filename.c_str(), session->crc);
+    }
+}
+
+static void endTarget(upload_session_t* session) {
+    if (session->file) {
+        session->file.close();
+    }
+    if (!session->committed) {
+        if (session->status == UPLOAD_OK) {
+            // Connection dropped before the last chunk
+            ESP_LOGW(LOG_TAG_COMMON, "Upload %s aborted after %u bytes", session->filename.c_str(), session->bytes);
+            failed++;
+        }
+        if (session->tmp.length()) {
+            LittleFS.remove(session->tmp);
+        }
+    }
+#ifndef HOST_SIM
+    otaImageFree(session->ota); // Aborts the update unless it finished
+#endif
+    if (session->ownsUpdate) {
+        updateActive = false;
+    }
+}
+
+static void runJob(const upload_job_t* job) {
+    upload_session_t* session = job->session;
+    switch (job->op) {
+    case UPLOAD_JOB_OPEN:
+        openTarget(session);
+        break;
+    case UPLOAD_JOB_WRITE:
+        writeTarget(session, job->block, job->len);
+        releaseBlock(job->block);
+        break;
+    case UPLOAD_JOB_COMMIT:
+        commitTarget(session);
+        session->finished = true;
+#if UPLOAD_WRITE_BEHIND
+        xSemaphoreGive(session->done);
+#endif
+        break;
+    case UPLOAD_JOB_END:
+        endTarget(session);
+#if UPLOAD_WRITE_BEHIND
+        vSemaphoreDelete(session->done);
+#endif
+        delete session;
+        break;
+    }
+}
+
+static void post(upload_session_t* session, uint8_t op, uint8_t* block = nullptr, size_t len = 0) {
+    upload_job_t job = {op, session, block, len};
+    submit(&job);
+}
+
+void uploadInit() {
+    if (!LittleFS.exists(UPLOAD_TMP_DIR)) {
+        LittleFS.mkdir(UPLOAD_TMP_DIR);
+    } else {
+        File dir = LittleFS.open(UPLOAD_TMP_DIR);
+        uint16_t removed = 0;
+        if (dir && dir.isDirectory()) {
+            for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+                String path = String(UPLOAD_TMP_DIR "/") + f.name();
+                f.close();
+                if (LittleFS.remove(path)) {
+                    removed++;
+                }
+            }
+            dir.close();
+        }
+        if (removed) {
+            ESP_LOGW(LOG_TAG_COMMON, "Removed %u interrupted upload(s)", removed);
+        }
+    }
+
+#if UPLOAD_WRITE_BEHIND
+    jobQueue = xQueueCreate(UPLOAD_QUEUE_LENGTH, sizeof(upload_job_t));
+    freeBlocks = xQueueCreate(UPLOAD_POOL_BLOCKS, sizeof(uint8_t*));
+    flowLock = xSemaphoreCreateMutex();
+    for (uint8_t i = 0; i < UPLOAD_POOL_BLOCKS; i++) {
+        uint8_t* block = (uint8_t*)malloc(UPLOAD_BLOCK_SIZE);
+        if (block) {
+            xQueueSend(freeBlocks, &block, 0);
+        }
+    }
+    xTaskCreate(storageTask, "storage", UPLOAD_TASK_STACK, nullptr, TASK_PRIO_STORAGE, nullptr);
+    ESP_LOGI(LOG_TAG_COMMON, "Storage task started (%u x %u byte blocks)", uxQueueMessagesWaiting(freeBlocks),
+             UPLOAD_BLOCK_SIZE);
+#endif
+}
+
+void uploadSetCommitCallback(upload_commit_callback_t callback) {
+    commitCallback = callback;
+}
+
+static upload_session_t* beginSession(upload_target_t target, const char* filename, AsyncClient* client) {
+    upload_session_t* session = new (std::nothrow) upload_session_t();
+    if (!session) {
+        return nullptr;
+    }
+    session->target = target;
+    session->filename = filename;
+    session->start_ms = millis();
+    started++;
+#if UPLOAD_WRITE_BEHIND
+    session->done = xSemaphoreCreateBinary();
+    if (!session->done) {
+        delete session;
+        return nullptr;
+    }
+#endif
+    if (!attach(session, client)) {
+        fail(session, UPLOAD_BUSY);
+        return session;
+    }
+    session->block = takeBlock();
+    if (!session->block) {
+        fail(session, noBlock);
+    }
+    return session;
+}
+
+upload_session_t* uploadBegin(const char* dir, const char* filename, size_t expected, AsyncClient* client) {
+    upload_session_t* session = beginSession(UPLOAD_TARGET_FILE, filename, client);
+    if (!session || session->status != UPLOAD_OK) {
+        return session;
+    }
+    session->path = String(dir) + "/" + filename;
+
+    size_t total = LittleFS.totalBytes();
+    size_t used = LittleFS.usedBytes();
+    size_t available = total > used ? total - used : 0;
+    if (expected && expected + UPLOAD_SPACE_MARGIN > available) {
+        ESP_LOGW(LOG_TAG_COMMON, "Upload %s: %u bytes do not fit (%u free)", filename, expected, available);
+        fail(session, UPLOAD_NO_SPACE);
+        return session;
+    }
+
+    char name[24];
+    snprintf(name, sizeof(name), UPLOAD_TMP_DIR "/%08x.tmp", (unsigned)nextId++);
+    session->tmp = name;
+    post(session, UPLOAD_JOB_OPEN);
+    return session;
+}
+
+#ifndef HOST_SIM
+upload_session_t* uploadBeginUpdate(int command, AsyncClient* client, const uint8_t* sha256, uint32_t imageSize) {
+    upload_session_t* session = beginSession(UPLOAD_TARGET_UPDATE, command == U_FLASH ? "firmware" : "filesystem",
+                                             client);
+    if (!session || session->status != UPLOAD_OK) {
+        return session;
+    }
+    // Only reached on async_tcp, so the flag needs no lock; the storage task
+    // clears it when the session ends
+    if (updateActive) {
+        fail(session, UPLOAD_BUSY);
+        return session;
+    }
+    updateActive = true;
+    session->ownsUpdate = true;
+    session->command = command;
+    session->imageSize = imageSize;
+    if (sha256) {
+        memcpy(session->sha256, sha256, OTA_SHA256_SIZE);
+        session->haveSha256 = true;
+    }
+    post(session, UPLOAD_JOB_OPEN);
+    return session;
+}
+#endif
+
+bool uploadWrite(upload_session_t* session, const uint8_t* data, size_t len) {
+    if (!session || session->status != UPLOAD_OK || session->commitQueued) {
+        return false;
+    }
+    int64_t start = esp_timer_get_time();
+    session->crc = imageCatalogCrc32(session->crc, data, len);
+    session->bytes += len;
+    while (len) {
+        size_t n = UPLOAD_BLOCK_SIZE - session->fill;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(session->block + session->fill, data, n);
+        session->fill += n;
+        data += n;
+        len -= n;
+        if (session->fill == UPLOAD_BLOCK_SIZE) {
+            post(session, UPLOAD_JOB_WRITE, session->block, UPLOAD_BLOCK_SIZE);
+            session->fill = 0;
+            session->block = takeBlock();
+            if (!session->block) {
+                ESP_LOGW(LOG_TAG_COMMON, "Upload %s: no free block, dropped", session->filename.c_str());
+                fail(session, noBlock);
+                return false;
+            }
+        }
+    }
+    throttle(session);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    session->max_write_us = max(session->max_write_us, us);
+    maxWriteUs = max(maxWriteUs, us);
+    return session->status == UPLOAD_OK;
+}
+
+bool uploadCommit(upload_session_t* session) {
+    if (!session || session->status != UPLOAD_OK) {
+        return false;
+    }
+    if (session->commitQueued) {
+        return true;
+    }
+    session->commitQueued = true;
+    if (session->fill) {
+        post(session, UPLOAD_JOB_WRITE, session->block, session->fill);
+    } else {
+        releaseBlock(session->block);
+    }
+    session->block = nullptr;
+    session->fill = 0;
+    post(session, UPLOAD_JOB_COMMIT);
+    return session->status == UPLOAD_OK;
+}
+
+bool uploadDone(const upload_session_t* session) {
+    if (!session) {
+        return true;
+    }
+    return session->commitQueued ? session->finished : session->status != UPLOAD_OK;
+}
+
+bool uploadWait(upload_session_t* session, uint32_t timeoutMs) {
+    if (!session || !session->commitQueued) {
+        return false;
+    }
+#if UPLOAD_WRITE_BEHIND
+    if (!session->waited) {
+        if (xSemaphoreTake(session->done, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) {
+            return false;
+        }
+        session->waited = true;
+    }
+#else
+    (void)timeoutMs; // Committed inline before this is called
+#endif
+    return session->committed;
+}
+
+void uploadEnd(upload_session_t* session) {
+    if (!session) {
+        return;
+    }
+    if (session->attached) {
+        detach(session);
+    }
+    if (session->block) {
+        releaseBlock(session->block);
+        session->block = nullptr;
+    }
+    // Behind any writes still queued for this session
+    post(session, UPLOAD_JOB_END);
+}
+
+upload_status_t uploadStatus(const upload_session_t* session) {
+    return session ? session->status : UPLOAD_NO_MEMORY;
+}
+
+const char* uploadStatusText(upload_status_t status) {
+    switch (status) {
+    case UPLOAD_OK:
+        return "ok";
+    case UPLOAD_NO_SPACE:
+        return "not enough space";
+    case UPLOAD_NO_MEMORY:
+        return "out of memory";
+    case UPLOAD_BUSY:
+        return "too many uploads";
+    case UPLOAD_OPEN_FAILED:
+        return "cannot create file";
+    case UPLOAD_WRITE_FAILED:
+        return "write failed";
+    case UPLOAD_COMMIT_FAILED:
+        return "commit failed";
+    case UPLOAD_BAD_IMAGE:
+        return "corrupt compressed image";
+    case UPLOAD_VERIFY_FAILED:
+        return "image does not match the manifest";
+    case UPLOAD_OVERRUN:
+        return "receive buffers full";
+    }
+    return "unknown";
+}
+
+const char* uploadFilename(const upload_session_t* session) {
+    return session->filename.c_str();
+}
+
+void uploadStats(const upload_session_t* session, upload_stats_t* out) {
+    uint32_t end = session->committed ? session->end_ms : millis();
+    out->bytes = session->bytes;
+    out->crc = session->crc;
+    out->writes = session->writes;
+    out->elapsed_ms = end - session->start_ms;
+    out->kbps = out->elapsed_ms ? (uint32_t)((uint64_t)session->bytes * 1000 / 1024 / out->elapsed_ms) : 0;
+    out->pauses = session->pauses;
+    out->max_write_us = session->max_write_us;
+}
+
+void uploadWriteMetrics(Print& out) {
+    out.printf("upload_started_total %u\n", started);
+    out.printf("upload_committed_total %u\n", committed);
+    out.printf("upload_failed_total %u\n", failed);
+    out.printf("upload_committed_bytes_total %llu\n", (unsigned long long)committedBytes);
+    out.printf("upload_last_kbps %u\n", lastKbps);
+    out.printf("upload_write_behind %u\n", UPLOAD_WRITE_BEHIND);
+    out.printf("upload_callback_max_us %u\n", maxWriteUs);
+    out.printf("upload_active_sessions %u\n", activeSessions);
+#if UPLOAD_WRITE_BEHIND
+    out.printf("upload_pool_free_blocks %u\n", uxQueueMessagesWaiting(freeBlocks));
+    out.printf("upload_pauses_total %u\n", pauses);
+    out.printf("upload_stalls_total %u\n", stalls);
+#endif
+}
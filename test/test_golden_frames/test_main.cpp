@@ -0,0 +1,220 @@
+// Golden frames: what the simulated panel shows for the splash screen, the
+// QR screen and the benchmark corpus cards (bench/corpus), against values
+// checked in here. A drawing change that alters any of them fails the test;
+// when the change is intended, the new hash is in the failure message (or
+// in frame_hash of the native program: --fs bench/corpus splash, image
+// bench/NAME).
+//
+//   Exact frames   splash and every PNG card, as FNV-1a over the visible
+//                  frame (simPanelVisibleHash)
+//   QR screen      exact outside the two symbols; inside them only what the
+//                  QR standard fixes (finder patterns, black/white modules),
+//                  so a QRCode library update needs no new golden
+//   JPEG cards     against the lossless card_rgb.png frame, within a mean
+//                  and a worst-tile error, so small IDCT differences pass
+
+#include <unity.h>
+#include <Adafruit_ILI9341.h>
+#include <string>
+#include "LittleFS.h"
+#include "sim_panel.h"
+#include "image_display.h"
+#include "image_catalog.h"
+#include "display_cache.h"
+#include "splash_screen.h"
+#include "tft_blit.h"
+
+extern Adafruit_ILI9341 tft;
+
+typedef struct
+{
+	const char* name;
+	uint32_t hash;
+} golden_t;
+
+static const uint32_t SPLASH_HASH = 0x4db07f39;
+static const uint32_t QR_SURROUND_HASH = 0x04c6aacd;
+
+static const golden_t pngCards[] = {
+    {"card_rgb.png", 0x912aaf80},
+    {"card_rgba.png", 0x94c0a1b5},
+    {"card_palette.png", 0x6080fc87},
+    {"card_pal4.png", 0x69031f47},
+    {"card_gray.png", 0x2f468592},
+};
+
+// Mean absolute error per channel (0..255) over the frame, and the worst
+// 16x16 tile; q50 is the loosest of the corpus
+static const char* const jpegCards[] = {"card_q50.jpg", "card_q75.jpg", "card_q90.jpg"};
+#define JPEG_MEAN_ERROR_MAX 6.0
+#define JPEG_TILE_ERROR_MAX 20.0
+
+// showQRCodes(): version 3 symbols (29 modules) at scale 3 behind a
+// 4-module quiet zone
+#define QR_MODULES 29
+#define QR_SCALE 3
+#define QR_TOP (110 + 4 * QR_SCALE)
+static const int16_t qrLeft[] = {2 + 4 * QR_SCALE, 127 + 4 * QR_SCALE};
+
+static uint16_t reference[SIM_PANEL_WIDTH * SIM_PANEL_HEIGHT];
+
+static std::string corpusRoot() {
+    std::string file = __FILE__;
+    return file.substr(0, file.find_last_of('/') + 1) + "../../bench/corpus";
+}
+
+void setUp(void) {
+    simPanelReset();
+    displayCacheScreenChanged();
+    displayRequestNew();
+}
+
+void tearDown(void) {}
+
+static bool inQrSymbol(int16_t x, int16_t y) {
+    for (int16_t left : qrLeft) {
+        if (x >= left && x < left + QR_MODULES * QR_SCALE && y >= QR_TOP && y < QR_TOP + QR_MODULES * QR_SCALE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// simPanelVisibleHash() with the QR symbols left out
+static uint32_t surroundHash() {
+    uint32_t h = 2166136261u;
+    for (int16_t y = 0; y < SIM_PANEL_HEIGHT; y++) {
+        for (int16_t x = 0; x < SIM_PANEL_WIDTH; x++) {
+            if (!inQrSymbol(x, y)) {
+                uint16_t c = simPanelVisiblePixel(x, y);
+                h = (h ^ (c & 0xFF)) * 16777619u;
+                h = (h ^ (c >> 8)) * 16777619u;
+            }
+        }
+    }
+    return h;
+}
+
+static void assertHash(const char* what, uint32_t expected, uint32_t actual) {
+    char message[96];
+    snprintf(message, sizeof(message), "%s frame changed, now 0x%08x", what, actual);
+    TEST_ASSERT_EQUAL_HEX32_MESSAGE(expected, actual, message);
+}
+
+static bool showCard(const char* name) {
+    std::string path = std::string("bench/") + name;
+    displayCacheInvalidate(path.c_str());
+    displayRequestNew();
+    return displayImageWithScaling(path.c_str(), true, false);
+}
+
+static void test_splash(void) {
+    showSplashScreen();
+    splashScreenProgress(100);
+    assertHash("splash", SPLASH_HASH, simPanelVisibleHash());
+}
+
+static void test_qr_screen(void) {
+    showQRCodes();
+    assertHash("QR surround", QR_SURROUND_HASH, surroundHash());
+
+    for (int16_t left : qrLeft) {
+        // Every module is one solid black or white square
+        for (int m = 0; m < QR_MODULES * QR_MODULES; m++) {
+            int16_t x0 = left + (m % QR_MODULES) * QR_SCALE;
+            int16_t y0 = QR_TOP + (m / QR_MODULES) * QR_SCALE;
+            uint16_t c = simPanelVisiblePixel(x0, y0);
+            TEST_ASSERT_TRUE(c == ILI9341_BLACK || c == ILI9341_WHITE);
+            for (int i = 1; i < QR_SCALE * QR_SCALE; i++) {
+                TEST_ASSERT_EQUAL_HEX16(c, simPanelVisiblePixel(x0 + i % QR_SCALE, y0 + i / QR_SCALE));
+            }
+        }
+        // Finder patterns in three corners: dark ring, light ring, dark 3x3
+        const int corners[3][2] = {{0, 0}, {QR_MODULES - 7, 0}, {0, QR_MODULES - 7}};
+        for (const auto& corner : corners) {
+            for (int my = 0; my < 7; my++) {
+                for (int mx = 0; mx < 7; mx++) {
+                    bool ring = mx == 0 || mx == 6 || my == 0 || my == 6;
+                    bool core = mx >= 2 && mx <= 4 && my >= 2 && my <= 4;
+                    uint16_t c = simPanelVisiblePixel(left + (corner[0] + mx) * QR_SCALE,
+                                                      QR_TOP + (corner[1] + my) * QR_SCALE);
+                    TEST_ASSERT_EQUAL_HEX16(ring || core ? ILI9341_BLACK : ILI9341_WHITE, c);
+                }
+            }
+        }
+    }
+}
+
+static void test_png_cards(void) {
+    for (const golden_t& card : pngCards) {
+        TEST_ASSERT_TRUE_MESSAGE(showCard(card.name), card.name);
+        assertHash(card.name, card.hash, simPanelVisibleHash());
+    }
+}
+
+static int channelError(uint16_t a, uint16_t b) {
+    // Channels widened to 8 bits so red/blue and green weigh the same
+    int dr = (int)((a >> 11) & 0x1F) * 255 / 31 - (int)((b >> 11) & 0x1F) * 255 / 31;
+    int dg = (int)((a >> 5) & 0x3F) * 255 / 63 - (int)((b >> 5) & 0x3F) * 255 / 63;
+    int db = (int)(a & 0x1F) * 255 / 31 - (int)(b & 0x1F) * 255 / 31;
+    return abs(dr) + abs(dg) + abs(db);
+}
+
+static void test_jpeg_cards(void) {
+    TEST_ASSERT_TRUE(showCard("card_rgb.png"));
+    for (int16_t y = 0; y < SIM_PANEL_HEIGHT; y++) {
+        for (int16_t x = 0; x < SIM_PANEL_WIDTH; x++) {
+            reference[y * SIM_PANEL_WIDTH + x] = simPanelVisiblePixel(x, y);
+        }
+    }
+
+    for (const char* name : jpegCards) {
+        setUp();
+        TEST_ASSERT_TRUE_MESSAGE(showCard(name), name);
+        uint64_t total = 0;
+        double worstTile = 0;
+        for (int16_t ty = 0; ty < SIM_PANEL_HEIGHT; ty += 16) {
+            for (int16_t tx = 0; tx < SIM_PANEL_WIDTH; tx += 16) {
+                uint32_t tile = 0;
+                for (int16_t y = ty; y < ty + 16; y++) {
+                    for (int16_t x = tx; x < tx + 16; x++) {
+                        tile += channelError(simPanelVisiblePixel(x, y), reference[y * SIM_PANEL_WIDTH + x]);
+                    }
+                }
+                total += tile;
+                double tileError = tile / (16.0 * 16 * 3);
+                if (tileError > worstTile) {
+                    worstTile = tileError;
+                }
+            }
+        }
+        double mean = total / (double)(SIM_PANEL_WIDTH * SIM_PANEL_HEIGHT * 3);
+        char message[128];
+        snprintf(message, sizeof(message), "%s: mean error %.2f, worst tile %.2f", name, mean, worstTile);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_TRUE_MESSAGE(mean <= JPEG_MEAN_ERROR_MAX, message);
+        TEST_ASSERT_TRUE_MESSAGE(worstTile <= JPEG_TILE_ERROR_MAX, message);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string root = corpusRoot();
+    LittleFS.setRoot(root.c_str());
+    if (!LittleFS.begin()) {
+        fprintf(stderr, "cannot use %s as the filesystem root\n", root.c_str());
+        return 1;
+    }
+    tft.begin(TFT_SPI_FREQ);
+    tftBlitInit();
+    tft.setRotation(0);
+    displayInit();
+    imageCatalogInit();
+    displayCacheInit();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_splash);
+    RUN_TEST(test_qr_screen);
+    RUN_TEST(test_png_cards);
+    RUN_TEST(test_jpeg_cards);
+    return UNITY_END();
+}
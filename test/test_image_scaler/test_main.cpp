@@ -0,0 +1,182 @@
+// Placement and resampling: computeImagePlacement() fitting and centring on
+// the 240x320 panel, the tjpgd reduction picked for a JPEG, and the
+// streaming resampler (image_scaler.h) on known patterns.
+
+#include <unity.h>
+#include "image_display.h"
+#include "image_scaler.h"
+
+#define MAX_ROWS 8
+
+static uint16_t out[MAX_ROWS][IMAGE_SCALER_MAX_DST];
+static uint8_t emitted[MAX_ROWS];
+
+static uint16_t be(uint16_t color) {
+    return (uint16_t)((color << 8) | (color >> 8));
+}
+
+static uint16_t* target(void* user, uint16_t dstY) {
+    emitted[dstY]++;
+    return out[dstY];
+}
+
+void setUp(void) {
+    memset(out, 0, sizeof(out));
+    memset(emitted, 0, sizeof(emitted));
+}
+
+void tearDown(void) {}
+
+static void assertPlacement(uint16_t srcW, uint16_t srcH, bool center, int16_t x, int16_t y, uint16_t w,
+                            uint16_t h) {
+    image_placement_t p;
+    computeImagePlacement(srcW, srcH, center, &p);
+    TEST_ASSERT_EQUAL_INT16(x, p.x);
+    TEST_ASSERT_EQUAL_INT16(y, p.y);
+    TEST_ASSERT_EQUAL_UINT16(w, p.width);
+    TEST_ASSERT_EQUAL_UINT16(h, p.height);
+}
+
+static void test_placement_fits_panel(void) {
+    assertPlacement(240, 320, true, 0, 0, 240, 320);
+    assertPlacement(480, 640, true, 0, 0, 240, 320);  // Same aspect, shrunk
+    assertPlacement(120, 160, true, 0, 0, 240, 320);  // Same aspect, enlarged
+}
+
+static void test_placement_centres_letterbox(void) {
+    assertPlacement(320, 240, true, 0, 70, 240, 180);   // Landscape: bars above and below
+    assertPlacement(100, 100, true, 0, 40, 240, 240);
+    assertPlacement(100, 1000, true, 104, 0, 32, 320);  // Narrow: bars left and right
+}
+
+static void test_placement_top_left_when_not_centred(void) {
+    assertPlacement(320, 240, false, 0, 0, 240, 180);
+    assertPlacement(100, 1000, false, 0, 0, 32, 320);
+}
+
+static void test_placement_never_empty(void) {
+    assertPlacement(1, 1000, true, 119, 0, 1, 320);
+    assertPlacement(1000, 1, true, 0, 159, 240, 1);
+}
+
+static void test_jpeg_scale_covers_the_fit(void) {
+    TEST_ASSERT_EQUAL_UINT8(1, scalerJpegScale(240, 320, 240, 320));
+    TEST_ASSERT_EQUAL_UINT8(2, scalerJpegScale(480, 640, 240, 320));
+    TEST_ASSERT_EQUAL_UINT8(4, scalerJpegScale(960, 1280, 240, 320));
+    TEST_ASSERT_EQUAL_UINT8(8, scalerJpegScale(1920, 2560, 240, 320));
+    TEST_ASSERT_EQUAL_UINT8(8, scalerJpegScale(4000, 6000, 213, 320)); // tjpgd stops at 1/8
+    // One pixel short of covering at 1/2: decode full size and shrink
+    TEST_ASSERT_EQUAL_UINT8(1, scalerJpegScale(479, 640, 240, 320));
+    TEST_ASSERT_EQUAL_UINT8(1, scalerJpegScale(100, 100, 240, 240)); // Enlarged
+}
+
+static void test_init_rejects_bad_sizes(void) {
+    image_scaler_t sc;
+    uint16_t prev[4];
+    TEST_ASSERT_FALSE(scalerInit(&sc, 0, 4, 2, 2, false, nullptr, target, nullptr));
+    TEST_ASSERT_FALSE(scalerInit(&sc, 4, 4, 0, 2, false, nullptr, target, nullptr));
+    TEST_ASSERT_FALSE(scalerInit(&sc, 4, 4, IMAGE_SCALER_MAX_DST + 1, 2, false, nullptr, target, nullptr));
+    TEST_ASSERT_FALSE(scalerInit(&sc, 4, 4, 2, 2, true, nullptr, target, nullptr));
+    TEST_ASSERT_TRUE(scalerInit(&sc, 4, 4, 2, 2, true, prev, target, nullptr));
+}
+
+// 4x4 source where each pixel is (y << 8) | x; nearest picks the source
+// pixel under each destination centre
+static void test_nearest_downscale(void) {
+    image_scaler_t sc;
+    TEST_ASSERT_TRUE(scalerInit(&sc, 4, 4, 2, 2, false, nullptr, target, nullptr));
+    uint16_t row[4];
+    for (uint16_t y = 0; y < 4; y++) {
+        for (uint16_t x = 0; x < 4; x++) {
+            row[x] = (uint16_t)((y << 8) | x);
+        }
+        scalerPushRow(&sc, row);
+    }
+    TEST_ASSERT_EQUAL_HEX16(0x0101, out[0][0]);
+    TEST_ASSERT_EQUAL_HEX16(0x0103, out[0][1]);
+    TEST_ASSERT_EQUAL_HEX16(0x0301, out[1][0]);
+    TEST_ASSERT_EQUAL_HEX16(0x0303, out[1][1]);
+    TEST_ASSERT_EQUAL_UINT8(1, emitted[0]);
+    TEST_ASSERT_EQUAL_UINT8(1, emitted[1]);
+}
+
+static void test_nearest_upscale_repeats_pixels(void) {
+    image_scaler_t sc;
+    TEST_ASSERT_TRUE(scalerInit(&sc, 2, 2, 4, 4, false, nullptr, target, nullptr));
+    const uint16_t top[] = {0x0A0A, 0x0B0B};
+    const uint16_t bottom[] = {0x0C0C, 0x0D0D};
+    scalerPushRow(&sc, top);
+    // The first source row already completes the top half
+    TEST_ASSERT_EQUAL_UINT8(1, emitted[1]);
+    TEST_ASSERT_EQUAL_UINT8(0, emitted[2]);
+    scalerPushRow(&sc, bottom);
+    const uint16_t row0[] = {0x0A0A, 0x0A0A, 0x0B0B, 0x0B0B};
+    const uint16_t row3[] = {0x0C0C, 0x0C0C, 0x0D0D, 0x0D0D};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(row0, out[0], 4);
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(row0, out[1], 4);
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(row3, out[2], 4);
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(row3, out[3], 4);
+}
+
+// Blue ramp 0 -> 31 over two pixels, sampled at pixel centres: the outer
+// destination pixels clamp to the ends, the inner ones get 1/4 and 3/4
+static void test_bilinear_horizontal_ramp(void) {
+    image_scaler_t sc;
+    uint16_t prev[2];
+    TEST_ASSERT_TRUE(scalerInit(&sc, 2, 1, 4, 1, true, prev, target, nullptr));
+    const uint16_t row[] = {be(0x0000), be(0x001F)};
+    scalerPushRow(&sc, row);
+    const uint16_t expected[] = {be(0x0000), be(0x0007), be(0x0017), be(0x001F)};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected, out[0], 4);
+}
+
+static void test_bilinear_vertical_ramp(void) {
+    image_scaler_t sc;
+    uint16_t prev[1];
+    TEST_ASSERT_TRUE(scalerInit(&sc, 1, 2, 1, 4, true, prev, target, nullptr));
+    const uint16_t black[] = {be(0x0000)};
+    const uint16_t red[] = {be(0xF800)};
+    scalerPushRow(&sc, black);
+    TEST_ASSERT_EQUAL_UINT8(0, emitted[0]); // Needs the row below as well
+    scalerPushRow(&sc, red);
+    const uint16_t expected[] = {be(0x0000), be(7 << 11), be(23 << 11), be(0xF800)};
+    for (int y = 0; y < 4; y++) {
+        TEST_ASSERT_EQUAL_UINT8(1, emitted[y]);
+        TEST_ASSERT_EQUAL_HEX16(expected[y], out[y][0]);
+    }
+}
+
+// A flat colour stays exactly flat through the 5-bit weights
+static void test_bilinear_flat_colour(void) {
+    image_scaler_t sc;
+    uint16_t prev[7];
+    uint16_t row[7];
+    for (int x = 0; x < 7; x++) {
+        row[x] = be(0x8410);
+    }
+    TEST_ASSERT_TRUE(scalerInit(&sc, 7, 5, 3, 2, true, prev, target, nullptr));
+    for (int y = 0; y < 5; y++) {
+        scalerPushRow(&sc, row);
+    }
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 3; x++) {
+            TEST_ASSERT_EQUAL_HEX16(be(0x8410), out[y][x]);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_placement_fits_panel);
+    RUN_TEST(test_placement_centres_letterbox);
+    RUN_TEST(test_placement_top_left_when_not_centred);
+    RUN_TEST(test_placement_never_empty);
+    RUN_TEST(test_jpeg_scale_covers_the_fit);
+    RUN_TEST(test_init_rejects_bad_sizes);
+    RUN_TEST(test_nearest_downscale);
+    RUN_TEST(test_nearest_upscale_repeats_pixels);
+    RUN_TEST(test_bilinear_horizontal_ramp);
+    RUN_TEST(test_bilinear_vertical_ramp);
+    RUN_TEST(test_bilinear_flat_colour);
+    return UNITY_END();
+}
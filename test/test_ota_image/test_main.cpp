@@ -0,0 +1,173 @@
+// OTA images: firmware.bin.gz and its manifest (tools/ota_pack.py pack of a
+// 96 KB mix of text and random bytes) go through otaImageWrite() in chunks
+// of every kind, with the inflater keeping 0 to 8 bytes after the deflate
+// stream as look-ahead, and must come out as the manifest's image. A bad
+// CRC, a short stream or bytes after the trailer fail with OTA_BAD_DATA.
+
+#include <unity.h>
+#include <Update.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "rom/miniz.h"
+#include "ota_image.h"
+
+static std::vector<uint8_t> packed;
+static uint8_t sha256[OTA_SHA256_SIZE];
+static uint32_t imageSize;
+
+static std::string fixture(const char* name) {
+    std::string path = __FILE__;
+    return path.substr(0, path.find_last_of('/') + 1) + name;
+}
+
+static std::vector<uint8_t> readFile(const char* name) {
+    std::vector<uint8_t> data;
+    FILE* f = fopen(fixture(name).c_str(), "rb");
+    if (f) {
+        uint8_t buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+            data.insert(data.end(), buf, buf + n);
+        }
+        fclose(f);
+    }
+    return data;
+}
+
+// The manifest's "sha256" and "size"
+static bool readManifest() {
+    std::vector<uint8_t> json = readFile("firmware.bin.json");
+    json.push_back(0);
+    const char* text = (const char*)json.data();
+    const char* hash = strstr(text, "\"sha256\": \"");
+    const char* size = strstr(text, "\"size\": ");
+    if (!hash || !size) {
+        return false;
+    }
+    imageSize = strtoul(size + 8, nullptr, 10);
+    std::string hex(hash + 11, OTA_SHA256_SIZE * 2);
+    return otaParseSha256(hex.c_str(), sha256);
+}
+
+// data written in pieces ending at each of splits, then finished
+static ota_status_t send(const std::vector<uint8_t>& data, const std::vector<size_t>& splits, bool verify = true) {
+    ota_image_t* ota = otaImageBegin(U_FLASH, verify ? sha256 : nullptr, verify ? imageSize : 0);
+    TEST_ASSERT_NOT_NULL(ota);
+    size_t pos = 0;
+    for (size_t end : splits) {
+        otaImageWrite(ota, data.data() + pos, end - pos);
+        pos = end;
+    }
+    otaImageWrite(ota, data.data() + pos, data.size() - pos);
+    ota_status_t status = otaImageFinish(ota);
+    ota_progress_t progress;
+    otaImageProgress(ota, &progress);
+    if (status == OTA_OK) {
+        TEST_ASSERT_EQUAL_UINT32(imageSize, Update.simSize());
+        TEST_ASSERT_EQUAL_UINT32(imageSize, progress.written);
+        TEST_ASSERT_TRUE(Update.simEnded());
+        TEST_ASSERT_EQUAL(verify, progress.verified);
+    }
+    otaImageFree(ota);
+    return status;
+}
+
+void setUp(void) {
+    simTinflSetLookahead(4);
+}
+
+void tearDown(void) {}
+
+static void test_single_write(void) {
+    TEST_ASSERT_EQUAL_INT(OTA_OK, send(packed, {}));
+}
+
+static void test_random_chunks(void) {
+    static const uint8_t lookaheads[] = {0, 1, 2, 3, 4, 8};
+    srand(24);
+    for (uint8_t lookahead : lookaheads) {
+        simTinflSetLookahead(lookahead);
+        for (int round = 0; round < 8; round++) {
+            std::vector<size_t> splits;
+            size_t pos = 0;
+            for (;;) {
+                // Mostly small pieces, now and then a TCP-segment-sized one
+                pos += (rand() % 4) ? 1 + rand() % 64 : 1 + rand() % 1460;
+                if (pos >= packed.size()) {
+                    break;
+                }
+                splits.push_back(pos);
+            }
+            char message[48];
+            snprintf(message, sizeof(message), "look-ahead %u, round %d", lookahead, round);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(OTA_OK, send(packed, splits), message);
+        }
+    }
+}
+
+// The trailer split from the deflate end at every point
+static void test_split_near_end(void) {
+    for (uint8_t lookahead = 0; lookahead <= 8; lookahead++) {
+        simTinflSetLookahead(lookahead);
+        for (size_t back = 1; back <= 24; back++) {
+            char message[48];
+            snprintf(message, sizeof(message), "look-ahead %u, split %u from the end", lookahead, (unsigned)back);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(OTA_OK, send(packed, {packed.size() - back}), message);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(OTA_OK, send(packed, {packed.size() - back, packed.size() - back + 1}),
+                                          message);
+        }
+    }
+}
+
+static void test_bad_crc(void) {
+    std::vector<uint8_t> data = packed;
+    data[data.size() - 8] ^= 0x01;
+    TEST_ASSERT_EQUAL_INT(OTA_BAD_DATA, send(data, {}, false));
+    TEST_ASSERT_EQUAL_INT(OTA_BAD_DATA, send(data, {data.size() - 3}, false));
+}
+
+static void test_truncated(void) {
+    for (size_t cut : {1, 4, 8, 9, 100}) {
+        std::vector<uint8_t> data(packed.begin(), packed.end() - cut);
+        TEST_ASSERT_EQUAL_INT(OTA_BAD_DATA, send(data, {}, false));
+    }
+}
+
+static void test_trailing_garbage(void) {
+    for (uint8_t lookahead : {0, 4}) {
+        simTinflSetLookahead(lookahead);
+        for (size_t extra : {1, 16}) {
+            std::vector<uint8_t> data = packed;
+            data.insert(data.end(), extra, 0xA5);
+            TEST_ASSERT_EQUAL_INT(OTA_BAD_DATA, send(data, {}, false));
+            TEST_ASSERT_EQUAL_INT(OTA_BAD_DATA, send(data, {packed.size()}, false));
+        }
+    }
+}
+
+// The image itself, uncompressed, goes straight through
+static void test_plain_image(void) {
+    TEST_ASSERT_EQUAL_INT(OTA_OK, send(packed, {}));
+    std::vector<uint8_t> image(Update.simData(), Update.simData() + Update.simSize());
+    TEST_ASSERT_EQUAL_INT(OTA_OK, send(image, {1, 2, 3, 4096}));
+    TEST_ASSERT_EQUAL_MEMORY(image.data(), Update.simData(), image.size());
+}
+
+int main(int argc, char** argv) {
+    packed = readFile("firmware.bin.gz");
+    if (packed.size() < 18 || !readManifest()) {
+        printf("missing or bad fixture %s\n", fixture("firmware.bin.gz").c_str());
+        return 1;
+    }
+    UNITY_BEGIN();
+    RUN_TEST(test_single_write);
+    RUN_TEST(test_random_chunks);
+    RUN_TEST(test_split_near_end);
+    RUN_TEST(test_bad_crc);
+    RUN_TEST(test_truncated);
+    RUN_TEST(test_trailing_garbage);
+    RUN_TEST(test_plain_image);
+    return UNITY_END();
+}
@@ -0,0 +1,226 @@
+// PNG row conversion kernels (pixel_convert.h): every colour type and bit
+// depth the decoder feeds them, against hand-computed RGB565. Kernels emit
+// panel (big-endian) order, so expected values go through be().
+
+#include <unity.h>
+#include "pixel_convert.h"
+
+using pixel_convert::rgb565;
+
+static uint16_t lut[256];
+static pixel_context_t ctx;
+
+static uint16_t be(uint16_t color) {
+    return (uint16_t)((color << 8) | (color >> 8));
+}
+
+void setUp(void) {
+    memset(lut, 0, sizeof(lut));
+    ctx.lut = lut;
+    pixelSetBackground(&ctx, 0x0000);
+}
+
+void tearDown(void) {}
+
+static void test_rgb565_packing(void) {
+    TEST_ASSERT_EQUAL_HEX16(0xF800, rgb565(255, 0, 0));
+    TEST_ASSERT_EQUAL_HEX16(0x07E0, rgb565(0, 255, 0));
+    TEST_ASSERT_EQUAL_HEX16(0x001F, rgb565(0, 0, 255));
+    TEST_ASSERT_EQUAL_HEX16(0x8410, rgb565(128, 128, 128));
+}
+
+static void test_blend_endpoints(void) {
+    TEST_ASSERT_EQUAL_UINT8(200, pixel_convert::blend(200, 255, 17));
+    TEST_ASSERT_EQUAL_UINT8(17, pixel_convert::blend(200, 0, 17));
+    TEST_ASSERT_EQUAL_UINT8(128, pixel_convert::blend(255, 128, 0));
+}
+
+static void test_background_from_rgb565(void) {
+    pixelSetBackground(&ctx, 0xFFFF);
+    TEST_ASSERT_EQUAL_UINT8(255, ctx.bg_r);
+    TEST_ASSERT_EQUAL_UINT8(255, ctx.bg_g);
+    TEST_ASSERT_EQUAL_UINT8(255, ctx.bg_b);
+    pixelSetBackground(&ctx, 0x001F);
+    TEST_ASSERT_EQUAL_UINT8(0, ctx.bg_r);
+    TEST_ASSERT_EQUAL_UINT8(0, ctx.bg_g);
+    TEST_ASSERT_EQUAL_UINT8(255, ctx.bg_b);
+}
+
+// PLTE plus tRNS: opaque, fully transparent and half transparent entries
+static void test_palette_with_trns(void) {
+    uint8_t palette[768 + 256];
+    memset(palette, 0, sizeof(palette));
+    memset(palette + 768, 255, 256);
+    palette[0] = 255;                           // 0: opaque red
+    palette[4] = 255;                           // 1: green, alpha 0
+    palette[768 + 1] = 0;
+    memset(palette + 6, 255, 3);                // 2: white, alpha 128
+    palette[768 + 2] = 128;
+
+    pixelBuildPaletteLut(lut, palette, true, &ctx);
+    TEST_ASSERT_EQUAL_HEX16(be(0xF800), lut[0]);
+    TEST_ASSERT_EQUAL_HEX16(be(0x0000), lut[1]);
+    TEST_ASSERT_EQUAL_HEX16(be(0x8410), lut[2]);
+
+    // Transparent entries take the background
+    pixelSetBackground(&ctx, 0xFFFF);
+    pixelBuildPaletteLut(lut, palette, true, &ctx);
+    TEST_ASSERT_EQUAL_HEX16(be(0xFFFF), lut[1]);
+    TEST_ASSERT_EQUAL_HEX16(be(0xF800), lut[0]);
+
+    // Without tRNS the alpha bytes are not read
+    pixelBuildPaletteLut(lut, palette, false, &ctx);
+    TEST_ASSERT_EQUAL_HEX16(be(0x07E0), lut[1]);
+}
+
+static void test_indexed_8bit_rows(void) {
+    for (int i = 0; i < 256; i++) {
+        lut[i] = (uint16_t)(i * 257);
+    }
+    // Five pixels: one 32-bit group plus a tail
+    const uint8_t src[] = {0, 1, 2, 200, 255};
+    uint16_t dst[5];
+    pixelSelectRowKernel(PIXEL_TYPE_INDEXED, 8)(src, dst, 5, &ctx);
+    const uint16_t expected[] = {0, 257, 514, 200 * 257, 0xFFFF};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected, dst, 5);
+}
+
+static void test_indexed_sub_byte_rows(void) {
+    for (int i = 0; i < 16; i++) {
+        lut[i] = (uint16_t)(0x100 + i);
+    }
+    uint16_t dst[6];
+    const uint8_t two[] = {0x1B, 0xC0}; // 0 1 2 3 | 3 0
+    pixelSelectRowKernel(PIXEL_TYPE_INDEXED, 2)(two, dst, 6, &ctx);
+    const uint16_t expected2[] = {0x100, 0x101, 0x102, 0x103, 0x103, 0x100};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected2, dst, 6);
+
+    const uint8_t four[] = {0xF1, 0x70}; // 15 1 | 7
+    pixelSelectRowKernel(PIXEL_TYPE_INDEXED, 4)(four, dst, 3, &ctx);
+    const uint16_t expected4[] = {0x10F, 0x101, 0x107};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected4, dst, 3);
+}
+
+static void test_gray_1bit(void) {
+    pixelBuildGrayLut(lut, 1);
+    TEST_ASSERT_EQUAL_HEX16(be(0x0000), lut[0]);
+    TEST_ASSERT_EQUAL_HEX16(be(0xFFFF), lut[1]);
+
+    // A whole byte, then a partial one read MSB first
+    const uint8_t src[] = {0xFF, 0x40};
+    uint16_t dst[10];
+    pixelSelectRowKernel(PIXEL_TYPE_GRAYSCALE, 1)(src, dst, 10, &ctx);
+    for (int x = 0; x < 8; x++) {
+        TEST_ASSERT_EQUAL_HEX16(be(0xFFFF), dst[x]);
+    }
+    TEST_ASSERT_EQUAL_HEX16(be(0x0000), dst[8]);
+    TEST_ASSERT_EQUAL_HEX16(be(0xFFFF), dst[9]);
+}
+
+static void test_gray_2bit(void) {
+    pixelBuildGrayLut(lut, 2);
+    const uint8_t src[] = {0x1B}; // 0 1 2 3
+    uint16_t dst[4];
+    pixelSelectRowKernel(PIXEL_TYPE_GRAYSCALE, 2)(src, dst, 4, &ctx);
+    const uint16_t expected[] = {be(rgb565(0, 0, 0)), be(rgb565(85, 85, 85)), be(rgb565(170, 170, 170)),
+                                 be(rgb565(255, 255, 255))};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected, dst, 4);
+    TEST_ASSERT_EQUAL_HEX16(be(0x52AA), dst[1]);
+}
+
+static void test_gray_4bit(void) {
+    pixelBuildGrayLut(lut, 4);
+    const uint8_t src[] = {0xF0, 0x50}; // 15 0 5
+    uint16_t dst[3];
+    pixelSelectRowKernel(PIXEL_TYPE_GRAYSCALE, 4)(src, dst, 3, &ctx);
+    const uint16_t expected[] = {be(0xFFFF), be(0x0000), be(rgb565(85, 85, 85))};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected, dst, 3);
+}
+
+// 16-bit samples: only the high byte counts
+static void test_gray_16bit(void) {
+    pixelBuildGrayLut(lut, 16);
+    const uint8_t src[] = {0x80, 0xFF, 0xFF, 0x00, 0x00, 0xFF};
+    uint16_t dst[3];
+    pixelSelectRowKernel(PIXEL_TYPE_GRAYSCALE, 16)(src, dst, 3, &ctx);
+    const uint16_t expected[] = {be(0x8410), be(0xFFFF), be(0x0000)};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected, dst, 3);
+}
+
+static void test_rgb8_rows(void) {
+    // Five pixels: the four-pixel fast path plus one through the generic tail
+    const uint8_t src[] = {255, 0, 0, 0, 255, 0, 0, 0, 255, 128, 128, 128, 255, 255, 255};
+    uint16_t dst[5];
+    pixelSelectRowKernel(PIXEL_TYPE_TRUECOLOR, 8)(src, dst, 5, &ctx);
+    const uint16_t expected[] = {be(0xF800), be(0x07E0), be(0x001F), be(0x8410), be(0xFFFF)};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected, dst, 5);
+}
+
+static void test_rgb16_rows(void) {
+    // Low bytes are noise the kernel must ignore; odd width takes the tail
+    const uint8_t src[] = {0xFF, 0x12, 0x00, 0x34, 0x00, 0x56,
+                           0x00, 0xFF, 0xFF, 0xFF, 0x00, 0xFF,
+                           0x80, 0x00, 0x80, 0x00, 0x80, 0x00};
+    uint16_t dst[3];
+    pixelSelectRowKernel(PIXEL_TYPE_TRUECOLOR, 16)(src, dst, 3, &ctx);
+    const uint16_t expected[] = {be(0xF800), be(0x07E0), be(0x8410)};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected, dst, 3);
+}
+
+static void test_rgba_blends_against_background(void) {
+    const uint8_t src[] = {255, 0, 0, 255,     // opaque red
+                           0, 0, 255, 0,       // transparent blue
+                           255, 255, 255, 128}; // half white
+    uint16_t dst[3];
+    pixel_row_kernel_t kernel = pixelSelectRowKernel(PIXEL_TYPE_TRUECOLOR_ALPHA, 8);
+
+    kernel(src, dst, 3, &ctx);
+    const uint16_t onBlack[] = {be(0xF800), be(0x0000), be(0x8410)};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(onBlack, dst, 3);
+
+    pixelSetBackground(&ctx, 0x07E0);
+    kernel(src, dst, 3, &ctx);
+    const uint16_t onGreen[] = {be(0xF800), be(0x07E0), be(rgb565(128, 255, 128))};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(onGreen, dst, 3);
+}
+
+static void test_gray_alpha_rows(void) {
+    const uint8_t src8[] = {255, 255, 255, 0};
+    uint16_t dst[2];
+    pixelSetBackground(&ctx, 0x001F);
+    pixelSelectRowKernel(PIXEL_TYPE_GRAY_ALPHA, 8)(src8, dst, 2, &ctx);
+    TEST_ASSERT_EQUAL_HEX16(be(0xFFFF), dst[0]);
+    TEST_ASSERT_EQUAL_HEX16(be(0x001F), dst[1]);
+
+    const uint8_t src16[] = {0xFF, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0x00, 0xFF};
+    pixelSelectRowKernel(PIXEL_TYPE_GRAY_ALPHA, 16)(src16, dst, 2, &ctx);
+    TEST_ASSERT_EQUAL_HEX16(be(0xFFFF), dst[0]);
+    TEST_ASSERT_EQUAL_HEX16(be(0x001F), dst[1]);
+}
+
+static void test_unsupported_formats(void) {
+    TEST_ASSERT_NULL(pixelSelectRowKernel(PIXEL_TYPE_INDEXED, 16));
+    TEST_ASSERT_NULL(pixelSelectRowKernel(PIXEL_TYPE_TRUECOLOR, 4));
+    TEST_ASSERT_NULL(pixelSelectRowKernel(PIXEL_TYPE_GRAYSCALE, 3));
+    TEST_ASSERT_NULL(pixelSelectRowKernel(5, 8));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rgb565_packing);
+    RUN_TEST(test_blend_endpoints);
+    RUN_TEST(test_background_from_rgb565);
+    RUN_TEST(test_palette_with_trns);
+    RUN_TEST(test_indexed_8bit_rows);
+    RUN_TEST(test_indexed_sub_byte_rows);
+    RUN_TEST(test_gray_1bit);
+    RUN_TEST(test_gray_2bit);
+    RUN_TEST(test_gray_4bit);
+    RUN_TEST(test_gray_16bit);
+    RUN_TEST(test_rgb8_rows);
+    RUN_TEST(test_rgb16_rows);
+    RUN_TEST(test_rgba_blends_against_background);
+    RUN_TEST(test_gray_alpha_rows);
+    RUN_TEST(test_unsupported_formats);
+    return UNITY_END();
+}
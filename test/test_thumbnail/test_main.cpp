@@ -0,0 +1,86 @@
+// Gallery thumbnails: thumbnailGenerate() on corpus cards (bench/corpus)
+// writes a PNG that a decoder reads back as exactly the pixels
+// displayRenderThumbnail() produced, and that is smaller than the
+// uncompressed 16-bit image.
+
+#include <unity.h>
+#include <PNGdec.h>
+#include <string>
+#include "LittleFS.h"
+#include "image_display.h"
+#include "image_catalog.h"
+#include "thumbnail.h"
+
+#define THUMB_PIXELS (THUMB_WIDTH * THUMB_HEIGHT)
+
+// At most this share of the RGB565 pixel data; q50 is the largest card
+#define THUMB_MAX_BYTES (THUMB_PIXELS * 2 * 6 / 10)
+
+static const char* const cards[] = {"card_rgb.png", "card_pal4.png", "card_gray.png", "card_q50.jpg",
+                                    "card_q75.jpg", "card_q90.jpg"};
+
+static PNG png;
+static uint16_t expected[THUMB_PIXELS];
+static uint16_t decoded[THUMB_PIXELS];
+static uint8_t file[THUMB_PIXELS * 4];
+
+static std::string corpusRoot() {
+    std::string path = __FILE__;
+    return path.substr(0, path.find_last_of('/') + 1) + "../../bench/corpus";
+}
+
+static int drawRow(PNGDRAW* draw) {
+    png.getLineAsRGB565(draw, decoded + draw->y * THUMB_WIDTH, PNG_RGB565_LITTLE_ENDIAN, 0);
+    return 1;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static void test_round_trip(void) {
+    for (const char* card : cards) {
+        std::string name = std::string("bench/") + card;
+        TEST_ASSERT_TRUE_MESSAGE(displayRenderThumbnail(name.c_str(), expected, THUMB_WIDTH, THUMB_HEIGHT), card);
+        TEST_ASSERT_TRUE_MESSAGE(thumbnailGenerate(name.c_str()), card);
+
+        File thumb = LittleFS.open(thumbnailPath(name.c_str()), "r");
+        TEST_ASSERT_TRUE_MESSAGE((bool)thumb, card);
+        size_t size = thumb.read(file, sizeof(file));
+        thumb.close();
+        thumbnailRemove(name.c_str());
+        char message[96];
+        snprintf(message, sizeof(message), "%s: %u bytes", card, (unsigned)size);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_TRUE_MESSAGE(size > 0 && size <= THUMB_MAX_BYTES, message);
+
+        memset(decoded, 0, sizeof(decoded));
+        TEST_ASSERT_EQUAL_INT_MESSAGE(PNG_SUCCESS, png.openRAM(file, size, drawRow), card);
+        TEST_ASSERT_EQUAL_INT(THUMB_WIDTH, png.getWidth());
+        TEST_ASSERT_EQUAL_INT(THUMB_HEIGHT, png.getHeight());
+        TEST_ASSERT_EQUAL_INT_MESSAGE(PNG_SUCCESS, png.decode(nullptr, 0), card);
+        png.close();
+        // Panel order is big-endian; RGB565 -> RGB888 -> RGB565 is lossless
+        for (uint32_t i = 0; i < THUMB_PIXELS; i++) {
+            expected[i] = __builtin_bswap16(expected[i]);
+        }
+        TEST_ASSERT_EQUAL_HEX16_ARRAY_MESSAGE(expected, decoded, THUMB_PIXELS, card);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string root = corpusRoot();
+    LittleFS.setRoot(root.c_str());
+    if (!LittleFS.begin()) {
+        fprintf(stderr, "cannot use %s as the filesystem root\n", root.c_str());
+        return 1;
+    }
+    displayInit();
+    imageCatalogInit();
+    thumbnailInit();
+    LittleFS.mkdir(THUMB_DIR "/bench");
+
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    return UNITY_END();
+}
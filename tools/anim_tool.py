@@ -0,0 +1,317 @@
+#!/usr/bin/env python3
+"""Make .anim files, the device's animation container (animation.h).
+
+Plain Python 3, no packages needed. Commands:
+
+  convert IN.gif OUT.anim [--max-drop K] [--loops N]
+      Decodes the GIF (disposal and transparency included), fits it into
+      240x320 (nearest neighbour, never enlarged) and centres it. Frames
+      identical to the one before are merged into its delay. Each frame
+      after the first is stored as the rectangle that changed since the K
+      frames before it, so the player may drop up to K in a row.
+  corpus [DIR]
+      Writes the animation benchmark corpus to DIR (default
+      bench/corpus/images/bench): a small ticker, a ball bouncing over a gradient
+      and a full-screen sweep, from cheap to SPI-bound frames.
+
+Every frame picks the smallest of the raw, RLE and delta encodings.
+
+    python3 tools/anim_tool.py convert loader.gif data/images/loader.anim
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from rect_client import ENCODINGS, encode, render_text, rgb565  # noqa: E402
+
+MAGIC = b"ANIM"
+VERSION = 1
+FRAME_KEY = 0x01
+PANEL_W, PANEL_H = 240, 320
+
+
+# -------------------------------------------------------------------- GIF
+
+def lzw_decode(data, min_code_size, count):
+    clear = 1 << min_code_size
+    end = clear + 1
+    out = bytearray()
+    table = [bytes([i]) for i in range(clear)] + [b"", b""]
+    size = min_code_size + 1
+    prev = None
+    bits = nbits = 0
+    for byte in data:
+        bits |= byte << nbits
+        nbits += 8
+        while nbits >= size:
+            code = bits & ((1 << size) - 1)
+            bits >>= size
+            nbits -= size
+            if code == clear:
+                table = table[:clear + 2]
+                size = min_code_size + 1
+                prev = None
+                continue
+            if code == end:
+                return bytes(out[:count])
+            if code < len(table):
+                entry = table[code]
+                if prev is not None:
+                    table.append(prev + entry[:1])
+            elif prev is not None:
+                entry = prev + prev[:1]
+                table.append(entry)
+            else:
+                raise ValueError("bad LZW code")
+            out += entry
+            prev = entry
+            if len(table) == 1 << size and size < 12:
+                size += 1
+    return bytes(out[:count])
+
+
+def read_gif(path):
+    """Composited frames as (RGB tuples list, delay_ms), plus width, height and loop count."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:6] not in (b"GIF87a", b"GIF89a"):
+        raise ValueError("%s is not a GIF" % path)
+    width, height, packed = struct.unpack("<HHB", data[6:11])
+    pos = 13
+    global_table = None
+    if packed & 0x80:
+        n = 2 << (packed & 7)
+        global_table = [tuple(data[pos + i * 3:pos + i * 3 + 3]) for i in range(n)]
+        pos += n * 3
+
+    canvas = [(0, 0, 0)] * (width * height)
+    frames = []
+    loops = 1
+    delay, transparent, disposal = 100, None, 0
+    while pos < len(data):
+        block = data[pos]
+        pos += 1
+        if block == 0x3B:
+            break
+        if block == 0x21:
+            label = data[pos]
+            pos += 1
+            sub = []
+            while data[pos]:
+                sub.append(data[pos + 1:pos + 1 + data[pos]])
+                pos += 1 + data[pos]
+            pos += 1
+            if label == 0xF9 and sub:
+                flags, centis, index = struct.unpack("<BHB", sub[0][:4])
+                delay = centis * 10
+                disposal = (flags >> 2) & 7
+                transparent = index if flags & 1 else None
+            elif label == 0xFF and sub and sub[0][:11] in (b"NETSCAPE2.0", b"ANIMEXTS1.0") and len(sub) > 1:
+                loops = struct.unpack("<H", sub[1][1:3])[0]  # 0: forever
+            continue
+        if block != 0x2C:
+            raise ValueError("unexpected block 0x%02x" % block)
+        x, y, w, h, flags = struct.unpack("<HHHHB", data[pos:pos + 9])
+        pos += 9
+        table = global_table
+        if flags & 0x80:
+            n = 2 << (flags & 7)
+            table = [tuple(data[pos + i * 3:pos + i * 3 + 3]) for i in range(n)]
+            pos += n * 3
+        min_code_size = data[pos]
+        pos += 1
+        lzw = bytearray()
+        while data[pos]:
+            lzw += data[pos + 1:pos + 1 + data[pos]]
+            pos += 1 + data[pos]
+        pos += 1
+        indices = lzw_decode(lzw, min_code_size, w * h)
+        rows = list(range(h))
+        if flags & 0x40:
+            rows = list(range(0, h, 8)) + list(range(4, h, 8)) + list(range(2, h, 4)) + list(range(1, h, 2))
+
+        before = canvas[:]
+        for src_row, dst_row in enumerate(rows):
+            cy = y + dst_row
+            if cy >= height:
+                continue
+            for cx_off in range(w):
+                i = src_row * w + cx_off
+                if i >= len(indices):
+                    break
+                index = indices[i]
+                cx = x + cx_off
+                if index != transparent and cx < width and index < len(table):
+                    canvas[cy * width + cx] = table[index]
+        frames.append((canvas[:], delay))
+
+        # Disposal applies before the next frame is drawn
+        if disposal == 2:
+            for cy in range(y, min(y + h, height)):
+                for cx in range(x, min(x + w, width)):
+                    canvas[cy * width + cx] = (0, 0, 0)
+        elif disposal == 3:
+            canvas = before
+        delay, transparent, disposal = 100, None, 0
+    return frames, width, height, loops
+
+
+def fit(frame, width, height):
+    """Nearest-neighbour fit into the panel; returns RGB565 pixels and the new size."""
+    scale = min(1.0, PANEL_W / width, PANEL_H / height)
+    w, h = max(1, int(width * scale)), max(1, int(height * scale))
+    xs = [min(width - 1, int(x / scale)) for x in range(w)]
+    out = []
+    for y in range(h):
+        row = min(height - 1, int(y / scale)) * width
+        out += [rgb565(*frame[row + sx]) for sx in xs]
+    return out, w, h
+
+
+# -------------------------------------------------------------------- writer
+
+def changed_rect(a, b, w, h):
+    """Bounding box (x0, y0, x1, y1) of the pixels that differ, or None."""
+    rows = [y for y in range(h) if a[y * w:(y + 1) * w] != b[y * w:(y + 1) * w]]
+    if not rows:
+        return None
+    x0, x1 = w, -1
+    for y in rows:
+        ra, rb = a[y * w:(y + 1) * w], b[y * w:(y + 1) * w]
+        left = next(x for x in range(w) if ra[x] != rb[x])
+        right = next(x for x in range(w - 1, -1, -1) if ra[x] != rb[x])
+        x0, x1 = min(x0, left), max(x1, right)
+    return x0, rows[0], x1, rows[-1]
+
+
+def union(r, s):
+    if r is None:
+        return s
+    if s is None:
+        return r
+    return min(r[0], s[0]), min(r[1], s[1]), max(r[2], s[2]), max(r[3], s[3])
+
+
+def smallest(seq, x, y, w, h, pixels):
+    return min((encode(seq, x, y, w, h, pixels, e) for e in ENCODINGS.values()), key=len)
+
+
+def write_anim(path, frames, w, h, max_drop, loops):
+    """frames: list of (RGB565 pixels of w x h, delay_ms); centred on the panel."""
+    merged = []
+    for pixels, delay in frames:
+        if merged and merged[-1][0] == pixels:
+            merged[-1] = (pixels, merged[-1][1] + delay)
+        else:
+            merged.append((pixels, delay))
+
+    ox, oy = (PANEL_W - w) // 2, (PANEL_H - h) // 2
+    out = bytearray(struct.pack("<4sBBHHHHH", MAGIC, VERSION, max_drop, w, h, len(merged), loops, 0))
+    raw = 0
+    for i, (pixels, delay) in enumerate(merged):
+        if i == 0:
+            rect, flags = (0, 0, w - 1, h - 1), FRAME_KEY
+        else:
+            # Whatever the panel may still show after up to max_drop drops
+            rect, flags = None, 0
+            for back in range(1, min(i, max_drop + 1) + 1):
+                rect = union(rect, changed_rect(merged[i - back][0], pixels, w, h))
+            if rect is None:
+                rect = (0, 0, 0, 0)
+        x0, y0, x1, y1 = rect
+        rw, rh = x1 - x0 + 1, y1 - y0 + 1
+        sub = [p for y in range(y0, y1 + 1) for p in pixels[y * w + x0:y * w + x1 + 1]]
+        msg = smallest(i, ox + x0, oy + y0, rw, rh, sub)
+        out += struct.pack("<HBBI", min(delay, 0xFFFF), flags, 0, len(msg)) + msg
+        raw += rw * rh * 2
+    with open(path, "wb") as f:
+        f.write(out)
+    print("%s: %dx%d, %d frames, %d bytes (%d raw rectangle bytes, %d full frames)"
+          % (path, w, h, len(merged), len(out), raw, len(merged) * w * h * 2))
+
+
+# -------------------------------------------------------------------- corpus
+
+def ticker():
+    """Small changes: a counter in a box on a plain screen."""
+    bg = rgb565(0, 0, 48)
+    frames = []
+    for n in range(60):
+        canvas = [bg] * (PANEL_W * PANEL_H)
+        box = render_text("%04d" % n, 88, 28, 5, 0xFFFF, rgb565(0, 0, 96))
+        for y in range(28):
+            canvas[(146 + y) * PANEL_W + 76:(146 + y) * PANEL_W + 164] = box[y * 88:(y + 1) * 88]
+        frames.append((canvas, 50))
+    return frames
+
+
+def ball():
+    """Medium changes: a ball bouncing over a vertical gradient."""
+    background = [rgb565(40, 60 + y * 150 // PANEL_H, 200 - y * 150 // PANEL_H) for y in range(PANEL_H)]
+    r = 16
+    frames = []
+    x, y, dx, dy = 40, 40, 7, 11
+    for _ in range(90):
+        canvas = []
+        for row in range(PANEL_H):
+            canvas += [background[row]] * PANEL_W
+        color = rgb565(255, 200, 0)
+        for by in range(-r, r + 1):
+            for bx in range(-r, r + 1):
+                if bx * bx + by * by <= r * r:
+                    canvas[(y + by) * PANEL_W + x + bx] = color
+        frames.append((canvas, 33))
+        x, y = x + dx, y + dy
+        if not r <= x < PANEL_W - r:
+            dx, x = -dx, max(r, min(PANEL_W - r - 1, x))
+        if not r <= y < PANEL_H - r:
+            dy, y = -dy, max(r, min(PANEL_H - r - 1, y))
+    return frames
+
+
+def sweep():
+    """Every pixel changes: colour bands scrolling down the whole screen."""
+    colors = [rgb565(255, 0, 0), rgb565(255, 160, 0), rgb565(255, 255, 0), rgb565(0, 200, 0),
+              rgb565(0, 120, 255), rgb565(120, 0, 200)]
+    frames = []
+    for n in range(40):
+        canvas = []
+        for row in range(PANEL_H):
+            canvas += [colors[((row + n * 8) // 16) % len(colors)]] * PANEL_W
+        frames.append((canvas, 40))
+    return frames
+
+
+def corpus(outdir):
+    os.makedirs(outdir, exist_ok=True)
+    for name, make, max_drop in (("ticker", ticker, 2), ("ball", ball, 2), ("sweep", sweep, 2)):
+        write_anim(os.path.join(outdir, "anim_%s.anim" % name), make(), PANEL_W, PANEL_H, max_drop, 0)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    sub = parser.add_subparsers(dest="command", required=True)
+    conv = sub.add_parser("convert")
+    conv.add_argument("gif")
+    conv.add_argument("out")
+    conv.add_argument("--max-drop", type=int, default=2)
+    conv.add_argument("--loops", type=int, help="override the GIF's loop count (0: forever)")
+    corp = sub.add_parser("corpus")
+    corp.add_argument("dir", nargs="?", default=os.path.join(os.path.dirname(__file__), "..", "bench", "corpus", "images", "bench"))
+    args = parser.parse_args()
+
+    if args.command == "corpus":
+        corpus(args.dir)
+        return
+    frames, width, height, loops = read_gif(args.gif)
+    fitted = [fit(frame, width, height) for frame, _ in frames]
+    w, h = fitted[0][1], fitted[0][2]
+    write_anim(args.out, [(pixels, delay) for (pixels, _, _), (_, delay) in zip(fitted, frames)], w, h,
+               max(0, min(255, args.max_drop)), loops if args.loops is None else args.loops)
+
+
+if __name__ == "__main__":
+    main()
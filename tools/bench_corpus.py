@@ -0,0 +1,574 @@
+#!/usr/bin/env python3
+"""Generate the decoder benchmark corpus (bench/corpus/images/bench).
+
+One 240x320 business card is rendered and stored in every format the
+benchmark covers: baseline and progressive JPEG at several qualities (4:2:0)
+and RGB, RGBA, palette and grayscale PNG. Only the standard library is used,
+so the files are reproducible anywhere:
+
+    python3 tools/bench_corpus.py [output_dir]
+"""
+
+import math
+import os
+import struct
+import sys
+import zlib
+
+WIDTH = 240
+HEIGHT = 320
+
+# Classic 5x7 glyphs for ASCII 0x20-0x7E, one byte per column, LSB on top
+FONT = bytes.fromhex(
+    "0000000000" "00005f0000" "0007000700" "147f147f14" "242a7f2a12" "2313086462" "3649552250" "0005030000"
+    "001c224100" "0041221c00" "082a1c2a08" "08083e0808" "0050300000" "0808080808" "0060600000" "2010080402"
+    "3e5149453e" "00427f4000" "4261514946" "2141454b31" "1814127f10" "2745454539" "3c4a494930" "0171090503"
+    "3649494936" "064949291e" "0036360000" "0056360000" "0814224100" "1414141414" "0041221408" "0201510906"
+    "324979413e" "7e1111117e" "7f49494936" "3e41414122" "7f4141221c" "7f49494941" "7f09090101" "3e41415132"
+    "7f0808087f" "00417f4100" "2040413f01" "7f08142241" "7f40404040" "7f0204027f" "7f0408107f" "3e4141413e"
+    "7f09090906" "3e4151215e" "7f09192946" "4649494931" "01017f0101" "3f4040403f" "1f2040201f" "7f2018207f"
+    "6314081463" "0304780403" "6151494543" "007f414100" "0204081020" "0041417f00" "0402010204" "4040404040"
+    "0001020400" "2054545478" "7f48444438" "3844444420" "384444487f" "3854545418" "087e090102" "081454543c"
+    "7f08040478" "00447d4000" "2040443d00" "007f102844" "00417f4000" "7c04180478" "7c08040478" "3844444438"
+    "7c14141408" "081414187c" "7c08040408" "4854545420" "043f444020" "3c4040207c" "1c2040201c" "3c4030403c"
+    "4428102844" "0c5050503c" "4464544c44" "0008364100" "00007f0000" "0041360800" "0804081008"
+)
+
+
+# ---------------------------------------------------------------- rendering
+
+class Canvas:
+    def __init__(self, w, h):
+        self.w = w
+        self.h = h
+        self.px = [(0, 0, 0, 255)] * (w * h)
+
+    def set(self, x, y, c):
+        if 0 <= x < self.w and 0 <= y < self.h:
+            self.px[y * self.w + x] = c
+
+    def fill(self, x0, y0, w, h, c):
+        for y in range(max(0, y0), min(self.h, y0 + h)):
+            for x in range(max(0, x0), min(self.w, x0 + w)):
+                self.px[y * self.w + x] = c
+
+    def circle(self, cx, cy, r, c):
+        for y in range(cy - r, cy + r + 1):
+            for x in range(cx - r, cx + r + 1):
+                if (x - cx) ** 2 + (y - cy) ** 2 <= r * r:
+                    self.set(x, y, c)
+
+    def text(self, x, y, s, c, size=1):
+        for ch in s:
+            code = ord(ch) - 0x20
+            if 0 <= code < 95:
+                for col in range(5):
+                    bits = FONT[code * 5 + col]
+                    for row in range(8):
+                        if bits >> row & 1:
+                            self.fill(x + col * size, y + row * size, size, size, c)
+            x += 6 * size
+
+
+def render_card():
+    """Photo header, name block, contact lines, logo and a QR-like code"""
+    cv = Canvas(WIDTH, HEIGHT)
+    seed = 12345
+
+    def noise():
+        nonlocal seed
+        seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+        return (seed >> 16) % 17 - 8
+
+    for y in range(140):
+        for x in range(WIDTH):
+            horizon = 92 + 14 * math.sin(x * 0.045) + 6 * math.sin(x * 0.13 + 1.0)
+            if y < horizon:
+                t = y / horizon
+                r, g, b = 70 + 110 * t, 130 + 80 * t, 230 - 30 * t
+                d = math.hypot(x - 176, y - 40)
+                if d < 22:
+                    r, g, b = 255, 236, 150
+                elif d < 40:
+                    k = (40 - d) / 18
+                    r, g, b = r + (255 - r) * k * 0.6, g + (236 - g) * k * 0.6, b + (150 - b) * k * 0.6
+            else:
+                t = (y - horizon) / (140 - horizon + 1)
+                stripe = 12 * math.sin(x * 0.3 + y * 0.7)
+                r, g, b = 40 + 30 * t + stripe, 120 - 40 * t + stripe, 50 + 10 * t
+            n = noise()
+            cv.px[y * WIDTH + x] = (clamp(r + n), clamp(g + n), clamp(b + n), 255)
+
+    cv.fill(0, 140, WIDTH, HEIGHT - 140, (250, 250, 246, 255))
+    cv.fill(0, 140, WIDTH, 4, (230, 90, 40, 255))
+    cv.circle(204, 176, 22, (28, 60, 120, 255))
+    cv.text(192, 169, "TY", (255, 255, 255, 255), 2)
+    cv.text(12, 156, "TARO", (30, 30, 30, 255), 3)
+    cv.text(12, 182, "YAMADA", (30, 30, 30, 255), 2)
+    cv.text(12, 204, "Embedded Engineer", (90, 90, 90, 255))
+    cv.fill(12, 218, 120, 2, (230, 90, 40, 255))
+    lines = ["taro@example.com", "+81 3 1234 5678", "github.com/example", "Tokyo, Japan"]
+    for i, line in enumerate(lines):
+        cv.text(12, 228 + i * 12, line, (60, 60, 60, 255))
+
+    # Module pattern in the bottom right, sharp edges like a real QR code
+    grid = 21
+    scale = 3
+    ox, oy = WIDTH - 12 - grid * scale, HEIGHT - 12 - grid * scale
+    cv.fill(ox - 3, oy - 3, grid * scale + 6, grid * scale + 6, (255, 255, 255, 255))
+    state = 99
+    for my in range(grid):
+        for mx in range(grid):
+            finder = any(fx <= mx < fx + 7 and fy <= my < fy + 7 for fx, fy in ((0, 0), (14, 0), (0, 14)))
+            if finder:
+                ix, iy = mx % 7 if mx < 7 else (mx - 14) % 7, my % 7 if my < 7 else (my - 14) % 7
+                dark = ix in (0, 6) or iy in (0, 6) or (2 <= ix <= 4 and 2 <= iy <= 4)
+            else:
+                state = (state * 1103515245 + 12345) & 0x7FFFFFFF
+                dark = (state >> 17) & 1
+            if dark:
+                cv.fill(ox + mx * scale, oy + my * scale, scale, scale, (0, 0, 0, 255))
+    return cv
+
+
+def clamp(v):
+    return 0 if v < 0 else 255 if v > 255 else int(v + 0.5)
+
+
+# --------------------------------------------------------------------- PNG
+
+def png_chunk(kind, data):
+    body = kind + data
+    return struct.pack(">I", len(data)) + body + struct.pack(">I", zlib.crc32(body) & 0xFFFFFFFF)
+
+
+def png_filter(rows, bpp):
+    """Per-row adaptive filter choice (minimum sum of absolute differences)"""
+    out = bytearray()
+    prev = bytes(len(rows[0]))
+    for row in rows:
+        candidates = []
+        for ftype in range(5):
+            f = bytearray(len(row))
+            for i, v in enumerate(row):
+                a = row[i - bpp] if i >= bpp else 0
+                b = prev[i]
+                c = prev[i - bpp] if i >= bpp else 0
+                if ftype == 0:
+                    p = 0
+                elif ftype == 1:
+                    p = a
+                elif ftype == 2:
+                    p = b
+                elif ftype == 3:
+                    p = (a + b) >> 1
+                else:
+                    pa, pb, pc = abs(b - c), abs(a - c), abs(a + b - 2 * c)
+                    p = a if pa <= pb and pa <= pc else b if pb <= pc else c
+                f[i] = (v - p) & 0xFF
+            cost = sum(x if x < 128 else 256 - x for x in f)
+            candidates.append((cost, ftype, f))
+        _, ftype, f = min(candidates, key=lambda t: t[0])
+        out.append(ftype)
+        out += f
+        prev = row
+    return bytes(out)
+
+
+def write_png(path, rows, color_type, bit_depth, bpp, palette=None):
+    data = b"\x89PNG\r\n\x1a\n"
+    data += png_chunk(b"IHDR", struct.pack(">IIBBBBB", WIDTH, HEIGHT, bit_depth, color_type, 0, 0, 0))
+    if palette:
+        data += png_chunk(b"PLTE", b"".join(bytes(c[:3]) for c in palette))
+    data += png_chunk(b"IDAT", zlib.compress(png_filter(rows, bpp), 9))
+    data += png_chunk(b"IEND", b"")
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def pack_bits(indices, depth):
+    out = bytearray()
+    per = 8 // depth
+    for i in range(0, len(indices), per):
+        v = 0
+        for j in range(per):
+            idx = indices[i + j] if i + j < len(indices) else 0
+            v |= idx << (8 - depth * (j + 1))
+        out.append(v)
+    return bytes(out)
+
+
+def nearest(palette, c):
+    return min(range(len(palette)), key=lambda i: sum((palette[i][k] - c[k]) ** 2 for k in range(3)))
+
+
+# -------------------------------------------------------------------- JPEG
+
+ZIGZAG = [
+    0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+]
+
+# Annex K example tables, natural order
+STD_LUMA = [
+    16, 11, 10, 16, 24, 40, 51, 61, 12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56, 14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77, 24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99,
+]
+STD_CHROMA = [
+    17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+] + [99] * 32
+
+COS = [[(math.sqrt(0.125) if u == 0 else 0.5) * math.cos((2 * x + 1) * u * math.pi / 16) for x in range(8)] for u in range(8)]
+
+
+def quant_table(base, quality):
+    scale = 5000 // quality if quality < 50 else 200 - quality * 2
+    return [min(255, max(1, (q * scale + 50) // 100)) for q in base]
+
+
+def fdct_quant(block, q):
+    """8x8 level-shifted samples -> quantised coefficients in zigzag order"""
+    tmp = [[sum(COS[u][x] * block[y * 8 + x] for x in range(8)) for u in range(8)] for y in range(8)]
+    coef = [0] * 64
+    for v in range(8):
+        cv = COS[v]
+        for u in range(8):
+            s = sum(cv[y] * tmp[y][u] for y in range(8))
+            coef[v * 8 + u] = int(round(s / q[v * 8 + u]))
+    return [coef[ZIGZAG[i]] for i in range(64)]
+
+
+def planes_ycbcr(cv):
+    ys, cbs, crs = [], [], []
+    for r, g, b, _ in cv.px:
+        ys.append(0.299 * r + 0.587 * g + 0.114 * b)
+        cbs.append(128 - 0.168736 * r - 0.331264 * g + 0.5 * b)
+        crs.append(128 + 0.5 * r - 0.418688 * g - 0.081312 * b)
+    return ys, cbs, crs
+
+
+def subsample(plane, w, h):
+    out = []
+    for y in range(0, h, 2):
+        for x in range(0, w, 2):
+            i = y * w + x
+            out.append((plane[i] + plane[i + 1] + plane[i + w] + plane[i + w + 1]) / 4)
+    return out
+
+
+def blocks_of(plane, w, h, q):
+    """Component blocks in raster order"""
+    rows = []
+    for by in range(h // 8):
+        row = []
+        for bx in range(w // 8):
+            block = [plane[(by * 8 + y) * w + bx * 8 + x] - 128 for y in range(8) for x in range(8)]
+            row.append(fdct_quant(block, q))
+        rows.append(row)
+    return rows
+
+
+def category(v):
+    v = abs(v)
+    n = 0
+    while v:
+        n += 1
+        v >>= 1
+    return n
+
+
+def extra_bits(v, n):
+    return v if v >= 0 else v + (1 << n) - 1
+
+
+class Huffman:
+    """Optimal table from symbol counts, lengths limited to 16 (Annex K.2)"""
+
+    def __init__(self, freq):
+        freq = dict(freq)
+        freq[256] = 1  # Reserved so no code is all ones
+        symbols = sorted(freq)
+        size = {s: 0 for s in symbols}
+        others = {s: None for s in symbols}
+        f = dict(freq)
+        while True:
+            live = [s for s in symbols if f[s] > 0]
+            if len(live) < 2:
+                break
+            v1 = min(live, key=lambda s: (f[s], -s))
+            live.remove(v1)
+            v2 = min(live, key=lambda s: (f[s], -s))
+            f[v1] += f[v2]
+            f[v2] = 0
+            s = v1
+            size[s] += 1
+            while others[s] is not None:
+                s = others[s]
+                size[s] += 1
+            others[s] = v2
+            s = v2
+            size[s] += 1
+            while others[s] is not None:
+                s = others[s]
+                size[s] += 1
+        bits = [0] * 33
+        for s in symbols:
+            if size[s]:
+                bits[size[s]] += 1
+        for i in range(32, 16, -1):
+            while bits[i] > 0:
+                j = i - 2
+                while bits[j] == 0:
+                    j -= 1
+                bits[i] -= 2
+                bits[i - 1] += 1
+                bits[j + 1] += 2
+                bits[j] -= 1
+        i = 16
+        while bits[i] == 0:
+            i -= 1
+        bits[i] -= 1  # Drop the reserved symbol
+        order = sorted((s for s in symbols if s != 256 and size[s]), key=lambda s: (size[s], s))
+        self.bits = bits[1:17]
+        self.values = order
+        self.codes = {}
+        code = 0
+        k = 0
+        for length in range(1, 17):
+            for _ in range(self.bits[length - 1]):
+                self.codes[order[k]] = (code, length)
+                code += 1
+                k += 1
+            code <<= 1
+
+    def segment(self, cls, ident):
+        body = bytes([cls << 4 | ident]) + bytes(self.bits) + bytes(self.values)
+        return b"\xff\xc4" + struct.pack(">H", len(body) + 2) + body
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.n = 0
+
+    def put(self, value, n):
+        for i in range(n - 1, -1, -1):
+            self.acc = self.acc << 1 | (value >> i & 1)
+            self.n += 1
+            if self.n == 8:
+                self.out.append(self.acc)
+                if self.acc == 0xFF:
+                    self.out.append(0)
+                self.acc = 0
+                self.n = 0
+
+    def flush(self):
+        while self.n:
+            self.put(1, 1)
+        return bytes(self.out)
+
+
+def encode_scan(events, tables):
+    """events: (table key, symbol, extra value, extra bit count)"""
+    bw = BitWriter()
+    for key, sym, val, n in events:
+        code, length = tables[key].codes[sym]
+        bw.put(code, length)
+        if n:
+            bw.put(val, n)
+    return bw.flush()
+
+
+def build_tables(events):
+    counts = {}
+    for key, sym, _, _ in events:
+        counts.setdefault(key, {})
+        counts[key][sym] = counts[key].get(sym, 0) + 1
+    return {key: Huffman(c) for key, c in counts.items()}
+
+
+def dc_events(key, diff):
+    n = category(diff)
+    return [(key, n, extra_bits(diff, n), n)]
+
+
+def ac_events(key, coefs, ss, se):
+    """Sequential/first-pass AC symbols for one block, without the EOB"""
+    events = []
+    run = 0
+    for k in range(ss, se + 1):
+        v = coefs[k]
+        if v == 0:
+            run += 1
+            continue
+        while run > 15:
+            events.append((key, 0xF0, 0, 0))
+            run -= 16
+        n = category(v)
+        events.append((key, run << 4 | n, extra_bits(v, n), n))
+        run = 0
+    return events, run > 0
+
+
+def mcu_order(y_blocks, cb_blocks, cr_blocks):
+    """Interleaved 4:2:0 MCUs: four Y blocks then Cb and Cr"""
+    for my in range(len(cb_blocks)):
+        for mx in range(len(cb_blocks[0])):
+            for dy in range(2):
+                for dx in range(2):
+                    yield 0, y_blocks[my * 2 + dy][mx * 2 + dx]
+            yield 1, cb_blocks[my][mx]
+            yield 2, cr_blocks[my][mx]
+
+
+def sos(components, ss, se):
+    body = bytes([len(components)])
+    for cid, sel in components:
+        body += bytes([cid, sel])
+    body += bytes([ss, se, 0])
+    return b"\xff\xda" + struct.pack(">H", len(body) + 2) + body
+
+
+def write_jpeg(path, cv, quality, progressive):
+    ys, cbs, crs = planes_ycbcr(cv)
+    ql = quant_table(STD_LUMA, quality)
+    qc = quant_table(STD_CHROMA, quality)
+    y_blocks = blocks_of(ys, WIDTH, HEIGHT, ql)
+    cb_blocks = blocks_of(subsample(cbs, WIDTH, HEIGHT), WIDTH // 2, HEIGHT // 2, qc)
+    cr_blocks = blocks_of(subsample(crs, WIDTH, HEIGHT), WIDTH // 2, HEIGHT // 2, qc)
+    planes = [y_blocks, cb_blocks, cr_blocks]
+
+    out = bytearray(b"\xff\xd8")
+    out += b"\xff\xe0" + struct.pack(">H5sBBBHHBB", 16, b"JFIF", 1, 1, 0, 1, 1, 0, 0)
+    for ident, q in ((0, ql), (1, qc)):
+        out += b"\xff\xdb" + struct.pack(">HB", 67, ident) + bytes(q[ZIGZAG[i]] for i in range(64))
+    sof = struct.pack(">BHHB", 8, HEIGHT, WIDTH, 3) + bytes([1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1])
+    out += (b"\xff\xc2" if progressive else b"\xff\xc0") + struct.pack(">H", len(sof) + 2) + sof
+
+    if not progressive:
+        events = []
+        pred = [0, 0, 0]
+        for comp, block in mcu_order(*planes):
+            table = "l" if comp == 0 else "c"
+            events += dc_events("dc" + table, block[0] - pred[comp])
+            pred[comp] = block[0]
+            ac, eob = ac_events("ac" + table, block, 1, 63)
+            events += ac
+            if eob:
+                events.append(("ac" + table, 0x00, 0, 0))
+        tables = build_tables(events)
+        out += tables["dcl"].segment(0, 0) + tables["dcc"].segment(0, 1)
+        out += tables["acl"].segment(1, 0) + tables["acc"].segment(1, 1)
+        out += sos([(1, 0x00), (2, 0x11), (3, 0x11)], 0, 63)
+        out += encode_scan(events, tables)
+    else:
+        # Spectral selection only: DC of all components, then AC bands
+        events = []
+        pred = [0, 0, 0]
+        for comp, block in mcu_order(*planes):
+            table = "l" if comp == 0 else "c"
+            events += dc_events("dc" + table, block[0] - pred[comp])
+            pred[comp] = block[0]
+        tables = build_tables(events)
+        out += tables["dcl"].segment(0, 0) + tables["dcc"].segment(0, 1)
+        out += sos([(1, 0x00), (2, 0x10), (3, 0x10)], 0, 0)
+        out += encode_scan(events, tables)
+        for comp, ss, se in ((0, 1, 5), (1, 1, 63), (2, 1, 63), (0, 6, 63)):
+            events = []
+            eobrun = 0
+
+            def flush_eobrun():
+                nonlocal eobrun
+                if eobrun:
+                    n = category(eobrun) - 1
+                    events.append(("ac", n << 4, eobrun - (1 << n), n))
+                    eobrun = 0
+
+            for row in planes[comp]:
+                for block in row:
+                    ac, trailing = ac_events("ac", block, ss, se)
+                    if ac:
+                        flush_eobrun()
+                        events += ac
+                    if trailing:
+                        eobrun += 1
+                        if eobrun == 0x7FFF:
+                            flush_eobrun()
+            flush_eobrun()
+            tables = build_tables(events)
+            out += tables["ac"].segment(1, 0)
+            out += sos([(comp + 1, 0x00)], ss, se)
+            out += encode_scan(events, tables)
+    out += b"\xff\xd9"
+    with open(path, "wb") as f:
+        f.write(out)
+
+
+# -------------------------------------------------------------------- main
+
+def main():
+    outdir = sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(__file__), "..", "bench", "corpus", "images", "bench")
+    os.makedirs(outdir, exist_ok=True)
+    cv = render_card()
+
+    for quality in (50, 75, 90):
+        write_jpeg(os.path.join(outdir, "card_q%d.jpg" % quality), cv, quality, False)
+    for quality in (75, 90):
+        write_jpeg(os.path.join(outdir, "card_q%d_prog.jpg" % quality), cv, quality, True)
+
+    rgb = [bytes(v for p in cv.px[y * WIDTH:(y + 1) * WIDTH] for v in p[:3]) for y in range(HEIGHT)]
+    write_png(os.path.join(outdir, "card_rgb.png"), rgb, 2, 8, 3)
+
+    # Transparent rounded corners and a translucent band over the photo
+    rgba = []
+    for y in range(HEIGHT):
+        row = bytearray()
+        for x in range(WIDTH):
+            r, g, b, _ = cv.px[y * WIDTH + x]
+            cx = min(x, WIDTH - 1 - x)
+            cy = min(y, HEIGHT - 1 - y)
+            a = 255
+            if cx < 16 and cy < 16 and (16 - cx) ** 2 + (16 - cy) ** 2 > 256:
+                a = 0
+            elif 100 <= y < 130:
+                a = 160
+            row += bytes((r, g, b, a))
+        rgba.append(bytes(row))
+    write_png(os.path.join(outdir, "card_rgba.png"), rgba, 6, 8, 4)
+
+    # 6x7x6 colour cube, 8-bit indices
+    cube = [(r * 51, g * 42 + g // 2, b * 51) for r in range(6) for g in range(7) for b in range(6)]
+    idx = [(round(r / 51) * 7 + round(g / 42.5)) * 6 + round(b / 51) for r, g, b, _ in cv.px]
+    write_png(os.path.join(outdir, "card_palette.png"),
+              [bytes(idx[y * WIDTH:(y + 1) * WIDTH]) for y in range(HEIGHT)], 3, 8, 1, cube)
+
+    # 16 colours, 4-bit indices, as exported by logo/badge tools
+    pal16 = [(0, 0, 0), (255, 255, 255), (250, 250, 246), (30, 30, 30), (90, 90, 90), (60, 60, 60),
+             (230, 90, 40), (28, 60, 120), (255, 236, 150), (90, 160, 225), (140, 190, 215), (180, 210, 205),
+             (50, 110, 55), (70, 90, 60), (110, 130, 80), (160, 170, 150)]
+    cache = {}
+    idx16 = []
+    for p in cv.px:
+        key = p[:3]
+        if key not in cache:
+            cache[key] = nearest(pal16, key)
+        idx16.append(cache[key])
+    write_png(os.path.join(outdir, "card_pal4.png"),
+              [pack_bits(idx16[y * WIDTH:(y + 1) * WIDTH], 4) for y in range(HEIGHT)], 3, 4, 1, pal16)
+
+    gray = [bytes(clamp(0.299 * r + 0.587 * g + 0.114 * b) for r, g, b, _ in cv.px[y * WIDTH:(y + 1) * WIDTH])
+            for y in range(HEIGHT)]
+    write_png(os.path.join(outdir, "card_gray.png"), gray, 0, 8, 1)
+
+    for name in sorted(os.listdir(outdir)):
+        print("%-20s %7d" % (name, os.path.getsize(os.path.join(outdir, name))))
+
+
+if __name__ == "__main__":
+    main()
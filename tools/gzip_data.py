@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Stage data/ for the filesystem image with text assets gzipped.
+
+Run by PlatformIO before buildfs/uploadfs (extra_scripts = pre:...): data/ is
+copied to $BUILD_DIR/data, every HTML/CSS/JS/JSON/SVG/text file is replaced
+by name.gz when that is smaller, and the filesystem image is built from the
+copy. The web server sends name.gz with Content-Encoding: gzip when only the
+compressed file exists. Images are stored as they are (already compressed).
+
+With BENCH_CORPUS=1 in the environment the benchmark corpus (bench/corpus,
+laid out like the filesystem) is merged into the image as well, for a device
+that is going to run the serial "bench" commands:
+
+    BENCH_CORPUS=1 pio run -e esp32-c3-devkitm-1 -t uploadfs
+
+Standalone, for checking sizes:
+
+    python3 tools/gzip_data.py [data_dir] [output_dir]
+"""
+
+import gzip
+import os
+import shutil
+import sys
+
+COMPRESS = (".html", ".htm", ".css", ".js", ".json", ".svg", ".txt")
+
+
+def stage(src, dst, log=print, extra=None):
+    if os.path.isdir(dst):
+        shutil.rmtree(dst)
+    shutil.copytree(src, dst)
+    if extra:
+        shutil.copytree(extra, dst, dirs_exist_ok=True)
+        log("added %s" % extra)
+    before = after = 0
+    for root, _, files in os.walk(dst):
+        for name in files:
+            if not name.lower().endswith(COMPRESS):
+                continue
+            path = os.path.join(root, name)
+            with open(path, "rb") as f:
+                raw = f.read()
+            # mtime=0 keeps the output, and so its ETag, identical across builds
+            packed = gzip.compress(raw, compresslevel=9, mtime=0)
+            if len(packed) >= len(raw):
+                continue
+            with open(path + ".gz", "wb") as f:
+                f.write(packed)
+            os.remove(path)
+            before += len(raw)
+            after += len(packed)
+            log("gzip %-32s %7d -> %6d bytes" % (os.path.relpath(path, dst), len(raw), len(packed)))
+    log("gzip total %d -> %d bytes" % (before, after))
+    return before, after
+
+
+def bench_corpus(project_dir):
+    if os.environ.get("BENCH_CORPUS", "0") in ("", "0"):
+        return None
+    return os.path.join(project_dir, "bench", "corpus")
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    if any(t in ("buildfs", "uploadfs", "uploadfsota") for t in COMMAND_LINE_TARGETS):  # noqa: F821
+        staged = os.path.join(env.subst("$BUILD_DIR"), "data")
+        stage(env.subst("$PROJECT_DATA_DIR"), staged, extra=bench_corpus(env.subst("$PROJECT_DIR")))
+        env.Replace(PROJECT_DATA_DIR=staged)
+elif __name__ == "__main__":
+    here = os.path.dirname(os.path.abspath(__file__))
+    src = sys.argv[1] if len(sys.argv) > 1 else os.path.join(here, "..", "data")
+    dst = sys.argv[2] if len(sys.argv) > 2 else os.path.join(here, "..", ".pio", "data_gz")
+    stage(src, dst, extra=bench_corpus(os.path.join(here, "..")))
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Compressed, verifiable OTA images for POST /update/file (ota_image.h).
+
+Plain Python 3, no packages needed. Commands:
+
+  pack IMAGE.bin [OUT_DIR]
+      Writes IMAGE.bin.gz (gzip -9, no timestamp, so the same build packs
+      to the same bytes) and IMAGE.bin.json, the manifest: the SHA-256 and
+      size of the uncompressed image, which the device checks before it
+      marks the partition bootable. IMAGE is firmware or littlefs, as
+      PlatformIO names them (.pio/build/<env>/).
+  send IMAGE.bin[.gz] [URL] [--manifest M.json]
+      Uploads the image with its manifest (IMAGE.bin.json next to it by
+      default) and prints one JSON line: what the device reported plus the
+      client-side seconds and MB/s. Nothing reboots; use /reboot.
+
+    python3 tools/ota_pack.py pack .pio/build/esp32-c3-devkitm-1/firmware.bin
+    python3 tools/ota_pack.py send .pio/build/esp32-c3-devkitm-1/firmware.bin.gz
+"""
+
+import argparse
+import gzip
+import hashlib
+import http.client
+import json
+import os
+import sys
+import time
+import urllib.parse
+import uuid
+
+IMAGES = ("firmware.bin", "littlefs.bin")
+
+
+def pack(path, outdir):
+    name = os.path.basename(path)
+    if name not in IMAGES:
+        sys.exit("%s: the device takes %s" % (name, " or ".join(IMAGES)))
+    with open(path, "rb") as f:
+        image = f.read()
+    packed = gzip.compress(image, 9, mtime=0)
+    outdir = outdir or os.path.dirname(path)
+    with open(os.path.join(outdir, name + ".gz"), "wb") as f:
+        f.write(packed)
+    manifest = {
+        "file": name + ".gz",
+        "image": name,
+        "size": len(image),
+        "sha256": hashlib.sha256(image).hexdigest(),
+        "compressed_size": len(packed),
+    }
+    with open(os.path.join(outdir, name + ".json"), "w") as f:
+        json.dump(manifest, f, indent=2)
+        f.write("\n")
+    print("%s: %d -> %d bytes (%.1f%%), sha256 %s"
+          % (name, len(image), len(packed), 100.0 * len(packed) / len(image), manifest["sha256"]))
+
+
+def send(path, base, manifest_path):
+    name = os.path.basename(path)
+    if not manifest_path:
+        manifest_path = os.path.join(os.path.dirname(path), name[:-3] if name.endswith(".gz") else name) + ".json"
+    query = {}
+    if os.path.exists(manifest_path):
+        with open(manifest_path) as f:
+            manifest = json.load(f)
+        query = {"sha256": manifest["sha256"], "image_size": manifest["size"]}
+    else:
+        print("no manifest %s: the image is not verified" % manifest_path, file=sys.stderr)
+    with open(path, "rb") as f:
+        data = f.read()
+
+    boundary = uuid.uuid4().hex
+    body = (
+        "--%s\r\nContent-Disposition: form-data; name=\"update\"; filename=\"%s\"\r\n"
+        "Content-Type: application/octet-stream\r\n\r\n" % (boundary, name)
+    ).encode() + data + ("\r\n--%s--\r\n" % boundary).encode()
+    parsed = urllib.parse.urlparse(base)
+    conn = http.client.HTTPConnection(parsed.hostname, parsed.port or 80, timeout=120)
+    url = "/update/file" + ("?" + urllib.parse.urlencode(query) if query else "")
+    start = time.monotonic()
+    conn.request("POST", url, body, {"Content-Type": "multipart/form-data; boundary=" + boundary})
+    resp = conn.getresponse()
+    text = resp.read().decode(errors="replace")
+    seconds = time.monotonic() - start
+    conn.close()
+    try:
+        result = json.loads(text)
+    except ValueError:
+        result = {"success": False, "error": text}
+    result.update({"file": name, "status": resp.status, "bytes": len(data), "seconds": round(seconds, 2),
+                   "mb_per_s": round(len(data) / seconds / 1e6, 3)})
+    print(json.dumps(result))
+    return 0 if resp.status == 200 else 1
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("pack")
+    p.add_argument("image")
+    p.add_argument("outdir", nargs="?")
+    s = sub.add_parser("send")
+    s.add_argument("image")
+    s.add_argument("url", nargs="?", default="http://192.168.4.1")
+    s.add_argument("--manifest")
+    args = parser.parse_args()
+
+    if args.command == "pack":
+        pack(args.image, args.outdir)
+        return 0
+    return send(args.image, args.url, args.manifest)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Measure the bytes a gallery page load moves, cold and warm.
+
+Replays what the browser does for data/index.html against a running device:
+the page itself, the /images listing and one thumbnail per image. The cold
+pass starts with an empty cache; the warm pass behaves like a browser cache
+filled by the cold one (fresh immutable entries are not requested at all,
+everything with an ETag is revalidated with If-None-Match). Bytes are the
+status line, headers and body of each response as received.
+
+    python3 tools/page_load.py [http://192.168.4.1]
+
+One JSON object per request, then one summary per pass.
+"""
+
+import http.client
+import json
+import sys
+import time
+import urllib.parse
+
+
+class Cache:
+    def __init__(self):
+        self.entries = {}  # url -> (etag, immutable)
+
+    def store(self, url, headers):
+        control = headers.get("cache-control", "")
+        if "no-store" in control:
+            return
+        etag = headers.get("etag")
+        immutable = "immutable" in control or "max-age=31536000" in control
+        if etag or immutable:
+            self.entries[url] = (etag, immutable)
+
+
+def fetch(conn, url, cache, warm):
+    headers = {"Accept-Encoding": "gzip"}
+    entry = cache.entries.get(url) if warm else None
+    if entry and entry[1]:
+        return {"url": url, "status": "cache", "bytes": 0, "ms": 0}
+    if entry and entry[0]:
+        headers["If-None-Match"] = entry[0]
+
+    start = time.monotonic()
+    conn.request("GET", url, headers=headers)
+    resp = conn.getresponse()
+    body = resp.read()
+    ms = (time.monotonic() - start) * 1000
+    head = len("HTTP/1.1 %d %s\r\n" % (resp.status, resp.reason))
+    head += sum(len("%s: %s\r\n" % kv) for kv in resp.getheaders()) + 2
+    received = {k.lower(): v for k, v in resp.getheaders()}
+    if resp.status == 200:
+        cache.store(url, received)
+    return {
+        "url": url,
+        "status": resp.status,
+        "bytes": head + len(body),
+        "body": len(body),
+        "encoding": received.get("content-encoding", ""),
+        "ms": round(ms, 1),
+        "_body": body,
+    }
+
+
+def page_load(base, cache, warm):
+    parsed = urllib.parse.urlparse(base)
+    conn = http.client.HTTPConnection(parsed.hostname, parsed.port or 80, timeout=30)
+    results = [fetch(conn, "/", cache, warm)]
+    listing = fetch(conn, "/images?sort=name", cache, warm)
+    results.append(listing)
+    images = json.loads(listing["_body"]).get("images", []) if listing["status"] == 200 else []
+    for image in images:
+        name = urllib.parse.quote(image["name"])
+        results.append(fetch(conn, "/thumb/%s?v=%x" % (name, image["crc"]), cache, warm))
+    conn.close()
+    return results
+
+
+def main():
+    base = sys.argv[1] if len(sys.argv) > 1 else "http://192.168.4.1"
+    cache = Cache()
+    for label, warm in (("cold", False), ("warm", True)):
+        results = page_load(base, cache, warm)
+        for r in results:
+            r.pop("_body", None)
+            print(json.dumps(dict(r, load=label)))
+        summary = {
+            "load": label,
+            "requests": sum(1 for r in results if r["status"] != "cache"),
+            "not_modified": sum(1 for r in results if r["status"] == 304),
+            "from_cache": sum(1 for r in results if r["status"] == "cache"),
+            "bytes": sum(r["bytes"] for r in results),
+            "ms": round(sum(r["ms"] for r in results), 1),
+        }
+        print(json.dumps(summary))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+"""Reference client for the /ws partial-rectangle protocol (rect_update.h).
+
+Plain Python 3 on Linux, no packages needed. Commands:
+
+  counter [--rate HZ] [--count N]
+      Draws a running counter in a small box at the top of the panel, the
+      kind of update the protocol is meant for, at HZ updates per second.
+  bench [--width W] [--height H] [--messages N] [--window K]
+      For every encoding and three kinds of content (flat, text-like and
+      noise) sends N updates of a WxH rectangle with up to K unanswered.
+      Prints one JSON line each: messages/s, pixels/s, KB/s on the wire,
+      the compression ratio and the round-trip latency (send to the
+      device's "drawn" reply) p50/p95/max, next to the device's own time.
+
+The base URL defaults to http://192.168.4.1. With --dump FILE messages are
+written to FILE (each prefixed with its length, 32-bit little-endian)
+instead of being sent; the host simulator draws such a file with
+"rect FILE".
+
+    python3 tools/rect_client.py bench [http://192.168.4.1] [--window 4]
+"""
+
+import argparse
+import base64
+import json
+import os
+import random
+import socket
+import struct
+import time
+import urllib.parse
+
+MSG_TYPE = 0x01
+RAW, RLE, DELTA = 0, 1, 2
+ENCODINGS = {"raw": RAW, "rle": RLE, "delta": DELTA}
+PANEL_W, PANEL_H = 240, 320
+
+
+def rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def rle(pixels):
+    """Runs of 2..128 equal pixels, literals of 1..128 otherwise."""
+    out = bytearray()
+    i, n = 0, len(pixels)
+    while i < n:
+        run = 1
+        while i + run < n and run < 128 and pixels[i + run] == pixels[i]:
+            run += 1
+        if run >= 2:
+            out.append(0x80 | (run - 1))
+            out += struct.pack(">H", pixels[i])
+            i += run
+            continue
+        start = i
+        while i < n and i - start < 128 and not (i + 1 < n and pixels[i + 1] == pixels[i]):
+            i += 1
+        out.append(i - start - 1)
+        out += struct.pack(">%dH" % (i - start), *pixels[start:i])
+    return bytes(out)
+
+
+def encode(seq, x, y, w, h, pixels, encoding):
+    header = struct.pack("<BBHHHHH", MSG_TYPE, encoding, seq & 0xFFFF, x, y, w, h)
+    if encoding == RAW:
+        payload = struct.pack(">%dH" % len(pixels), *pixels)
+    elif encoding == RLE:
+        payload = rle(pixels)
+    else:
+        above = [0] * w
+        xored = []
+        for row in range(h):
+            line = pixels[row * w:(row + 1) * w]
+            xored += [p ^ a for p, a in zip(line, above)]
+            above = line
+        payload = rle(xored)
+    return header + payload
+
+
+# 3x5 digits, one row of three bits per entry
+DIGITS = ["111101101101111", "010110010010111", "111001111100111", "111001111001111", "101101111001001",
+          "111100111001111", "111100111101111", "111001001001001", "111101111101111", "111101111001111"]
+
+
+def render_text(text, w, h, scale, fg, bg):
+    """Digits in a 3x5 font scaled up, on a plain background."""
+    pixels = [bg] * (w * h)
+    for index, ch in enumerate(text):
+        glyph = DIGITS[int(ch)]
+        ox = 4 + index * 4 * scale
+        for gy in range(5):
+            for gx in range(3):
+                if glyph[gy * 3 + gx] != "1":
+                    continue
+                for dy in range(scale):
+                    for dx in range(scale):
+                        px, py = ox + gx * scale + dx, 4 + gy * scale + dy
+                        if px < w and py < h:
+                            pixels[py * w + px] = fg
+    return pixels
+
+
+def content(kind, w, h, frame):
+    if kind == "flat":
+        return [rgb565(frame * 37 % 256, 80, 160)] * (w * h)
+    if kind == "text":
+        return render_text("%06d" % frame, w, h, max(1, min((w - 8) // 24, (h - 8) // 5)), 0xFFFF, rgb565(0, 0, 96))
+    return [random.getrandbits(16) for _ in range(w * h)]
+
+
+class Socket:
+    """Just enough RFC 6455 for binary messages out and text replies back."""
+
+    def __init__(self, base, path="/ws"):
+        parsed = urllib.parse.urlparse(base)
+        self.sock = socket.create_connection((parsed.hostname, parsed.port or 80), timeout=10)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        key = base64.b64encode(os.urandom(16)).decode()
+        self.sock.sendall(("GET %s HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                           "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n"
+                           % (path, parsed.hostname, key)).encode())
+        self.buf = b""
+        while b"\r\n\r\n" not in self.buf:
+            chunk = self.sock.recv(1024)
+            if not chunk:
+                raise OSError("connection closed during handshake")
+            self.buf += chunk
+        head, self.buf = self.buf.split(b"\r\n\r\n", 1)
+        if b" 101 " not in head.split(b"\r\n")[0]:
+            raise OSError("handshake refused: %s" % head.split(b"\r\n")[0].decode(errors="replace"))
+
+    def send_binary(self, data):
+        mask = os.urandom(4)
+        n = len(data)
+        if n < 126:
+            header = struct.pack("!BB", 0x82, 0x80 | n)
+        elif n < 65536:
+            header = struct.pack("!BBH", 0x82, 0x80 | 126, n)
+        else:
+            header = struct.pack("!BBQ", 0x82, 0x80 | 127, n)
+        key = (mask * (n // 4 + 1))[:n]
+        masked = (int.from_bytes(data, "big") ^ int.from_bytes(key, "big")).to_bytes(n, "big")
+        self.sock.sendall(header + mask + masked)
+
+    def _read(self, n):
+        while len(self.buf) < n:
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise OSError("connection closed")
+            self.buf += chunk
+        data, self.buf = self.buf[:n], self.buf[n:]
+        return data
+
+    def recv_text(self):
+        while True:
+            b0, b1 = self._read(2)
+            n = b1 & 0x7F
+            if n == 126:
+                n = struct.unpack("!H", self._read(2))[0]
+            elif n == 127:
+                n = struct.unpack("!Q", self._read(8))[0]
+            payload = self._read(n)
+            opcode = b0 & 0x0F
+            if opcode == 0x1:
+                return payload.decode()
+            if opcode == 0x8:
+                raise OSError("closed by the device")
+
+    def close(self):
+        self.sock.close()
+
+
+def percentile(values, p):
+    if not values:
+        return 0
+    values = sorted(values)
+    return round(values[min(len(values) - 1, int(len(values) * p / 100))], 2)
+
+
+def run(sock, messages, window):
+    """Send with up to window unanswered; returns latencies and replies."""
+    sent = {}
+    latencies, replies = [], []
+    start = time.monotonic()
+    pending = 0
+    for seq, msg in messages:
+        while pending >= window:
+            reply = json.loads(sock.recv_text())
+            latencies.append((time.monotonic() - sent.pop(reply["seq"])) * 1000)
+            replies.append(reply)
+            pending -= 1
+        sent[seq] = time.monotonic()
+        sock.send_binary(msg)
+        pending += 1
+    while pending:
+        reply = json.loads(sock.recv_text())
+        latencies.append((time.monotonic() - sent.pop(reply["seq"])) * 1000)
+        replies.append(reply)
+        pending -= 1
+    return time.monotonic() - start, latencies, replies
+
+
+def bench(args, sock, dump):
+    x, y = (PANEL_W - args.width) // 2, 8
+    seq = 0
+    for kind in ("flat", "text", "noise"):
+        frames = [content(kind, args.width, args.height, i) for i in range(args.messages)]
+        for name, encoding in ENCODINGS.items():
+            messages = []
+            for pixels in frames:
+                messages.append((seq & 0xFFFF, encode(seq, x, y, args.width, args.height, pixels, encoding)))
+                seq += 1
+            wire = sum(len(m) for _, m in messages)
+            summary = {"content": kind, "encoding": name, "width": args.width, "height": args.height,
+                       "messages": len(messages), "bytes_per_msg": round(wire / len(messages)),
+                       "ratio": round(args.width * args.height * 2 * len(messages) / wire, 2)}
+            if dump:
+                for _, m in messages:
+                    dump.write(struct.pack("<I", len(m)) + m)
+                print(json.dumps(summary))
+                continue
+            seconds, latencies, replies = run(sock, messages, args.window)
+            ok = [r for r in replies if r["status"] == "ok"]
+            summary.update({
+                "window": args.window,
+                "failures": len(replies) - len(ok),
+                "msgs_per_s": round(len(messages) / seconds, 1),
+                "mpx_per_s": round(sum(r["px"] for r in ok) / seconds / 1e6, 3),
+                "kb_per_s": round(wire / 1024 / seconds, 1),
+                "latency_ms_p50": percentile(latencies, 50),
+                "latency_ms_p95": percentile(latencies, 95),
+                "latency_ms_max": round(max(latencies), 2),
+                "device_ms_avg": round(sum(r["us"] for r in ok) / len(ok) / 1000, 2) if ok else 0,
+            })
+            print(json.dumps(summary))
+
+
+def counter(args, sock, dump):
+    w, h = 120, 28
+    x, y = (PANEL_W - w) // 2, 8
+    interval = 1.0 / args.rate
+    latencies = []
+    next_time = time.monotonic()
+    for i in range(args.count):
+        msg = encode(i, x, y, w, h, render_text("%06d" % i, w, h, 3, 0xFFFF, rgb565(0, 0, 96)), DELTA)
+        if dump:
+            dump.write(struct.pack("<I", len(msg)) + msg)
+            continue
+        _, lat, replies = run(sock, [(i, msg)], 1)
+        latencies += lat
+        next_time += interval
+        time.sleep(max(0, next_time - time.monotonic()))
+    if latencies:
+        print(json.dumps({"updates": len(latencies), "rate_hz": args.rate, "latency_ms_p50": percentile(latencies, 50),
+                          "latency_ms_p95": percentile(latencies, 95), "latency_ms_max": round(max(latencies), 2)}))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("command", choices=("bench", "counter"))
+    parser.add_argument("base", nargs="?", default="http://192.168.4.1")
+    parser.add_argument("--width", type=int, default=120)
+    parser.add_argument("--height", type=int, default=32)
+    parser.add_argument("--messages", type=int, default=100)
+    parser.add_argument("--window", type=int, default=1)
+    parser.add_argument("--rate", type=float, default=30)
+    parser.add_argument("--count", type=int, default=300)
+    parser.add_argument("--dump", help="write the messages to this file instead of sending them")
+    args = parser.parse_args()
+
+    random.seed(1)
+    dump = open(args.dump, "wb") if args.dump else None
+    sock = None if dump else Socket(args.base)
+    try:
+        (bench if args.command == "bench" else counter)(args, sock, dump)
+    finally:
+        if sock:
+            sock.close()
+        if dump:
+            dump.close()
+
+
+if __name__ == "__main__":
+    main()
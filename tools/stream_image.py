@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Time from the start of the request until the image is on the panel.
+
+Two ways of showing the same JPEG, each `--runs` times:
+  stream   POST /stream (?save=NAME with --save); the device answers once
+           the last row is drawn
+  upload   POST /upload, then POST /display/NAME and wait for its "render"
+           event with state "done" on /events
+Prints one JSON line per way with the client-side milliseconds and what
+the device reported for the stream (transfer, decode and the tail from the
+last body byte to the last pixel). The uploaded copy is deleted at the end.
+
+    python3 tools/stream_image.py IMAGE.jpg [http://192.168.4.1] [--runs N] [--save]
+"""
+
+import argparse
+import http.client
+import json
+import os
+import threading
+import time
+import urllib.parse
+import uuid
+
+NAME = "streamtest.jpg"
+
+
+def connect(base):
+    parsed = urllib.parse.urlparse(base)
+    return http.client.HTTPConnection(parsed.hostname, parsed.port or 80, timeout=60)
+
+
+def stream(base, data, save):
+    conn = connect(base)
+    start = time.monotonic()
+    conn.request("POST", "/stream" + ("?save=" + NAME if save else ""), data, {"Content-Type": "image/jpeg"})
+    resp = conn.getresponse()
+    reply = resp.read()
+    ms = (time.monotonic() - start) * 1000
+    conn.close()
+    try:
+        device = json.loads(reply)
+    except ValueError:
+        device = {}
+    return resp.status, ms, device
+
+
+class RenderEvents(threading.Thread):
+    """Follows /events and records when each render job reached "done"."""
+
+    def __init__(self, base):
+        super().__init__(daemon=True)
+        self.base = base
+        self.done = {}
+        self.cond = threading.Condition()
+
+    def run(self):
+        conn = connect(self.base)
+        conn.request("GET", "/events")
+        resp = conn.getresponse()
+        event = None
+        while True:
+            line = resp.fp.readline()
+            if not line:
+                return
+            line = line.decode(errors="replace").strip()
+            if line.startswith("event:"):
+                event = line[6:].strip()
+            elif line.startswith("data:") and event == "render":
+                data = json.loads(line[5:])
+                if data.get("state") in ("done", "failed", "superseded"):
+                    with self.cond:
+                        self.done[data["id"]] = (data["state"], time.monotonic())
+                        self.cond.notify_all()
+
+    def wait(self, job, timeout=30):
+        with self.cond:
+            self.cond.wait_for(lambda: job in self.done, timeout)
+            return self.done.get(job)
+
+
+def upload_and_display(base, data, events):
+    boundary = uuid.uuid4().hex
+    body = (
+        "--%s\r\nContent-Disposition: form-data; name=\"image\"; filename=\"%s\"\r\n"
+        "Content-Type: application/octet-stream\r\n\r\n" % (boundary, NAME)
+    ).encode() + data + ("\r\n--%s--\r\n" % boundary).encode()
+    conn = connect(base)
+    start = time.monotonic()
+    conn.request("POST", "/upload", body, {"Content-Type": "multipart/form-data; boundary=" + boundary})
+    resp = conn.getresponse()
+    resp.read()
+    if resp.status != 200:
+        return resp.status, 0
+    conn.request("POST", "/display/" + NAME)
+    resp = conn.getresponse()
+    job = json.loads(resp.read())["job"]
+    conn.close()
+    result = events.wait(job)
+    if not result or result[0] != "done":
+        return 500, 0
+    return 200, (result[1] - start) * 1000
+
+
+def summarize(way, samples, extra=None):
+    ok = [ms for status, ms in samples if status == 200]
+    summary = {"way": way, "runs": len(samples), "failures": len(samples) - len(ok)}
+    if ok:
+        summary["ms_min"] = round(min(ok), 1)
+        summary["ms_avg"] = round(sum(ok) / len(ok), 1)
+        summary["ms_max"] = round(max(ok), 1)
+    summary.update(extra or {})
+    return summary
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("image")
+    parser.add_argument("base", nargs="?", default="http://192.168.4.1")
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--save", action="store_true", help="persist the streamed image as well")
+    args = parser.parse_args()
+    with open(args.image, "rb") as f:
+        data = f.read()
+
+    samples = []
+    device = []
+    for _ in range(args.runs):
+        status, ms, reply = stream(args.base, data, args.save)
+        samples.append((status, ms))
+        if status == 200:
+            device.append(reply)
+    extra = {"bytes": len(data), "save": args.save}
+    for key in ("transfer_ms", "decode_ms", "tail_ms", "total_ms"):
+        if device:
+            extra["device_" + key] = round(sum(d.get(key, 0) for d in device) / len(device), 1)
+    print(json.dumps(summarize("stream", samples, extra)))
+
+    events = RenderEvents(args.base)
+    events.start()
+    time.sleep(0.5)  # Subscribed before the first job
+    samples = [upload_and_display(args.base, data, events) for _ in range(args.runs)]
+    print(json.dumps(summarize("upload", samples, {"bytes": len(data)})))
+
+    conn = connect(args.base)
+    conn.request("DELETE", "/delete/" + NAME)
+    conn.getresponse().read()
+    conn.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Upload throughput and gallery latency, alone and together.
+
+Three phases against a running device:
+  browse  the gallery is loaded repeatedly (/images, then every thumbnail)
+  upload  IMAGE is posted to /upload `--uploads` times, one after another
+  mixed   both at once, from two threads
+The uploaded copies are deleted at the end.
+
+For uploads it prints the client-side KB/s and what the device reported;
+for browsing the latency percentiles of every GET. Build the firmware once
+with -DUPLOAD_WRITE_BEHIND=0 (flash writes on async_tcp) and once with the
+default, run this against each and compare the "mixed" lines. The mode is
+read from /metrics and printed with every summary.
+
+    python3 tools/upload_load.py IMAGE [http://192.168.4.1] [--uploads N] [--seconds S]
+"""
+
+import argparse
+import http.client
+import json
+import os
+import threading
+import time
+import urllib.parse
+import uuid
+
+
+def connect(base):
+    parsed = urllib.parse.urlparse(base)
+    return http.client.HTTPConnection(parsed.hostname, parsed.port or 80, timeout=60)
+
+
+def get(conn, url):
+    start = time.monotonic()
+    conn.request("GET", url)
+    resp = conn.getresponse()
+    body = resp.read()
+    return resp.status, body, (time.monotonic() - start) * 1000
+
+
+def upload(base, name, data):
+    boundary = uuid.uuid4().hex
+    body = (
+        "--%s\r\nContent-Disposition: form-data; name=\"image\"; filename=\"%s\"\r\n"
+        "Content-Type: application/octet-stream\r\n\r\n" % (boundary, name)
+    ).encode() + data + ("\r\n--%s--\r\n" % boundary).encode()
+    conn = connect(base)
+    start = time.monotonic()
+    conn.request("POST", "/upload", body, {"Content-Type": "multipart/form-data; boundary=" + boundary})
+    resp = conn.getresponse()
+    reply = resp.read()
+    seconds = time.monotonic() - start
+    conn.close()
+    try:
+        device = json.loads(reply).get("kbps")
+    except ValueError:
+        device = None
+    return {"status": resp.status, "kbps": round(len(data) / 1024 / seconds, 1), "device_kbps": device,
+            "ms": round(seconds * 1000, 1)}
+
+
+def browse_once(base, latencies):
+    conn = connect(base)
+    status, body, ms = get(conn, "/images?sort=name")
+    latencies.append(ms)
+    if status == 200:
+        for image in json.loads(body).get("images", []):
+            name = urllib.parse.quote(image["name"])
+            latencies.append(get(conn, "/thumb/%s?v=%x" % (name, image["crc"]))[2])
+    conn.close()
+
+
+def percentile(values, p):
+    if not values:
+        return 0
+    values = sorted(values)
+    return round(values[min(len(values) - 1, int(len(values) * p / 100))], 1)
+
+
+def write_behind(base):
+    try:
+        status, body, _ = get(connect(base), "/metrics")
+    except OSError:
+        return None
+    for line in body.decode(errors="replace").splitlines():
+        if line.startswith("upload_write_behind "):
+            return int(line.split()[1])
+    return None
+
+
+def run_phase(args, data, phase):
+    latencies = []
+    uploads = []
+    stop = threading.Event()
+
+    def browser():
+        while not stop.is_set():
+            browse_once(args.base, latencies)
+
+    thread = None
+    if phase != "upload":
+        thread = threading.Thread(target=browser)
+        thread.start()
+    if phase == "browse":
+        time.sleep(args.seconds)
+    else:
+        for i in range(args.uploads):
+            uploads.append(upload(args.base, "loadtest_%d%s" % (i, os.path.splitext(args.image)[1]), data))
+    stop.set()
+    if thread:
+        thread.join()
+
+    summary = {"phase": phase, "write_behind": args.mode}
+    if uploads:
+        ok = [u for u in uploads if u["status"] == 200]
+        summary["uploads"] = len(uploads)
+        summary["upload_failures"] = len(uploads) - len(ok)
+        summary["upload_kbps"] = round(sum(u["kbps"] for u in ok) / len(ok), 1) if ok else 0
+        summary["device_kbps"] = round(sum(u["device_kbps"] or 0 for u in ok) / len(ok), 1) if ok else 0
+        summary["upload_ms_max"] = max(u["ms"] for u in uploads)
+    if latencies:
+        summary["gets"] = len(latencies)
+        summary["get_ms_p50"] = percentile(latencies, 50)
+        summary["get_ms_p95"] = percentile(latencies, 95)
+        summary["get_ms_max"] = round(max(latencies), 1)
+    return summary
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("image")
+    parser.add_argument("base", nargs="?", default="http://192.168.4.1")
+    parser.add_argument("--uploads", type=int, default=10)
+    parser.add_argument("--seconds", type=float, default=10)
+    args = parser.parse_args()
+    with open(args.image, "rb") as f:
+        data = f.read()
+    args.mode = write_behind(args.base)
+    for phase in ("browse", "upload", "mixed"):
+        print(json.dumps(run_phase(args, data, phase)))
+    # The uploads reuse the same names; remove them again
+    conn = connect(args.base)
+    for i in range(args.uploads):
+        conn.request("DELETE", "/delete/loadtest_%d%s" % (i, os.path.splitext(args.image)[1]))
+        conn.getresponse().read()
+    conn.close()
+
+
+if __name__ == "__main__":
+    main()